@@ -0,0 +1,105 @@
+/**
+ * File name: smllib_capture.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_CAPTURE_H_
+#define SMLLIB_CAPTURE_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+
+/*
+ * Reader for transport captures on disk (CMake CAPTURE, POSIX hosts). The
+ * file is mapped read-only and every frame is validated and parsed where
+ * it lies, nothing is copied into a buffer first. Offsets into the capture
+ * are 64 bit; a single frame is limited to 4 GB like everywhere else.
+ *
+ * The mapping is advised sequential, the reader requests read ahead of
+ * window bytes in front of the position and drops the pages more than
+ * window bytes behind it. Only about two windows of the capture are
+ * resident at a time, so captures larger than RAM are fine. A frame
+ * returned earlier stays readable, its pages are faulted in again.
+ *
+ * Noise and invalid frames are skipped the way
+ * sml_transport_parse_file_tolerant() skips them and are counted in the
+ * capture (and in the framesSkipped and resyncBytes metrics).
+ */
+
+#ifndef SML_CAPTURE_WINDOW
+	#define SML_CAPTURE_WINDOW (8UL * 1024 * 1024)
+#endif
+
+/* sml_capture_next(): no further frame */
+#define SML_CAPTURE_END 3
+
+typedef struct SML_Capture {
+	const unsigned char* data;	/* the mapping, NULL for an empty file */
+	uint64_t size;
+	uint64_t offset;			/* the search for the next frame starts here */
+	uint64_t frameOffset;		/* frame returned last */
+	uint32_t frameLength;
+	uint64_t skippedFrames;
+	uint64_t skippedBytes;		/* noise and skipped frames */
+	uint32_t window;			/* read ahead and keep behind, SML_CAPTURE_WINDOW */
+	uint32_t pageSize;
+	uint64_t prefetched;		/* read ahead requested up to here */
+	uint64_t released;			/* pages below have been dropped */
+} SML_Capture;
+
+/* Public methods */
+
+/**
+ * Maps the capture at path. Returns SML_PARSE_ERROR if it cannot be opened
+ * or mapped (errno tells why), or if it does not fit into the address space.
+ */
+uint8_t sml_capture_open(SML_Capture* capture, const char* path);
+
+void sml_capture_close(SML_Capture* capture);
+
+/**
+ * Moves to the next valid frame and points *frame to it inside the mapping.
+ * Returns SML_CAPTURE_END at the end of the capture.
+ */
+uint8_t sml_capture_next_frame(SML_Capture* capture, const unsigned char** frame, uint32_t* length);
+
+/**
+ * Parses the next valid frame into message. The message lives in the parser
+ * memory of the current context until sml_parser_free(), error offsets of
+ * sml_context_error() are relative to frameOffset. Frames that validate but
+ * fail to parse are skipped. On SML_PARSE_NOMEM the position stays at the
+ * frame, it is returned again by the next call.
+ */
+uint8_t sml_capture_next(SML_Capture* capture, SML_Message* message);
+
+/* Continues the search at offset, e.g. the frameOffset of an earlier frame */
+void sml_capture_seek(SML_Capture* capture, uint64_t offset);
+
+/* Private methods */
+
+/* Bytes from offset on that a 32 bit offset can address */
+uint32_t p_sml_capture_span(const SML_Capture* capture, uint64_t offset);
+
+/* Read ahead of and release behind the position */
+void p_sml_capture_advise(SML_Capture* capture);
+
+void p_sml_capture_skip(SML_Capture* capture, uint64_t length);
+
+#endif /* SMLLIB_CAPTURE_H_ */
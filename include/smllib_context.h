@@ -0,0 +1,251 @@
+/**
+ * File name: smllib_context.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_CONTEXT_H_
+#define SMLLIB_CONTEXT_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+#include "smllib_trace.h"
+#include "smllib_error.h"
+
+/*** Allocation statistics ***/
+
+/* Number of message body buckets (14 SML_MESSAGEBODY_* types + unattributed) */
+#define SML_MESSAGEBODY_TYPES 15
+#define SML_MESSAGEBODY_INDEX_NONE 14
+
+/**
+ * Memory allocator used by the parser and the encoder. All three functions
+ * get the user pointer as first argument. alloc need not return zeroed
+ * memory; realloc and free are only called with non-NULL pointers.
+ */
+typedef struct SML_Allocator {
+	void* (*alloc)(void* user, size_t size);
+	void* (*realloc)(void* user, void* ptr, size_t size);
+	void (*free)(void* user, void* ptr);
+	void* user;
+} SML_Allocator;
+
+typedef struct SML_Alloc_Counter {
+	uint32_t allocations;	/* alloc calls (realloc of NULL included) */
+	uint32_t reallocations;
+	uint32_t frees;
+	uint64_t bytes;			/* bytes requested by alloc and realloc calls */
+} SML_Alloc_Counter;
+
+typedef struct SML_Alloc_Stats {
+	SML_Alloc_Counter total;
+	SML_Alloc_Counter messageType[SML_MESSAGEBODY_TYPES]; /* see sml_messagebody_index() */
+} SML_Alloc_Stats;
+
+/*** Operation counters (see smllib_metrics.h) ***/
+
+#define SML_METRIC(field, name, help) uint64_t field;
+typedef struct SML_Metrics {
+	#include "smllib_metrics_counters.h"
+} SML_Metrics;
+#undef SML_METRIC
+
+/*** Static pool ***/
+
+/**
+ * Caller-supplied memory block the parser and encoder allocate from
+ * instead of the heap (see sml_context_set_pool()). Allocation is a bump
+ * of "used"; only the most recent block can be freed or resized in place.
+ * sml_parser_free() releases the whole pool.
+ */
+typedef struct SML_Pool {
+	unsigned char* base;
+	size_t size;	/* hard byte budget */
+	size_t used;
+	size_t last;	/* offset of the most recent block, SML_POOL_NO_BLOCK if none */
+	size_t high;	/* high-water mark of used */
+	size_t floor;	/* blocks below survive sml_parser_free() (intern table) */
+} SML_Pool;
+
+#define SML_POOL_NO_BLOCK ((size_t)-1)
+
+/* Alignment of pool blocks (define SMLLIB_POOL_ALIGN=1 on 8-bit targets) */
+#ifndef SMLLIB_POOL_ALIGN
+	#define SMLLIB_POOL_ALIGN (sizeof(uint64_t) > sizeof(void*) ? sizeof(uint64_t) : sizeof(void*))
+#endif
+
+/* Called on every alloc/realloc with the message body choiceTag being processed (0 if none) */
+typedef void (*SML_Alloc_Hook)(void* user, uint32_t choiceTag, size_t size);
+
+/**
+ * Parse/encode context. Holds the allocator, the allocation statistics, the
+ * encoder options and the list of allocations owned by the parser.
+ * Initialize with sml_context_init() and activate with sml_context_use().
+ */
+typedef struct SML_Context {
+	SML_Allocator allocator;		/* all NULL: C library calloc/realloc/free */
+	SML_Pool pool;					/* used instead of the allocator if base is set */
+	SML_Boolean outOfMemory;		/* set by a failed allocation, see SML_PARSE_NOMEM */
+	const char* encodeError;		/* set by a nested encoder, fails the message encoding */
+	SML_Error error;				/* see sml_context_error() */
+	size_t poolWorstCase[SML_MESSAGEBODY_TYPES];	/* see sml_context_pool_worst_case() */
+	size_t poolMessageStart;
+	SML_Alloc_Stats allocStats;
+	SML_Metrics metrics;			/* see smllib_metrics.h */
+	SML_Alloc_Hook allocHook;		/* optional */
+	void* allocHookUser;
+	SML_Trace_Sink traceSink;		/* optional, see smllib_trace.h */
+	void* traceSinkUser;
+
+	SML_Boolean encodeShortest;		/* see sml_encode_set_shortest_integers() */
+	SML_Boolean compactLayout;		/* see sml_context_set_compact_layout() */
+	struct SML_Intern_Table* internTable;	/* see sml_context_set_intern_table() */
+	struct SML_Latency* latency;	/* see sml_context_set_latency() */
+
+	uint32_t messageType;			/* choiceTag of the message being processed */
+	uint32_t messageDepth;
+	SML_Alloc_Counter messageStart;	/* unattributed counter at message start */
+
+	void** pointerList;				/* allocations released by sml_parser_free() */
+	uint32_t pointerCount;
+	uint32_t pointerMax;
+} SML_Context;
+
+/* Public methods */
+
+void sml_context_init(SML_Context* context);
+
+void sml_context_set_allocator(SML_Context* context, const SML_Allocator* allocator);
+
+/**
+ * Lets the context allocate from the given memory block only, the heap is
+ * never touched. An exhausted pool makes the parser return SML_PARSE_NOMEM.
+ * NULL switches back to the allocator.
+ */
+void sml_context_set_pool(SML_Context* context, void* pool, size_t size);
+
+/**
+ * Largest number of pool bytes a single message of the given
+ * SML_MESSAGEBODY_* type needed so far (0 if none was processed). Parsing
+ * representative messages with a large pool on the host yields the pool
+ * size required on the target.
+ */
+size_t sml_context_pool_worst_case(const SML_Context* context, uint32_t choiceTag);
+
+/**
+ * Error of the last failed parse or encode call made with the context: code,
+ * offset and enclosing elements (see smllib_error.h). Reset when the next
+ * call starts, code is SML_ERROR_NONE after a successful one.
+ */
+const SML_Error* sml_context_error(const SML_Context* context);
+
+/**
+ * Selects the compact structures (SML_*_Compact, optional scalars inline
+ * with presence bits, flattened parameter trees) for PublicOpen_Req,
+ * PublicOpen_Res, GetList_Res and GetProcParameter_Res in both parser and
+ * encoder: SML_MessageBody then carries openRequestCompact,
+ * openResponseCompact, getListResponseCompact or
+ * getProcParameterResponseCompact.
+ */
+void sml_context_set_compact_layout(SML_Context* context, SML_Boolean enable);
+
+/* TRUE if the body type has a compact structure */
+SML_Boolean sml_messagebody_has_compact_layout(uint32_t choiceTag);
+
+void sml_context_set_alloc_hook(SML_Context* context, SML_Alloc_Hook hook, void* user);
+
+/* Receives the trace events of the compiled-in SMLLIB_TRACE_LEVEL, NULL drops them */
+void sml_context_set_trace_sink(SML_Context* context, SML_Trace_Sink sink, void* user);
+
+/**
+ * Makes the given context the active one for all following parse/encode
+ * calls and returns the previously active context. NULL selects the
+ * built-in default context (C library allocator). With
+ * SMLLIB_THREAD_CONTEXT (CMake THREAD_CONTEXT, implied by PIPELINE) the
+ * choice is per thread, and so is the default context: threads that never
+ * call this do not share one.
+ */
+SML_Context* sml_context_use(SML_Context* context);
+
+SML_Context* sml_context_current(void);
+
+void sml_context_reset_stats(SML_Context* context);
+
+/* Maps an SML_MESSAGEBODY_* choiceTag to its SML_Alloc_Stats.messageType index */
+uint32_t sml_messagebody_index(uint32_t choiceTag);
+
+/* Frees an encoder result with the allocator of the active context */
+void sml_encode_result_free(SML_Encode_Binary_Result* result);
+
+/* Private methods */
+
+void* p_sml_calloc(size_t count, size_t size);
+
+/* oldSize bounds the bytes copied when a pool block cannot grow in place */
+void* p_sml_realloc(void* ptr, size_t oldSize, size_t size);
+
+void p_sml_free(void* ptr);
+
+/* Releases all pool blocks of the active context (no-op without pool) */
+void p_sml_pool_reset(void);
+
+/* Current pool position and rollback to it, dropping all younger blocks (no-op without pool) */
+size_t p_sml_pool_mark(void);
+
+void p_sml_pool_release(size_t mark);
+
+/**
+ * Moves block, the result built above mark, down to mark and drops all other
+ * blocks above it. Returns the new address (block itself without pool).
+ */
+void* p_sml_pool_settle(size_t mark, void* block, size_t length);
+
+/* TRUE if block was allocated from the active pool */
+SML_Boolean p_sml_pool_holds(const void* block);
+
+void p_sml_message_begin(void);
+
+void p_sml_message_type(uint32_t choiceTag);
+
+void p_sml_message_end(void);
+
+/* Private fields */
+
+/**
+ * Each thread has its own active context and its own default context in
+ * SMLLIB_THREAD_CONTEXT builds (CMake THREAD_CONTEXT). A thread-local
+ * pointer cannot be initialized with the address of another thread-local,
+ * so it starts out NULL and the first access of a thread selects the
+ * thread's default context.
+ */
+#ifdef SMLLIB_THREAD_CONTEXT
+	#define SML_THREAD_LOCAL __thread
+
+	extern SML_THREAD_LOCAL SML_Context* p_sml_thread_context;
+
+	SML_Context* p_sml_context_thread_default(void);
+
+	#define p_sml_context ((p_sml_thread_context != NULL) ? p_sml_thread_context : p_sml_context_thread_default())
+#else
+	#define SML_THREAD_LOCAL
+
+	extern SML_Context* p_sml_context;
+#endif
+
+#endif /* SMLLIB_CONTEXT_H_ */
@@ -0,0 +1,115 @@
+/**
+ * File name: smllib_deframer.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_DEFRAMER_H_
+#define SMLLIB_DEFRAMER_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+
+/*
+ * Incremental transport deframer for byte streams (serial links, sockets):
+ * bytes go into the caller's buffer as they arrive, sml_deframer_next()
+ * hands out every complete frame that validates, in place. Noise, broken
+ * frames and frames longer than the buffer are skipped and counted (and
+ * go into the framesSkipped and resyncBytes metrics).
+ *
+ * A valid frame holds no 0x1B run whose length modulo eight is four or
+ * more, except the one of its end escape. Any other byte behind such a run
+ * ends a broken frame there, and a start escape at that point begins the
+ * next frame right away, so a frame cut off by a reconnect costs only
+ * itself.
+ *
+ * Frames are checked with sml_transport_validate_message(). With validate
+ * set to FALSE only the frame crc is checked, for a consumer that
+ * validates the message itself.
+ */
+
+/* sml_deframer_next(): no complete frame in the buffer */
+#define SML_DEFRAMER_MORE 3
+
+typedef struct SML_Deframer {
+	unsigned char* buffer;
+	uint32_t size;
+	uint32_t fill;
+	uint32_t start;			/* bytes in front are done with, moved out once per refill */
+	uint32_t scan;			/* escape scan position in the current frame */
+	uint32_t consumed;		/* frame handed out last (at start), dropped by the next call */
+	SML_Boolean inFrame;	/* a start escape is at the front of the buffer */
+	SML_Boolean validate;	/* TRUE (default): message structure too, FALSE: frame crc only */
+	uint64_t frames;
+	uint64_t skippedFrames;
+	uint64_t skippedBytes;	/* noise and skipped frames */
+} SML_Deframer;
+
+/* Public methods */
+
+/* The buffer bounds the frame length, it needs room for at least the two escapes */
+void sml_deframer_init(SML_Deframer* deframer, unsigned char* buffer, uint32_t size);
+
+/**
+ * Free part of the buffer, to read into directly; announce what was
+ * written with sml_deframer_commit(). Never empty after
+ * sml_deframer_next() returned SML_DEFRAMER_MORE.
+ */
+unsigned char* sml_deframer_space(SML_Deframer* deframer, uint32_t* length);
+
+void sml_deframer_commit(SML_Deframer* deframer, uint32_t length);
+
+/* Copies as much of data as fits, returns the number of bytes taken */
+uint32_t sml_deframer_feed(SML_Deframer* deframer, const unsigned char* data, uint32_t length);
+
+/**
+ * Next complete and valid frame, *frame points into the buffer and stays
+ * valid up to the next call. SML_DEFRAMER_MORE when more bytes are needed.
+ */
+uint8_t sml_deframer_next(SML_Deframer* deframer, const unsigned char** frame, uint32_t* length);
+
+/**
+ * Continues in the given buffer, of the same size, and returns the old one
+ * with the frame of the last sml_deframer_next() call at its start; the
+ * bytes behind that frame are moved over. Hands frames on without copying
+ * them (see smllib_pipeline.h).
+ */
+unsigned char* sml_deframer_exchange(SML_Deframer* deframer, unsigned char* buffer);
+
+/* Private methods */
+
+/* Drops length bytes at start, without moving any */
+void p_sml_deframer_discard(SML_Deframer* deframer, uint32_t length);
+
+/* Moves the bytes from start on to the front of the buffer */
+void p_sml_deframer_compact(SML_Deframer* deframer);
+
+/* As above, counted as skipped */
+void p_sml_deframer_skip(SML_Deframer* deframer, uint32_t length);
+
+/* Skips the broken or invalid frame at the front, length bytes of it */
+void p_sml_deframer_drop(SML_Deframer* deframer, uint32_t length);
+
+/* Frame crc of the frame from start to frameEnd */
+uint8_t p_sml_deframer_check_crc(const unsigned char* buffer, uint32_t start, uint32_t frameEnd);
+
+/* SML_DEFRAMER_MORE, after dropping a frame that fills the whole buffer */
+uint8_t p_sml_deframer_wait(SML_Deframer* deframer);
+
+#endif /* SMLLIB_DEFRAMER_H_ */
@@ -36,9 +36,54 @@ SML_Encode_Binary_Result sml_transport_encode_file(SML_File* file);
 
 SML_Encode_Binary_Result sml_transport_encode_message(SML_Message* message);
 
+/**
+ * Encodes a GetProfilePack_Res message without materializing its period_List:
+ * period_List.listSize rows are pulled one at a time from the rows callback
+ * (period_List_Entry is ignored) and the output is handed to write in chunks
+ * of SMLLIB_STREAM_BUFFER_SIZE bytes. The row passed to the callback is zeroed
+ * once and reused, its memory stays owned by the caller. Output is
+ * byte-identical to sml_encode_message_binary() resp.
+ * sml_transport_encode_message(). The result carries no binary, only the
+ * number of bytes written; on a callback failure the output is truncated.
+ */
+SML_Encode_Binary_Result sml_encode_profilepack_stream(SML_Message* message, SML_Period_Callback rows, void* rowUser, SML_Write_Callback write, void* writeUser);
+
+SML_Encode_Binary_Result sml_transport_encode_profilepack_stream(SML_Message* message, SML_Period_Callback rows, void* rowUser, SML_Write_Callback write, void* writeUser);
+
+/**
+ * Enables/disables shortest-form encoding of Integer and Unsigned fields.
+ * When enabled, each value is written with the minimal number of bytes that
+ * still represents it (sign-extended for Integer types) instead of the full
+ * declared width. Message and transport CRCs always keep their full width.
+ * The setting is stored in the active SML_Context.
+ */
+void sml_encode_set_shortest_integers(SML_Boolean enable);
+
 
 /* Private methods */
 
+SML_Encode_Binary_Result p_sml_encode_message(SML_Message* message);
+
+SML_Encode_Binary_Result p_sml_transport_encode_message(SML_Message* message);
+
+SML_Encode_Binary_Result p_sml_encode_profilepack_stream(SML_Message* message, SML_Period_Callback rows, void* rowUser, SML_Write_Callback write, void* writeUser, SML_Boolean transport);
+
+void p_sml_stream_init(SML_Encode_Stream* stream, SML_Write_Callback write, void* writeUser, SML_Boolean transport);
+
+/* Hands the buffered bytes to the write callback */
+void p_sml_stream_flush(SML_Encode_Stream* stream);
+
+/* Appends transport bytes (no escaping, no message crc) */
+void p_sml_stream_raw(SML_Encode_Stream* stream, const unsigned char* data, uint32_t length);
+
+/* Appends message bytes: message crc, escaping in transport mode */
+void p_sml_stream_message(SML_Encode_Stream* stream, const unsigned char* data, uint32_t length);
+
+/* Appends an encoded part and frees it */
+void p_sml_stream_put(SML_Encode_Stream* stream, SML_Encode_Binary_Result part);
+
+void p_sml_stream_periods(SML_Encode_Stream* stream, uint32_t count, SML_Period_Callback rows, void* rowUser);
+
 SML_Encode_Binary_Result p_sml_encode_open_request(SML_PublicOpen_Req* request);
 
 SML_Encode_Binary_Result p_sml_encode_open_response(SML_PublicOpen_Res* response);
@@ -75,6 +120,8 @@ SML_Encode_Binary_Result p_sml_encode_list_of_tree(List_of_SML_Tree* list);
 
 SML_Encode_Binary_Result p_sml_encode_tree(SML_Tree* tree);
 
+SML_Encode_Binary_Result p_sml_encode_flat_tree(SML_Flat_Tree* tree);
+
 SML_Encode_Binary_Result p_sml_encode_list_of_objreqentry(List_of_SML_ObjReqEntry* list);
 
 SML_Encode_Binary_Result p_sml_encode_list_of_periodentry(List_of_SML_PeriodEntry* list);
@@ -105,16 +152,39 @@ SML_Encode_Binary_Result p_sml_encode_list(SML_List* list);
 
 SML_Encode_Binary_Result p_sml_encode_listentry(SML_ListEntry* entry);
 
+SML_Encode_Binary_Result p_sml_encode_list_compact(SML_List_Compact* list);
+
+SML_Encode_Binary_Result p_sml_encode_listentry_compact(SML_ListEntry_Compact* entry);
+
+SML_Encode_Binary_Result p_sml_encode_open_request_compact(SML_PublicOpen_Req_Compact* request);
+
+SML_Encode_Binary_Result p_sml_encode_open_response_compact(SML_PublicOpen_Res_Compact* response);
+
+SML_Encode_Binary_Result p_sml_encode_getlist_response_compact(SML_GetList_Res_Compact* response);
+
+SML_Encode_Binary_Result p_sml_encode_getprocparameter_response_compact(SML_GetProcParameter_Res_Compact* response);
+
+SML_Encode_Binary_Result p_sml_encode_messagebody_compact(SML_MessageBody* messageBody);
+
 SML_Encode_Binary_Result p_sml_encode_time(SML_Time* time);
 
 SML_Encode_Binary_Result p_sml_encode_string(char* in);
 
+/* Encodes objName, or the inline obis code if objName is NULL */
+SML_Encode_Binary_Result p_sml_encode_objname(char* objName, SML_Obis* obis);
+
 SML_Encode_Binary_Result p_sml_encode_boolean(SML_Boolean in);
 
 SML_Encode_Binary_Result p_sml_encode_integer(int64_t in, uint32_t length);
 
 SML_Encode_Binary_Result p_sml_encode_unsigned(uint64_t in, uint32_t length);
 
+SML_Encode_Binary_Result p_sml_encode_number(uint64_t in, TL_FieldType type, uint32_t length);
+
+uint32_t p_sml_unsigned_min_length(uint64_t in, uint32_t length);
+
+uint32_t p_sml_integer_min_length(int64_t in, uint32_t length);
+
 SML_Encode_Binary_Result p_sml_encode_primitive_type(void* in_ptr, TL_FieldType type, uint32_t length);
 
 SML_Encode_Binary_Result p_sml_encode_tlfield(TL_FieldType type, uint32_t length);
@@ -123,12 +193,37 @@ void p_concat_binary_results(SML_Encode_Binary_Result* target, SML_Encode_Binary
 
 void p_concat_binary_results_dynamic(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result** src, uint32_t count);
 
-void p_allocate_concat_free(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* src, uint32_t count);
+/**
+ * Concatenates the parts into target and frees them (and src, which must come
+ * from p_sml_calloc). mark is the pool position taken before the first part,
+ * the result is moved down to it so nested encoders leave no pool garbage.
+ */
+void p_allocate_concat_free(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* src, uint32_t count, size_t mark);
+
+/* As above, src being the caller's array of parts */
+void p_allocate_concat_free_dynamic(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result** src, uint32_t count, size_t mark);
 
-void p_allocate_concat_free_dynamic(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result** src, uint32_t count);
+/**
+ * Concatenates and frees array[0..count-1], or *ptrs[0..count-1] if array is
+ * NULL. Pool parts lying back to back are closed up in place, no copy.
+ */
+void p_sml_concat_parts(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* array, SML_Encode_Binary_Result** ptrs, uint32_t count);
 
 void p_set_encode_error(SML_Encode_Binary_Result* result, const char* errmsg);
 
-SML_Encode_Binary_Result p_sml_transport_escape_message(SML_Encode_Binary_Result* message);
+/* Flags a failed allocation for the top-level encoder, returns an empty part */
+SML_Encode_Binary_Result p_sml_encode_nomem(void);
+
+/* Turns result into an error if a nested encoder reported one */
+void p_sml_check_encode_error(SML_Encode_Binary_Result* result);
+
+/* Frees messages[0..failed-1] and returns the failed result */
+SML_Encode_Binary_Result p_sml_encode_failed_message(SML_Encode_Binary_Result* messages, uint32_t failed);
+
+/* Length of message after escaping */
+uint32_t p_sml_transport_escaped_length(const SML_Encode_Binary_Result* message);
+
+/* Writes the escaped message to out (p_sml_transport_escaped_length() bytes) */
+void p_sml_transport_escape_message(const SML_Encode_Binary_Result* message, unsigned char* out);
 
 #endif /* SMLLIB_ENCODE_H_ */
@@ -0,0 +1,95 @@
+/**
+ * File name: smllib_error.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_ERROR_H_
+#define SMLLIB_ERROR_H_
+
+#include "smllib_types.h"
+
+/*** Error codes ***/
+
+/*
+ * The context keeps the first error of the last parse or encode call (see
+ * sml_context_error()). Recording it costs a few stores and no allocation,
+ * nothing is done on the success path.
+ */
+#define SML_ERROR_NONE 0
+#define SML_ERROR_TL 1				/* invalid type-length field */
+#define SML_ERROR_TYPE 2			/* field of unexpected type or length */
+#define SML_ERROR_LISTSIZE 3		/* list with the wrong number of elements */
+#define SML_ERROR_CHOICE 4			/* unknown choice tag */
+#define SML_ERROR_DEPTH 5			/* tree nested deeper than SMLLIB_TREE_MAX_DEPTH */
+#define SML_ERROR_MESSAGE_CRC 6		/* message CRC16 mismatch */
+#define SML_ERROR_MESSAGE_END 7		/* end of message byte missing */
+#define SML_ERROR_FRAME 8			/* transport start escape sequence missing */
+#define SML_ERROR_FRAME_CRC 9		/* transport frame CRC16 mismatch */
+#define SML_ERROR_CALLBACK 10		/* a streaming callback stopped the call */
+#define SML_ERROR_NOMEM 11			/* allocator or static pool exhausted */
+#define SML_ERROR_ENCODE 12			/* encoder input rejected, see message */
+#define SML_ERROR_CODES 13
+
+/* Enclosing elements kept in SML_Error.path, the innermost ones win */
+#ifndef SML_ERROR_PATH_DEPTH
+	#define SML_ERROR_PATH_DEPTH 8
+#endif
+
+typedef struct SML_Error {
+	uint8_t code;				/* SML_ERROR_* */
+	uint8_t depth;				/* entries in path */
+	uint32_t offset;			/* of the failing field, see below */
+	uint32_t messageType;		/* choiceTag, 0 if not known yet */
+	const char* message;		/* encoder errors only, static text */
+	const char* path[SML_ERROR_PATH_DEPTH];	/* element names, innermost first */
+} SML_Error;
+
+/*
+ * Parse errors: offset is relative to smlBinary as passed to the parse
+ * function. Frames are parsed after unescaping, so below the transport layer
+ * (codes other than SML_ERROR_FRAME/FRAME_CRC) it is relative to the start of
+ * the unescaped message. Encode errors have no offset.
+ */
+
+/* Public methods */
+
+/* Short description of an SML_ERROR_* code */
+const char* sml_error_name(uint8_t code);
+
+/**
+ * Writes the path as "Message/MessageBody/GetList.Res/ListEntry" into buffer
+ * (NUL terminated, truncated to size). Returns the length written.
+ */
+uint32_t sml_error_path(const SML_Error* error, char* buffer, uint32_t size);
+
+/* Private methods */
+
+void p_sml_error_reset(void);
+
+/* Records code at offset unless an inner call did already, returns SML_PARSE_ERROR */
+uint8_t p_sml_parse_error(uint8_t code, uint32_t offset);
+
+/* Adds element to the path of the current error, returns SML_PARSE_ERROR */
+uint8_t p_sml_parse_failed(const char* element);
+
+/* Replaces the current error by an encoder error */
+void p_sml_encode_error(const char* message);
+
+#endif /* SMLLIB_ERROR_H_ */
@@ -0,0 +1,145 @@
+/**
+ * File name: smllib_index.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_INDEX_H_
+#define SMLLIB_INDEX_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+#include "smllib_capture.h"
+
+/*
+ * Frame index of a capture, kept as a sidecar file next to it. One pass
+ * with sml_index_build() records offset, length, message type, serverId
+ * hash and time of every frame; sml_index_find() then picks the frames of
+ * a time range or a server without reading the capture, and
+ * sml_capture_seek() jumps to them.
+ *
+ * The time is the actSensorTime (else actGatewayTime) of a GetList_Res,
+ * the actTime of a GetProfileList_Res or GetProfilePack_Res and the
+ * refTime of a PublicOpen_Res. Messages without serverId or time take
+ * them over from the frame before (SML_INDEX_INHERITED_*). A PublicOpen
+ * lacking either (a PublicOpen_Res normally has no refTime) and the frames
+ * following it take them over from the first later frame that has both
+ * instead, so the PublicOpen, body and PublicClose frames of an SML file
+ * are found together. A file without such a frame (within
+ * SMLLIB_INDEX_PENDING frames) falls back to the frame before.
+ *
+ * File layout, all numbers little endian: a 32 byte header ("SMLX",
+ * version, entry size, capture size, entry count, flags) followed by one
+ * 32 byte record per frame in capture order.
+ */
+
+#define SML_INDEX_VERSION 1
+#define SML_INDEX_HEADER_SIZE 32
+#define SML_INDEX_ENTRY_SIZE 32
+
+/* SML_Index_Entry flags */
+#define SML_INDEX_INHERITED_SERVER 0x01
+#define SML_INDEX_INHERITED_TIME 0x02
+#define SML_INDEX_UNPARSED 0x04		/* too big for the parser memory, messageType is 0 */
+
+/* SML_Index flags: the times never decrease, sml_index_find() bisects */
+#define SML_INDEX_SORTED 0x01
+
+typedef struct SML_Index_Entry {
+	uint64_t offset;
+	uint32_t length;
+	uint32_t messageType;	/* choiceTag of the message body */
+	uint32_t serverHash;	/* sml_index_server_hash(), 0 without a serverId */
+	uint32_t time;
+	uint8_t timeType;		/* SML_TIME_SECINDEX, SML_TIME_TIMESTAMP or 0 */
+	uint8_t flags;
+} SML_Index_Entry;
+
+typedef struct SML_Index {
+	SML_Capture file;		/* the mapped sidecar */
+	uint64_t captureSize;	/* size of the indexed capture */
+	uint64_t count;
+	uint8_t flags;
+	uint8_t sortedTimeType;	/* time type of a SML_INDEX_SORTED index */
+} SML_Index;
+
+/* Selects frames, fields left as set by sml_index_query_init() match everything */
+typedef struct SML_Index_Query {
+	uint8_t timeType;		/* 0: any time */
+	uint32_t from;			/* inclusive */
+	uint32_t to;			/* inclusive */
+	SML_Boolean byServer;
+	uint32_t serverHash;
+} SML_Index_Query;
+
+/* Public methods */
+
+/**
+ * Indexes every frame of the capture from its start and writes the index
+ * to path (through path.tmp and a rename). Parser memory of the current
+ * context is used per frame and released again. Returns SML_PARSE_ERROR
+ * if the file cannot be written.
+ */
+uint8_t sml_index_build(SML_Capture* capture, const char* path);
+
+/* Maps the index at path; SML_PARSE_ERROR if it is missing or malformed */
+uint8_t sml_index_open(SML_Index* index, const char* path);
+
+void sml_index_close(SML_Index* index);
+
+/* Reads entry i (below count) */
+void sml_index_entry(const SML_Index* index, uint64_t i, SML_Index_Entry* entry);
+
+void sml_index_query_init(SML_Index_Query* query);
+
+/* Hash of the length octets of a serverId as stored in the index (octet strings may contain 0x00) */
+uint32_t sml_index_server_hash(const char* serverId, uint32_t length);
+
+/**
+ * Finds the first matching entry at or behind *position and moves *position
+ * behind it. Start with *position = 0. Returns SML_CAPTURE_END when no
+ * further entry matches.
+ */
+uint8_t sml_index_find(const SML_Index* index, const SML_Index_Query* query, uint64_t* position, SML_Index_Entry* entry);
+
+/* Private methods */
+
+/* Takes over the serverHash and time entry lacks from source, flagged as inherited */
+void p_sml_index_inherit(SML_Index_Entry* entry, const SML_Index_Entry* source);
+
+/* serverId (of serverLength octets) and time from the message body, FALSE for what it lacks */
+void p_sml_index_describe(const SML_Message* message, uint32_t serverLength, SML_Index_Entry* entry, SML_Boolean* hasServer, SML_Boolean* hasTime);
+
+/* Length of the serverId octet string in a valid frame, 0 for message types without one */
+uint32_t p_sml_index_server_length(const unsigned char* frame, uint32_t length);
+
+void p_sml_index_encode(const SML_Index_Entry* entry, unsigned char* record);
+
+/* First entry whose time is at or after time, for SML_INDEX_SORTED indexes */
+uint64_t p_sml_index_lower_bound(const SML_Index* index, uint32_t time);
+
+void p_sml_index_put32(unsigned char* data, uint32_t value);
+
+void p_sml_index_put64(unsigned char* data, uint64_t value);
+
+uint32_t p_sml_index_get32(const unsigned char* data);
+
+uint64_t p_sml_index_get64(const unsigned char* data);
+
+#endif /* SMLLIB_INDEX_H_ */
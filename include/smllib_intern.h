@@ -0,0 +1,88 @@
+/**
+ * File name: smllib_intern.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_INTERN_H_
+#define SMLLIB_INTERN_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+#include "smllib_context.h"
+
+/*** String interning ***/
+
+#define SML_INTERN_NO_ID ((uint32_t)-1)
+
+typedef struct SML_Intern_Entry {
+	char* string;		/* NULL: free slot */
+	uint32_t hash;
+	uint32_t length;
+} SML_Intern_Entry;
+
+/**
+ * Bounded table of unique strings. Parsed serverId and objName values are
+ * looked up here and resolve to one stable, read-only copy with a dense
+ * ID (0..maxStrings-1). Strings that do not fit any more are copied by the
+ * parser as usual. Table and strings live in one block allocated at
+ * creation time.
+ */
+typedef struct SML_Intern_Table {
+	SML_Intern_Entry* slots;	/* open addressing, power of two */
+	uint32_t slotMask;
+	char** strings;				/* by ID */
+	uint32_t count;
+	uint32_t maxStrings;
+	unsigned char* arena;		/* per string: 2 byte ID, bytes, '\0' */
+	uint32_t arenaUsed;
+	uint32_t arenaSize;
+	uint32_t hits;
+	uint32_t misses;			/* lookups of new strings that did not fit */
+} SML_Intern_Table;
+
+/* Public methods */
+
+/**
+ * Creates a table for up to maxStrings (at most 65535) strings with
+ * maxBytes of string data, allocated with the active context. In pool mode
+ * it must be created before parsing; it then survives sml_parser_free().
+ * Returns NULL if out of memory.
+ */
+SML_Intern_Table* sml_intern_create(uint32_t maxStrings, uint32_t maxBytes);
+
+void sml_intern_destroy(SML_Intern_Table* table);
+
+/* Lets the parser of the context intern serverId and objName strings (NULL: off) */
+void sml_context_set_intern_table(SML_Context* context, SML_Intern_Table* table);
+
+/* Returns the interned copy of the given bytes, NULL if the table is full */
+char* sml_intern(SML_Intern_Table* table, const char* data, uint32_t length);
+
+/* ID of an interned string pointer, SML_INTERN_NO_ID for other pointers */
+uint32_t sml_intern_id(const SML_Intern_Table* table, const char* string);
+
+/* Interned string of an ID, NULL if unknown */
+const char* sml_intern_string(const SML_Intern_Table* table, uint32_t id);
+
+/* Private methods */
+
+uint32_t p_sml_intern_hash(const unsigned char* data, uint32_t length);
+
+#endif /* SMLLIB_INTERN_H_ */
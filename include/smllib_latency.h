@@ -0,0 +1,121 @@
+/**
+ * File name: smllib_latency.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_LATENCY_H_
+#define SMLLIB_LATENCY_H_
+
+#include <stdlib.h>
+#ifndef SMLLIB_FREESTANDING
+	#include <stdio.h>
+#endif
+#include "smllib_types.h"
+#include "smllib_context.h"
+
+/*
+ * Latency histograms per operation and message body type. Built with
+ * SMLLIB_LATENCY (CMake LATENCY), the public parse and encode functions
+ * time every successful call and record it in the SML_Latency attached
+ * with sml_context_set_latency(). Without SMLLIB_LATENCY the
+ * instrumentation compiles to nothing; the histogram functions stay
+ * available for the caller's own measurements.
+ *
+ * Times are TSC cycles on x86 with GCC/Clang, nanoseconds of
+ * CLOCK_MONOTONIC elsewhere (see sml_latency_unit()).
+ */
+
+#define SML_LATENCY_PARSE				0	/* sml_parse_message_binary() */
+#define SML_LATENCY_TRANSPORT_PARSE		1	/* sml_transport_parse_message() */
+#define SML_LATENCY_ENCODE				2	/* sml_encode_message_binary() */
+#define SML_LATENCY_TRANSPORT_ENCODE	3	/* sml_transport_encode_message() */
+#define SML_LATENCY_OPS					4
+
+/*
+ * Log-linear buckets: values below 8 exactly, above that 8 buckets per
+ * power of two (at most 12.5% relative error) up to 2^40.
+ */
+#define SML_LATENCY_SUB_BUCKETS			8
+#define SML_LATENCY_BUCKETS				(38 * SML_LATENCY_SUB_BUCKETS)
+
+typedef struct SML_Latency_Histogram {
+	uint32_t buckets[SML_LATENCY_BUCKETS];
+	uint32_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+} SML_Latency_Histogram;
+
+/* Indexed by SML_LATENCY_* and sml_messagebody_index() */
+typedef struct SML_Latency {
+	SML_Latency_Histogram histograms[SML_LATENCY_OPS][SML_MESSAGEBODY_TYPES];
+} SML_Latency;
+
+/* Public methods */
+
+void sml_latency_init(SML_Latency* latency);
+
+/* Lets the parser and encoder of the context record into latency (NULL: off) */
+void sml_context_set_latency(SML_Context* context, SML_Latency* latency);
+
+SML_Latency_Histogram* sml_latency_histogram(SML_Latency* latency, uint32_t op, uint32_t choiceTag);
+
+void sml_latency_record(SML_Latency_Histogram* histogram, uint64_t value);
+
+/**
+ * Value below which the given fraction (0.0 - 1.0) of the recorded values
+ * lies: the upper bound of the bucket, at most the maximum. 0 if empty.
+ */
+uint64_t sml_latency_percentile(const SML_Latency_Histogram* histogram, double fraction);
+
+#ifndef SMLLIB_FREESTANDING
+/* Writes count, min, p50, p90, p99, p99.9 and max of every non-empty histogram (not in SMLLIB_FREESTANDING builds) */
+void sml_latency_report(FILE* out, const SML_Latency* latency);
+#endif
+
+/* "cycles" or "ns" */
+const char* sml_latency_unit(void);
+
+/* Private methods */
+
+uint32_t p_sml_latency_bucket(uint64_t value);
+
+uint64_t p_sml_latency_bucket_limit(uint32_t bucket);
+
+#ifdef SMLLIB_LATENCY
+	uint64_t p_sml_latency_now(void);
+
+	void p_sml_latency_record(uint32_t op, uint32_t choiceTag, uint64_t start);
+
+	/* Use without trailing semicolon, among the declarations */
+	#define SML_LATENCY_DECLARE(start) uint64_t start;
+	#define SML_LATENCY_START(start) \
+		((start) = (p_sml_context->latency != NULL) ? p_sml_latency_now() : 0)
+	/* Outermost call only, an encoder nested in the transport encoder is not recorded */
+	#define SML_LATENCY_RECORD(op, choiceTag, start) \
+		((p_sml_context->latency != NULL && p_sml_context->messageDepth == 0) ? \
+			p_sml_latency_record(op, choiceTag, start) : (void)0)
+#else
+	#define SML_LATENCY_DECLARE(start)
+	#define SML_LATENCY_START(start) ((void)0)
+	#define SML_LATENCY_RECORD(op, choiceTag, start) ((void)0)
+#endif
+
+#endif /* SMLLIB_LATENCY_H_ */
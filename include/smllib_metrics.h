@@ -0,0 +1,92 @@
+/**
+ * File name: smllib_metrics.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_METRICS_H_
+#define SMLLIB_METRICS_H_
+
+#include <stdlib.h>
+#ifndef SMLLIB_FREESTANDING
+	#include <stdio.h>
+#endif
+#include "smllib_types.h"
+#include "smllib_context.h"
+
+/*
+ * Operation counters of a context (SML_Context.metrics), updated by the
+ * parsers, the encoders and crc16_ccitt(). The counters are plain
+ * increments; build with SMLLIB_ATOMIC_METRICS (CMake ATOMIC_METRICS) when
+ * several threads share a context, or with SMLLIB_NO_METRICS to drop them.
+ *
+ * The allocation statistics are never atomic: a snapshot taken while
+ * another thread allocates from the context may hold torn values.
+ *
+ * The Prometheus writers use stdio and are left out of SMLLIB_FREESTANDING
+ * builds.
+ */
+
+typedef struct SML_Metrics_Snapshot {
+	SML_Metrics counters;
+	SML_Alloc_Counter allocations;	/* allocStats.total of the context, copied without atomics */
+} SML_Metrics_Snapshot;
+
+/* Public methods */
+
+/* Consistent per counter (not across counters) while other threads update the context, see above for allocations */
+void sml_metrics_snapshot(const SML_Context* context, SML_Metrics_Snapshot* snapshot);
+
+void sml_metrics_reset(SML_Context* context);
+
+#ifndef SMLLIB_FREESTANDING
+
+/**
+ * Writes the snapshots in Prometheus text exposition format, one sample per
+ * snapshot and metric labelled link="<links[i]>". Returns SML_ENCODE_ERROR
+ * if writing fails.
+ */
+uint8_t sml_metrics_write_prometheus(FILE* out, const SML_Metrics_Snapshot* snapshots, const char* const* links, uint32_t count);
+
+/**
+ * Same as sml_metrics_write_prometheus(), into the file at path. The file
+ * is written under path.tmp and renamed, so a scraper (node_exporter
+ * textfile collector) never reads a partial file.
+ */
+uint8_t sml_metrics_export_prometheus(const char* path, const SML_Metrics_Snapshot* snapshots, const char* const* links, uint32_t count);
+
+#endif /* SMLLIB_FREESTANDING */
+
+/* Private methods */
+
+/* Buffer size for p_sml_metrics_format_uint64(), 20 digits and the terminator */
+#define SML_METRICS_UINT64_DIGITS 21
+
+/* uint64_t in decimal without the C99 printf length modifiers, returns the start in digits */
+const char* p_sml_metrics_format_uint64(char* digits, uint64_t value);
+
+#if defined(SMLLIB_NO_METRICS)
+	#define SML_METRIC_ADD(counter, amount) ((void)0)
+#elif defined(SMLLIB_ATOMIC_METRICS)
+	#define SML_METRIC_ADD(counter, amount) ((void)__atomic_fetch_add(&p_sml_context->metrics.counter, (uint64_t)(amount), __ATOMIC_RELAXED))
+#else
+	#define SML_METRIC_ADD(counter, amount) ((void)(p_sml_context->metrics.counter += (uint64_t)(amount)))
+#endif
+
+#endif /* SMLLIB_METRICS_H_ */
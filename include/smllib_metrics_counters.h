@@ -0,0 +1,51 @@
+/**
+ * File name: smllib_metrics_counters.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Per context operation counters (see smllib_metrics.h). Each line expands
+ * the macro SML_METRIC(field, name, help), which the includer defines; this
+ * file therefore has no include guard. name is the Prometheus metric name.
+ */
+
+/* Parser */
+SML_METRIC(messagesParsed, "sml_messages_parsed_total", "SML messages parsed successfully")
+SML_METRIC(messageBytesParsed, "sml_message_bytes_parsed_total", "Bytes of successfully parsed SML messages (unescaped)")
+SML_METRIC(parseErrors, "sml_parse_errors_total", "Messages or transport frames that failed to parse")
+SML_METRIC(framesParsed, "sml_frames_parsed_total", "Transport frames with valid framing and CRC16")
+SML_METRIC(frameBytesParsed, "sml_frame_bytes_parsed_total", "Bytes of transport frames with valid framing and CRC16")
+SML_METRIC(escapesParsed, "sml_escapes_parsed_total", "Escape sequences removed by the transport parser")
+SML_METRIC(messageCrcFailures, "sml_message_crc_failures_total", "Messages with a wrong CRC16")
+SML_METRIC(frameCrcFailures, "sml_frame_crc_failures_total", "Transport frames with a wrong CRC16")
+SML_METRIC(framesSkipped, "sml_frames_skipped_total", "Transport frames skipped by the tolerant file parser")
+SML_METRIC(resyncBytes, "sml_resync_bytes_total", "Bytes skipped by the tolerant file parser, skipped frames included")
+
+/* Encoder */
+SML_METRIC(messagesEncoded, "sml_messages_encoded_total", "SML messages encoded successfully")
+SML_METRIC(messageBytesEncoded, "sml_message_bytes_encoded_total", "Bytes of encoded SML messages (unescaped)")
+SML_METRIC(encodeErrors, "sml_encode_errors_total", "Messages or transport frames that failed to encode")
+SML_METRIC(framesEncoded, "sml_frames_encoded_total", "Transport frames encoded successfully")
+SML_METRIC(frameBytesEncoded, "sml_frame_bytes_encoded_total", "Bytes of encoded transport frames")
+SML_METRIC(escapesEncoded, "sml_escapes_encoded_total", "Escape sequences inserted by the transport encoder")
+
+/* crc16_ccitt() */
+SML_METRIC(crcCalls, "sml_crc_calls_total", "CRC16 computations")
+SML_METRIC(crcBytes, "sml_crc_bytes_total", "Bytes run through the CRC16")
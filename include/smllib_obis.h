@@ -0,0 +1,58 @@
+/**
+ * File name: smllib_obis.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_OBIS_H_
+#define SMLLIB_OBIS_H_
+
+#include "smllib_types.h"
+
+/*** Well-known OBIS codes ***/
+
+/* Dense IDs of the codes in smllib_obis_codes.h, usable as array index */
+#define SML_OBIS_CODE(name, text, a, b, c, d, e, f) SML_OBIS_##name,
+typedef enum SML_Obis_Id {
+	SML_OBIS_NONE = 0,		/* no OBIS code (objName not 6 bytes long) */
+	SML_OBIS_UNKNOWN,		/* 6 byte code that is not in the table */
+	#include "smllib_obis_codes.h"
+	SML_OBIS_COUNT
+} SML_Obis_Id;
+#undef SML_OBIS_CODE
+
+/* Public methods */
+
+/* SML_OBIS_* ID of a 6 byte code, SML_OBIS_UNKNOWN if it is not well known */
+uint16_t sml_obis_lookup(const uint8_t* code);
+
+/* Fills obis from a code, computing its ID */
+void sml_obis_set(SML_Obis* obis, const uint8_t* code);
+
+/* Code of a well-known ID, NULL for SML_OBIS_NONE/UNKNOWN */
+const uint8_t* sml_obis_code(uint16_t id);
+
+/* Textual form ("1-0:1.8.0*255") of a well-known ID, NULL otherwise */
+const char* sml_obis_text(uint16_t id);
+
+/* Private methods */
+
+uint32_t p_sml_obis_hash(const uint8_t* code, uint32_t seed);
+
+#endif /* SMLLIB_OBIS_H_ */
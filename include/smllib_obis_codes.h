@@ -0,0 +1,58 @@
+/**
+ * File name: smllib_obis_codes.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Well-known OBIS codes (IEC 62056-61). Each line expands the macro
+ * SML_OBIS_CODE(name, text, A, B, C, D, E, F), which the includer defines;
+ * this file therefore has no include guard. The order defines the
+ * SML_OBIS_* IDs. After editing, regenerate smllib_obis_table.h with the
+ * "obis_table" build target.
+ */
+
+/* Active energy, total and per tariff */
+SML_OBIS_CODE(ENERGY_IMPORT, "1-0:1.8.0*255", 0x01, 0x00, 0x01, 0x08, 0x00, 0xFF)
+SML_OBIS_CODE(ENERGY_IMPORT_T1, "1-0:1.8.1*255", 0x01, 0x00, 0x01, 0x08, 0x01, 0xFF)
+SML_OBIS_CODE(ENERGY_IMPORT_T2, "1-0:1.8.2*255", 0x01, 0x00, 0x01, 0x08, 0x02, 0xFF)
+SML_OBIS_CODE(ENERGY_EXPORT, "1-0:2.8.0*255", 0x01, 0x00, 0x02, 0x08, 0x00, 0xFF)
+SML_OBIS_CODE(ENERGY_EXPORT_T1, "1-0:2.8.1*255", 0x01, 0x00, 0x02, 0x08, 0x01, 0xFF)
+SML_OBIS_CODE(ENERGY_EXPORT_T2, "1-0:2.8.2*255", 0x01, 0x00, 0x02, 0x08, 0x02, 0xFF)
+
+/* Instantaneous active power, total and per phase */
+SML_OBIS_CODE(POWER, "1-0:16.7.0*255", 0x01, 0x00, 0x10, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(POWER_L1, "1-0:36.7.0*255", 0x01, 0x00, 0x24, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(POWER_L2, "1-0:56.7.0*255", 0x01, 0x00, 0x38, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(POWER_L3, "1-0:76.7.0*255", 0x01, 0x00, 0x4C, 0x07, 0x00, 0xFF)
+
+/* Instantaneous voltage and current per phase, frequency */
+SML_OBIS_CODE(VOLTAGE_L1, "1-0:32.7.0*255", 0x01, 0x00, 0x20, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(VOLTAGE_L2, "1-0:52.7.0*255", 0x01, 0x00, 0x34, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(VOLTAGE_L3, "1-0:72.7.0*255", 0x01, 0x00, 0x48, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(CURRENT_L1, "1-0:31.7.0*255", 0x01, 0x00, 0x1F, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(CURRENT_L2, "1-0:51.7.0*255", 0x01, 0x00, 0x33, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(CURRENT_L3, "1-0:71.7.0*255", 0x01, 0x00, 0x47, 0x07, 0x00, 0xFF)
+SML_OBIS_CODE(FREQUENCY, "1-0:14.7.0*255", 0x01, 0x00, 0x0E, 0x07, 0x00, 0xFF)
+
+/* Device identification */
+SML_OBIS_CODE(DEVICE_ID, "1-0:0.0.9*255", 0x01, 0x00, 0x00, 0x00, 0x09, 0xFF)
+SML_OBIS_CODE(SERIAL_NUMBER, "1-0:96.1.0*255", 0x01, 0x00, 0x60, 0x01, 0x00, 0xFF)
+SML_OBIS_CODE(MANUFACTURER, "129-129:199.130.3*255", 0x81, 0x81, 0xC7, 0x82, 0x03, 0xFF)
+SML_OBIS_CODE(PUBLIC_KEY, "129-129:199.130.5*255", 0x81, 0x81, 0xC7, 0x82, 0x05, 0xFF)
@@ -0,0 +1,16 @@
+/* Generated by Gen_Obis_Table from smllib_obis_codes.h, do not edit */
+#ifndef SMLLIB_OBIS_TABLE_H_
+#define SMLLIB_OBIS_TABLE_H_
+
+#define SML_OBIS_HASH_SEED 0x00000054UL
+#define SML_OBIS_HASH_SIZE 64
+
+/* SML_OBIS_* ID per hash slot, SML_OBIS_NONE for empty slots */
+static const uint8_t p_sml_obis_slots[SML_OBIS_HASH_SIZE] = {
+	  0,  0,  0,  6,  0,  0,  4, 10, 16,  8,  0,  0,  0,  0,  3,  0,
+	  0,  5, 11,  0,  0,  0, 18,  0, 15,  0,  0,  0,  7,  0, 14,  0,
+	  0, 13,  0,  0,  0, 21, 20,  0,  0,  0,  0,  0, 19,  0,  0,  2,
+	  0, 12, 22,  0,  0,  0,  0,  0,  0,  0,  0,  0,  9, 17,  0,  0
+};
+
+#endif /* SMLLIB_OBIS_TABLE_H_ */
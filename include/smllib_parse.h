@@ -35,12 +35,54 @@ uint8_t sml_parse_message_binary(const unsigned char* smlBinary, uint32_t* offse
 
 uint8_t sml_transport_parse_file(const unsigned char* smlBinary, uint32_t msgCount, SML_File* file);
 
+uint8_t sml_transport_parse_file_tolerant(const unsigned char* smlBinary, uint32_t length, SML_File* file, SML_Frame_Error* errors, uint32_t errorSpace, uint32_t* errorCount);
+
 uint8_t sml_transport_parse_message(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message);
 
+/**
+ * Parses a GetProfilePack_Res message without materializing its period_List.
+ * header is called once the fields in front of period_List are parsed
+ * (period_List.listSize is set, period_List_Entry is NULL), period then once
+ * per decoded row. A row and its values are released when period returns,
+ * so memory does not grow with the period count. rawdata, profileSignature
+ * and the crc follow the periods: rows are delivered before the message crc
+ * is checked. Callbacks return SML_PARSE_OK to continue; header and period
+ * may be NULL. The recorded latency includes the time spent in the callbacks.
+ */
+uint8_t sml_parse_profilepack_stream(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user);
+
+/* As above for a transport frame (the unescaped message is buffered) */
+uint8_t sml_transport_parse_profilepack_stream(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user);
+
 void sml_parser_free(void);
 
 /* Private methods */
 
+uint8_t p_sml_parse_message(const unsigned char* smlBinary, uint32_t* offset, SML_Message* smlMessage);
+
+/* Final return code of a public parse call (SML_PARSE_NOMEM after a failed allocation), counts errors */
+uint8_t p_sml_parse_result(uint8_t retValue);
+
+uint8_t p_sml_transport_parse_message(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message);
+
+/* Checks crc16 over smlBinary[offsetPrev..*offset) and endOfSmlMessage */
+uint8_t p_sml_parse_message_crc(const unsigned char* smlBinary, uint32_t* offset, uint32_t offsetPrev, SML_Message* smlMessage);
+
+/* Offset of the next start sequence at or after offset, length if there is none */
+uint32_t p_sml_transport_find_start(const unsigned char* smlBinary, uint32_t offset, uint32_t length);
+
+/* Checks and unescapes the frame at offset into a parser-owned buffer */
+uint8_t p_sml_transport_unescape(const unsigned char* smlBinary, uint32_t offset, unsigned char** message, uint32_t* frameLength);
+
+uint8_t p_sml_parse_profilepack_stream(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user);
+
+uint8_t p_sml_parse_profile_periods(const unsigned char* smlBinary, uint32_t* offset, SML_GetProfilePack_Res* response, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user);
+
+/* Parser allocation position and rollback to it (pool or pointer list) */
+size_t p_sml_parser_mark(void);
+
+void p_sml_parser_release(size_t mark);
+
 uint8_t p_sml_parse_open_request(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Req* request);
 
 uint8_t p_sml_parse_open_response(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Res* response);
@@ -79,6 +121,18 @@ uint8_t p_sml_parse_tree_optional(const unsigned char* smlBinary, uint32_t* offs
 
 uint8_t p_sml_parse_list_of_tree_optional(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_Tree** list);
 
+/* Allocates the child list and its (empty) entries without parsing them */
+uint8_t p_sml_parse_list_of_tree_header(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_Tree** list);
+
+/* Parses an SML_Tree into one block of preorder nodes and values */
+uint8_t p_sml_parse_flat_tree(const unsigned char* smlBinary, uint32_t* offset, SML_Flat_Tree* tree);
+
+/* Counts the nodes and values of the SML_Tree at offset without parsing it */
+uint8_t p_sml_scan_tree(const unsigned char* smlBinary, uint32_t offset, uint32_t* nodeCount, uint32_t* valueCount);
+
+/* Steps over one element of any type, lists included */
+uint8_t p_sml_skip_element(const unsigned char* smlBinary, uint32_t* offset);
+
 uint8_t p_sml_parse_list_of_objreqentry_optional(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_ObjReqEntry** list);
 
 uint8_t p_sml_parse_list_of_periodentry(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_PeriodEntry* list);
@@ -97,6 +151,8 @@ uint8_t p_sml_parse_objperiodentry(const unsigned char* smlBinary, uint32_t* off
 
 uint8_t p_sml_parse_procparvalue_optional(const unsigned char* smlBinary, uint32_t* offset, SML_ProcParValue** value);
 
+uint8_t p_sml_parse_procparvalue(const unsigned char* smlBinary, uint32_t* offset, SML_ProcParValue* value);
+
 uint8_t p_sml_parse_periodentry(const unsigned char* smlBinary, uint32_t* offset, SML_PeriodEntry* entry);
 
 uint8_t p_sml_parse_tupelentry(const unsigned char* smlBinary, uint32_t* offset, SML_TupelEntry* entry);
@@ -105,15 +161,37 @@ uint8_t p_sml_parse_list(const unsigned char* smlBinary, uint32_t* offset, SML_L
 
 uint8_t p_sml_parse_listentry(const unsigned char* smlBinary, uint32_t* offset, SML_ListEntry* entry);
 
+uint8_t p_sml_parse_list_compact(const unsigned char* smlBinary, uint32_t* offset, SML_List_Compact* list);
+
+uint8_t p_sml_parse_listentry_compact(const unsigned char* smlBinary, uint32_t* offset, SML_ListEntry_Compact* entry);
+
+uint8_t p_sml_parse_open_request_compact(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Req_Compact* request);
+
+uint8_t p_sml_parse_open_response_compact(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Res_Compact* response);
+
+uint8_t p_sml_parse_getlist_response_compact(const unsigned char* smlBinary, uint32_t* offset, SML_GetList_Res_Compact* response);
+
+uint8_t p_sml_parse_getprocparameter_response_compact(const unsigned char* smlBinary, uint32_t* offset, SML_GetProcParameter_Res_Compact* response);
+
+uint8_t p_sml_parse_messagebody_compact(const unsigned char* smlBinary, uint32_t* offset, SML_MessageBody* messageBody);
+
 uint8_t p_sml_parse_value(const unsigned char* smlBinary, uint32_t* offset, SML_Value* value);
 
 uint8_t p_sml_parse_status_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Status** status);
 
+uint8_t p_sml_parse_status(const unsigned char* smlBinary, uint32_t* offset, SML_Status* status);
+
 uint8_t p_sml_parse_time(const unsigned char* smlBinary, uint32_t* offset, SML_Time* time);
 uint8_t p_sml_parse_time_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Time** time);
 
 uint8_t p_sml_parse_string(const unsigned char* smlBinary, uint32_t* offset, char** value);
 
+/* Like p_sml_parse_string(), but resolves to the context's intern table if set */
+uint8_t p_sml_parse_string_interned(const unsigned char* smlBinary, uint32_t* offset, char** value);
+
+/* Parses an objName, additionally filling obis if it is a 6 byte OBIS code */
+uint8_t p_sml_parse_objname(const unsigned char* smlBinary, uint32_t* offset, char** objName, SML_Obis* obis);
+
 uint8_t p_sml_parse_boolean(const unsigned char* smlBinary, uint32_t* offset, SML_Boolean* value);
 uint8_t p_sml_parse_boolean_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Boolean** value);
 
@@ -141,16 +219,20 @@ uint8_t p_sml_parse_unsigned16_optional(const unsigned char* smlBinary, uint32_t
 uint8_t p_sml_parse_unsigned32_optional(const unsigned char* smlBinary, uint32_t* offset, uint32_t** value);
 uint8_t p_sml_parse_unsigned64_optional(const unsigned char* smlBinary, uint32_t* offset, uint64_t** value);
 
+uint64_t p_sml_read_number(const unsigned char* data, uint32_t length, TL_FieldType type);
+
+void p_sml_store_number(void* value, uint32_t size, uint64_t number);
+
+/* Skips an omitted optional field and returns TRUE, FALSE if a value follows */
+SML_Boolean p_sml_parse_absent(const unsigned char* smlBinary, uint32_t* offset);
+
 uint8_t p_sml_parse_tlfield(const unsigned char* smlBinary, uint32_t* offset, TL_FieldType* tl_type, uint32_t* tl_value);
 
 uint8_t p_sml_parse_listsize(const unsigned char* smlBinary, uint32_t* offset, uint32_t listSize);
 
 void p_sml_add_pointer(void* ptr);
 
-/* Private fields */
-
-extern uint32_t p_sml_pointer_max;
-extern uint32_t p_sml_pointer_count;
-extern void** p_sml_pointer_list;
+/* Zeroed block released by sml_parser_free(), NULL with SML_ERROR_NOMEM set if it cannot be allocated or registered */
+void* p_sml_parser_calloc(size_t count, size_t size);
 
 #endif /* SMLLIB_PARSE_H_ */
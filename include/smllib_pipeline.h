@@ -0,0 +1,228 @@
+/**
+ * File name: smllib_pipeline.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_PIPELINE_H_
+#define SMLLIB_PIPELINE_H_
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "smllib_types.h"
+#include "smllib_context.h"
+#include "smllib_deframer.h"
+
+/*
+ * Multi-threaded frame pipeline (CMake PIPELINE, pthreads and GCC/Clang
+ * __atomic builtins): one reader thread deframes the links and submits
+ * complete transport frames, checking only the frame crc; parse workers
+ * validate the message and run sml_transport_parse_message() with a
+ * context of their own, exporter threads hand the messages to the export
+ * callback and recycle the frames.
+ *
+ *   reader --> worker input rings --> workers --> worker output rings
+ *          <-- exporter free rings <-- exporters <--
+ *
+ * The stages are joined by single-producer/single-consumer rings of frame
+ * pointers; no locks, and frames are never copied. A frame owns a buffer
+ * the deframer writes the frame into (see sml_deframer_exchange()) and a
+ * pool its message is parsed into, so the hot path allocates nothing.
+ * All memory is one block supplied by the caller, see
+ * sml_pipeline_memory_size().
+ *
+ * Frames with the same key go to the same worker, the worker to a fixed
+ * exporter: the frames of one link are exported in order.
+ */
+
+#ifndef SML_PIPELINE_MAX_WORKERS
+	#define SML_PIPELINE_MAX_WORKERS 16
+#endif
+
+/* Keeps the indices of producer and consumer on separate cache lines */
+#ifndef SML_CACHE_LINE
+	#define SML_CACHE_LINE 64
+#endif
+
+/*** Ring ***/
+
+/**
+ * Bounded single-producer/single-consumer queue of pointers. Each side
+ * keeps a copy of the other's index and only reloads it when the ring
+ * looks full or empty.
+ */
+typedef struct SML_Ring {
+	uint32_t head;			/* next slot written, producer */
+	uint32_t tailCache;		/* tail as last seen by the producer */
+	char producerPad[SML_CACHE_LINE - 2 * sizeof(uint32_t)];
+	uint32_t tail;			/* next slot read, consumer */
+	uint32_t headCache;		/* head as last seen by the consumer */
+	char consumerPad[SML_CACHE_LINE - 2 * sizeof(uint32_t)];
+	void** slots;
+	uint32_t mask;			/* capacity - 1 */
+} SML_Ring;
+
+/*** Pipeline ***/
+
+typedef struct SML_Pipeline_Frame {
+	unsigned char* data;	/* frameSize bytes, the transport frame at the start */
+	uint32_t length;		/* 0: no frame, recycled without export */
+	uint32_t key;			/* see sml_pipeline_submit() */
+	void* source;			/* the submitter's, e.g. the meter behind the link */
+	uint8_t result;			/* of validation and sml_transport_parse_message() */
+	SML_Message message;	/* lives in pool, valid if result is SML_PARSE_OK */
+	void* pool;				/* poolSize bytes */
+} SML_Pipeline_Frame;
+
+/**
+ * Called by an exporter thread for every parsed frame, in the order the
+ * frames of a key were submitted. The frame is recycled when it returns.
+ */
+typedef void (*SML_Pipeline_Export)(void* user, SML_Pipeline_Frame* frame);
+
+typedef struct SML_Pipeline_Config {
+	uint32_t workers;		/* 1 .. SML_PIPELINE_MAX_WORKERS */
+	uint32_t exporters;		/* 1 .. workers */
+	uint32_t frames;		/* power of two, more than the inputs in use */
+	uint32_t frameSize;		/* longest frame passed on */
+	uint32_t poolSize;		/* parser memory of one frame, see sml_context_pool_worst_case() */
+	SML_Pipeline_Export exportFrame;
+	void* user;
+} SML_Pipeline_Config;
+
+struct SML_Pipeline;
+
+typedef struct SML_Pipeline_Worker {
+	SML_Context context;	/* options may be set between sml_pipeline_init() and start, no intern table */
+	SML_Ring input;			/* reader -> worker */
+	SML_Ring output;		/* worker -> exporter */
+	struct SML_Pipeline* pipeline;
+	pthread_t thread;
+	uint64_t frames;
+	uint64_t parseErrors;
+} SML_Pipeline_Worker;
+
+typedef struct SML_Pipeline_Exporter {
+	SML_Ring free;			/* exporter -> reader */
+	struct SML_Pipeline* pipeline;
+	uint32_t index;
+	pthread_t thread;
+	uint64_t frames;
+} SML_Pipeline_Exporter;
+
+typedef struct SML_Pipeline {
+	SML_Pipeline_Config config;
+	SML_Pipeline_Worker workers[SML_PIPELINE_MAX_WORKERS];
+	SML_Pipeline_Exporter exporters[SML_PIPELINE_MAX_WORKERS];
+	SML_Pipeline_Frame* frames;
+	uint32_t nextFree;		/* free ring the reader looks at first */
+	uint32_t running;		/* threads started */
+	uint32_t stopping;		/* set by sml_pipeline_stop() */
+	uint32_t workersDone;
+	uint64_t submitted;
+} SML_Pipeline;
+
+/**
+ * Frame input of one link, for the reader thread: a deframer writing into
+ * the buffer of a pipeline frame it holds.
+ */
+typedef struct SML_Pipeline_Input {
+	SML_Deframer deframer;
+	SML_Pipeline_Frame* frame;	/* owns the deframer's buffer */
+	uint32_t key;
+	void* source;
+} SML_Pipeline_Input;
+
+/* Public methods */
+
+/* FALSE if the ring is full */
+SML_Boolean sml_ring_push(SML_Ring* ring, void* item);
+
+/* FALSE if the ring is empty */
+SML_Boolean sml_ring_pop(SML_Ring* ring, void** item);
+
+/* Bytes of the memory block of sml_pipeline_init(), 0 for an invalid config */
+size_t sml_pipeline_memory_size(const SML_Pipeline_Config* config);
+
+/**
+ * Lays out rings, frames, buffers and pools in memory and initializes the
+ * worker contexts. SML_PARSE_ERROR for an invalid config.
+ */
+uint8_t sml_pipeline_init(SML_Pipeline* pipeline, const SML_Pipeline_Config* config, void* memory);
+
+/**
+ * Starts the threads, SML_PARSE_ERROR if one cannot be created (none runs
+ * then) or a worker context has an intern table: every frame is parsed
+ * into its own pool (sml_context_set_pool()), which would drop a pool
+ * resident table, and the string IDs would differ between workers.
+ */
+uint8_t sml_pipeline_start(SML_Pipeline* pipeline);
+
+/**
+ * Lets the threads finish the frames submitted so far and joins them.
+ * Close the inputs first, the frames they hold are not exported.
+ */
+void sml_pipeline_stop(SML_Pipeline* pipeline);
+
+/*
+ * The following are for one reader thread only (the single producer of the
+ * worker input rings and single consumer of the free rings).
+ */
+
+/* Free frame, NULL if all are in use */
+SML_Pipeline_Frame* sml_pipeline_acquire(SML_Pipeline* pipeline);
+
+/* As above, waits for the exporters to recycle one */
+SML_Pipeline_Frame* sml_pipeline_take(SML_Pipeline* pipeline);
+
+/* Passes an acquired frame with data and length set to the worker of key */
+void sml_pipeline_submit(SML_Pipeline* pipeline, SML_Pipeline_Frame* frame, uint32_t key);
+
+/* Takes a frame for the input's deframer; the input holds it until closed */
+void sml_pipeline_input_init(SML_Pipeline* pipeline, SML_Pipeline_Input* input, uint32_t key, void* source);
+
+/* Feeds all bytes of data, returns the number of frames submitted */
+uint32_t sml_pipeline_input_feed(SML_Pipeline* pipeline, SML_Pipeline_Input* input, const unsigned char* data, uint32_t length);
+
+/**
+ * Submits the complete frames in the deframer, each swapping the
+ * deframer over to a new frame's buffer. For bytes read directly into
+ * sml_deframer_space(), returns the number of frames submitted.
+ */
+uint32_t sml_pipeline_input_flush(SML_Pipeline* pipeline, SML_Pipeline_Input* input);
+
+/* Gives the input's frame back, buffered bytes of an incomplete frame are lost */
+void sml_pipeline_input_close(SML_Pipeline* pipeline, SML_Pipeline_Input* input);
+
+/* Private methods */
+
+/* Size of the layout, assigns it to pipeline unless memory is NULL */
+size_t p_sml_pipeline_layout(SML_Pipeline* pipeline, const SML_Pipeline_Config* config, unsigned char* memory);
+
+void* p_sml_pipeline_worker(void* worker);
+
+void* p_sml_pipeline_exporter(void* exporter);
+
+/* Parses the frame into its pool with the worker's context */
+void p_sml_pipeline_parse(SML_Pipeline_Worker* worker, SML_Pipeline_Frame* frame);
+
+/* Backs off while a thread has nothing to do: spins, yields, then sleeps */
+void p_sml_pipeline_idle(uint32_t* idle);
+
+#endif /* SMLLIB_PIPELINE_H_ */
@@ -0,0 +1,114 @@
+/**
+ * File name: smllib_reader.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_READER_H_
+#define SMLLIB_READER_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+#include "smllib_deframer.h"
+
+/*
+ * Event loop over many meter links (CMake READER, Linux epoll): serial
+ * devices, ptys or sockets are read by one thread, every link feeds its
+ * own SML_Deframer and complete frames are handed to the callbacks. The
+ * reader allocates nothing, links and their buffers belong to the caller.
+ *
+ * Each ready link gets one read() per sml_reader_poll(), so a busy link
+ * cannot starve the others. Messages are parsed with the current context;
+ * their memory is released when the message callback returns.
+ *
+ * A callback may remove any link, the rest of the poll skips it; the link
+ * must stay valid until sml_reader_poll() returns. Once a callback stops
+ * the reader no further frame is delivered in that poll, complete frames
+ * already read stay in the link's deframer until its next read.
+ */
+
+/* Ready links handled per sml_reader_poll() */
+#ifndef SML_READER_EVENTS
+	#define SML_READER_EVENTS 64
+#endif
+
+typedef struct SML_Link SML_Link;
+
+/* Valid transport frame of link, in the link's buffer */
+typedef uint8_t (*SML_Reader_Frame_Callback)(void* user, SML_Link* link, const unsigned char* frame, uint32_t length);
+
+/* The frame parsed */
+typedef uint8_t (*SML_Reader_Message_Callback)(void* user, SML_Link* link, SML_Message* message);
+
+/* End of file, hang up or read error; the link has left the reader */
+typedef void (*SML_Reader_Closed_Callback)(void* user, SML_Link* link);
+
+struct SML_Link {
+	SML_Deframer deframer;
+	int fd;
+	void* user;				/* the caller's, e.g. the meter behind the link */
+	uint64_t bytes;
+	uint64_t parseErrors;	/* frames that validated but did not parse */
+	SML_Boolean open;
+};
+
+typedef struct SML_Reader {
+	int epollFd;
+	uint32_t links;
+	SML_Reader_Frame_Callback frame;		/* may be NULL */
+	SML_Reader_Message_Callback message;	/* may be NULL, no parsing then */
+	SML_Reader_Closed_Callback closed;		/* may be NULL */
+	void* user;
+	SML_Boolean stop;		/* a callback of the last poll did not return SML_PARSE_OK */
+} SML_Reader;
+
+/* Public methods */
+
+/* SML_PARSE_ERROR if no epoll instance can be created (errno) */
+uint8_t sml_reader_init(SML_Reader* reader, SML_Reader_Frame_Callback frame, SML_Reader_Message_Callback message, SML_Reader_Closed_Callback closed, void* user);
+
+void sml_reader_close(SML_Reader* reader);
+
+/* Prepares a link over fd with the given frame buffer */
+void sml_link_init(SML_Link* link, int fd, unsigned char* buffer, uint32_t size, void* user);
+
+/* Switches fd to non-blocking mode and watches it; SML_PARSE_ERROR with errno */
+uint8_t sml_reader_add(SML_Reader* reader, SML_Link* link);
+
+/* Stops watching the link, fd stays open */
+void sml_reader_remove(SML_Reader* reader, SML_Link* link);
+
+/**
+ * Waits up to timeout milliseconds (-1: no limit) for data and delivers
+ * the frames it completes. Returns the number of frames, -1 if epoll
+ * fails.
+ */
+int sml_reader_poll(SML_Reader* reader, int timeout);
+
+/* Polls until no link is left or a callback stops the reader */
+uint8_t sml_reader_run(SML_Reader* reader);
+
+/* Private methods */
+
+/* One read() of the link, returns the frames delivered */
+uint32_t p_sml_reader_service(SML_Reader* reader, SML_Link* link);
+
+uint32_t p_sml_reader_deliver(SML_Reader* reader, SML_Link* link);
+
+#endif /* SMLLIB_READER_H_ */
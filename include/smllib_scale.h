@@ -0,0 +1,89 @@
+/**
+ * File name: smllib_scale.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_SCALE_H_
+#define SMLLIB_SCALE_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+
+/*** Scaling of readings ***/
+
+/*
+ * A reading is raw * 10^scaler (SML_ListEntry.scaler,
+ * SML_ProfObjHeaderEntry.scaler). The kernels below convert whole arrays
+ * with precomputed powers of ten; the column variants use one scaler for all
+ * values and look its power up once instead of per value. Where the compiler
+ * targets AVX2, SSE2 or aarch64 NEON they convert in SIMD lanes (fixed point:
+ * AVX2 and NEON, multiplications only) and leave the remainder to the scalar
+ * loops; results are bit-identical either way.
+ */
+
+#define SML_SCALE_MAX_POW10 128		/* 10^-128 for scaler -128 */
+
+/* Public methods */
+
+/* out[i] = raw[i] * 10^scaler[i] */
+void sml_scale_double(const int64_t* raw, const int8_t* scaler, uint32_t count, double* out);
+
+/* out[i] = raw[i] * 10^scaler */
+void sml_scale_column_double(const int64_t* raw, int8_t scaler, uint32_t count, double* out);
+
+/**
+ * Fixed point in units of 10^target: out[i] = raw[i] * 10^(scaler[i] - target),
+ * rounded half away from zero when digits are dropped and saturated to the
+ * int64_t range on overflow. Returns the number of saturated values.
+ */
+uint32_t sml_scale_fixed(const int64_t* raw, const int8_t* scaler, int8_t target, uint32_t count, int64_t* out);
+
+/* As sml_scale_fixed() with one scaler for all values */
+uint32_t sml_scale_column_fixed(const int64_t* raw, int8_t scaler, int8_t target, uint32_t count, int64_t* out);
+
+/* Integer value as int64_t (Unsigned64 saturates), FALSE for boolean/string values */
+SML_Boolean sml_value_raw(const SML_Value* value, int64_t* raw);
+
+/**
+ * Gathers the values of a GetList_Res list for the kernels above. Entries
+ * without scaler get 0, non-integer values raw 0; unit may be NULL (absent
+ * units are 0). Returns the number of integer values.
+ */
+uint32_t sml_list_raw(const SML_List* list, int64_t* raw, int8_t* scaler, SML_Unit* unit);
+
+uint32_t sml_list_compact_raw(const SML_List_Compact* list, int64_t* raw, int8_t* scaler, SML_Unit* unit);
+
+/* Gathers value column of every period (scaler and unit are in header_List) */
+uint32_t sml_profile_column_raw(const List_of_SML_ProfObjPeriodEntry* periods, uint32_t column, int64_t* raw);
+
+/* Private methods */
+
+/* Scalar loops of the column kernels, also their tail after the SIMD lanes */
+void p_sml_scale_column_double_scalar(const int64_t* raw, int8_t scaler, uint32_t count, double* out);
+
+uint32_t p_sml_scale_column_fixed_scalar(const int64_t* raw, int8_t scaler, int8_t target, uint32_t count, int64_t* out);
+
+int64_t p_sml_scale_fixed_value(int64_t raw, int diff, uint32_t* saturated);
+
+/* Private fields */
+
+extern const double p_sml_pow10_double[SML_SCALE_MAX_POW10 + 1];
+
+#endif /* SMLLIB_SCALE_H_ */
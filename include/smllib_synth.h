@@ -0,0 +1,75 @@
+/**
+ * File name: smllib_synth.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_SYNTH_H_
+#define SMLLIB_SYNTH_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+
+/*
+ * Synthetic SML_Message payloads for benchmarks and load tests (host tools,
+ * not part of the library). All data comes from a seeded PRNG, so the same
+ * seed always gives the same messages. Memory is owned by the SML_Synth.
+ */
+
+/* Message body types the library can encode (SetProcParameter_Res has no body) */
+#define SML_SYNTH_TYPE_COUNT 14
+
+/* Default fanout of synthetic parameter trees */
+#define SML_SYNTH_TREE_FANOUT 4
+
+typedef struct SML_Synth {
+	uint32_t state;		/* xorshift32 */
+	uint32_t treeFanout;	/* children per tree node, at least 2 keeps trees shallow */
+	uint32_t escapeRate;	/* per mille of octet strings and counters holding 1B1B1B1B */
+	void** blocks;
+	uint32_t blockCount;
+	uint32_t blockMax;
+} SML_Synth;
+
+extern const uint32_t sml_synth_types[SML_SYNTH_TYPE_COUNT];
+
+/* Seeds synth with SML_SYNTH_TREE_FANOUT and no escape sequences */
+void sml_synth_init(SML_Synth* synth, uint32_t seed);
+
+/* Frees every message built with synth, the PRNG state is kept */
+void sml_synth_free(SML_Synth* synth);
+
+uint32_t sml_synth_random(SML_Synth* synth);
+
+/* Zeroed block owned by synth */
+void* sml_synth_alloc(SML_Synth* synth, size_t size);
+
+/**
+ * Builds a message of the given body type. size is the number of list
+ * entries, periods, tree nodes or path entries of the type's variable part
+ * (see sml_synth_is_sized()). Returns NULL for unknown types.
+ */
+SML_Message* sml_synth_message(SML_Synth* synth, uint32_t choiceTag, uint32_t size);
+
+/* FALSE if the type has no variable part and ignores size */
+SML_Boolean sml_synth_is_sized(uint32_t choiceTag);
+
+const char* sml_synth_type_name(uint32_t choiceTag);
+
+#endif /* SMLLIB_SYNTH_H_ */
@@ -33,4 +33,7 @@ int sml_transport_msg_test(SML_Message* message);
 
 int sml_transport_file_test(SML_File* file);
 
+/* Heap copy of an encoding that outlives sml_parser_free() on a pool, frees result; NULL on error */
+unsigned char* sml_test_copy_result(SML_Encode_Binary_Result result, uint32_t* length);
+
 #endif /* SMLLIB_TEST_H_ */
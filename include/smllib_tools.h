@@ -27,6 +27,9 @@
 
 uint16_t crc16_ccitt(const unsigned char* data, uint32_t length);
 
+/* Continues a crc16_ccitt() over further data (start with crc = 0xFFFF) */
+uint16_t p_sml_crc16_update(uint16_t crc, const unsigned char* data, uint32_t length);
+
 SML_Boolean bigendian_check(void);
 
 void endian_swap16(uint16_t* x);
@@ -35,16 +38,42 @@ void endian_swap32(uint32_t* x);
 
 void endian_swap64(uint64_t* x);
 
-int memcmp(const void *s1, const void *s2, size_t n);
+/*
+ * Non-recursive preorder walk over an SML_Tree: starts with depth = 0 and
+ * node = root, returns the node following node (descending into its
+ * child_List first) or NULL once the walk is complete or walk->overflow is set.
+ */
+SML_Tree* p_sml_tree_next(SML_Tree_Walk* walk, SML_Tree* node);
+
+/*
+ * String/memory primitives used by the library. Hosted builds map them to the
+ * (usually vectorized) C library routines; freestanding builds
+ * (SMLLIB_FREESTANDING, e.g. AVR) use the portable fallbacks in smllib_tools.c.
+ */
+#ifdef SMLLIB_FREESTANDING
+	int p_sml_memcmp(const void *s1, const void *s2, size_t n);
+
+	void* p_sml_memcpy(void *dst, const void *src, size_t len);
+
+	void* p_sml_memmove(void *dst, const void *src, size_t len);
 
-void* memcpy(void *dst, const void *src, size_t len);
+	void* p_sml_memset(void *dst, int c, size_t len);
 
-void* memmove(void *dst, const void *src, size_t len);
+	char* p_sml_strcpy(char *dest, const char *src);
 
-char* strcpy(char *dest, const char *src);
+	int p_sml_strcmp(const char *s1, const char *s2);
 
-size_t strlen(const char *str);
+	size_t p_sml_strlen(const char *str);
+#else
+	#include <string.h>
 
-void printBinaryResult(const char* field, SML_Encode_Binary_Result* result);
+	#define p_sml_memcmp memcmp
+	#define p_sml_memcpy memcpy
+	#define p_sml_memmove memmove
+	#define p_sml_memset memset
+	#define p_sml_strcpy strcpy
+	#define p_sml_strcmp strcmp
+	#define p_sml_strlen strlen
+#endif
 
 #endif /* SMLLIB_TOOLS_H_ */
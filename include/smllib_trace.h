@@ -0,0 +1,102 @@
+/**
+ * File name: smllib_trace.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_TRACE_H_
+#define SMLLIB_TRACE_H_
+
+#include "smllib_types.h"
+
+/*** Trace levels ***/
+
+/*
+ * The library is compiled with SMLLIB_TRACE_LEVEL (CMake TRACE_LEVEL); trace
+ * points above that level are removed by the preprocessor. Events of the
+ * remaining points go to the sink of the active context, none if it is NULL.
+ */
+#define SML_TRACE_OFF 0
+#define SML_TRACE_ERROR 1		/* encoder errors, CRC mismatches */
+#define SML_TRACE_MESSAGE 2		/* one summary per parsed or encoded message */
+#define SML_TRACE_FIELDS 3		/* encoded bytes of every message field */
+
+#ifndef SMLLIB_TRACE_LEVEL
+	#define SMLLIB_TRACE_LEVEL SML_TRACE_OFF
+#endif
+
+/* SML_Trace_Event.type */
+#define SML_TRACE_BYTES 0
+#define SML_TRACE_NUMBER 1
+#define SML_TRACE_TEXT 2
+
+typedef struct SML_Trace_Event {
+	uint8_t level;				/* SML_TRACE_ERROR ... SML_TRACE_FIELDS */
+	uint8_t type;
+	const char* name;			/* field or message part */
+	const unsigned char* data;	/* SML_TRACE_BYTES and SML_TRACE_TEXT, not NUL terminated */
+	uint32_t length;
+	uint32_t number;			/* SML_TRACE_NUMBER */
+} SML_Trace_Event;
+
+/* Receives the events, data is only valid during the call */
+typedef void (*SML_Trace_Sink)(void* user, const SML_Trace_Event* event);
+
+/* Public methods */
+
+#ifndef SMLLIB_FREESTANDING
+/**
+ * Sink printing one line per event in the format of the former debug
+ * output. user is the FILE* to write to, NULL for stdout. Not in
+ * SMLLIB_FREESTANDING builds.
+ */
+void sml_trace_print_sink(void* user, const SML_Trace_Event* event);
+#endif
+
+/* Private methods */
+
+void p_sml_trace_bytes(uint8_t level, const char* name, const unsigned char* data, uint32_t length);
+
+void p_sml_trace_number(uint8_t level, const char* name, uint32_t number);
+
+void p_sml_trace_text(uint8_t level, const char* name, const char* text);
+
+/* Trace points, one set per level */
+
+#if SMLLIB_TRACE_LEVEL >= SML_TRACE_ERROR
+	#define SML_TRACE_ERROR_TEXT(name, text) p_sml_trace_text(SML_TRACE_ERROR, name, text)
+#else
+	#define SML_TRACE_ERROR_TEXT(name, text) ((void)0)
+#endif
+
+#if SMLLIB_TRACE_LEVEL >= SML_TRACE_MESSAGE
+	#define SML_TRACE_MESSAGE_BYTES(name, data, length) p_sml_trace_bytes(SML_TRACE_MESSAGE, name, data, length)
+	#define SML_TRACE_MESSAGE_NUMBER(name, number) p_sml_trace_number(SML_TRACE_MESSAGE, name, number)
+#else
+	#define SML_TRACE_MESSAGE_BYTES(name, data, length) ((void)0)
+	#define SML_TRACE_MESSAGE_NUMBER(name, number) ((void)0)
+#endif
+
+#if SMLLIB_TRACE_LEVEL >= SML_TRACE_FIELDS
+	#define SML_TRACE_FIELD(name, result) p_sml_trace_bytes(SML_TRACE_FIELDS, name, (result)->resultBinary, (result)->length)
+#else
+	#define SML_TRACE_FIELD(name, result) ((void)0)
+#endif
+
+#endif /* SMLLIB_TRACE_H_ */
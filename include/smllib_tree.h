@@ -0,0 +1,97 @@
+/**
+ * File name: smllib_tree.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_TREE_H_
+#define SMLLIB_TREE_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+#include "smllib_context.h"
+
+/*** Parameter tree lookup ***/
+
+#define SML_TREE_INDEX_ROOT ((uint32_t)-1)
+
+typedef struct SML_Tree_Index_Entry {
+	SML_Tree* node;
+	uint32_t hash;		/* of the parameterName path from the root to node */
+	uint32_t parent;	/* entry of the parent node, SML_TREE_INDEX_ROOT for the root */
+	uint32_t depth;		/* 0 for the root */
+} SML_Tree_Index_Entry;
+
+/**
+ * Hash index from the full parameterName path of every node of a (parsed)
+ * SML_Tree to the node. Built once in a single block allocated with the
+ * active context; the tree must stay unchanged while the index is used.
+ */
+typedef struct SML_Tree_Index {
+	SML_Tree_Index_Entry* entries;	/* preorder */
+	uint32_t count;
+	uint32_t* slots;				/* entry + 1, 0: free slot; power of two */
+	uint32_t slotMask;
+} SML_Tree_Index;
+
+/* Public methods */
+
+/**
+ * Linear lookup without allocation. The first path entry names the root,
+ * each further one a child of the node before. Returns the first matching
+ * node or NULL.
+ */
+SML_Tree* sml_tree_find(SML_Tree* root, const SML_TreePath* path);
+
+/* Indexes all nodes below root. Returns NULL if out of memory or if the tree
+ * nests deeper than SMLLIB_TREE_MAX_DEPTH. */
+SML_Tree_Index* sml_tree_index_create(SML_Tree* root);
+
+void sml_tree_index_destroy(SML_Tree_Index* index);
+
+/* Same result as sml_tree_find() on the indexed root, in constant time */
+SML_Tree* sml_tree_index_find(const SML_Tree_Index* index, const SML_TreePath* path);
+
+/**
+ * Flattens a linked tree into target (one block allocated with the active
+ * context, release with sml_flat_tree_free()). Names and value data are
+ * shared with the source. Returns SML_PARSE_ERROR if out of memory or if the
+ * tree nests deeper than SMLLIB_TREE_MAX_DEPTH.
+ */
+uint8_t sml_flat_tree_from_tree(SML_Flat_Tree* target, SML_Tree* root);
+
+/* Copies source into a new block with a single memcpy, see sml_flat_tree_from_tree() */
+uint8_t sml_flat_tree_copy(SML_Flat_Tree* target, const SML_Flat_Tree* source);
+
+/* Releases a block of sml_flat_tree_from_tree()/sml_flat_tree_copy() (not parsed trees) */
+void sml_flat_tree_free(SML_Flat_Tree* tree);
+
+/* sml_tree_find() on a flattened tree, returns the node index or SML_FLAT_NO_VALUE */
+uint32_t sml_flat_tree_find(const SML_Flat_Tree* tree, const SML_TreePath* path);
+
+/* Private methods */
+
+uint8_t p_sml_flat_tree_alloc(SML_Flat_Tree* tree, uint32_t nodeCount, uint32_t valueCount);
+
+
+uint32_t p_sml_tree_path_hash(uint32_t hash, const char* name);
+
+SML_Boolean p_sml_tree_name_equals(const char* parameterName, const char* name);
+
+#endif /* SMLLIB_TREE_H_ */
@@ -39,14 +39,12 @@ typedef int64_t intptr_t;
 typedef uint64_t uintptr_t;
 */
 
-/* Debug output */
-#define SMLLIB_DEBUG
-
 /*** Return codes ***/
 #define SML_ENCODE_ERROR 1
 #define SML_ENCODE_OK 0
 #define SML_PARSE_ERROR 1
 #define SML_PARSE_OK 0
+#define SML_PARSE_NOMEM 2 /* allocator or static pool exhausted */
 
 /*** MessageBody codes ***/
 #define SML_MESSAGEBODY_OPEN_REQUEST 0x00000100
@@ -105,6 +103,13 @@ typedef char* SML_Signature;
 typedef char* SML_ObjReqEntry;
 typedef uint32_t SML_Timestamp;
 
+/* Inline OBIS code of an objName, see smllib_obis.h */
+#define SML_OBIS_LENGTH 6
+typedef struct SML_Obis {
+	uint8_t code[SML_OBIS_LENGTH];
+	uint16_t id;	/* SML_OBIS_*, SML_OBIS_NONE (0) if objName is no OBIS code */
+} SML_Obis;
+
 /*** Basic SML structures ***/
 
 typedef struct SML_Time {
@@ -134,6 +139,12 @@ typedef struct SML_MessageBody {
 		struct SML_GetProcParameter_Res* getProcParameterResponse;
 		struct SML_SetProcParameter_Req* setProcParameterRequest;
 		struct SML_Attention_Res* attentionResponse;
+
+		/* Compact layout, see sml_context_set_compact_layout() */
+		struct SML_PublicOpen_Req_Compact* openRequestCompact;
+		struct SML_PublicOpen_Res_Compact* openResponseCompact;
+		struct SML_GetList_Res_Compact* getListResponseCompact;
+		struct SML_GetProcParameter_Res_Compact* getProcParameterResponseCompact;
 	} choiceValue;
 } SML_MessageBody;
 
@@ -153,6 +164,20 @@ typedef struct SML_File {
 	uint8_t version;
 } SML_File;
 
+/*** Tolerant transport file parsing ***/
+
+/* Reasons of SML_Frame_Error */
+#define SML_FRAME_ERROR_SYNC 1		/* bytes in front of the next frame start sequence */
+#define SML_FRAME_ERROR_INVALID 2	/* malformed or truncated frame, wrong CRC16 */
+#define SML_FRAME_ERROR_NOMEM 3		/* valid frame, allocator or static pool exhausted */
+
+/* Bytes offset up to offset+length were skipped for reason */
+typedef struct SML_Frame_Error {
+	uint32_t offset;
+	uint32_t length;
+	uint8_t reason;
+} SML_Frame_Error;
+
 /************* Containers and list structures *************/
 
 /* Entries */
@@ -184,7 +209,8 @@ typedef struct SML_Status {
 } SML_Status;
 
 typedef struct SML_ListEntry {
-	char* objName;
+	char* objName;					/* NULL: encode obis */
+	SML_Obis obis;					/* set by the parser */
 	SML_Status* status; 				/* optional */
 	SML_Time* valTime; 				/* optional */
 	SML_Unit* unit; 					/* optional */
@@ -212,13 +238,15 @@ typedef struct SML_ProfObjPeriodEntry {
 } SML_ProfObjPeriodEntry;
 
 typedef struct SML_ProfObjHeaderEntry {
-	char* objName;
+	char* objName;		/* NULL: encode obis */
+	SML_Obis obis;		/* set by the parser */
 	SML_Unit unit;
 	int8_t scaler;
 } SML_ProfObjHeaderEntry;
 
 typedef struct SML_PeriodEntry {
-	char* objName;
+	char* objName;		/* NULL: encode obis */
+	SML_Obis obis;		/* set by the parser */
 	SML_Unit unit;
 	int8_t scaler;
 	SML_Value value;
@@ -289,6 +317,24 @@ struct List_of_SML_Tree {
 	SML_Tree* tree_Entry;
 };
 
+/* Maximum nesting of child lists below an SML_Tree root, deeper trees fail
+ * to parse/encode. Each level costs one SML_Tree_Frame of walk stack. */
+#ifndef SMLLIB_TREE_MAX_DEPTH
+	#define SMLLIB_TREE_MAX_DEPTH 32
+#endif
+
+typedef struct SML_Tree_Frame {
+	List_of_SML_Tree* list;
+	uint32_t next;				/* index of the next child to visit */
+} SML_Tree_Frame;
+
+/* Explicit stack of a preorder SML_Tree walk, see p_sml_tree_next() */
+typedef struct SML_Tree_Walk {
+	SML_Tree_Frame stack[SMLLIB_TREE_MAX_DEPTH];
+	uint32_t depth;
+	SML_Boolean overflow;		/* set if the tree nests deeper than the stack */
+} SML_Tree_Walk;
+
 typedef struct SML_List {
 	uint32_t listSize;
 	SML_ListEntry* valListEntry;
@@ -437,11 +483,146 @@ typedef struct SML_Attention_Res {
 	SML_Tree* attentionDetails; /* optional */
 } SML_Attention_Res;
 
+/************* Compact structures *************/
+
+/*
+ * Alternative layout for the body types with optional scalars: the
+ * scalars are stored inline and a bit in "present" marks them as set,
+ * instead of one heap allocation per optional field. Optional strings
+ * stay NULL when absent. Parameter trees are flattened (SML_Flat_Tree).
+ */
+
+#define SML_LISTENTRY_STATUS 0x01
+#define SML_LISTENTRY_VALTIME 0x02
+#define SML_LISTENTRY_UNIT 0x04
+#define SML_LISTENTRY_SCALER 0x08
+
+typedef struct SML_ListEntry_Compact {
+	char* objName;					/* NULL: encode obis */
+	SML_Obis obis;					/* set by the parser */
+	SML_Value value;
+	SML_Status status;				/* SML_LISTENTRY_STATUS */
+	SML_Time valTime;				/* SML_LISTENTRY_VALTIME */
+	SML_Signature valueSignature;	/* optional */
+	SML_Unit unit;					/* SML_LISTENTRY_UNIT */
+	int8_t scaler;					/* SML_LISTENTRY_SCALER */
+	uint8_t present;
+} SML_ListEntry_Compact;
+
+typedef struct SML_List_Compact {
+	uint32_t listSize;
+	SML_ListEntry_Compact* valListEntry;
+} SML_List_Compact;
+
+#define SML_GETLISTRES_ACTSENSORTIME 0x01
+#define SML_GETLISTRES_ACTGATEWAYTIME 0x02
+
+typedef struct SML_GetList_Res_Compact {
+	char* clientId;					/* optional */
+	char* serverId;
+	char* listName;					/* optional */
+	SML_Time actSensorTime;			/* SML_GETLISTRES_ACTSENSORTIME */
+	SML_List_Compact valList;
+	SML_Signature listSignature;	/* optional */
+	SML_Time actGatewayTime;		/* SML_GETLISTRES_ACTGATEWAYTIME */
+	uint8_t present;
+} SML_GetList_Res_Compact;
+
+#define SML_OPENREQ_SMLVERSION 0x01
+
+typedef struct SML_PublicOpen_Req_Compact {
+	char* codepage; 	/* optional */
+	char* clientId;
+	char* reqFileId;
+	char* serverId; 	/* optional */
+	char* username; 	/* optional */
+	char* password; 	/* optional */
+	uint8_t smlVersion;	/* SML_OPENREQ_SMLVERSION */
+	uint8_t present;
+} SML_PublicOpen_Req_Compact;
+
+#define SML_OPENRES_REFTIME 0x01
+#define SML_OPENRES_SMLVERSION 0x02
+
+typedef struct SML_PublicOpen_Res_Compact {
+	char* codepage; 	/* optional */
+	char* clientId; 	/* optional */
+	char* reqFileId;
+	char* serverId;
+	SML_Time refTime;	/* SML_OPENRES_REFTIME */
+	uint8_t smlVersion;	/* SML_OPENRES_SMLVERSION */
+	uint8_t present;
+} SML_PublicOpen_Res_Compact;
+
+#define SML_FLAT_NO_VALUE ((uint32_t)-1)
+
+typedef struct SML_Flat_Node {
+	char* parameterName;
+	uint32_t value;			/* index into values, SML_FLAT_NO_VALUE if absent */
+	uint32_t childCount;
+	uint32_t end;			/* one past the last node of the subtree */
+} SML_Flat_Node;
+
+/*
+ * SML_Tree flattened into one block: nodes in preorder, the subtree of node
+ * i is nodes[i..end-1]. Its first child is node i+1, every further child
+ * starts at the end of its previous sibling. The parameter values are kept
+ * in a side table. Structure is held by indices only, so sml_flat_tree_copy()
+ * copies a whole tree with one memcpy (names and value data are shared).
+ */
+typedef struct SML_Flat_Tree {
+	SML_Flat_Node* nodes;
+	SML_ProcParValue* values;	/* directly behind nodes */
+	uint32_t nodeCount;
+	uint32_t valueCount;
+} SML_Flat_Tree;
+
+typedef struct SML_GetProcParameter_Res_Compact {
+	char* serverId;
+	SML_TreePath parameterTreePath;
+	SML_Flat_Tree parameterTree;
+} SML_GetProcParameter_Res_Compact;
+
 typedef struct SML_Encode_Binary_Result {
 	int resultCode;
-	char* errorMessage;
+	const char* errorMessage;	/* static text, set on SML_ENCODE_ERROR */
 	unsigned char* resultBinary;
 	uint32_t length;
 } SML_Encode_Binary_Result;
 
+/*** Streaming encoder ***/
+
+/* Output sink of the streaming encoders, returns SML_ENCODE_OK to continue */
+typedef uint8_t (*SML_Write_Callback)(void* user, const unsigned char* data, uint32_t length);
+
+/* Fills period row number index, returns SML_ENCODE_OK to continue */
+typedef uint8_t (*SML_Period_Callback)(void* user, uint32_t index, SML_ProfObjPeriodEntry* row);
+
+/* Bytes collected before each call of the write callback */
+#ifndef SMLLIB_STREAM_BUFFER_SIZE
+	#define SMLLIB_STREAM_BUFFER_SIZE 64
+#endif
+
+typedef struct SML_Encode_Stream {
+	SML_Write_Callback write;
+	void* writeUser;
+	SML_Boolean transport;		/* escape and frame the message */
+	uint16_t messageCrc;
+	uint32_t messageLength;		/* unescaped, for the transport padding */
+	uint32_t escape;			/* last four message bytes */
+	uint16_t transportCrc;
+	uint32_t written;
+	const char* error;			/* first failure, stops the stream */
+	uint32_t fill;
+	unsigned char buffer[SMLLIB_STREAM_BUFFER_SIZE];
+} SML_Encode_Stream;
+
+/*** Streaming decoder ***/
+
+/* Called once the fields in front of period_List are parsed, returns SML_PARSE_OK to continue */
+typedef uint8_t (*SML_Profile_Header_Callback)(void* user, SML_GetProfilePack_Res* response);
+
+/* Called per decoded period (valid until it returns), returns SML_PARSE_OK to continue */
+typedef uint8_t (*SML_Profile_Period_Callback)(void* user, uint32_t index, SML_ProfObjPeriodEntry* period);
+
 #endif /* SMLLIB_TYPES_H_ */
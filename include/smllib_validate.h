@@ -0,0 +1,141 @@
+/**
+ * File name: smllib_validate.h
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_VALIDATE_H_
+#define SMLLIB_VALIDATE_H_
+
+#include <stdlib.h>
+#include "smllib_types.h"
+
+/*
+ * Validation without materializing: the message structure (list sizes, TL
+ * types and lengths, choice tags, tree nesting up to SMLLIB_TREE_MAX_DEPTH),
+ * the transport escape framing and both CRCs are checked in one pass over
+ * the input. Nothing is allocated and the context is not touched, so
+ * sml_parser_free() is not needed. All reads stay within length bytes of
+ * smlBinary. A message that validates is accepted by the matching parse
+ * function.
+ */
+
+/* Cursor over the message bytes, unescaping transport frames on the fly */
+typedef struct SML_Validator {
+	const unsigned char* data;
+	uint32_t position;
+	uint32_t end;				/* reads stop here (end escape of a frame) */
+	uint32_t ones;				/* 0x1B bytes of the current run still to deliver */
+	uint16_t crc;				/* over the message bytes up to crcPosition */
+	uint32_t crcPosition;
+	SML_Boolean transport;
+	SML_Boolean endFound;
+} SML_Validator;
+
+/* Public methods */
+
+/**
+ * Checks the message at smlBinary+*offset like sml_parse_message_binary()
+ * does and moves *offset behind it. Returns SML_PARSE_ERROR for malformed
+ * or truncated input, *offset is unchanged then.
+ */
+uint8_t sml_validate_message(const unsigned char* smlBinary, uint32_t length, uint32_t* offset);
+
+/* As above for the transport frame at smlBinary+*offset, see sml_transport_parse_message() */
+uint8_t sml_transport_validate_message(const unsigned char* smlBinary, uint32_t length, uint32_t* offset);
+
+/* Private methods */
+
+void p_sml_validator_init(SML_Validator* validator, const unsigned char* data, uint32_t position, uint32_t end, SML_Boolean transport);
+
+/* Reads count message bytes into out (NULL: skip them) */
+uint8_t p_sml_validate_read(SML_Validator* validator, unsigned char* out, uint32_t count);
+
+/* Brings the crc up to the position */
+void p_sml_validate_crc(SML_Validator* validator);
+
+/* Resolves the 0x1B run at the position: escapes, literal bytes or the end escape */
+void p_sml_validate_run(SML_Validator* validator);
+
+/* Structure, crc and endOfSmlMessage of the message at the position */
+uint8_t p_sml_validate_message(SML_Validator* validator);
+
+uint8_t p_sml_validate_messagebody(SML_Validator* validator, uint32_t choiceTag);
+
+uint8_t p_sml_validate_tlfield(SML_Validator* validator, TL_FieldType* tl_type, uint32_t* tl_value);
+
+/* TL field whose first byte has been read already */
+uint8_t p_sml_validate_tlfield_from(SML_Validator* validator, unsigned char first, TL_FieldType* tl_type, uint32_t* tl_value);
+
+uint8_t p_sml_validate_listsize(SML_Validator* validator, uint32_t listSize);
+
+/* Non-empty list of any size */
+uint8_t p_sml_validate_list(SML_Validator* validator, uint32_t* listSize);
+
+/* Octet string, also the empty one of an absent field */
+uint8_t p_sml_validate_string(SML_Validator* validator);
+
+/* Value of a read TL field of the given type with 1 to size bytes, number may be NULL */
+uint8_t p_sml_validate_scalar(SML_Validator* validator, TL_FieldType tl_type, uint32_t tl_value, TL_FieldType type, uint32_t size, uint64_t* number);
+
+uint8_t p_sml_validate_number(SML_Validator* validator, TL_FieldType type, uint32_t size, uint64_t* number);
+
+uint8_t p_sml_validate_number_optional(SML_Validator* validator, TL_FieldType type, uint32_t size);
+
+uint8_t p_sml_validate_boolean_optional(SML_Validator* validator);
+
+uint8_t p_sml_validate_value(SML_Validator* validator);
+
+uint8_t p_sml_validate_status_optional(SML_Validator* validator);
+
+/* Choice of an SML_Time whose list header has been read */
+uint8_t p_sml_validate_time_choice(SML_Validator* validator);
+
+uint8_t p_sml_validate_time(SML_Validator* validator);
+
+uint8_t p_sml_validate_time_optional(SML_Validator* validator);
+
+uint8_t p_sml_validate_treepath(SML_Validator* validator);
+
+/* Preorder like p_sml_parse_tree(); headerRead: the root list header is consumed */
+uint8_t p_sml_validate_tree(SML_Validator* validator, SML_Boolean headerRead);
+
+uint8_t p_sml_validate_tree_optional(SML_Validator* validator);
+
+/* Choice of an SML_ProcParValue whose list header has been read */
+uint8_t p_sml_validate_procparvalue_choice(SML_Validator* validator);
+
+uint8_t p_sml_validate_periodentry(SML_Validator* validator);
+
+uint8_t p_sml_validate_tupelentry(SML_Validator* validator);
+
+uint8_t p_sml_validate_listentry(SML_Validator* validator);
+
+uint8_t p_sml_validate_objheaderentry(SML_Validator* validator);
+
+uint8_t p_sml_validate_objperiodentry(SML_Validator* validator);
+
+uint8_t p_sml_validate_valueentry(SML_Validator* validator);
+
+/* Non-empty list of entries checked by entry */
+uint8_t p_sml_validate_list_of(SML_Validator* validator, uint8_t (*entry)(SML_Validator*));
+
+uint8_t p_sml_validate_list_of_string_optional(SML_Validator* validator);
+
+#endif /* SMLLIB_VALIDATE_H_ */
@@ -0,0 +1,146 @@
+/**
+ * File name: gen_obis_table.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_obis.h"
+
+/*
+ * Generates smllib_obis_table.h: finds a hash seed that maps every code of
+ * smllib_obis_codes.h to its own slot (perfect hash).
+ *
+ *   Gen_Obis_Table <header>          writes the table
+ *   Gen_Obis_Table --check <header>  fails if the header is out of date
+ */
+
+#define GEN_MAX_SEEDS 10000000UL
+#define GEN_MAX_TABLE 4096
+
+#define SML_OBIS_CODE(name, text, a, b, c, d, e, f) {a, b, c, d, e, f},
+static const uint8_t gen_codes[][SML_OBIS_LENGTH] = {
+	#include "smllib_obis_codes.h"
+};
+#undef SML_OBIS_CODE
+
+#define GEN_CODE_COUNT (sizeof(gen_codes) / sizeof(gen_codes[0]))
+
+static uint8_t gen_slots[GEN_MAX_TABLE];
+
+/* Tries one seed, fills gen_slots on success */
+static int gen_try_seed(uint32_t seed, uint32_t size) {
+	uint32_t i;
+	uint32_t slot;
+
+	memset(gen_slots, 0, size);
+	for(i=0; i<GEN_CODE_COUNT; i++) {
+		slot = p_sml_obis_hash(gen_codes[i], seed) & (size - 1);
+		if(gen_slots[slot] != SML_OBIS_NONE) {
+			return 0;
+		}
+		gen_slots[slot] = (uint8_t)(SML_OBIS_UNKNOWN + 1 + i);
+	}
+	return 1;
+}
+
+static int gen_write(FILE* out, uint32_t seed, uint32_t size) {
+	uint32_t i;
+
+	fprintf(out, "/* Generated by Gen_Obis_Table from smllib_obis_codes.h, do not edit */\n");
+	fprintf(out, "#ifndef SMLLIB_OBIS_TABLE_H_\n#define SMLLIB_OBIS_TABLE_H_\n\n");
+	fprintf(out, "#define SML_OBIS_HASH_SEED 0x%08lXUL\n", (unsigned long)seed);
+	fprintf(out, "#define SML_OBIS_HASH_SIZE %lu\n\n", (unsigned long)size);
+	fprintf(out, "/* SML_OBIS_* ID per hash slot, SML_OBIS_NONE for empty slots */\n");
+	fprintf(out, "static const uint8_t p_sml_obis_slots[SML_OBIS_HASH_SIZE] = {");
+	for(i=0; i<size; i++) {
+		fprintf(out, "%s%3u%s", (i % 16 == 0) ? "\n\t" : "", (unsigned int)gen_slots[i], (i + 1 < size) ? "," : "");
+	}
+	fprintf(out, "\n};\n\n#endif /* SMLLIB_OBIS_TABLE_H_ */\n");
+	return ferror(out) ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+	const char* path = (argc == 3) ? argv[2] : argv[1];
+	int check = (argc == 3 && strcmp(argv[1], "--check") == 0);
+	uint32_t size;
+	uint32_t seed = 0;
+	FILE* file;
+	char expected[16384];
+	char actual[16384];
+	size_t expectedLength;
+	size_t actualLength;
+
+	if(argc < 2 || argc > 3 || (argc == 3 && !check)) {
+		fprintf(stderr, "usage: %s [--check] <smllib_obis_table.h>\n", argv[0]);
+		return 2;
+	}
+
+	/* Smallest power of two table (load <= 1/2) that has a perfect seed */
+	for(size = 2; size < GEN_CODE_COUNT * 2; size <<= 1);
+	for(; size <= GEN_MAX_TABLE; size <<= 1) {
+		for(seed = 1; seed < GEN_MAX_SEEDS; seed++) {
+			if(gen_try_seed(seed, size)) {
+				break;
+			}
+		}
+		if(seed < GEN_MAX_SEEDS) {
+			break;
+		}
+	}
+	if(size > GEN_MAX_TABLE) {
+		fprintf(stderr, "no perfect hash seed found\n");
+		return 1;
+	}
+
+	if(!check) {
+		file = fopen(path, "w");
+		if(file == NULL || gen_write(file, seed, size) != 0) {
+			fprintf(stderr, "cannot write %s\n", path);
+			return 1;
+		}
+		fclose(file);
+		return 0;
+	}
+
+	/* Compare the generated text with the checked-in header */
+	file = tmpfile();
+	if(file == NULL || gen_write(file, seed, size) != 0) {
+		return 1;
+	}
+	rewind(file);
+	expectedLength = fread(expected, 1, sizeof(expected), file);
+	fclose(file);
+	file = fopen(path, "r");
+	if(file == NULL) {
+		fprintf(stderr, "cannot read %s\n", path);
+		return 1;
+	}
+	actualLength = fread(actual, 1, sizeof(actual), file);
+	fclose(file);
+	if(actualLength != expectedLength || memcmp(actual, expected, actualLength) != 0) {
+		fprintf(stderr, "%s is out of date, build the obis_table target\n", path);
+		return 1;
+	}
+	return 0;
+}
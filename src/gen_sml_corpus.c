@@ -0,0 +1,361 @@
+/**
+ * File name: gen_sml_corpus.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_validate.h"
+#include "smllib_synth.h"
+
+/*
+ * Generates a reproducible corpus of transport encoded SML files: every file
+ * is PublicOpen_Res, one body message and PublicClose_Res, written with
+ * sml_transport_encode_file(). The body is an eHZ push (GetList_Res), a load
+ * profile (GetProfilePack_Res) or a parameter tree (GetProcParameter_Res).
+ *
+ *   Gen_SML_Corpus [options] <output>   writes the corpus
+ *   Gen_SML_Corpus [options] --verify   validates and parses every file back instead
+ *
+ *   --seed=<n>             PRNG seed (1)
+ *   --files=<n>            number of SML files (1000)
+ *   --mix=<g>,<p>,<t>      weights of GetList_Res, GetProfilePack_Res and
+ *                          GetProcParameter_Res bodies (90,2,8)
+ *   --entries=<min>-<max>  GetList_Res entries (10-40)
+ *   --periods=<min>-<max>  GetProfilePack_Res periods (96-2976)
+ *   --nodes=<min>-<max>    GetProcParameter_Res tree nodes (16-1024)
+ *   --fanout=<n>           children per tree node, 2 or more (4)
+ *   --dist=uniform|skew    size distribution, skew favours small sizes (uniform)
+ *   --escape=<n>           per mille of octet strings and counters that hold
+ *                          an escape sequence (0)
+ *
+ * A summary goes to stderr.
+ */
+
+#define GEN_KIND_GETLIST 0
+#define GEN_KIND_PROFILE 1
+#define GEN_KIND_PROCPAR 2
+#define GEN_KIND_COUNT 3
+
+/* Pool of the STATIC_POOL build, big enough for the largest profile */
+#define GEN_POOL_SIZE (64 * 1024 * 1024)
+
+static const uint32_t gen_kind_types[GEN_KIND_COUNT] = {
+	SML_MESSAGEBODY_GETLIST_RESPONSE,
+	SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE,
+	SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE
+};
+
+typedef struct Gen_Range {
+	uint32_t min;
+	uint32_t max;
+} Gen_Range;
+
+typedef struct Gen_Options {
+	uint32_t seed;
+	uint32_t files;
+	uint32_t mix[GEN_KIND_COUNT];
+	Gen_Range sizes[GEN_KIND_COUNT];
+	uint32_t fanout;
+	SML_Boolean skew;
+	uint32_t escapeRate;
+	SML_Boolean verify;
+	const char* output;
+} Gen_Options;
+
+typedef struct Gen_Summary {
+	uint32_t files[GEN_KIND_COUNT];
+	uint32_t frames;
+	uint32_t escapes;
+	uint32_t failures;
+	double bytes;
+} Gen_Summary;
+
+static int gen_parse_range(const char* text, Gen_Range* range) {
+	unsigned long min;
+	unsigned long max;
+
+	if(sscanf(text, "%lu-%lu", &min, &max) != 2 || min == 0 || min > max) {
+		return 0;
+	}
+	range->min = (uint32_t)min;
+	range->max = (uint32_t)max;
+	return 1;
+}
+
+static int gen_options(int argc, char** argv, Gen_Options* options) {
+	unsigned long mix[GEN_KIND_COUNT];
+	int i;
+
+	options->seed = 1;
+	options->files = 1000;
+	options->mix[GEN_KIND_GETLIST] = 90;
+	options->mix[GEN_KIND_PROFILE] = 2;
+	options->mix[GEN_KIND_PROCPAR] = 8;
+	options->sizes[GEN_KIND_GETLIST].min = 10;
+	options->sizes[GEN_KIND_GETLIST].max = 40;
+	options->sizes[GEN_KIND_PROFILE].min = 96;
+	options->sizes[GEN_KIND_PROFILE].max = 2976;
+	options->sizes[GEN_KIND_PROCPAR].min = 16;
+	options->sizes[GEN_KIND_PROCPAR].max = 1024;
+	options->fanout = SML_SYNTH_TREE_FANOUT;
+	options->skew = FALSE;
+	options->escapeRate = 0;
+	options->verify = FALSE;
+	options->output = NULL;
+
+	for(i=1; i<argc; i++) {
+		if(strncmp(argv[i], "--seed=", 7) == 0) {
+			options->seed = (uint32_t)strtoul(argv[i] + 7, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--files=", 8) == 0) {
+			options->files = (uint32_t)strtoul(argv[i] + 8, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--mix=", 6) == 0) {
+			if(sscanf(argv[i] + 6, "%lu,%lu,%lu", &mix[0], &mix[1], &mix[2]) != 3 || mix[0] + mix[1] + mix[2] == 0) {
+				return 0;
+			}
+			options->mix[GEN_KIND_GETLIST] = (uint32_t)mix[0];
+			options->mix[GEN_KIND_PROFILE] = (uint32_t)mix[1];
+			options->mix[GEN_KIND_PROCPAR] = (uint32_t)mix[2];
+		}
+		else if(strncmp(argv[i], "--entries=", 10) == 0) {
+			if(!gen_parse_range(argv[i] + 10, &options->sizes[GEN_KIND_GETLIST])) {
+				return 0;
+			}
+		}
+		else if(strncmp(argv[i], "--periods=", 10) == 0) {
+			if(!gen_parse_range(argv[i] + 10, &options->sizes[GEN_KIND_PROFILE])) {
+				return 0;
+			}
+		}
+		else if(strncmp(argv[i], "--nodes=", 8) == 0) {
+			if(!gen_parse_range(argv[i] + 8, &options->sizes[GEN_KIND_PROCPAR])) {
+				return 0;
+			}
+		}
+		else if(strncmp(argv[i], "--fanout=", 9) == 0) {
+			options->fanout = (uint32_t)strtoul(argv[i] + 9, NULL, 10);
+			if(options->fanout < 2) {
+				return 0;
+			}
+		}
+		else if(strcmp(argv[i], "--dist=uniform") == 0) {
+			options->skew = FALSE;
+		}
+		else if(strcmp(argv[i], "--dist=skew") == 0) {
+			options->skew = TRUE;
+		}
+		else if(strncmp(argv[i], "--escape=", 9) == 0) {
+			options->escapeRate = (uint32_t)strtoul(argv[i] + 9, NULL, 10);
+			if(options->escapeRate > 1000) {
+				return 0;
+			}
+		}
+		else if(strcmp(argv[i], "--verify") == 0) {
+			options->verify = TRUE;
+		}
+		else if(argv[i][0] != '-' && options->output == NULL) {
+			options->output = argv[i];
+		}
+		else {
+			return 0;
+		}
+	}
+	return options->verify || options->output != NULL;
+}
+
+static uint32_t gen_kind(SML_Synth* synth, const Gen_Options* options) {
+	uint32_t total = options->mix[0] + options->mix[1] + options->mix[2];
+	uint32_t pick = sml_synth_random(synth) % total;
+	uint32_t kind;
+
+	for(kind=0; kind<GEN_KIND_COUNT - 1; kind++) {
+		if(pick < options->mix[kind]) {
+			break;
+		}
+		pick -= options->mix[kind];
+	}
+	return kind;
+}
+
+/* Uniform, or quadratically skewed towards range->min */
+static uint32_t gen_size(SML_Synth* synth, const Gen_Options* options, const Gen_Range* range) {
+	double span = (double)(range->max - range->min);
+	double u = (double)(sml_synth_random(synth) % 1000001UL) / 1000000.0;
+
+	if(options->skew) {
+		u = u * u;
+	}
+	return range->min + (uint32_t)(u * span + 0.5);
+}
+
+/* Escaped 1B1B1B1B sequences of a frame (start and end sequences excluded) */
+static uint32_t gen_count_escapes(const unsigned char* frame, uint32_t length) {
+	static const unsigned char escaped[8] = {0x1B, 0x1B, 0x1B, 0x1B, 0x1B, 0x1B, 0x1B, 0x1B};
+	uint32_t count = 0;
+	uint32_t i;
+
+	for(i=0; i + 8 <= length; i++) {
+		if(memcmp(frame + i, escaped, 8) == 0) {
+			count++;
+			i += 7;
+		}
+	}
+	return count;
+}
+
+/* Validates and parses the transport frames of one file back, returns the frame count or 0 */
+static uint32_t gen_verify(const unsigned char* binary, uint32_t length, uint32_t bodyType) {
+	SML_Message message;
+	uint32_t offset = 0;
+	uint32_t validOffset = 0;
+	uint32_t frames = 0;
+	static const uint32_t expected[3] = {SML_MESSAGEBODY_OPEN_RESPONSE, 0, SML_MESSAGEBODY_CLOSE_RESPONSE};
+
+	while(offset < length) {
+		if(frames >= 3
+				|| sml_transport_validate_message(binary, length, &validOffset) != SML_PARSE_OK
+				|| sml_transport_parse_message(binary, &offset, &message) != SML_PARSE_OK
+				|| offset != validOffset
+				|| message.messageBody.choiceTag != (frames == 1 ? bodyType : expected[frames])) {
+			sml_parser_free();
+			return 0;
+		}
+		frames++;
+	}
+	sml_parser_free();
+	return (frames == 3) ? frames : 0;
+}
+
+static int gen_file(SML_Synth* synth, const Gen_Options* options, FILE* out, Gen_Summary* summary) {
+	SML_Encode_Binary_Result result;
+	SML_Message* messages[3];
+	SML_File file;
+	unsigned char* binary;
+	uint32_t length;
+	uint32_t kind = gen_kind(synth, options);
+	uint32_t size = gen_size(synth, options, &options->sizes[kind]);
+	int retValue = 0;
+
+	messages[0] = sml_synth_message(synth, SML_MESSAGEBODY_OPEN_RESPONSE, 0);
+	messages[1] = sml_synth_message(synth, gen_kind_types[kind], size);
+	messages[2] = sml_synth_message(synth, SML_MESSAGEBODY_CLOSE_RESPONSE, 0);
+	file.messages = messages;
+	file.msgCount = 3;
+	file.crc16 = 0;
+	file.version = 1;
+
+	result = sml_transport_encode_file(&file);
+	if(result.resultCode != SML_ENCODE_OK) {
+		fprintf(stderr, "encoding failed: %s\n", result.errorMessage != NULL ? result.errorMessage : "");
+		sml_encode_result_free(&result);
+		return 1;
+	}
+	/* Own copy, sml_parser_free() releases pool memory in STATIC_POOL builds */
+	length = result.length;
+	binary = (unsigned char*)malloc(length);
+	memcpy(binary, result.resultBinary, length);
+	sml_encode_result_free(&result);
+
+	if(out != NULL && fwrite(binary, 1, length, out) != length) {
+		fprintf(stderr, "%s\n", "write failed");
+		retValue = 1;
+	}
+	if(options->verify && gen_verify(binary, length, gen_kind_types[kind]) == 0) {
+		summary->failures++;
+		retValue = 1;
+	}
+	summary->files[kind]++;
+	summary->frames += 3;
+	summary->bytes += (double)length;
+	summary->escapes += gen_count_escapes(binary, length);
+
+	free(binary);
+	sml_parser_free();
+	sml_synth_free(synth);
+	return retValue;
+}
+
+int main(int argc, char** argv) {
+	Gen_Options options;
+	Gen_Summary summary;
+	SML_Synth synth;
+	FILE* out = NULL;
+	uint32_t i;
+	int retValue = 0;
+
+	#ifdef SMLLIB_STATIC_POOL
+		SML_Context context;
+		void* pool = malloc(GEN_POOL_SIZE);
+	#endif
+
+	if(!gen_options(argc, argv, &options)) {
+		fprintf(stderr, "%s\n", "usage: Gen_SML_Corpus [--seed=<n>] [--files=<n>] [--mix=<g>,<p>,<t>] [--entries=<min>-<max>]");
+		fprintf(stderr, "%s\n", "       [--periods=<min>-<max>] [--nodes=<min>-<max>] [--fanout=<n>] [--dist=uniform|skew]");
+		fprintf(stderr, "%s\n", "       [--escape=<per mille>] (<output> | --verify)");
+		return 2;
+	}
+	if(options.output != NULL) {
+		out = fopen(options.output, "wb");
+		if(out == NULL) {
+			fprintf(stderr, "cannot open %s\n", options.output);
+			return 1;
+		}
+	}
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_init(&context);
+		sml_context_set_pool(&context, pool, GEN_POOL_SIZE);
+		sml_context_use(&context);
+	#endif
+
+	memset(&summary, 0, sizeof(summary));
+	sml_synth_init(&synth, options.seed);
+	synth.treeFanout = options.fanout;
+	synth.escapeRate = options.escapeRate;
+	for(i=0; i<options.files && retValue == 0; i++) {
+		retValue = gen_file(&synth, &options, out, &summary);
+	}
+
+	if(out != NULL && fclose(out) != 0) {
+		retValue = 1;
+	}
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_use(NULL);
+		free(pool);
+	#endif
+
+	fprintf(stderr, "files %u (GetList_Res %u, GetProfilePack_Res %u, GetProcParameter_Res %u), frames %u, bytes %.0f, escapes %u",
+		(unsigned int)(summary.files[0] + summary.files[1] + summary.files[2]),
+		(unsigned int)summary.files[GEN_KIND_GETLIST], (unsigned int)summary.files[GEN_KIND_PROFILE],
+		(unsigned int)summary.files[GEN_KIND_PROCPAR], (unsigned int)summary.frames, summary.bytes,
+		(unsigned int)summary.escapes);
+	if(options.verify) {
+		fprintf(stderr, ", verify failures %u", (unsigned int)summary.failures);
+	}
+	fprintf(stderr, "%s", "\n");
+	return retValue;
+}
@@ -0,0 +1,834 @@
+/**
+ * File name: smllib_bench.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_intern.h"
+#include "smllib_tree.h"
+#include "smllib_tools.h"
+#include "smllib_scale.h"
+
+/*
+ * Benchmark and size report for the encoder/parser. Measure with the default
+ * TRACE_LEVEL=0, compiled-in trace points cost time even without a sink.
+ */
+
+/* Typical meter register kinds used to fill synthetic lists */
+#define BENCH_KIND_ENERGY 0
+#define BENCH_KIND_POWER 1
+#define BENCH_KIND_VOLTAGE 2
+#define BENCH_KIND_COUNTER 3
+
+static char bench_obis[4][7] = {
+	{0x01, 0x01, 0x01, 0x08, 0x01, (char)0xFF, 0x00},	/* energy register */
+	{0x01, 0x01, 0x10, 0x07, 0x01, (char)0xFF, 0x00},	/* active power */
+	{0x01, 0x01, 0x20, 0x07, 0x01, (char)0xFF, 0x00},	/* voltage L1 */
+	{0x01, 0x01, 0x60, 0x08, 0x01, (char)0xFF, 0x00}	/* operating seconds */
+};
+
+static uint8_t bench_units[4] = {30, 27, 35, 7};
+static int8_t bench_scalers[4] = {-1, 0, -1, 0};
+
+typedef struct Bench_GetList {
+	SML_Message message;
+	SML_GetList_Res response;
+	SML_ListEntry* entries;
+	SML_Status status;
+	SML_Time actSensorTime;
+} Bench_GetList;
+
+typedef struct Bench_ProfilePack {
+	SML_Message message;
+	SML_GetProfilePack_Res response;
+	SML_ProfObjHeaderEntry* headers;
+	SML_ProfObjPeriodEntry* periods;
+	SML_ValueEntry* values;
+	char* pathEntry[1];
+} Bench_ProfilePack;
+
+typedef struct Bench_ParamTree {
+	SML_Message message;
+	SML_GetProcParameter_Res response;
+	SML_Tree* nodes;
+	List_of_SML_Tree* lists;
+	SML_ProcParValue* values;
+	SML_Value* smlValues;
+	char (*names)[8];
+	char* pathEntry[1];
+} Bench_ParamTree;
+
+static char bench_transactionId[] = {"BenchTransaction"};
+static char bench_serverId[] = {"\x0A\x01ISK\x01\x02\x03\x04\x05"};
+static char bench_pathEntry[] = {"\x81\x81\xC7\x86\x20\xFF"};
+
+static void bench_build_getlist(Bench_GetList* bench, uint32_t entryCount) {
+	uint32_t i;
+	uint32_t kind;
+
+	bench->status.choiceTag = SML_STATUS_UINT64;
+	bench->status.choiceValue.uint64 = 0x0182;
+	bench->actSensorTime.choiceTag = SML_TIME_SECINDEX;
+	bench->actSensorTime.choiceValue.secIndex = 12345678;
+
+	bench->entries = (SML_ListEntry*)calloc(entryCount, sizeof(SML_ListEntry));
+	for(i=0; i<entryCount; i++) {
+		kind = i % 4;
+		bench->entries[i].objName = bench_obis[kind];
+		bench->entries[i].status = (kind == BENCH_KIND_ENERGY) ? &bench->status : NULL;
+		bench->entries[i].valTime = NULL;
+		bench->entries[i].unit = &bench_units[kind];
+		bench->entries[i].scaler = &bench_scalers[kind];
+		bench->entries[i].valueSignature = NULL;
+		switch(kind) {
+			case BENCH_KIND_ENERGY:
+				bench->entries[i].value.choiceTag = SML_VALUE_UINT64;
+				bench->entries[i].value.choiceValue.uint64 = 10000000 + i * 12345;
+			break;
+			case BENCH_KIND_POWER:
+				bench->entries[i].value.choiceTag = SML_VALUE_INT32;
+				bench->entries[i].value.choiceValue.int32 = 1500 - (int32_t)(i * 97);
+			break;
+			case BENCH_KIND_VOLTAGE:
+				bench->entries[i].value.choiceTag = SML_VALUE_UINT16;
+				bench->entries[i].value.choiceValue.uint16 = (uint16_t)(2300 + i);
+			break;
+			default:
+				bench->entries[i].value.choiceTag = SML_VALUE_UINT32;
+				bench->entries[i].value.choiceValue.uint32 = i * 3;
+			break;
+		}
+	}
+
+	bench->response.clientId = NULL;
+	bench->response.serverId = bench_serverId;
+	bench->response.listName = NULL;
+	bench->response.actSensorTime = &bench->actSensorTime;
+	bench->response.valList.listSize = entryCount;
+	bench->response.valList.valListEntry = bench->entries;
+	bench->response.listSignature = NULL;
+	bench->response.actGatewayTime = NULL;
+
+	bench->message.transactionId = bench_transactionId;
+	bench->message.groupNo = 0;
+	bench->message.abortOnError = 0;
+	bench->message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	bench->message.messageBody.choiceValue.getListResponse = &bench->response;
+}
+
+static void bench_build_profilepack(Bench_ProfilePack* bench, uint32_t periodCount, uint32_t valueCount) {
+	uint32_t i;
+	uint32_t v;
+
+	bench->headers = (SML_ProfObjHeaderEntry*)calloc(valueCount, sizeof(SML_ProfObjHeaderEntry));
+	bench->periods = (SML_ProfObjPeriodEntry*)calloc(periodCount, sizeof(SML_ProfObjPeriodEntry));
+	bench->values = (SML_ValueEntry*)calloc(periodCount * valueCount, sizeof(SML_ValueEntry));
+
+	for(v=0; v<valueCount; v++) {
+		bench->headers[v].objName = bench_obis[BENCH_KIND_ENERGY];
+		bench->headers[v].unit = bench_units[BENCH_KIND_ENERGY];
+		bench->headers[v].scaler = bench_scalers[BENCH_KIND_ENERGY];
+	}
+	for(i=0; i<periodCount; i++) {
+		bench->periods[i].valTime.choiceTag = SML_TIME_SECINDEX;
+		bench->periods[i].valTime.choiceValue.secIndex = 12345678 + i * 900;
+		bench->periods[i].status = 0;
+		bench->periods[i].value_List.listSize = valueCount;
+		bench->periods[i].value_List.value_List_Entry = bench->values + i * valueCount;
+		bench->periods[i].periodSignature = NULL;
+		for(v=0; v<valueCount; v++) {
+			bench->values[i * valueCount + v].value.choiceTag = SML_VALUE_UINT64;
+			bench->values[i * valueCount + v].value.choiceValue.uint64 = 10000000 + i * 25 + v;
+			bench->values[i * valueCount + v].valueSignature = NULL;
+		}
+	}
+
+	bench->pathEntry[0] = bench_pathEntry;
+	bench->response.serverId = bench_serverId;
+	bench->response.actTime.choiceTag = SML_TIME_SECINDEX;
+	bench->response.actTime.choiceValue.secIndex = 12345678;
+	bench->response.regPeriod = 900;
+	bench->response.parameterTreePath.listSize = 1;
+	bench->response.parameterTreePath.path_Entry = bench->pathEntry;
+	bench->response.header_List.listSize = valueCount;
+	bench->response.header_List.header_List_Entry = bench->headers;
+	bench->response.period_List.listSize = periodCount;
+	bench->response.period_List.period_List_Entry = bench->periods;
+	bench->response.rawdata = NULL;
+	bench->response.profileSignature = NULL;
+
+	bench->message.transactionId = bench_transactionId;
+	bench->message.groupNo = 0;
+	bench->message.abortOnError = 0;
+	bench->message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE;
+	bench->message.messageBody.choiceValue.getProfilePackResponse = &bench->response;
+}
+
+/* Parameter tree of nodeCount nodes, fanout children per node (breadth first) */
+static void bench_build_paramtree(Bench_ParamTree* bench, uint32_t nodeCount, uint32_t fanout) {
+	uint32_t i;
+	uint32_t first;
+
+	bench->nodes = (SML_Tree*)calloc(nodeCount, sizeof(SML_Tree));
+	bench->lists = (List_of_SML_Tree*)calloc(nodeCount, sizeof(List_of_SML_Tree));
+	bench->values = (SML_ProcParValue*)calloc(nodeCount, sizeof(SML_ProcParValue));
+	bench->smlValues = (SML_Value*)calloc(nodeCount, sizeof(SML_Value));
+	bench->names = (char (*)[8])calloc(nodeCount, sizeof(bench->names[0]));
+
+	for(i=0; i<nodeCount; i++) {
+		bench->smlValues[i].choiceTag = SML_VALUE_UINT32;
+		bench->smlValues[i].choiceValue.uint32 = 1000 + i;
+		bench->values[i].choiceTag = SML_PROCPAR_VALUE;
+		bench->values[i].choiceValue.smlValue = bench->smlValues + i;
+		sprintf(bench->names[i], "P%05lu", (unsigned long)i);
+		bench->nodes[i].parameterName = bench->names[i];
+		bench->nodes[i].parameterValue = bench->values + i;
+		first = i * fanout + 1;
+		if(first < nodeCount) {
+			bench->lists[i].listSize = (nodeCount - first < fanout) ? nodeCount - first : fanout;
+			bench->lists[i].tree_Entry = bench->nodes + first;
+			bench->nodes[i].child_List = bench->lists + i;
+		}
+	}
+
+	bench->pathEntry[0] = bench_pathEntry;
+	bench->response.serverId = bench_serverId;
+	bench->response.parameterTreePath.listSize = 1;
+	bench->response.parameterTreePath.path_Entry = bench->pathEntry;
+	bench->response.parameterTree = bench->nodes[0];
+
+	bench->message.transactionId = bench_transactionId;
+	bench->message.groupNo = 0;
+	bench->message.abortOnError = 0;
+	bench->message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE;
+	bench->message.messageBody.choiceValue.getProcParameterResponse = &bench->response;
+}
+
+static void bench_free_paramtree(Bench_ParamTree* bench) {
+	free(bench->nodes);
+	free(bench->lists);
+	free(bench->values);
+	free(bench->smlValues);
+	free(bench->names);
+}
+
+static uint32_t bench_transport_size(SML_Message* message, SML_Boolean shortest) {
+	SML_Encode_Binary_Result result;
+	uint32_t length;
+
+	sml_encode_set_shortest_integers(shortest);
+	result = sml_transport_encode_message(message);
+	length = result.length;
+	sml_encode_result_free(&result);
+	sml_encode_set_shortest_integers(FALSE);
+
+	return length;
+}
+
+static void bench_print_size(const char* name, SML_Message* message) {
+	uint32_t full = bench_transport_size(message, FALSE);
+	uint32_t shortest = bench_transport_size(message, TRUE);
+
+	printf("%-28s %10u %10u %10u %7.1f%%\n", name,
+		(unsigned int)full, (unsigned int)shortest, (unsigned int)(full - shortest),
+		100.0 * (double)(full - shortest) / (double)full);
+}
+
+static void bench_size_report(void) {
+	static const uint32_t listSizes[] = {5, 10, 20, 40};
+	static const uint32_t periodCounts[] = {96, 672, 2976};
+	Bench_GetList getList;
+	Bench_ProfilePack profilePack;
+	char name[64];
+	uint32_t i;
+
+	printf("%s\n", "== Shortest-form integer encoding (transport bytes) ==");
+	printf("%-28s %10s %10s %10s %8s\n", "payload", "full", "shortest", "saved", "saved%");
+
+	for(i=0; i<sizeof(listSizes)/sizeof(listSizes[0]); i++) {
+		bench_build_getlist(&getList, listSizes[i]);
+		sprintf(name, "GetList_Res %u entries", (unsigned int)listSizes[i]);
+		bench_print_size(name, &getList.message);
+		free(getList.entries);
+	}
+	for(i=0; i<sizeof(periodCounts)/sizeof(periodCounts[0]); i++) {
+		bench_build_profilepack(&profilePack, periodCounts[i], 4);
+		sprintf(name, "GetProfilePack_Res %ux4", (unsigned int)periodCounts[i]);
+		bench_print_size(name, &profilePack.message);
+		free(profilePack.headers);
+		free(profilePack.periods);
+		free(profilePack.values);
+	}
+}
+
+/* Pool large enough for every bench payload */
+#define BENCH_POOL_SIZE (16 * 1024 * 1024)
+
+static void bench_print_pool(const char* name, SML_Message* message, void* pool) {
+	SML_Encode_Binary_Result result;
+	SML_Context context;
+	SML_Message parsed;
+	uint32_t offset = 0;
+	uint32_t length;
+	uint8_t retValue;
+
+	result = sml_transport_encode_message(message);
+	length = result.length;
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, BENCH_POOL_SIZE);
+	sml_context_use(&context);
+	retValue = sml_transport_parse_message(result.resultBinary, &offset, &parsed);
+	sml_parser_free();
+	sml_context_use(NULL);
+	sml_encode_result_free(&result);
+
+	printf("%-28s %10u %12u\n", name, (unsigned int)length,
+		(retValue == SML_PARSE_OK) ? (unsigned int)sml_context_pool_worst_case(&context, message->messageBody.choiceTag) : 0);
+}
+
+static void bench_pool_report(void) {
+	static const uint32_t listSizes[] = {5, 10, 20, 40};
+	static const uint32_t periodCounts[] = {96, 672};
+	Bench_GetList getList;
+	Bench_ProfilePack profilePack;
+	char name[64];
+	void* pool = malloc(BENCH_POOL_SIZE);
+	uint32_t i;
+
+	printf("%s\n", "== Static pool worst case (transport parse) ==");
+	printf("%-28s %10s %12s\n", "payload", "bytes", "pool bytes");
+
+	for(i=0; i<sizeof(listSizes)/sizeof(listSizes[0]); i++) {
+		bench_build_getlist(&getList, listSizes[i]);
+		sprintf(name, "GetList_Res %u entries", (unsigned int)listSizes[i]);
+		bench_print_pool(name, &getList.message, pool);
+		free(getList.entries);
+	}
+	for(i=0; i<sizeof(periodCounts)/sizeof(periodCounts[0]); i++) {
+		bench_build_profilepack(&profilePack, periodCounts[i], 4);
+		sprintf(name, "GetProfilePack_Res %ux4", (unsigned int)periodCounts[i]);
+		bench_print_pool(name, &profilePack.message, pool);
+		free(profilePack.headers);
+		free(profilePack.periods);
+		free(profilePack.values);
+	}
+	free(pool);
+}
+
+/* Minimum measuring time per throughput case */
+#define BENCH_MIN_SECONDS 0.5
+
+static double bench_seconds(clock_t start) {
+	return (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+}
+
+static void bench_print_throughput(const char* name, const char* operation, uint32_t iterations, uint32_t length, double seconds, uint32_t allocations) {
+	printf("%-28s %-10s %12.0f %10.2f %10.1f\n", name, operation,
+		(double)iterations / seconds,
+		(double)iterations * (double)length / seconds / (1024.0 * 1024.0),
+		(double)allocations / (double)iterations);
+}
+
+static void bench_throughput(const char* name, SML_Message* message) {
+	SML_Encode_Binary_Result result;
+	SML_Message parsed;
+	uint32_t iterations;
+	uint32_t length;
+	uint32_t offset;
+	uint32_t allocations;
+	clock_t start;
+	SML_Alloc_Stats* stats = &sml_context_current()->allocStats;
+
+	/* encode */
+	allocations = stats->total.allocations;
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		result = sml_encode_message_binary(message);
+		length = result.length;
+		sml_encode_result_free(&result);
+	}
+	bench_print_throughput(name, "encode", iterations, length, bench_seconds(start), stats->total.allocations - allocations);
+
+	/* parse */
+	result = sml_encode_message_binary(message);
+	allocations = stats->total.allocations;
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		offset = 0;
+		sml_parse_message_binary(result.resultBinary, &offset, &parsed);
+		sml_parser_free();
+	}
+	bench_print_throughput(name, "parse", iterations, result.length, bench_seconds(start), stats->total.allocations - allocations);
+	sml_encode_result_free(&result);
+}
+
+static void bench_throughput_context(const char* name, SML_Message* message, SML_Context* context) {
+	SML_Encode_Binary_Result result;
+	SML_Message parsed;
+	uint32_t iterations;
+	uint32_t offset;
+	clock_t start;
+
+	/* parse only, with the options of the given context */
+	result = sml_encode_message_binary(message);
+	sml_context_use(context);
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		offset = 0;
+		sml_parse_message_binary(result.resultBinary, &offset, &parsed);
+		sml_parser_free();
+	}
+	bench_print_throughput(name, "parse", iterations, result.length, bench_seconds(start), context->allocStats.total.allocations);
+	sml_context_use(NULL);
+	sml_encode_result_free(&result);
+}
+
+static void bench_throughput_report(void) {
+	Bench_GetList getList;
+	Bench_ProfilePack profilePack;
+	Bench_ParamTree paramTree;
+	SML_Context context;
+
+	#ifdef SMLLIB_FREESTANDING
+		printf("%s\n", "== Encode/parse throughput (built-in string routines) ==");
+	#else
+		printf("%s\n", "== Encode/parse throughput (C library string routines) ==");
+	#endif
+	printf("%-28s %-10s %12s %10s %10s\n", "payload", "operation", "msgs/s", "MB/s", "allocs/op");
+
+	bench_build_getlist(&getList, 40);
+	bench_throughput("GetList_Res 40 entries", &getList.message);
+	sml_context_init(&context);
+	sml_context_set_compact_layout(&context, TRUE);
+	bench_throughput_context("GetList_Res 40 compact", &getList.message, &context);
+	sml_context_init(&context);
+	sml_context_set_intern_table(&context, sml_intern_create(64, 1024));
+	bench_throughput_context("GetList_Res 40 interned", &getList.message, &context);
+	sml_context_set_compact_layout(&context, TRUE);
+	sml_context_reset_stats(&context);
+	bench_throughput_context("GetList_Res 40 compact+int.", &getList.message, &context);
+	sml_intern_destroy(context.internTable);
+	free(getList.entries);
+
+	bench_build_profilepack(&profilePack, 672, 4);
+	bench_throughput("GetProfilePack_Res 672x4", &profilePack.message);
+	free(profilePack.headers);
+	free(profilePack.periods);
+	free(profilePack.values);
+
+	bench_build_paramtree(&paramTree, 10000, 10);
+	bench_throughput("ProcParameter_Res 10k tree", &paramTree.message);
+	sml_context_init(&context);
+	sml_context_set_compact_layout(&context, TRUE);
+	bench_throughput_context("ProcParameter_Res 10k flat", &paramTree.message, &context);
+	bench_free_paramtree(&paramTree);
+}
+
+static double bench_lookups(SML_Tree* root, SML_Tree_Index* index, SML_TreePath* paths, uint32_t pathCount) {
+	uint32_t iterations;
+	uint32_t i;
+	uint32_t found = 0;
+	clock_t start = clock();
+
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		for(i=0; i<pathCount; i++) {
+			found += (index != NULL ? sml_tree_index_find(index, paths+i) : sml_tree_find(root, paths+i)) != NULL;
+		}
+	}
+	if(found != iterations * pathCount) {
+		printf("%s\n", "lookup failed");
+	}
+	return (double)iterations * (double)pathCount / bench_seconds(start);
+}
+
+/* Keeps the walks from being optimized away */
+static volatile uint64_t bench_sink;
+
+static uint64_t bench_walk_linked(SML_Tree* root) {
+	SML_Tree_Walk walk;
+	SML_Tree* node;
+	uint64_t sum = 0;
+
+	walk.depth = 0;
+	walk.overflow = FALSE;
+	for(node = root; node != NULL; node = p_sml_tree_next(&walk, node)) {
+		if(node->parameterValue != NULL) {
+			sum += node->parameterValue->choiceValue.smlValue->choiceValue.uint32;
+		}
+	}
+	return sum;
+}
+
+static uint64_t bench_walk_flat(SML_Flat_Tree* tree) {
+	uint64_t sum = 0;
+	uint32_t i;
+
+	for(i=0; i<tree->nodeCount; i++) {
+		if(tree->nodes[i].value != SML_FLAT_NO_VALUE) {
+			sum += tree->values[tree->nodes[i].value].choiceValue.smlValue->choiceValue.uint32;
+		}
+	}
+	return sum;
+}
+
+static void bench_tree_walk_report(void) {
+	Bench_ParamTree paramTree;
+	SML_Encode_Binary_Result result;
+	SML_Message linked;
+	SML_Message flat;
+	SML_Context context;
+	SML_Tree* root;
+	SML_Flat_Tree* flatTree;
+	uint32_t iterations;
+	uint32_t offset = 0;
+	clock_t start;
+
+	printf("%s\n", "== Parsed parameter tree walk (10000 nodes, fanout 10) ==");
+	printf("%-28s %12s\n", "layout", "nodes/s");
+
+	bench_build_paramtree(&paramTree, 10000, 10);
+	result = sml_encode_message_binary(&paramTree.message);
+	sml_parse_message_binary(result.resultBinary, &offset, &linked);
+	root = &linked.messageBody.choiceValue.getProcParameterResponse->parameterTree;
+	sml_context_init(&context);
+	sml_context_set_compact_layout(&context, TRUE);
+	sml_context_use(&context);
+	offset = 0;
+	sml_parse_message_binary(result.resultBinary, &offset, &flat);
+	flatTree = &flat.messageBody.choiceValue.getProcParameterResponseCompact->parameterTree;
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		bench_sink += bench_walk_linked(root);
+	}
+	printf("%-28s %12.0f\n", "SML_Tree (linked)", (double)iterations * 10000.0 / bench_seconds(start));
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		bench_sink += bench_walk_flat(flatTree);
+	}
+	printf("%-28s %12.0f\n", "SML_Flat_Tree", (double)iterations * 10000.0 / bench_seconds(start));
+
+	sml_parser_free();
+	sml_context_use(NULL);
+	sml_parser_free();
+	sml_encode_result_free(&result);
+	bench_free_paramtree(&paramTree);
+}
+
+static void bench_tree_lookup_report(void) {
+	Bench_ParamTree paramTree;
+	SML_Tree_Index* index;
+	SML_TreePath* paths;
+	char** components;
+	uint32_t depth;
+	uint32_t e;
+	uint32_t i;
+	clock_t start;
+	double seconds;
+
+	printf("%s\n", "== GetProcParameter_Res tree path lookup (10000 nodes, fanout 100) ==");
+	printf("%-28s %12s\n", "method", "lookups/s");
+
+	bench_build_paramtree(&paramTree, 10000, 100);
+	start = clock();
+	index = sml_tree_index_create(paramTree.nodes);
+	seconds = bench_seconds(start);
+
+	/* Query the path of every node */
+	paths = (SML_TreePath*)calloc(index->count, sizeof(SML_TreePath));
+	components = (char**)calloc(index->count * (SMLLIB_TREE_MAX_DEPTH + 1), sizeof(char*));
+	for(i=0; i<index->count; i++) {
+		paths[i].listSize = index->entries[i].depth + 1;
+		paths[i].path_Entry = components + i * (SMLLIB_TREE_MAX_DEPTH + 1);
+		for(depth = paths[i].listSize, e = i; depth > 0; depth--, e = index->entries[e].parent) {
+			paths[i].path_Entry[depth-1] = index->entries[e].node->parameterName;
+		}
+	}
+	printf("%-28s %12.0f\n", "sml_tree_find (linear)", bench_lookups(paramTree.nodes, NULL, paths, index->count));
+	printf("%-28s %12.0f\n", "sml_tree_index_find", bench_lookups(paramTree.nodes, index, paths, index->count));
+	printf("%-28s %12.3f\n", "index build (ms)", seconds * 1000.0);
+
+	free(components);
+	free(paths);
+	sml_tree_index_destroy(index);
+	bench_free_paramtree(&paramTree);
+}
+
+/* A year of 15-minute periods */
+#define BENCH_YEAR_ROWS 35040
+#define BENCH_YEAR_POOL_SIZE (128 * 1024 * 1024)
+
+typedef struct Bench_StreamRows {
+	SML_ValueEntry values[4];
+	uint32_t written;
+} Bench_StreamRows;
+
+static uint8_t bench_stream_row(void* user, uint32_t index, SML_ProfObjPeriodEntry* row) {
+	Bench_StreamRows* rows = (Bench_StreamRows*)user;
+	uint32_t v;
+
+	row->valTime.choiceTag = SML_TIME_SECINDEX;
+	row->valTime.choiceValue.secIndex = 12345678 + index * 900;
+	row->status = 0;
+	row->value_List.listSize = 4;
+	row->value_List.value_List_Entry = rows->values;
+	row->periodSignature = NULL;
+	for(v=0; v<4; v++) {
+		rows->values[v].value.choiceTag = SML_VALUE_UINT64;
+		rows->values[v].value.choiceValue.uint64 = 10000000 + index * 25 + v;
+		rows->values[v].valueSignature = NULL;
+	}
+	return SML_ENCODE_OK;
+}
+
+static uint8_t bench_stream_write(void* user, const unsigned char* data, uint32_t length) {
+	bench_sink += data[length-1];
+	((Bench_StreamRows*)user)->written += length;
+	return SML_ENCODE_OK;
+}
+
+static void bench_profile_stream_report(void) {
+	Bench_ProfilePack profilePack;
+	Bench_StreamRows rows;
+	SML_Encode_Binary_Result result;
+	SML_Context context;
+	uint32_t iterations;
+	uint32_t length;
+	size_t model;
+	clock_t start;
+	void* pool = malloc(BENCH_YEAR_POOL_SIZE);
+
+	printf("%s\n", "== GetProfilePack_Res year of 15-minute rows (35040x4, transport) ==");
+	printf("%-28s %10s %10s %12s\n", "encoder", "ms/msg", "MB/s", "peak bytes");
+
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, BENCH_YEAR_POOL_SIZE);
+	sml_context_use(&context);
+
+	/* The peak of the materializing encoder includes the period model it reads */
+	bench_build_profilepack(&profilePack, BENCH_YEAR_ROWS, 4);
+	model = BENCH_YEAR_ROWS * (sizeof(SML_ProfObjPeriodEntry) + 4 * sizeof(SML_ValueEntry));
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		result = sml_transport_encode_message(&profilePack.message);
+		length = result.length;
+		sml_parser_free();
+	}
+	printf("%-28s %10.1f %10.2f %12u\n", "sml_transport_encode_message",
+		bench_seconds(start) * 1000.0 / (double)iterations,
+		(double)iterations * (double)length / bench_seconds(start) / (1024.0 * 1024.0),
+		(unsigned int)(model + context.pool.high));
+	free(profilePack.periods);
+	free(profilePack.values);
+
+	profilePack.response.period_List.period_List_Entry = NULL;
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		rows.written = 0;
+		result = sml_transport_encode_profilepack_stream(&profilePack.message, bench_stream_row, &rows, bench_stream_write, &rows);
+	}
+	printf("%-28s %10.1f %10.2f %12u\n", "..._profilepack_stream",
+		bench_seconds(start) * 1000.0 / (double)iterations,
+		(double)iterations * (double)rows.written / bench_seconds(start) / (1024.0 * 1024.0),
+		(unsigned int)(sizeof(rows) + sizeof(SML_Encode_Stream) + context.pool.high));
+	free(profilePack.headers);
+
+	sml_context_use(NULL);
+	free(pool);
+}
+
+static uint8_t bench_decode_period(void* user, uint32_t index, SML_ProfObjPeriodEntry* period) {
+	(void)index;
+	*(uint64_t*)user += period->value_List.value_List_Entry[0].value.choiceValue.uint64;
+	return SML_PARSE_OK;
+}
+
+static void bench_profile_decode_report(void) {
+	Bench_ProfilePack profilePack;
+	SML_Encode_Binary_Result result;
+	SML_Context context;
+	SML_Message parsed;
+	uint32_t iterations;
+	uint32_t offset;
+	uint64_t sum;
+	clock_t start;
+	void* pool = malloc(BENCH_YEAR_POOL_SIZE);
+
+	printf("%s\n", "== GetProfilePack_Res year of 15-minute rows (35040x4, decode) ==");
+	printf("%-28s %10s %10s %12s\n", "decoder", "ms/msg", "MB/s", "peak bytes");
+
+	bench_build_profilepack(&profilePack, BENCH_YEAR_ROWS, 4);
+	result = sml_encode_message_binary(&profilePack.message);
+	free(profilePack.headers);
+	free(profilePack.periods);
+	free(profilePack.values);
+
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, BENCH_YEAR_POOL_SIZE);
+	sml_context_use(&context);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		offset = 0;
+		sml_parse_message_binary(result.resultBinary, &offset, &parsed);
+		sml_parser_free();
+	}
+	printf("%-28s %10.1f %10.2f %12u\n", "sml_parse_message_binary",
+		bench_seconds(start) * 1000.0 / (double)iterations,
+		(double)iterations * (double)result.length / bench_seconds(start) / (1024.0 * 1024.0),
+		(unsigned int)context.pool.high);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		offset = 0;
+		sum = 0;
+		sml_parse_profilepack_stream(result.resultBinary, &offset, &parsed, NULL, bench_decode_period, &sum);
+		sml_parser_free();
+		bench_sink += sum;
+	}
+	printf("%-28s %10.1f %10.2f %12u\n", "sml_parse_profilepack_stream",
+		bench_seconds(start) * 1000.0 / (double)iterations,
+		(double)iterations * (double)result.length / bench_seconds(start) / (1024.0 * 1024.0),
+		(unsigned int)context.pool.high);
+
+	sml_context_use(NULL);
+	sml_encode_result_free(&result);
+	free(pool);
+}
+
+#define BENCH_SCALE_VALUES 65536
+
+/* What consumers write without the batch API: one value at a time */
+static void bench_scale_naive(const int64_t* raw, const int8_t* scaler, uint32_t count, double* out) {
+	uint32_t i;
+	int k;
+
+	for(i=0; i<count; i++) {
+		out[i] = (double)raw[i];
+		for(k=0; k<scaler[i]; k++) {
+			out[i] *= 10.0;
+		}
+		for(k=0; k>scaler[i]; k--) {
+			out[i] /= 10.0;
+		}
+	}
+}
+
+static void bench_print_scale(const char* name, uint32_t iterations, clock_t start) {
+	printf("%-28s %14.0f\n", name, (double)iterations * BENCH_SCALE_VALUES / bench_seconds(start));
+}
+
+static void bench_scale_report(void) {
+	int64_t* raw = (int64_t*)malloc(BENCH_SCALE_VALUES * sizeof(int64_t));
+	int8_t* scaler = (int8_t*)malloc(BENCH_SCALE_VALUES * sizeof(int8_t));
+	double* out = (double*)malloc(BENCH_SCALE_VALUES * sizeof(double));
+	int64_t* fixed = (int64_t*)malloc(BENCH_SCALE_VALUES * sizeof(int64_t));
+	uint32_t iterations;
+	uint32_t i;
+	clock_t start;
+
+	for(i=0; i<BENCH_SCALE_VALUES; i++) {
+		raw[i] = 10000000 + (int64_t)i * 25;
+		scaler[i] = bench_scalers[i % 4];
+	}
+
+	printf("%s\n", "== Scaling of readings (65536 values, scalers -1/0) ==");
+	printf("%-28s %14s\n", "kernel", "values/s");
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		bench_scale_naive(raw, scaler, BENCH_SCALE_VALUES, out);
+		bench_sink += (uint64_t)out[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("per value loop (naive)", iterations, start);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		sml_scale_double(raw, scaler, BENCH_SCALE_VALUES, out);
+		bench_sink += (uint64_t)out[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("sml_scale_double", iterations, start);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		sml_scale_column_double(raw, -1, BENCH_SCALE_VALUES, out);
+		bench_sink += (uint64_t)out[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("sml_scale_column_double", iterations, start);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		p_sml_scale_column_double_scalar(raw, -1, BENCH_SCALE_VALUES, out);
+		bench_sink += (uint64_t)out[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("  scalar loop", iterations, start);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		sml_scale_fixed(raw, scaler, -3, BENCH_SCALE_VALUES, fixed);
+		bench_sink += (uint64_t)fixed[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("sml_scale_fixed (to -3)", iterations, start);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		sml_scale_column_fixed(raw, -1, -3, BENCH_SCALE_VALUES, fixed);
+		bench_sink += (uint64_t)fixed[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("sml_scale_column_fixed", iterations, start);
+
+	start = clock();
+	for(iterations=0; iterations == 0 || bench_seconds(start) < BENCH_MIN_SECONDS; iterations++) {
+		p_sml_scale_column_fixed_scalar(raw, -1, -3, BENCH_SCALE_VALUES, fixed);
+		bench_sink += (uint64_t)fixed[iterations % BENCH_SCALE_VALUES];
+	}
+	bench_print_scale("  scalar loop", iterations, start);
+
+	free(raw);
+	free(scaler);
+	free(out);
+	free(fixed);
+}
+
+int main(void) {
+	bench_size_report();
+	printf("%s", "\n");
+	bench_pool_report();
+	printf("%s", "\n");
+	bench_throughput_report();
+	printf("%s", "\n");
+	bench_tree_lookup_report();
+	printf("%s", "\n");
+	bench_tree_walk_report();
+	printf("%s", "\n");
+	bench_profile_stream_report();
+	printf("%s", "\n");
+	bench_profile_decode_report();
+	printf("%s", "\n");
+	bench_scale_report();
+	return 0;
+}
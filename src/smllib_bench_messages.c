@@ -0,0 +1,340 @@
+/**
+ * File name: smllib_bench_messages.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* clock_gettime() in C89 mode */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_latency.h"
+#include "smllib_validate.h"
+#include "smllib_synth.h"
+
+/*
+ * Per message type benchmark: encode, parse and validate, plain and as
+ * transport frame, of synthetic messages of every SML_MESSAGEBODY_* type the library
+ * encodes, at several payload sizes. Measure with the default TRACE_LEVEL=0.
+ *
+ * Runs are timed in batches that double until the minimum time is
+ * reached, so the clock is read a few dozen times per case rather than per
+ * run; the iteration count shows how much each row averages over.
+ *
+ * Built with LATENCY=on, the per call latency percentiles of all sizes
+ * follow on stderr (the timing itself costs some throughput).
+ *
+ * Bench_Messages [--csv] [--seconds=<minimum seconds per case>] [--seed=<n>]
+ */
+
+#define BENCH_OP_ENCODE 0
+#define BENCH_OP_PARSE 1
+#define BENCH_OP_TRANSPORT_ENCODE 2
+#define BENCH_OP_TRANSPORT_PARSE 3
+#define BENCH_OP_VALIDATE 4
+#define BENCH_OP_TRANSPORT_VALIDATE 5
+#define BENCH_OP_COUNT 6
+
+static const char* bench_op_names[BENCH_OP_COUNT] = {
+	"encode", "parse", "t-encode", "t-parse", "validate", "t-validate"
+};
+
+/* Entries, periods or tree nodes of the variable part */
+static const uint32_t bench_sizes[] = {1, 32, 1024};
+
+/* Pool large enough for the largest case, used to measure peak memory */
+#define BENCH_POOL_SIZE (64 * 1024 * 1024)
+
+typedef struct Bench_Options {
+	SML_Boolean csv;
+	double seconds;
+	uint32_t seed;
+} Bench_Options;
+
+/* The parse inputs live on the heap, sml_parser_free() would reset them with a pool */
+typedef struct Bench_Case {
+	SML_Message* message;
+	unsigned char* plain;			/* input of the parse cases */
+	uint32_t plainLength;
+	unsigned char* transport;		/* input of the transport parse cases */
+	uint32_t transportLength;
+} Bench_Case;
+
+static unsigned char* bench_copy(SML_Encode_Binary_Result* result, uint32_t* length) {
+	unsigned char* copy = NULL;
+
+	*length = 0;
+	if(result->resultCode == SML_ENCODE_OK) {
+		copy = (unsigned char*)malloc(result->length);
+		memcpy(copy, result->resultBinary, result->length);
+		*length = result->length;
+	}
+	sml_encode_result_free(result);
+	return copy;
+}
+
+static double bench_now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/* One run of the operation, returns the processed byte count, 0 on failure */
+static uint32_t bench_run(const Bench_Case* bench, uint32_t op) {
+	SML_Encode_Binary_Result result;
+	SML_Message parsed;
+	uint32_t offset = 0;
+	uint32_t length = 0;
+
+	switch(op) {
+		case BENCH_OP_ENCODE:
+		case BENCH_OP_TRANSPORT_ENCODE:
+			result = (op == BENCH_OP_ENCODE) ?
+				sml_encode_message_binary(bench->message) : sml_transport_encode_message(bench->message);
+			if(result.resultCode == SML_ENCODE_OK) {
+				length = result.length;
+			}
+			sml_encode_result_free(&result);
+		break;
+		case BENCH_OP_PARSE:
+			if(sml_parse_message_binary(bench->plain, &offset, &parsed) == SML_PARSE_OK) {
+				length = bench->plainLength;
+			}
+			sml_parser_free();
+		break;
+		case BENCH_OP_TRANSPORT_PARSE:
+			if(sml_transport_parse_message(bench->transport, &offset, &parsed) == SML_PARSE_OK) {
+				length = bench->transportLength;
+			}
+			sml_parser_free();
+		break;
+		case BENCH_OP_VALIDATE:
+			if(sml_validate_message(bench->plain, bench->plainLength, &offset) == SML_PARSE_OK) {
+				length = bench->plainLength;
+			}
+		break;
+		default:
+			if(sml_transport_validate_message(bench->transport, bench->transportLength, &offset) == SML_PARSE_OK) {
+				length = bench->transportLength;
+			}
+		break;
+	}
+	return length;
+}
+
+/* Peak pool bytes of one run, encoder output included */
+static size_t bench_peak(const Bench_Case* bench, uint32_t op, void* pool) {
+	SML_Context context;
+	SML_Context* previous;
+	size_t peak;
+
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, BENCH_POOL_SIZE);
+	previous = sml_context_use(&context);
+	peak = (bench_run(bench, op) > 0) ? context.pool.high : 0;
+	sml_context_use(previous);
+	return peak;
+}
+
+static void bench_print_header(const Bench_Options* options) {
+	if(options->csv) {
+		printf("%s\n", "type,size,operation,bytes,msgs_per_s,mb_per_s,allocs_per_op,peak_bytes,iterations");
+	}
+	else {
+		printf("%-22s %6s %-10s %9s %12s %9s %10s %10s %10s\n",
+			"type", "size", "operation", "bytes", "msgs/s", "MB/s", "allocs/op", "peak", "iterations");
+	}
+}
+
+static void bench_print(const Bench_Options* options, uint32_t choiceTag, uint32_t size, uint32_t op,
+		uint32_t length, double msgsPerSecond, double allocsPerOp, size_t peak, uint32_t iterations) {
+	double mbPerSecond = msgsPerSecond * (double)length / (1024.0 * 1024.0);
+
+	if(options->csv) {
+		printf("%s,%u,%s,%u,%.0f,%.3f,%.1f,%lu,%lu\n", sml_synth_type_name(choiceTag), (unsigned int)size,
+			bench_op_names[op], (unsigned int)length, msgsPerSecond, mbPerSecond, allocsPerOp, (unsigned long)peak,
+			(unsigned long)iterations);
+	}
+	else {
+		printf("%-22s %6u %-10s %9u %12.0f %9.2f %10.1f %10lu %10lu\n", sml_synth_type_name(choiceTag), (unsigned int)size,
+			bench_op_names[op], (unsigned int)length, msgsPerSecond, mbPerSecond, allocsPerOp, (unsigned long)peak,
+			(unsigned long)iterations);
+	}
+}
+
+/* Measures all operations of one message, returns FALSE if any of them fails */
+static SML_Boolean bench_case(const Bench_Options* options, SML_Message* message, uint32_t size, void* pool) {
+	SML_Alloc_Stats* stats = &sml_context_current()->allocStats;
+	SML_Encode_Binary_Result result;
+	SML_Boolean ok = TRUE;
+	Bench_Case bench;
+	uint32_t iterations;
+	uint32_t batch;
+	uint32_t allocations;
+	uint32_t length;
+	uint32_t op;
+	uint32_t i;
+	double start;
+	double seconds;
+
+	bench.message = message;
+	result = sml_encode_message_binary(message);
+	bench.plain = bench_copy(&result, &bench.plainLength);
+	result = sml_transport_encode_message(message);
+	bench.transport = bench_copy(&result, &bench.transportLength);
+	if(bench.plain == NULL || bench.transport == NULL) {
+		fprintf(stderr, "%s size %u does not encode\n", sml_synth_type_name(message->messageBody.choiceTag), (unsigned int)size);
+		ok = FALSE;
+	}
+
+	for(op=0; ok && op<BENCH_OP_COUNT; op++) {
+		length = 0;
+		allocations = stats->total.allocations;
+		iterations = 0;
+		start = bench_now();
+		/* The clock is read once per batch, the batch doubles until the minimum time is reached */
+		for(batch=1; ; batch*=2) {
+			for(i=0; i<batch; i++) {
+				length = bench_run(&bench, op);
+				if(length == 0) {
+					break;
+				}
+			}
+			iterations += i;
+			seconds = bench_now() - start;
+			if(length == 0 || seconds >= options->seconds || batch >= 0x80000000UL) {
+				break;
+			}
+		}
+		if(length == 0) {
+			fprintf(stderr, "%s %s size %u failed\n", sml_synth_type_name(message->messageBody.choiceTag),
+				bench_op_names[op], (unsigned int)size);
+			ok = FALSE;
+			break;
+		}
+		/* --seconds=0 times a single run */
+		if(seconds <= 0.0) {
+			seconds = 1e-9;
+		}
+		bench_print(options, message->messageBody.choiceTag, size, op, length,
+			(double)iterations / seconds,
+			(double)(stats->total.allocations - allocations) / (double)iterations,
+			bench_peak(&bench, op, pool), iterations);
+	}
+
+	free(bench.plain);
+	free(bench.transport);
+	return ok;
+}
+
+static SML_Boolean bench_options(int argc, char** argv, Bench_Options* options) {
+	int i;
+
+	options->csv = FALSE;
+	options->seconds = 0.2;
+	options->seed = 1;
+	for(i=1; i<argc; i++) {
+		if(strcmp(argv[i], "--csv") == 0) {
+			options->csv = TRUE;
+		}
+		else if(strncmp(argv[i], "--seconds=", 10) == 0) {
+			options->seconds = atof(argv[i] + 10);
+		}
+		else if(strncmp(argv[i], "--seed=", 7) == 0) {
+			options->seed = (uint32_t)strtoul(argv[i] + 7, NULL, 10);
+		}
+		else {
+			fprintf(stderr, "%s\n", "usage: Bench_Messages [--csv] [--seconds=<s>] [--seed=<n>]");
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int main(int argc, char** argv) {
+	Bench_Options options;
+	SML_Synth synth;
+	SML_Message* message;
+	void* pool;
+	int retValue = 0;
+	uint32_t choiceTag;
+	uint32_t t;
+	uint32_t s;
+
+	#ifdef SMLLIB_STATIC_POOL
+		SML_Context heap;
+		void* heapPool = malloc(BENCH_POOL_SIZE);
+	#endif
+	#ifdef SMLLIB_LATENCY
+		static SML_Latency latency;
+	#endif
+
+	if(!bench_options(argc, argv, &options)) {
+		return 2;
+	}
+	pool = malloc(BENCH_POOL_SIZE);
+	#ifdef SMLLIB_STATIC_POOL
+		/* No heap allocator in this build, throughput runs on a pool as well */
+		sml_context_init(&heap);
+		sml_context_set_pool(&heap, heapPool, BENCH_POOL_SIZE);
+		sml_context_use(&heap);
+	#endif
+	#ifdef SMLLIB_LATENCY
+		sml_latency_init(&latency);
+		sml_context_set_latency(sml_context_current(), &latency);
+	#endif
+
+	bench_print_header(&options);
+	for(t=0; t<SML_SYNTH_TYPE_COUNT; t++) {
+		choiceTag = sml_synth_types[t];
+		for(s=0; s<sizeof(bench_sizes)/sizeof(bench_sizes[0]); s++) {
+			if(s > 0 && !sml_synth_is_sized(choiceTag)) {
+				break;
+			}
+			sml_synth_init(&synth, options.seed);
+			message = sml_synth_message(&synth, choiceTag, bench_sizes[s]);
+			if(!bench_case(&options, message, sml_synth_is_sized(choiceTag) ? bench_sizes[s] : 0, pool)) {
+				retValue = 1;
+			}
+			sml_synth_free(&synth);
+		}
+	}
+
+	#ifdef SMLLIB_LATENCY
+		sml_context_set_latency(sml_context_current(), NULL);
+		#ifndef SMLLIB_FREESTANDING
+			sml_latency_report(stderr, &latency);
+		#endif
+	#endif
+	free(pool);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_use(NULL);
+		free(heapPool);
+	#endif
+	return retValue;
+}
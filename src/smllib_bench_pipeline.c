@@ -0,0 +1,335 @@
+/**
+ * File name: smllib_bench_pipeline.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* clock_gettime() in C89 mode */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_deframer.h"
+#include "smllib_pipeline.h"
+#include "smllib_synth.h"
+
+/*
+ * Throughput of the frame pipeline (see smllib_pipeline.h): synthetic
+ * GetList_Res transport frames are fed through the inputs of one reader
+ * thread, parsed by 1 .. --workers parse workers and counted by the
+ * exporters. The first line is the same deframe and parse work done by
+ * the reader thread alone. Wall clock time, so run it on an idle machine.
+ *
+ * Bench_Pipeline [--workers=<n>] [--exporters=<n>] [--inputs=<n>]
+ *   [--messages=<n>] [--entries=<n>] [--seed=<n>]
+ */
+
+/* Distinct frames, cycled through for the whole run */
+#define BENCH_VARIANTS 64
+
+#define BENCH_FRAMES 256
+#define BENCH_POOL_SIZE (4 * 1024 * 1024)
+
+typedef struct Bench_Options {
+	uint32_t workers;
+	uint32_t exporters;
+	uint32_t inputs;
+	uint32_t messages;
+	uint32_t entries;
+	uint32_t seed;
+} Bench_Options;
+
+typedef struct Bench_Frames {
+	unsigned char* data[BENCH_VARIANTS];
+	uint32_t length[BENCH_VARIANTS];
+	uint32_t maxLength;
+	size_t maxPool;			/* parser memory of the largest message */
+} Bench_Frames;
+
+/* Value list entries seen by the exporters */
+static uint64_t bench_entries;
+
+static double bench_now(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void bench_export(void* user, SML_Pipeline_Frame* frame) {
+	(void)user;
+	if(frame->result == SML_PARSE_OK) {
+		__atomic_add_fetch(&bench_entries, frame->message.messageBody.choiceValue.getListResponse->valList.listSize, __ATOMIC_RELAXED);
+	}
+}
+
+/* Encodes the frames and measures their parser memory, FALSE on failure */
+static SML_Boolean bench_frames(const Bench_Options* options, Bench_Frames* frames, void* pool) {
+	SML_Encode_Binary_Result result;
+	SML_Context context;
+	SML_Context* previous;
+	SML_Message parsed;
+	SML_Synth synth;
+	uint32_t offset;
+	uint32_t i;
+
+	frames->maxLength = 0;
+	frames->maxPool = 0;
+	sml_synth_init(&synth, options->seed);
+	sml_context_init(&context);
+	for(i=0; i<BENCH_VARIANTS; i++) {
+		result = sml_transport_encode_message(
+			sml_synth_message(&synth, SML_MESSAGEBODY_GETLIST_RESPONSE, 1 + sml_synth_random(&synth) % options->entries));
+		if(result.resultCode != SML_ENCODE_OK) {
+			sml_synth_free(&synth);
+			return FALSE;
+		}
+		frames->data[i] = (unsigned char*)malloc(result.length);
+		memcpy(frames->data[i], result.resultBinary, result.length);
+		frames->length[i] = result.length;
+		if(result.length > frames->maxLength) {
+			frames->maxLength = result.length;
+		}
+		sml_encode_result_free(&result);
+
+		sml_context_set_pool(&context, pool, BENCH_POOL_SIZE);
+		previous = sml_context_use(&context);
+		offset = 0;
+		if(sml_transport_parse_message(frames->data[i], &offset, &parsed) != SML_PARSE_OK) {
+			sml_context_use(previous);
+			sml_synth_free(&synth);
+			return FALSE;
+		}
+		if(context.pool.high > frames->maxPool) {
+			frames->maxPool = context.pool.high;
+		}
+		sml_context_use(previous);
+	}
+	sml_synth_free(&synth);
+	return TRUE;
+}
+
+static void bench_print(const char* stage, uint32_t workers, uint32_t exporters, uint32_t messages, uint64_t bytes, double seconds) {
+	printf("%-10s %7u %9u %12.0f %9.2f\n", stage, (unsigned int)workers, (unsigned int)exporters,
+		(double)messages / seconds, (double)bytes / seconds / (1024.0 * 1024.0));
+}
+
+/* Deframing and parsing in the calling thread, returns the frames parsed */
+static uint32_t bench_single(const Bench_Options* options, const Bench_Frames* frames, void* pool, uint64_t* bytes) {
+	SML_Deframer* deframers;
+	unsigned char* buffers;
+	SML_Context context;
+	SML_Context* previous;
+	SML_Message parsed;
+	const unsigned char* frame;
+	uint32_t length;
+	uint32_t offset;
+	uint32_t parsedCount = 0;
+	uint32_t half;
+	uint32_t d;
+	uint32_t i;
+
+	deframers = (SML_Deframer*)malloc(options->inputs * sizeof(SML_Deframer));
+	buffers = (unsigned char*)malloc((size_t)options->inputs * frames->maxLength);
+	for(i=0; i<options->inputs; i++) {
+		sml_deframer_init(&deframers[i], buffers + (size_t)i * frames->maxLength, frames->maxLength);
+	}
+	sml_context_init(&context);
+	previous = sml_context_use(&context);
+	*bytes = 0;
+	for(i=0; i<options->messages; i++) {
+		d = i % options->inputs;
+		half = frames->length[i % BENCH_VARIANTS] / 2;
+		sml_deframer_feed(&deframers[d], frames->data[i % BENCH_VARIANTS], half);
+		sml_deframer_feed(&deframers[d], frames->data[i % BENCH_VARIANTS] + half, frames->length[i % BENCH_VARIANTS] - half);
+		while(sml_deframer_next(&deframers[d], &frame, &length) == SML_PARSE_OK) {
+			sml_context_set_pool(&context, pool, frames->maxPool);
+			offset = 0;
+			if(sml_transport_parse_message(frame, &offset, &parsed) == SML_PARSE_OK) {
+				parsedCount++;
+			}
+			*bytes += length;
+		}
+	}
+	sml_context_use(previous);
+	free(buffers);
+	free(deframers);
+	return parsedCount;
+}
+
+/* The same through the pipeline, returns the frames exported */
+static uint32_t bench_pipeline(const Bench_Options* options, const Bench_Frames* frames, uint32_t workers, uint32_t exporters, uint64_t* bytes) {
+	static SML_Pipeline pipeline;
+	SML_Pipeline_Config config;
+	SML_Pipeline_Input* inputs;
+	void* memory;
+	uint32_t exported = 0;
+	uint32_t half;
+	uint32_t d;
+	uint32_t i;
+
+	memset(&config, 0, sizeof(config));
+	config.workers = workers;
+	config.exporters = exporters;
+	config.frames = BENCH_FRAMES;
+	config.frameSize = frames->maxLength;
+	config.poolSize = (uint32_t)frames->maxPool;
+	config.exportFrame = bench_export;
+	memory = malloc(sml_pipeline_memory_size(&config));
+	if(sml_pipeline_init(&pipeline, &config, memory) != SML_PARSE_OK || sml_pipeline_start(&pipeline) != SML_PARSE_OK) {
+		free(memory);
+		return 0;
+	}
+	inputs = (SML_Pipeline_Input*)malloc(options->inputs * sizeof(SML_Pipeline_Input));
+	for(i=0; i<options->inputs; i++) {
+		sml_pipeline_input_init(&pipeline, &inputs[i], i, NULL);
+	}
+	*bytes = 0;
+	for(i=0; i<options->messages; i++) {
+		d = i % options->inputs;
+		half = frames->length[i % BENCH_VARIANTS] / 2;
+		sml_pipeline_input_feed(&pipeline, &inputs[d], frames->data[i % BENCH_VARIANTS], half);
+		sml_pipeline_input_feed(&pipeline, &inputs[d], frames->data[i % BENCH_VARIANTS] + half, frames->length[i % BENCH_VARIANTS] - half);
+		*bytes += frames->length[i % BENCH_VARIANTS];
+	}
+	for(i=0; i<options->inputs; i++) {
+		sml_pipeline_input_close(&pipeline, &inputs[i]);
+	}
+	sml_pipeline_stop(&pipeline);
+
+	for(i=0; i<exporters; i++) {
+		exported += (uint32_t)pipeline.exporters[i].frames;
+	}
+	for(i=0; i<workers; i++) {
+		exported -= (uint32_t)pipeline.workers[i].parseErrors;
+	}
+	free(inputs);
+	free(memory);
+	return exported;
+}
+
+static SML_Boolean bench_options(int argc, char** argv, Bench_Options* options) {
+	int i;
+
+	options->workers = 4;
+	options->exporters = 1;
+	options->inputs = 8;
+	options->messages = 200000;
+	options->entries = 16;
+	options->seed = 1;
+	for(i=1; i<argc; i++) {
+		if(strncmp(argv[i], "--workers=", 10) == 0) {
+			options->workers = (uint32_t)strtoul(argv[i] + 10, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--exporters=", 12) == 0) {
+			options->exporters = (uint32_t)strtoul(argv[i] + 12, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--inputs=", 9) == 0) {
+			options->inputs = (uint32_t)strtoul(argv[i] + 9, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--messages=", 11) == 0) {
+			options->messages = (uint32_t)strtoul(argv[i] + 11, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--entries=", 10) == 0) {
+			options->entries = (uint32_t)strtoul(argv[i] + 10, NULL, 10);
+		}
+		else if(strncmp(argv[i], "--seed=", 7) == 0) {
+			options->seed = (uint32_t)strtoul(argv[i] + 7, NULL, 10);
+		}
+		else {
+			options->workers = 0;
+		}
+	}
+	/* Every input holds one frame */
+	if(options->workers == 0 || options->workers > SML_PIPELINE_MAX_WORKERS || options->exporters == 0 ||
+		options->inputs == 0 || options->inputs >= BENCH_FRAMES / 2 || options->entries == 0) {
+		fprintf(stderr, "%s\n", "usage: Bench_Pipeline [--workers=<1-16>] [--exporters=<n>] [--inputs=<1-127>] "
+			"[--messages=<n>] [--entries=<n>] [--seed=<n>]");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+int main(int argc, char** argv) {
+	Bench_Options options;
+	Bench_Frames frames;
+	void* pool;
+	uint64_t bytes;
+	uint32_t done;
+	uint32_t workers;
+	uint32_t exporters;
+	double start;
+	int retValue = 0;
+	uint32_t i;
+
+	#ifdef SMLLIB_STATIC_POOL
+		SML_Context heap;
+		void* heapPool = malloc(BENCH_POOL_SIZE);
+	#endif
+
+	if(!bench_options(argc, argv, &options)) {
+		return 2;
+	}
+	pool = malloc(BENCH_POOL_SIZE);
+	#ifdef SMLLIB_STATIC_POOL
+		/* No heap allocator in this build, the encoder runs on a pool as well */
+		sml_context_init(&heap);
+		sml_context_set_pool(&heap, heapPool, BENCH_POOL_SIZE);
+		sml_context_use(&heap);
+	#endif
+	if(!bench_frames(&options, &frames, pool)) {
+		fprintf(stderr, "%s\n", "synthetic frames do not encode or parse");
+		return 1;
+	}
+
+	printf("%-10s %7s %9s %12s %9s\n", "stage", "workers", "exporters", "frames/s", "MB/s");
+	start = bench_now();
+	done = bench_single(&options, &frames, pool, &bytes);
+	bench_print("single", 0, 0, done, bytes, bench_now() - start);
+	if(done != options.messages) {
+		retValue = 1;
+	}
+	for(workers=1; workers<=options.workers; workers=(workers * 2 > options.workers && workers < options.workers) ? options.workers : workers * 2) {
+		exporters = (options.exporters < workers) ? options.exporters : workers;
+		start = bench_now();
+		done = bench_pipeline(&options, &frames, workers, exporters, &bytes);
+		bench_print("pipeline", workers, exporters, done, bytes, bench_now() - start);
+		if(done != options.messages) {
+			fprintf(stderr, "%u of %u frames exported\n", (unsigned int)done, (unsigned int)options.messages);
+			retValue = 1;
+		}
+	}
+
+	for(i=0; i<BENCH_VARIANTS; i++) {
+		free(frames.data[i]);
+	}
+	free(pool);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_use(NULL);
+		free(heapPool);
+	#endif
+	return retValue;
+}
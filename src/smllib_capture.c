@@ -0,0 +1,226 @@
+/**
+ * File name: smllib_capture.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* madvise() and the MADV_ flags, 64 bit off_t on 32 bit hosts */
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "smllib_capture.h"
+#include "smllib_parse.h"
+#include "smllib_validate.h"
+#include "smllib_context.h"
+#include "smllib_metrics.h"
+#include "smllib_tools.h"
+
+/* Length of a start escape, the search resumes behind an invalid one */
+#define SML_CAPTURE_ESCAPE_LENGTH 8
+
+uint8_t sml_capture_open(SML_Capture* capture, const char* path) {
+	struct stat status;
+	void* data;
+	long pageSize;
+	int error;
+	int fd;
+
+	p_sml_memset(capture, 0, sizeof(SML_Capture));
+	capture->window = SML_CAPTURE_WINDOW;
+	pageSize = sysconf(_SC_PAGESIZE);
+	capture->pageSize = (pageSize > 0) ? (uint32_t)pageSize : 4096;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		return SML_PARSE_ERROR;
+	}
+	error = 0;
+	if(fstat(fd, &status) != 0) {
+		error = errno;
+	}
+	else if(status.st_size < 0 || (uint64_t)(size_t)status.st_size != (uint64_t)status.st_size) {
+		error = EOVERFLOW;
+	}
+	if(error != 0) {
+		close(fd);
+		errno = error;
+		return SML_PARSE_ERROR;
+	}
+
+	capture->size = (uint64_t)status.st_size;
+	if(capture->size > 0) {
+		data = mmap(NULL, (size_t)capture->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(data == MAP_FAILED) {
+			error = errno;
+			close(fd);
+			errno = error;
+			capture->size = 0;
+			return SML_PARSE_ERROR;
+		}
+		madvise(data, (size_t)capture->size, MADV_SEQUENTIAL);
+		capture->data = (const unsigned char*)data;
+	}
+
+	/* The mapping keeps the file open */
+	close(fd);
+	p_sml_capture_advise(capture);
+	return SML_PARSE_OK;
+}
+
+void sml_capture_close(SML_Capture* capture) {
+	if(capture->data != NULL) {
+		munmap((void*)capture->data, (size_t)capture->size);
+	}
+	capture->data = NULL;
+	capture->size = 0;
+	capture->offset = 0;
+}
+
+uint8_t sml_capture_next_frame(SML_Capture* capture, const unsigned char** frame, uint32_t* length) {
+	const unsigned char* window;
+	uint32_t span;
+	uint32_t start;
+	uint32_t frameEnd;
+
+	while(capture->offset < capture->size) {
+		window = capture->data + capture->offset;
+		span = p_sml_capture_span(capture, capture->offset);
+
+		start = p_sml_transport_find_start(window, 0, span);
+		if(start == span && capture->offset + span < capture->size) {
+			/* A start escape may cross the end of the span */
+			start = span - (SML_CAPTURE_ESCAPE_LENGTH - 1);
+		}
+		if(start > 0) {
+			p_sml_capture_skip(capture, start);
+			continue;
+		}
+
+		frameEnd = 0;
+		if(sml_transport_validate_message(window, span, &frameEnd) == SML_PARSE_OK) {
+			capture->frameOffset = capture->offset;
+			capture->frameLength = frameEnd;
+			capture->offset += frameEnd;
+			p_sml_capture_advise(capture);
+			*frame = window;
+			*length = frameEnd;
+			return SML_PARSE_OK;
+		}
+
+		/* A start escape cannot overlap itself, the next one is behind this one */
+		capture->skippedFrames++;
+		SML_METRIC_ADD(framesSkipped, 1);
+		p_sml_capture_skip(capture, SML_CAPTURE_ESCAPE_LENGTH);
+	}
+	return SML_CAPTURE_END;
+}
+
+uint8_t sml_capture_next(SML_Capture* capture, SML_Message* message) {
+	const unsigned char* frame;
+	uint32_t length;
+	uint32_t offset;
+	uint8_t retValue;
+	size_t mark;
+
+	for(;;) {
+		retValue = sml_capture_next_frame(capture, &frame, &length);
+		if(retValue != SML_PARSE_OK) {
+			return retValue;
+		}
+
+		/* The frame is parsed in place, a failed one leaves nothing behind */
+		mark = p_sml_parser_mark();
+		offset = 0;
+		retValue = sml_transport_parse_message(frame, &offset, message);
+		if(retValue == SML_PARSE_OK) {
+			return SML_PARSE_OK;
+		}
+		p_sml_parser_release(mark);
+		if(retValue == SML_PARSE_NOMEM) {
+			capture->offset = capture->frameOffset;
+			return SML_PARSE_NOMEM;
+		}
+		capture->skippedFrames++;
+		capture->skippedBytes += length;
+		SML_METRIC_ADD(framesSkipped, 1);
+		SML_METRIC_ADD(resyncBytes, length);
+	}
+}
+
+void sml_capture_seek(SML_Capture* capture, uint64_t offset) {
+	uint64_t page = ~((uint64_t)capture->pageSize - 1);
+
+	capture->offset = (offset < capture->size) ? offset : capture->size;
+	capture->prefetched = capture->offset;
+	if((capture->offset & page) < capture->released) {
+		capture->released = capture->offset & page;
+	}
+	p_sml_capture_advise(capture);
+}
+
+uint32_t p_sml_capture_span(const SML_Capture* capture, uint64_t offset) {
+	uint64_t span = capture->size - offset;
+
+	return (span > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)span;
+}
+
+void p_sml_capture_advise(SML_Capture* capture) {
+	uint64_t page = ~((uint64_t)capture->pageSize - 1);
+	uint64_t ahead = capture->offset + capture->window;
+	uint64_t behind;
+	uint64_t from;
+
+	if(capture->data == NULL) {
+		return;
+	}
+
+	/* Both in steps of half a window, not once per frame */
+	if(ahead > capture->size) {
+		ahead = capture->size;
+	}
+	if(ahead > capture->prefetched &&
+		(ahead - capture->prefetched >= capture->window / 2 || ahead == capture->size)) {
+		from = capture->prefetched & page;
+		madvise((void*)(capture->data + from), (size_t)(ahead - from), MADV_WILLNEED);
+		capture->prefetched = ahead;
+	}
+
+	if(capture->offset > capture->window) {
+		behind = (capture->offset - capture->window) & page;
+		if(behind >= capture->released + capture->window / 2) {
+			madvise((void*)(capture->data + capture->released), (size_t)(behind - capture->released), MADV_DONTNEED);
+			capture->released = behind;
+		}
+	}
+}
+
+void p_sml_capture_skip(SML_Capture* capture, uint64_t length) {
+	capture->offset += length;
+	capture->skippedBytes += length;
+	SML_METRIC_ADD(resyncBytes, length);
+	p_sml_capture_advise(capture);
+}
@@ -0,0 +1,399 @@
+/**
+ * File name: smllib_context.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_context.h"
+#include "smllib_tools.h"
+
+static SML_THREAD_LOCAL SML_Context p_sml_default_context;
+
+#ifdef SMLLIB_STATIC_POOL
+	/* Heap-free build: the default context allocates from this pool */
+	#ifndef SMLLIB_STATIC_POOL_SIZE
+		#define SMLLIB_STATIC_POOL_SIZE 2048
+	#endif
+	static SML_THREAD_LOCAL unsigned char p_sml_default_pool[SMLLIB_STATIC_POOL_SIZE];
+#endif
+
+#ifdef SMLLIB_THREAD_CONTEXT
+	SML_THREAD_LOCAL SML_Context* p_sml_thread_context = NULL;
+#else
+	SML_Context* p_sml_context = &p_sml_default_context;
+#endif
+
+void sml_context_init(SML_Context* context) {
+	p_sml_memset(context, 0, sizeof(SML_Context));
+	context->pool.last = SML_POOL_NO_BLOCK;
+}
+
+void sml_context_set_pool(SML_Context* context, void* pool, size_t size) {
+	context->pool.base = (unsigned char*)pool;
+	context->pool.size = (pool != NULL) ? size : 0;
+	context->pool.used = 0;
+	context->pool.last = SML_POOL_NO_BLOCK;
+	context->pool.high = 0;
+	context->pool.floor = 0;
+}
+
+size_t sml_context_pool_worst_case(const SML_Context* context, uint32_t choiceTag) {
+	return context->poolWorstCase[sml_messagebody_index(choiceTag)];
+}
+
+const SML_Error* sml_context_error(const SML_Context* context) {
+	return &context->error;
+}
+
+void sml_context_set_allocator(SML_Context* context, const SML_Allocator* allocator) {
+	if(allocator == NULL) {
+		p_sml_memset(&context->allocator, 0, sizeof(SML_Allocator));
+	}
+	else {
+		context->allocator = *allocator;
+	}
+}
+
+void sml_context_set_compact_layout(SML_Context* context, SML_Boolean enable) {
+	context->compactLayout = enable;
+}
+
+SML_Boolean sml_messagebody_has_compact_layout(uint32_t choiceTag) {
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+void sml_context_set_alloc_hook(SML_Context* context, SML_Alloc_Hook hook, void* user) {
+	context->allocHook = hook;
+	context->allocHookUser = user;
+}
+
+void sml_context_set_trace_sink(SML_Context* context, SML_Trace_Sink sink, void* user) {
+	context->traceSink = sink;
+	context->traceSinkUser = user;
+}
+
+SML_Context* sml_context_use(SML_Context* context) {
+	SML_Context* previous = p_sml_context;
+
+	#ifdef SMLLIB_THREAD_CONTEXT
+		p_sml_thread_context = (context != NULL) ? context : &p_sml_default_context;
+	#else
+		p_sml_context = (context != NULL) ? context : &p_sml_default_context;
+	#endif
+	return previous;
+}
+
+SML_Context* sml_context_current(void) {
+	return p_sml_context;
+}
+
+#ifdef SMLLIB_THREAD_CONTEXT
+SML_Context* p_sml_context_thread_default(void) {
+	p_sml_thread_context = &p_sml_default_context;
+	return p_sml_thread_context;
+}
+#endif
+
+void sml_context_reset_stats(SML_Context* context) {
+	p_sml_memset(&context->allocStats, 0, sizeof(SML_Alloc_Stats));
+	p_sml_memset(&context->messageStart, 0, sizeof(SML_Alloc_Counter));
+	p_sml_memset(context->poolWorstCase, 0, sizeof(context->poolWorstCase));
+}
+
+uint32_t sml_messagebody_index(uint32_t choiceTag) {
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST: return 0;
+		case SML_MESSAGEBODY_OPEN_RESPONSE: return 1;
+		case SML_MESSAGEBODY_CLOSE_REQUEST: return 2;
+		case SML_MESSAGEBODY_CLOSE_RESPONSE: return 3;
+		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST: return 4;
+		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE: return 5;
+		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST: return 6;
+		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE: return 7;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST: return 8;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE: return 9;
+		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST: return 10;
+		case SML_MESSAGEBODY_GETLIST_REQUEST: return 11;
+		case SML_MESSAGEBODY_GETLIST_RESPONSE: return 12;
+		case SML_MESSAGEBODY_ATTENTION_RESPONSE: return 13;
+		default: return SML_MESSAGEBODY_INDEX_NONE;
+	}
+}
+
+void sml_encode_result_free(SML_Encode_Binary_Result* result) {
+	if(result->resultBinary != NULL) {
+		p_sml_free(result->resultBinary);
+		result->resultBinary = NULL;
+	}
+	result->errorMessage = NULL;
+	result->length = 0;
+}
+
+static void p_sml_count_alloc(size_t size, SML_Boolean resize) {
+	SML_Alloc_Counter* counter = &p_sml_context->allocStats.messageType[sml_messagebody_index(p_sml_context->messageType)];
+
+	if(resize) {
+		p_sml_context->allocStats.total.reallocations++;
+		counter->reallocations++;
+	}
+	else {
+		p_sml_context->allocStats.total.allocations++;
+		counter->allocations++;
+	}
+	p_sml_context->allocStats.total.bytes += size;
+	counter->bytes += size;
+	if(p_sml_context->allocHook != NULL) {
+		p_sml_context->allocHook(p_sml_context->allocHookUser, p_sml_context->messageType, size);
+	}
+}
+
+static void* p_sml_pool_alloc(SML_Pool* pool, size_t size) {
+	size_t offset = (pool->used + SMLLIB_POOL_ALIGN - 1) / SMLLIB_POOL_ALIGN * SMLLIB_POOL_ALIGN;
+
+	if(offset > pool->size || size > pool->size - offset) {
+		return NULL;
+	}
+	pool->last = offset;
+	pool->used = offset + size;
+	if(pool->used > pool->high) {
+		pool->high = pool->used;
+	}
+	p_sml_memset(pool->base + offset, 0, size);
+	return pool->base + offset;
+}
+
+static void* p_sml_pool_realloc(SML_Pool* pool, void* ptr, size_t oldSize, size_t size) {
+	size_t offset = (size_t)((unsigned char*)ptr - pool->base);
+	void* block;
+
+	/* The most recent block grows in place */
+	if(offset == pool->last) {
+		if(size > pool->size - offset) {
+			return NULL;
+		}
+		pool->used = offset + size;
+		if(pool->used > pool->high) {
+			pool->high = pool->used;
+		}
+		return ptr;
+	}
+	/* Older blocks are copied, the pool does not record their size */
+	block = p_sml_pool_alloc(pool, size);
+	if(block != NULL) {
+		p_sml_memcpy(block, ptr, (oldSize < size) ? oldSize : size);
+	}
+	return block;
+}
+
+static void p_sml_pool_free(SML_Pool* pool, void* ptr) {
+	if((size_t)((unsigned char*)ptr - pool->base) == pool->last) {
+		pool->used = pool->last;
+		pool->last = SML_POOL_NO_BLOCK;
+	}
+}
+
+static SML_Pool* p_sml_active_pool(void) {
+	#ifdef SMLLIB_STATIC_POOL
+		if(p_sml_context == &p_sml_default_context && p_sml_context->pool.base == NULL) {
+			sml_context_set_pool(p_sml_context, p_sml_default_pool, SMLLIB_STATIC_POOL_SIZE);
+		}
+	#endif
+	return (p_sml_context->pool.base != NULL) ? &p_sml_context->pool : NULL;
+}
+
+void* p_sml_calloc(size_t count, size_t size) {
+	void* ptr;
+	size_t total = count * size;
+	SML_Pool* pool = p_sml_active_pool();
+
+	p_sml_count_alloc(total, FALSE);
+	if(pool != NULL) {
+		ptr = p_sml_pool_alloc(pool, total);
+	}
+	else if(p_sml_context->allocator.alloc != NULL) {
+		ptr = p_sml_context->allocator.alloc(p_sml_context->allocator.user, total);
+		if(ptr != NULL) {
+			p_sml_memset(ptr, 0, total);
+		}
+	}
+	else {
+		#ifdef SMLLIB_STATIC_POOL
+			ptr = NULL;
+		#else
+			ptr = calloc(count, size);
+		#endif
+	}
+	if(ptr == NULL && total > 0) {
+		p_sml_context->outOfMemory = TRUE;
+	}
+	return ptr;
+}
+
+void* p_sml_realloc(void* ptr, size_t oldSize, size_t size) {
+	void* block;
+	SML_Pool* pool;
+
+	if(ptr == NULL) {
+		return p_sml_calloc(1, size);
+	}
+	pool = p_sml_active_pool();
+	p_sml_count_alloc(size, TRUE);
+	if(pool != NULL) {
+		block = p_sml_pool_realloc(pool, ptr, oldSize, size);
+	}
+	else if(p_sml_context->allocator.realloc != NULL) {
+		block = p_sml_context->allocator.realloc(p_sml_context->allocator.user, ptr, size);
+	}
+	else {
+		#ifdef SMLLIB_STATIC_POOL
+			block = NULL;
+		#else
+			block = realloc(ptr, size);
+		#endif
+	}
+	if(block == NULL && size > 0) {
+		p_sml_context->outOfMemory = TRUE;
+	}
+	return block;
+}
+
+void p_sml_free(void* ptr) {
+	SML_Pool* pool;
+
+	if(ptr == NULL) {
+		return;
+	}
+	pool = p_sml_active_pool();
+	p_sml_context->allocStats.total.frees++;
+	p_sml_context->allocStats.messageType[sml_messagebody_index(p_sml_context->messageType)].frees++;
+	if(pool != NULL) {
+		p_sml_pool_free(pool, ptr);
+	}
+	else if(p_sml_context->allocator.free != NULL) {
+		p_sml_context->allocator.free(p_sml_context->allocator.user, ptr);
+	}
+	else {
+		#ifndef SMLLIB_STATIC_POOL
+			free(ptr);
+		#endif
+	}
+}
+
+void p_sml_pool_reset(void) {
+	SML_Pool* pool = p_sml_active_pool();
+
+	if(pool != NULL) {
+		pool->used = pool->floor;
+		pool->last = SML_POOL_NO_BLOCK;
+	}
+}
+
+size_t p_sml_pool_mark(void) {
+	SML_Pool* pool = p_sml_active_pool();
+
+	return (pool != NULL) ? pool->used : 0;
+}
+
+void p_sml_pool_release(size_t mark) {
+	SML_Pool* pool = p_sml_active_pool();
+
+	if(pool != NULL && mark >= pool->floor && mark <= pool->used) {
+		pool->used = mark;
+		pool->last = SML_POOL_NO_BLOCK;
+	}
+}
+
+void* p_sml_pool_settle(size_t mark, void* block, size_t length) {
+	SML_Pool* pool = p_sml_active_pool();
+	size_t offset = (mark + SMLLIB_POOL_ALIGN - 1) / SMLLIB_POOL_ALIGN * SMLLIB_POOL_ALIGN;
+	size_t at;
+
+	if(pool == NULL) {
+		return block;
+	}
+	if(block == NULL) {
+		p_sml_pool_release(mark);
+		return NULL;
+	}
+	at = (size_t)((unsigned char*)block - pool->base);
+	if(mark < pool->floor || at < offset || at > pool->used) {
+		return block;
+	}
+	p_sml_memmove(pool->base + offset, block, length);
+	pool->last = offset;
+	pool->used = offset + length;
+	return pool->base + offset;
+}
+
+SML_Boolean p_sml_pool_holds(const void* block) {
+	SML_Pool* pool = p_sml_active_pool();
+	const unsigned char* ptr = (const unsigned char*)block;
+
+	if(pool == NULL || ptr == NULL) {
+		return FALSE;
+	}
+	return (ptr >= pool->base + pool->floor && ptr < pool->base + pool->used) ? TRUE : FALSE;
+}
+
+void p_sml_message_begin(void) {
+	if(p_sml_context->messageDepth++ == 0) {
+		p_sml_context->messageType = 0;
+		p_sml_error_reset();
+		p_sml_context->messageStart = p_sml_context->allocStats.messageType[SML_MESSAGEBODY_INDEX_NONE];
+		p_sml_context->pool.high = p_sml_context->pool.used;
+		p_sml_context->poolMessageStart = p_sml_context->pool.used;
+	}
+}
+
+void p_sml_message_type(uint32_t choiceTag) {
+	SML_Alloc_Counter* none = &p_sml_context->allocStats.messageType[SML_MESSAGEBODY_INDEX_NONE];
+	SML_Alloc_Counter* counter = &p_sml_context->allocStats.messageType[sml_messagebody_index(choiceTag)];
+
+	/* Attribute the envelope allocations made so far to the message type */
+	if(p_sml_context->messageType == 0 && counter != none) {
+		counter->allocations += none->allocations - p_sml_context->messageStart.allocations;
+		counter->reallocations += none->reallocations - p_sml_context->messageStart.reallocations;
+		counter->frees += none->frees - p_sml_context->messageStart.frees;
+		counter->bytes += none->bytes - p_sml_context->messageStart.bytes;
+		*none = p_sml_context->messageStart;
+	}
+	p_sml_context->messageType = choiceTag;
+}
+
+void p_sml_message_end(void) {
+	size_t* worstCase;
+
+	if(p_sml_context->messageDepth > 0 && --p_sml_context->messageDepth == 0) {
+		worstCase = &p_sml_context->poolWorstCase[sml_messagebody_index(p_sml_context->messageType)];
+		if(p_sml_context->pool.high - p_sml_context->poolMessageStart > *worstCase) {
+			*worstCase = p_sml_context->pool.high - p_sml_context->poolMessageStart;
+		}
+		p_sml_context->messageType = 0;
+	}
+}
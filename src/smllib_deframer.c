@@ -0,0 +1,206 @@
+/**
+ * File name: smllib_deframer.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_deframer.h"
+#include "smllib_parse.h"
+#include "smllib_validate.h"
+#include "smllib_context.h"
+#include "smllib_metrics.h"
+#include "smllib_tools.h"
+
+/* Length of the start escape and of the end escape with padding count and crc */
+#define SML_DEFRAMER_ESCAPE_LENGTH 8
+
+void sml_deframer_init(SML_Deframer* deframer, unsigned char* buffer, uint32_t size) {
+	p_sml_memset(deframer, 0, sizeof(SML_Deframer));
+	deframer->buffer = buffer;
+	deframer->size = size;
+	deframer->validate = TRUE;
+}
+
+unsigned char* sml_deframer_space(SML_Deframer* deframer, uint32_t* length) {
+	p_sml_deframer_discard(deframer, deframer->consumed);
+	deframer->consumed = 0;
+	/* Moved once per refill, not once per frame */
+	if(deframer->size - deframer->fill < deframer->start) {
+		p_sml_deframer_compact(deframer);
+	}
+	*length = deframer->size - deframer->fill;
+	return deframer->buffer + deframer->fill;
+}
+
+void sml_deframer_commit(SML_Deframer* deframer, uint32_t length) {
+	deframer->fill += length;
+}
+
+uint32_t sml_deframer_feed(SML_Deframer* deframer, const unsigned char* data, uint32_t length) {
+	uint32_t space;
+	unsigned char* target = sml_deframer_space(deframer, &space);
+
+	if(length > space) {
+		length = space;
+	}
+	p_sml_memcpy(target, data, length);
+	sml_deframer_commit(deframer, length);
+	return length;
+}
+
+uint8_t sml_deframer_next(SML_Deframer* deframer, const unsigned char** frame, uint32_t* length) {
+	unsigned char* buffer = deframer->buffer;
+	uint32_t start;
+	uint32_t run;
+	uint32_t escape;
+	uint32_t frameEnd;
+	uint8_t retValue;
+
+	p_sml_deframer_discard(deframer, deframer->consumed);
+	deframer->consumed = 0;
+
+	for(;;) {
+		if(!deframer->inFrame) {
+			start = p_sml_transport_find_start(buffer, deframer->start, deframer->fill);
+			if(start == deframer->fill) {
+				/* The last seven bytes may begin a start escape */
+				if(deframer->fill - deframer->start >= SML_DEFRAMER_ESCAPE_LENGTH) {
+					p_sml_deframer_skip(deframer, deframer->fill - deframer->start - (SML_DEFRAMER_ESCAPE_LENGTH - 1));
+				}
+				return SML_DEFRAMER_MORE;
+			}
+			p_sml_deframer_skip(deframer, start - deframer->start);
+			deframer->inFrame = TRUE;
+			deframer->scan = deframer->start + SML_DEFRAMER_ESCAPE_LENGTH;
+		}
+
+		/* Next 0x1B run, complete only once the byte behind it is there */
+		while(deframer->scan < deframer->fill && buffer[deframer->scan] != 0x1B) {
+			deframer->scan++;
+		}
+		for(run=0; deframer->scan + run < deframer->fill && buffer[deframer->scan + run] == 0x1B; run++);
+		if(deframer->scan + run == deframer->fill) {
+			return p_sml_deframer_wait(deframer);
+		}
+		if(run % 8 < 4) {
+			deframer->scan += run;
+			continue;
+		}
+
+		escape = deframer->scan + run - 4;
+		if(buffer[deframer->scan + run] != 0x1A) {
+			p_sml_deframer_drop(deframer, escape - deframer->start);
+			continue;
+		}
+		frameEnd = escape + SML_DEFRAMER_ESCAPE_LENGTH;
+		if(deframer->fill < frameEnd) {
+			return p_sml_deframer_wait(deframer);
+		}
+
+		start = deframer->start;
+		if(deframer->validate) {
+			retValue = (sml_transport_validate_message(buffer, frameEnd, &start) == SML_PARSE_OK && start == frameEnd) ?
+				SML_PARSE_OK : SML_PARSE_ERROR;
+		}
+		else {
+			retValue = p_sml_deframer_check_crc(buffer, start, frameEnd);
+		}
+		if(retValue == SML_PARSE_OK) {
+			deframer->inFrame = FALSE;
+			deframer->consumed = frameEnd - deframer->start;
+			deframer->frames++;
+			*frame = buffer + deframer->start;
+			*length = deframer->consumed;
+			return SML_PARSE_OK;
+		}
+		/* A frame cut off inside a 0x1B run can hide the start of the next one */
+		p_sml_deframer_drop(deframer, SML_DEFRAMER_ESCAPE_LENGTH);
+	}
+}
+
+unsigned char* sml_deframer_exchange(SML_Deframer* deframer, unsigned char* buffer) {
+	unsigned char* previous = deframer->buffer;
+	uint32_t frameEnd = deframer->start + deframer->consumed;
+
+	p_sml_memcpy(buffer, previous + frameEnd, deframer->fill - frameEnd);
+	/* Only behind skipped bytes the frame is not at the front yet */
+	if(deframer->start > 0) {
+		p_sml_memmove(previous, previous + deframer->start, deframer->consumed);
+	}
+	deframer->fill -= frameEnd;
+	deframer->scan = (deframer->scan > frameEnd) ? deframer->scan - frameEnd : 0;
+	deframer->start = 0;
+	deframer->consumed = 0;
+	deframer->buffer = buffer;
+	return previous;
+}
+
+void p_sml_deframer_discard(SML_Deframer* deframer, uint32_t length) {
+	deframer->start += length;
+	/* An empty buffer starts over at the front for free */
+	if(deframer->start == deframer->fill) {
+		p_sml_deframer_compact(deframer);
+	}
+}
+
+void p_sml_deframer_compact(SML_Deframer* deframer) {
+	uint32_t start = deframer->start;
+
+	if(start == 0) {
+		return;
+	}
+	p_sml_memmove(deframer->buffer, deframer->buffer + start, deframer->fill - start);
+	deframer->fill -= start;
+	deframer->scan = (deframer->scan > start) ? deframer->scan - start : 0;
+	deframer->start = 0;
+}
+
+void p_sml_deframer_skip(SML_Deframer* deframer, uint32_t length) {
+	p_sml_deframer_discard(deframer, length);
+	deframer->skippedBytes += length;
+	SML_METRIC_ADD(resyncBytes, length);
+}
+
+void p_sml_deframer_drop(SML_Deframer* deframer, uint32_t length) {
+	deframer->inFrame = FALSE;
+	deframer->skippedFrames++;
+	SML_METRIC_ADD(framesSkipped, 1);
+	p_sml_deframer_skip(deframer, length);
+}
+
+uint8_t p_sml_deframer_check_crc(const unsigned char* buffer, uint32_t start, uint32_t frameEnd) {
+	/* 1B1B1B1B 1A, padding count, crc16 over the frame up to the padding count */
+	uint32_t crcOffset = frameEnd - 2;
+	uint16_t crc16 = p_sml_crc16_update(0xFFFF, buffer + start, crcOffset - start);
+
+	if(buffer[crcOffset] != (unsigned char)(crc16 >> 8) || buffer[crcOffset + 1] != (unsigned char)(crc16 & 0xFF)) {
+		return SML_PARSE_ERROR;
+	}
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_deframer_wait(SML_Deframer* deframer) {
+	/* A frame that does not fit can never complete, the search starts over */
+	if(deframer->fill - deframer->start == deframer->size) {
+		p_sml_deframer_drop(deframer, deframer->size);
+	}
+	return SML_DEFRAMER_MORE;
+}
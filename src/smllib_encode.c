@@ -24,18 +24,29 @@
 
 #include "smllib_encode.h"
 #include "smllib_tools.h"
+#include "smllib_context.h"
+#include "smllib_obis.h"
+#include "smllib_trace.h"
+#include "smllib_metrics.h"
+#include "smllib_latency.h"
 
-#ifdef SMLLIB_DEBUG
-	#include <stdio.h>
-#endif
+/* Compared by address, see p_set_encode_error() */
+static const char p_sml_encode_nomem_text[] = "Out of memory.";
+
+void sml_encode_set_shortest_integers(SML_Boolean enable) {
+	p_sml_context->encodeShortest = (enable == FALSE) ? FALSE : TRUE;
+}
 
 SML_Encode_Binary_Result sml_encode_file_binary(SML_File* smlFile) {
 	SML_Encode_Binary_Result* smlMessage;
 	SML_Encode_Binary_Result result;
+	size_t mark;
 	uint32_t i;
 
 	/* Assume encoding error on default */
 	result.resultCode = SML_ENCODE_ERROR;
+	result.resultBinary = NULL;
+	result.length = 0;
 
 	/* Check if messages pointer is available */
 	if(smlFile->messages == NULL) {
@@ -66,26 +77,58 @@ SML_Encode_Binary_Result sml_encode_file_binary(SML_File* smlFile) {
 	}
 
 	/* Allocate & encode messages */
-	smlMessage = (SML_Encode_Binary_Result*)calloc(smlFile->msgCount, sizeof(SML_Encode_Binary_Result));
+	mark = p_sml_pool_mark();
+	smlMessage = (SML_Encode_Binary_Result*)p_sml_calloc(smlFile->msgCount, sizeof(SML_Encode_Binary_Result));
+	if(smlMessage == NULL) {
+		p_set_encode_error(&result, p_sml_encode_nomem_text);
+		return result;
+	}
 	for(i=0; i < smlFile->msgCount; i++) {
 		smlMessage[i] = sml_encode_message_binary(smlFile->messages[i]);
+		if(smlMessage[i].resultCode == SML_ENCODE_ERROR) {
+			result = p_sml_encode_failed_message(smlMessage, i);
+			p_sml_free(smlMessage);
+			p_sml_pool_release(mark);
+			return result;
+		}
 	}
 
-	/* Concat partial message encodings to result */
-	p_allocate_concat_free(&result, smlMessage, smlFile->msgCount);
-
-	/* Free space from encode parts */
-	free(smlMessage);
+	/* Concat partial message encodings to result, frees them and the list */
+	p_allocate_concat_free(&result, smlMessage, smlFile->msgCount, mark);
 
 	result.resultCode = SML_ENCODE_OK;
+	p_sml_check_encode_error(&result);
 	return result;
 }
 
 SML_Encode_Binary_Result sml_encode_message_binary(SML_Message* message) {
+	SML_Encode_Binary_Result result;
+	SML_LATENCY_DECLARE(start)
+
+	SML_LATENCY_START(start);
+	p_sml_message_begin();
+	p_sml_context->encodeError = NULL;
+	result = p_sml_encode_message(message);
+	p_sml_check_encode_error(&result);
+	p_sml_message_end();
+
+	if(result.resultCode == SML_ENCODE_OK) {
+		SML_LATENCY_RECORD(SML_LATENCY_ENCODE, message->messageBody.choiceTag, start);
+		SML_METRIC_ADD(messagesEncoded, 1);
+		SML_METRIC_ADD(messageBytesEncoded, result.length);
+	}
+	else {
+		SML_METRIC_ADD(encodeErrors, 1);
+	}
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_encode_message(SML_Message* message) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[6];
+	size_t mark = p_sml_pool_mark();
 
-	uint32_t totalLength;
+	unsigned char* grown;
 	SML_Encode_Binary_Result crc16;
 	SML_Encode_Binary_Result messageBody;
 	SML_Encode_Binary_Result listWrapper	   	= p_sml_encode_tlfield(LIST, 6);
@@ -93,24 +136,12 @@ SML_Encode_Binary_Result sml_encode_message_binary(SML_Message* message) {
 	SML_Encode_Binary_Result groupNo		   	= p_sml_encode_unsigned(message->groupNo, sizeof(uint8_t));
 	SML_Encode_Binary_Result abortOnError   	= p_sml_encode_unsigned(message->abortOnError, sizeof(uint8_t));
 
-	printBinaryResult("listWrapper", &listWrapper);
-	printBinaryResult("transactionId", &transactionId);
-	printBinaryResult("abortOnError", &abortOnError);
-	printBinaryResult("groupNo", &groupNo);
+	SML_TRACE_FIELD("listWrapper", &listWrapper);
+	SML_TRACE_FIELD("transactionId", &transactionId);
+	SML_TRACE_FIELD("abortOnError", &abortOnError);
+	SML_TRACE_FIELD("groupNo", &groupNo);
 
 	messageBody	= p_sml_encode_messagebody(&message->messageBody);
-	totalLength = (
-		listWrapper.length
-		+ transactionId.length
-		+ groupNo.length
-		+ abortOnError.length
-		+ messageBody.length
-		+ (uint32_t)(sizeof(uint16_t) + 1) /* CRC16 + TL */
-		+ 1 /* endOfSmlMessage */
-	);
-
-	result.length = 0;
-	result.resultBinary = (unsigned char*)calloc(totalLength, sizeof(unsigned char));
 
 	/* add encoded parts */
 	listPtr[0] = &listWrapper;
@@ -118,34 +149,41 @@ SML_Encode_Binary_Result sml_encode_message_binary(SML_Message* message) {
 	listPtr[2] = &groupNo;
 	listPtr[3] = &abortOnError;
 	listPtr[4] = &messageBody;
-	p_concat_binary_results_dynamic(&result, listPtr, 5);
+	p_allocate_concat_free_dynamic(&result, listPtr, 5, mark);
+
+	/* Room for crc16 + TL and endOfSmlMessage, the youngest pool block grows in place */
+	grown = NULL;
+	if(result.resultBinary != NULL) {
+		grown = (unsigned char*)p_sml_realloc(result.resultBinary, result.length, result.length + sizeof(uint16_t) + 2);
+		if(grown == NULL) {
+			p_sml_free(result.resultBinary);
+		}
+	}
+	if(grown == NULL) {
+		p_sml_pool_release(mark);
+		return p_sml_encode_nomem();
+	}
+	result.resultBinary = grown;
 
-	/* add crc16 */
-	crc16 = p_sml_encode_unsigned(
-		crc16_ccitt(result.resultBinary, result.length), sizeof(uint16_t)
+	/* add crc16 (always full width, the message length above relies on it) */
+	crc16 = p_sml_encode_number(
+		crc16_ccitt(result.resultBinary, result.length), UNSIGNED, sizeof(uint16_t)
 	);
 
-	printBinaryResult("crc16", &crc16);
+	SML_TRACE_FIELD("crc16", &crc16);
 
 	listPtr[5] = &crc16;
 	p_concat_binary_results_dynamic(&result, listPtr+5, 1);
+	p_sml_free(crc16.resultBinary);
 
 	/* add endOfSmlMessage */
-	result.resultBinary[totalLength-1] = 0x00;
-	result.length++;
-
-	printBinaryResult("msgComplete", &result);
-	#ifdef SMLLIB_DEBUG
-		printf("msgLength: %u bytes\n", (unsigned int)result.length);
-		printf("%s", "========= endOfSmlMessage =========\n\n");
-	#endif
-
-	free(listWrapper.resultBinary);
-	free(transactionId.resultBinary);
-	free(groupNo.resultBinary);
-	free(abortOnError.resultBinary);
-	free(messageBody.resultBinary);
-	free(crc16.resultBinary);
+	result.resultBinary[result.length++] = 0x00;
+
+	SML_TRACE_FIELD("msgComplete", &result);
+	SML_TRACE_MESSAGE_BYTES("transactionId", (const unsigned char*)message->transactionId,
+		(message->transactionId != NULL) ? (uint32_t)p_sml_strlen(message->transactionId) : 0);
+	SML_TRACE_MESSAGE_NUMBER("messageBodyTag", message->messageBody.choiceTag);
+	SML_TRACE_MESSAGE_NUMBER("msgLength", result.length);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -154,51 +192,94 @@ SML_Encode_Binary_Result sml_encode_message_binary(SML_Message* message) {
 SML_Encode_Binary_Result sml_transport_encode_file(SML_File* file) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* messageList;
+	size_t mark = p_sml_pool_mark();
 	uint32_t i;
 
-	messageList = (SML_Encode_Binary_Result*)calloc(file->msgCount, sizeof(SML_Encode_Binary_Result));
+	messageList = (SML_Encode_Binary_Result*)p_sml_calloc(file->msgCount, sizeof(SML_Encode_Binary_Result));
+	if(messageList == NULL) {
+		result.resultCode = SML_ENCODE_ERROR;
+		result.resultBinary = NULL;
+		result.length = 0;
+		p_set_encode_error(&result, p_sml_encode_nomem_text);
+		return result;
+	}
 	for(i=0; i < file->msgCount; i++) {
 		messageList[i] = sml_transport_encode_message(file->messages[i]);
+		if(messageList[i].resultCode == SML_ENCODE_ERROR) {
+			result = p_sml_encode_failed_message(messageList, i);
+			p_sml_free(messageList);
+			p_sml_pool_release(mark);
+			return result;
+		}
 	}
 
-	p_allocate_concat_free(&result, messageList, file->msgCount);
-
-	free(messageList);
+	p_allocate_concat_free(&result, messageList, file->msgCount, mark);
 
 	result.resultCode = SML_ENCODE_OK;
+	p_sml_check_encode_error(&result);
 	return result;
 }
 
 SML_Encode_Binary_Result sml_transport_encode_message(SML_Message* message) {
+	SML_Encode_Binary_Result result;
+	SML_LATENCY_DECLARE(start)
+
+	SML_LATENCY_START(start);
+	p_sml_message_begin();
+	p_sml_context->encodeError = NULL;
+	result = p_sml_transport_encode_message(message);
+	p_sml_check_encode_error(&result);
+	p_sml_message_end();
+
+	if(result.resultCode == SML_ENCODE_OK) {
+		SML_LATENCY_RECORD(SML_LATENCY_TRANSPORT_ENCODE, message->messageBody.choiceTag, start);
+		SML_METRIC_ADD(framesEncoded, 1);
+		SML_METRIC_ADD(frameBytesEncoded, result.length);
+	}
+	else {
+		SML_METRIC_ADD(encodeErrors, 1);
+	}
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_transport_encode_message(SML_Message* message) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result messageBin;
-	SML_Encode_Binary_Result messageBinEnc;
+	size_t mark = p_sml_pool_mark();
 	unsigned char* offset;
 
 	uint8_t i;
 	uint8_t paddingBytes;
 	uint16_t crc;
+	uint32_t escapedLength;
 	uint32_t totalLength;
 
 	messageBin = sml_encode_message_binary(message);
+	if(messageBin.resultCode != SML_ENCODE_OK) {
+		/* Already reported by the nested call, fails the frame as well */
+		p_sml_context->encodeError = messageBin.errorMessage;
+		return messageBin;
+	}
 	paddingBytes = (uint8_t)(messageBin.length % 4 != 0 ? (4 - messageBin.length % 4) : 0);
 
-	messageBinEnc = p_sml_transport_escape_message(&messageBin);
-	totalLength = (messageBinEnc.length + paddingBytes + 16);
-	result.resultBinary = (unsigned char*)calloc(totalLength, sizeof(unsigned char));
+	/* The message is escaped straight into the frame */
+	escapedLength = p_sml_transport_escaped_length(&messageBin);
+	totalLength = (escapedLength + paddingBytes + 16);
+	result.resultBinary = (unsigned char*)p_sml_calloc(totalLength, sizeof(unsigned char));
 	result.length = totalLength;
+	if(result.resultBinary == NULL) {
+		p_sml_free(messageBin.resultBinary);
+		p_sml_pool_release(mark);
+		return p_sml_encode_nomem();
+	}
 
 	/* Start of msg */
 	*((uint32_t*)result.resultBinary) = 0x1B1B1B1B;
 	*((uint32_t*)(result.resultBinary + 4)) = 0x01010101;
-	memmove(
-		result.resultBinary + 8,
-		messageBinEnc.resultBinary,
-		messageBinEnc.length
-	);
+	p_sml_transport_escape_message(&messageBin, result.resultBinary + 8);
 
 	/* Padding bytes */
-	offset = (unsigned char*)(result.resultBinary + 8 + messageBinEnc.length);
+	offset = (unsigned char*)(result.resultBinary + 8 + escapedLength);
 	for(i=0; i<paddingBytes; i++) {
 		offset[i] = 0;
 	}
@@ -215,11 +296,117 @@ SML_Encode_Binary_Result sml_transport_encode_message(SML_Message* message) {
 	offset[2] = (unsigned char)(crc >> 8);
 	offset[3] = (unsigned char)(crc & 0xFF);
 
-	free(messageBin.resultBinary);
-	free(messageBinEnc.resultBinary);
+	p_sml_free(messageBin.resultBinary);
+	result.resultBinary = (unsigned char*)p_sml_pool_settle(mark, result.resultBinary, result.length);
+
+	SML_TRACE_FIELD("transportMsg", &result);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+SML_Encode_Binary_Result sml_encode_profilepack_stream(SML_Message* message, SML_Period_Callback rows, void* rowUser, SML_Write_Callback write, void* writeUser) {
+	return p_sml_encode_profilepack_stream(message, rows, rowUser, write, writeUser, FALSE);
+}
+
+SML_Encode_Binary_Result sml_transport_encode_profilepack_stream(SML_Message* message, SML_Period_Callback rows, void* rowUser, SML_Write_Callback write, void* writeUser) {
+	return p_sml_encode_profilepack_stream(message, rows, rowUser, write, writeUser, TRUE);
+}
+
+SML_Encode_Binary_Result p_sml_encode_profilepack_stream(SML_Message* message, SML_Period_Callback rows, void* rowUser, SML_Write_Callback write, void* writeUser, SML_Boolean transport) {
+	static const unsigned char startOfMsg[8] = { 0x1B, 0x1B, 0x1B, 0x1B, 0x01, 0x01, 0x01, 0x01 };
+	static const unsigned char endOfMsg[4] = { 0x1B, 0x1B, 0x1B, 0x1B };
 
-	printBinaryResult("transportMsg", &result);
+	SML_Encode_Binary_Result result;
+	SML_Encode_Stream stream;
+	SML_GetProfilePack_Res* response;
+	unsigned char trailer[4];
+	uint8_t paddingBytes;
+	size_t mark;
+
+	result.resultCode = SML_ENCODE_ERROR;
+	result.resultBinary = NULL;
+	result.length = 0;
+
+	if(message->messageBody.choiceTag != SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE) {
+		p_set_encode_error(&result, "Streaming encoder requires a GetProfilePack_Res message.");
+		return result;
+	}
+	response = message->messageBody.choiceValue.getProfilePackResponse;
+
+	p_sml_stream_init(&stream, write, writeUser, transport);
+	mark = p_sml_pool_mark();
+	p_sml_message_begin();
+	p_sml_context->encodeError = NULL;
+	p_sml_message_type(SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE);
+
+	if(transport) {
+		p_sml_stream_raw(&stream, startOfMsg, 8);
+	}
 
+	/* Same layout as p_sml_encode_message() and p_sml_encode_getprofilepack_response() */
+	p_sml_stream_put(&stream, p_sml_encode_tlfield(LIST, 6));
+	p_sml_stream_put(&stream, p_sml_encode_string(message->transactionId));
+	p_sml_stream_put(&stream, p_sml_encode_unsigned(message->groupNo, sizeof(uint8_t)));
+	p_sml_stream_put(&stream, p_sml_encode_unsigned(message->abortOnError, sizeof(uint8_t)));
+	p_sml_stream_put(&stream, p_sml_encode_tlfield(LIST, 2));
+	p_sml_stream_put(&stream, p_sml_encode_unsigned(SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE, sizeof(uint32_t)));
+
+	p_sml_stream_put(&stream, p_sml_encode_tlfield(LIST, 8));
+	p_sml_stream_put(&stream, p_sml_encode_string(response->serverId));
+	p_sml_stream_put(&stream, p_sml_encode_time(&response->actTime));
+	p_sml_stream_put(&stream, p_sml_encode_unsigned(response->regPeriod, sizeof(uint32_t)));
+	p_sml_stream_put(&stream, p_sml_encode_treepath(&response->parameterTreePath));
+	p_sml_stream_put(&stream, p_sml_encode_list_of_objheaderentry(&response->header_List));
+
+	/* The row count is known up front, so the list TL needs no back-patching */
+	p_sml_stream_put(&stream, p_sml_encode_tlfield(LIST, response->period_List.listSize));
+	p_sml_stream_periods(&stream, response->period_List.listSize, rows, rowUser);
+
+	p_sml_stream_put(&stream, response->rawdata != NULL ? p_sml_encode_string(response->rawdata) : p_sml_encode_tlfield(STRING, 0));
+	p_sml_stream_put(&stream, response->profileSignature != NULL ? p_sml_encode_string(response->profileSignature) : p_sml_encode_tlfield(STRING, 0));
+
+	/* add crc16 (always full width) and endOfSmlMessage */
+	p_sml_stream_put(&stream, p_sml_encode_number(stream.messageCrc, UNSIGNED, sizeof(uint16_t)));
+	trailer[0] = 0x00;
+	p_sml_stream_message(&stream, trailer, 1);
+
+	if(transport) {
+		paddingBytes = (uint8_t)(stream.messageLength % 4 != 0 ? (4 - stream.messageLength % 4) : 0);
+		p_sml_memset(trailer, 0, sizeof(trailer));
+		p_sml_stream_raw(&stream, trailer, paddingBytes);
+		p_sml_stream_raw(&stream, endOfMsg, 4);
+		trailer[0] = 0x1A;
+		trailer[1] = paddingBytes;
+		p_sml_stream_raw(&stream, trailer, 2);
+
+		/* The transport crc covers everything flushed so far */
+		p_sml_stream_flush(&stream);
+		trailer[0] = (unsigned char)(stream.transportCrc >> 8);
+		trailer[1] = (unsigned char)(stream.transportCrc & 0xFF);
+		p_sml_stream_raw(&stream, trailer, 2);
+	}
+	p_sml_stream_flush(&stream);
+
+	if(stream.error == NULL) {
+		stream.error = p_sml_context->encodeError;
+	}
+	p_sml_context->encodeError = NULL;
+	p_sml_message_end();
+	p_sml_pool_release(mark);
+
+	result.length = stream.written;
+	if(stream.error != NULL) {
+		SML_METRIC_ADD(encodeErrors, 1);
+		p_set_encode_error(&result, stream.error);
+		return result;
+	}
+	SML_METRIC_ADD(messagesEncoded, 1);
+	SML_METRIC_ADD(messageBytesEncoded, stream.messageLength);
+	if(transport) {
+		SML_METRIC_ADD(framesEncoded, 1);
+		SML_METRIC_ADD(frameBytesEncoded, stream.written);
+	}
 	result.resultCode = SML_ENCODE_OK;
 	return result;
 }
@@ -227,6 +414,7 @@ SML_Encode_Binary_Result sml_transport_encode_message(SML_Message* message) {
 SML_Encode_Binary_Result p_sml_encode_open_request(SML_PublicOpen_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[8];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 7);
 	SML_Encode_Binary_Result codepage  		= request->codepage != NULL ? p_sml_encode_string(request->codepage) : p_sml_encode_tlfield(STRING, 0);
@@ -245,7 +433,7 @@ SML_Encode_Binary_Result p_sml_encode_open_request(SML_PublicOpen_Req* request)
 	listPtr[5] = &username;
 	listPtr[6] = &password;
 	listPtr[7] = &smlVersion;
-	p_allocate_concat_free_dynamic(&result, listPtr, 8);
+	p_allocate_concat_free_dynamic(&result, listPtr, 8, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -255,10 +443,11 @@ SML_Encode_Binary_Result p_sml_encode_open_request(SML_PublicOpen_Req* request)
 SML_Encode_Binary_Result p_sml_encode_open_response(SML_PublicOpen_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[7];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 6);
 	SML_Encode_Binary_Result codepage  		= response->codepage != NULL ? p_sml_encode_string(response->codepage) : p_sml_encode_tlfield(STRING, 0);
-	SML_Encode_Binary_Result clientId		= p_sml_encode_string(response->clientId);
+	SML_Encode_Binary_Result clientId		= response->clientId != NULL ? p_sml_encode_string(response->clientId) : p_sml_encode_tlfield(STRING, 0);
 	SML_Encode_Binary_Result reqFileId   	= p_sml_encode_string(response->reqFileId);
 	SML_Encode_Binary_Result serverId		= response->serverId != NULL ? p_sml_encode_string(response->serverId) : p_sml_encode_tlfield(STRING, 0);
 	SML_Encode_Binary_Result refTime		= response->refTime != NULL ? p_sml_encode_time(response->refTime) : p_sml_encode_tlfield(STRING, 0);
@@ -271,7 +460,7 @@ SML_Encode_Binary_Result p_sml_encode_open_response(SML_PublicOpen_Res* response
 	listPtr[4] = &serverId;
 	listPtr[5] = &refTime;
 	listPtr[6] = &smlVersion;
-	p_allocate_concat_free_dynamic(&result, listPtr, 7);
+	p_allocate_concat_free_dynamic(&result, listPtr, 7, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -280,13 +469,14 @@ SML_Encode_Binary_Result p_sml_encode_open_response(SML_PublicOpen_Res* response
 SML_Encode_Binary_Result p_sml_encode_close_request(SML_PublicClose_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[2];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	 = p_sml_encode_tlfield(LIST, 1);
 	SML_Encode_Binary_Result globalSignature = request->globalSignature != NULL ? p_sml_encode_string(request->globalSignature) : p_sml_encode_tlfield(STRING, 0);
 
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &globalSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 2);
+	p_allocate_concat_free_dynamic(&result, listPtr, 2, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -295,13 +485,14 @@ SML_Encode_Binary_Result p_sml_encode_close_request(SML_PublicClose_Req* request
 SML_Encode_Binary_Result p_sml_encode_close_response(SML_PublicClose_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[2];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	 = p_sml_encode_tlfield(LIST, 1);
 	SML_Encode_Binary_Result globalSignature = response->globalSignature != NULL ? p_sml_encode_string(response->globalSignature) : p_sml_encode_tlfield(STRING, 0);
 
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &globalSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 2);
+	p_allocate_concat_free_dynamic(&result, listPtr, 2, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -310,6 +501,7 @@ SML_Encode_Binary_Result p_sml_encode_close_response(SML_PublicClose_Res* respon
 SML_Encode_Binary_Result p_sml_encode_getprofilepack_request(SML_GetProfilePack_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[10];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 9);
 	SML_Encode_Binary_Result serverId 			= request->serverId != NULL ? p_sml_encode_string(request->serverId) : p_sml_encode_tlfield(STRING, 0);
@@ -332,7 +524,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilepack_request(SML_GetProfilePack_
 	listPtr[7] = &parameterTreePath;
 	listPtr[8] = &object_List;
 	listPtr[9] = &dasDetails;
-	p_allocate_concat_free_dynamic(&result, listPtr, 10);
+	p_allocate_concat_free_dynamic(&result, listPtr, 10, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -341,6 +533,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilepack_request(SML_GetProfilePack_
 SML_Encode_Binary_Result p_sml_encode_getprofilepack_response(SML_GetProfilePack_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[9];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 8);
 	SML_Encode_Binary_Result serverId			= p_sml_encode_string(response->serverId);
@@ -361,7 +554,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilepack_response(SML_GetProfilePack
 	listPtr[6] = &period_List;
 	listPtr[7] = &rawdata;
 	listPtr[8] = &profileSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 9);
+	p_allocate_concat_free_dynamic(&result, listPtr, 9, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -370,6 +563,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilepack_response(SML_GetProfilePack
 SML_Encode_Binary_Result p_sml_encode_getprofilelist_request(SML_GetProfileList_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[10];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 9);
 	SML_Encode_Binary_Result serverId 			= request->serverId != NULL ? p_sml_encode_string(request->serverId) : p_sml_encode_tlfield(STRING, 0);
@@ -392,7 +586,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilelist_request(SML_GetProfileList_
 	listPtr[7] = &parameterTreePath;
 	listPtr[8] = &object_List;
 	listPtr[9] = &dasDetails;
-	p_allocate_concat_free_dynamic(&result, listPtr, 10);
+	p_allocate_concat_free_dynamic(&result, listPtr, 10, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -401,6 +595,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilelist_request(SML_GetProfileList_
 SML_Encode_Binary_Result p_sml_encode_getprofilelist_response(SML_GetProfileList_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[10];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 9);
 	SML_Encode_Binary_Result serverId			= p_sml_encode_string(response->serverId);
@@ -423,7 +618,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilelist_response(SML_GetProfileList
 	listPtr[7] = &period_List;
 	listPtr[8] = &rawdata;
 	listPtr[9] = &periodSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 10);
+	p_allocate_concat_free_dynamic(&result, listPtr, 10, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -432,6 +627,7 @@ SML_Encode_Binary_Result p_sml_encode_getprofilelist_response(SML_GetProfileList
 SML_Encode_Binary_Result p_sml_encode_getlist_request(SML_GetList_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[6];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 5);
 	SML_Encode_Binary_Result clientId 		= p_sml_encode_string(request->clientId);
@@ -440,12 +636,12 @@ SML_Encode_Binary_Result p_sml_encode_getlist_request(SML_GetList_Req* request)
 	SML_Encode_Binary_Result password 		= request->password != NULL ? p_sml_encode_string(request->password) : p_sml_encode_tlfield(STRING, 0);
 	SML_Encode_Binary_Result listName 		= request->listName != NULL ? p_sml_encode_string(request->listName) : p_sml_encode_tlfield(STRING, 0);
 
-	printBinaryResult("listWrapper", &listWrapper);
-	printBinaryResult("clientId", &clientId);
-	printBinaryResult("serverId", &serverId);
-	printBinaryResult("username", &username);
-	printBinaryResult("password", &password);
-	printBinaryResult("listName", &listName);
+	SML_TRACE_FIELD("listWrapper", &listWrapper);
+	SML_TRACE_FIELD("clientId", &clientId);
+	SML_TRACE_FIELD("serverId", &serverId);
+	SML_TRACE_FIELD("username", &username);
+	SML_TRACE_FIELD("password", &password);
+	SML_TRACE_FIELD("listName", &listName);
 
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &clientId;
@@ -453,7 +649,7 @@ SML_Encode_Binary_Result p_sml_encode_getlist_request(SML_GetList_Req* request)
 	listPtr[3] = &username;
 	listPtr[4] = &password;
 	listPtr[5] = &listName;
-	p_allocate_concat_free_dynamic(&result, listPtr, 6);
+	p_allocate_concat_free_dynamic(&result, listPtr, 6, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -462,6 +658,7 @@ SML_Encode_Binary_Result p_sml_encode_getlist_request(SML_GetList_Req* request)
 SML_Encode_Binary_Result p_sml_encode_getlist_response(SML_GetList_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[8];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 7);
 	SML_Encode_Binary_Result clientId		= response->clientId != NULL ? p_sml_encode_string(response->clientId) : p_sml_encode_tlfield(STRING, 0);
@@ -472,14 +669,14 @@ SML_Encode_Binary_Result p_sml_encode_getlist_response(SML_GetList_Res* response
 	SML_Encode_Binary_Result listSignature 	= response->listSignature != NULL ? p_sml_encode_string(response->listSignature) : p_sml_encode_tlfield(STRING, 0);
 	SML_Encode_Binary_Result actGatewayTime = response->actGatewayTime != NULL ? p_sml_encode_time(response->actGatewayTime) : p_sml_encode_tlfield(STRING, 0);
 
-	printBinaryResult("listWrapper", &listWrapper);
-	printBinaryResult("clientId", &clientId);
-	printBinaryResult("serverId", &serverId);
-	printBinaryResult("listName", &listName);
-	printBinaryResult("actSensorTime", &actSensorTime);
-	printBinaryResult("valList", &valList);
-	printBinaryResult("listSignature", &listSignature);
-	printBinaryResult("actGatewayTime", &actGatewayTime);
+	SML_TRACE_FIELD("listWrapper", &listWrapper);
+	SML_TRACE_FIELD("clientId", &clientId);
+	SML_TRACE_FIELD("serverId", &serverId);
+	SML_TRACE_FIELD("listName", &listName);
+	SML_TRACE_FIELD("actSensorTime", &actSensorTime);
+	SML_TRACE_FIELD("valList", &valList);
+	SML_TRACE_FIELD("listSignature", &listSignature);
+	SML_TRACE_FIELD("actGatewayTime", &actGatewayTime);
 
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &clientId;
@@ -489,7 +686,7 @@ SML_Encode_Binary_Result p_sml_encode_getlist_response(SML_GetList_Res* response
 	listPtr[5] = &valList;
 	listPtr[6] = &listSignature;
 	listPtr[7] = &actGatewayTime;
-	p_allocate_concat_free_dynamic(&result, listPtr, 8);
+	p_allocate_concat_free_dynamic(&result, listPtr, 8, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -498,6 +695,7 @@ SML_Encode_Binary_Result p_sml_encode_getlist_response(SML_GetList_Res* response
 SML_Encode_Binary_Result p_sml_encode_getprocparameter_request(SML_GetProcParameter_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[6];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 5);
 	SML_Encode_Binary_Result serverId 			= request->serverId != NULL ? p_sml_encode_string(request->serverId) : p_sml_encode_tlfield(STRING, 0);
@@ -512,7 +710,7 @@ SML_Encode_Binary_Result p_sml_encode_getprocparameter_request(SML_GetProcParame
 	listPtr[3] = &password;
 	listPtr[4] = &parameterTreePath;
 	listPtr[5] = &attribute;
-	p_allocate_concat_free_dynamic(&result, listPtr, 6);
+	p_allocate_concat_free_dynamic(&result, listPtr, 6, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -521,6 +719,7 @@ SML_Encode_Binary_Result p_sml_encode_getprocparameter_request(SML_GetProcParame
 SML_Encode_Binary_Result p_sml_encode_getprocparameter_response(SML_GetProcParameter_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[4];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 3);
 	SML_Encode_Binary_Result serverId 			= p_sml_encode_string(response->serverId);
@@ -531,7 +730,7 @@ SML_Encode_Binary_Result p_sml_encode_getprocparameter_response(SML_GetProcParam
 	listPtr[1] = &serverId;
 	listPtr[2] = &parameterTreePath;
 	listPtr[3] = &parameterTree;
-	p_allocate_concat_free_dynamic(&result, listPtr, 4);
+	p_allocate_concat_free_dynamic(&result, listPtr, 4, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -540,6 +739,7 @@ SML_Encode_Binary_Result p_sml_encode_getprocparameter_response(SML_GetProcParam
 SML_Encode_Binary_Result p_sml_encode_setprocparameter_request(SML_SetProcParameter_Req* request) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[6];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 5);
 	SML_Encode_Binary_Result serverId 			= request->serverId != NULL ? p_sml_encode_string(request->serverId) : p_sml_encode_tlfield(STRING, 0);
@@ -554,7 +754,7 @@ SML_Encode_Binary_Result p_sml_encode_setprocparameter_request(SML_SetProcParame
 	listPtr[3] = &password;
 	listPtr[4] = &parameterTreePath;
 	listPtr[5] = &parameterTree;
-	p_allocate_concat_free_dynamic(&result, listPtr, 6);
+	p_allocate_concat_free_dynamic(&result, listPtr, 6, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -563,6 +763,7 @@ SML_Encode_Binary_Result p_sml_encode_setprocparameter_request(SML_SetProcParame
 SML_Encode_Binary_Result p_sml_encode_attention_response(SML_Attention_Res* response) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[5];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 4);
 	SML_Encode_Binary_Result serverId 			= p_sml_encode_string(response->serverId);
@@ -575,72 +776,195 @@ SML_Encode_Binary_Result p_sml_encode_attention_response(SML_Attention_Res* resp
 	listPtr[2] = &attentionNo;
 	listPtr[3] = &attentionMsg;
 	listPtr[4] = &attentionDetails;
-	p_allocate_concat_free_dynamic(&result, listPtr, 5);
+	p_allocate_concat_free_dynamic(&result, listPtr, 5, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
 }
 
+SML_Encode_Binary_Result p_sml_encode_open_request_compact(SML_PublicOpen_Req_Compact* request) {
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result* listPtr[8];
+	size_t mark = p_sml_pool_mark();
+
+	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 7);
+	SML_Encode_Binary_Result codepage  		= request->codepage != NULL ? p_sml_encode_string(request->codepage) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result clientId		= p_sml_encode_string(request->clientId);
+	SML_Encode_Binary_Result reqFileId   	= p_sml_encode_string(request->reqFileId);
+	SML_Encode_Binary_Result serverId		= request->serverId != NULL ? p_sml_encode_string(request->serverId) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result username		= request->username != NULL ? p_sml_encode_string(request->username) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result password		= request->password != NULL ? p_sml_encode_string(request->password) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result smlVersion		= (request->present & SML_OPENREQ_SMLVERSION) ? p_sml_encode_unsigned(request->smlVersion, sizeof(uint8_t)) : p_sml_encode_tlfield(STRING, 0);
+
+	listPtr[0] = &listWrapper;
+	listPtr[1] = &codepage;
+	listPtr[2] = &clientId;
+	listPtr[3] = &reqFileId;
+	listPtr[4] = &serverId;
+	listPtr[5] = &username;
+	listPtr[6] = &password;
+	listPtr[7] = &smlVersion;
+	p_allocate_concat_free_dynamic(&result, listPtr, 8, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_encode_open_response_compact(SML_PublicOpen_Res_Compact* response) {
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result* listPtr[7];
+	size_t mark = p_sml_pool_mark();
+
+	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 6);
+	SML_Encode_Binary_Result codepage  		= response->codepage != NULL ? p_sml_encode_string(response->codepage) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result clientId		= response->clientId != NULL ? p_sml_encode_string(response->clientId) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result reqFileId   	= p_sml_encode_string(response->reqFileId);
+	SML_Encode_Binary_Result serverId		= p_sml_encode_string(response->serverId);
+	SML_Encode_Binary_Result refTime		= (response->present & SML_OPENRES_REFTIME) ? p_sml_encode_time(&response->refTime) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result smlVersion		= (response->present & SML_OPENRES_SMLVERSION) ? p_sml_encode_unsigned(response->smlVersion, sizeof(uint8_t)) : p_sml_encode_tlfield(STRING, 0);
+
+	listPtr[0] = &listWrapper;
+	listPtr[1] = &codepage;
+	listPtr[2] = &clientId;
+	listPtr[3] = &reqFileId;
+	listPtr[4] = &serverId;
+	listPtr[5] = &refTime;
+	listPtr[6] = &smlVersion;
+	p_allocate_concat_free_dynamic(&result, listPtr, 7, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_encode_getlist_response_compact(SML_GetList_Res_Compact* response) {
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result* listPtr[8];
+	size_t mark = p_sml_pool_mark();
+
+	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 7);
+	SML_Encode_Binary_Result clientId		= response->clientId != NULL ? p_sml_encode_string(response->clientId) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result serverId		= p_sml_encode_string(response->serverId);
+	SML_Encode_Binary_Result listName 		= response->listName != NULL ? p_sml_encode_string(response->listName) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result actSensorTime 	= (response->present & SML_GETLISTRES_ACTSENSORTIME) ? p_sml_encode_time(&response->actSensorTime) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result valList 		= p_sml_encode_list_compact(&response->valList);
+	SML_Encode_Binary_Result listSignature 	= response->listSignature != NULL ? p_sml_encode_string(response->listSignature) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result actGatewayTime = (response->present & SML_GETLISTRES_ACTGATEWAYTIME) ? p_sml_encode_time(&response->actGatewayTime) : p_sml_encode_tlfield(STRING, 0);
+
+	listPtr[0] = &listWrapper;
+	listPtr[1] = &clientId;
+	listPtr[2] = &serverId;
+	listPtr[3] = &listName;
+	listPtr[4] = &actSensorTime;
+	listPtr[5] = &valList;
+	listPtr[6] = &listSignature;
+	listPtr[7] = &actGatewayTime;
+	p_allocate_concat_free_dynamic(&result, listPtr, 8, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_encode_getprocparameter_response_compact(SML_GetProcParameter_Res_Compact* response) {
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result* listPtr[4];
+	size_t mark = p_sml_pool_mark();
+
+	SML_Encode_Binary_Result listWrapper		= p_sml_encode_tlfield(LIST, 3);
+	SML_Encode_Binary_Result serverId 			= p_sml_encode_string(response->serverId);
+	SML_Encode_Binary_Result parameterTreePath 	= p_sml_encode_treepath(&response->parameterTreePath);
+	SML_Encode_Binary_Result parameterTree		= p_sml_encode_flat_tree(&response->parameterTree);
+
+	listPtr[0] = &listWrapper;
+	listPtr[1] = &serverId;
+	listPtr[2] = &parameterTreePath;
+	listPtr[3] = &parameterTree;
+	p_allocate_concat_free_dynamic(&result, listPtr, 4, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_encode_messagebody_compact(SML_MessageBody* messageBody) {
+	switch(messageBody->choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+			return p_sml_encode_open_request_compact(messageBody->choiceValue.openRequestCompact);
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+			return p_sml_encode_open_response_compact(messageBody->choiceValue.openResponseCompact);
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+			return p_sml_encode_getlist_response_compact(messageBody->choiceValue.getListResponseCompact);
+		default:
+			return p_sml_encode_getprocparameter_response_compact(messageBody->choiceValue.getProcParameterResponseCompact);
+	}
+}
+
 SML_Encode_Binary_Result p_sml_encode_messagebody(SML_MessageBody* messageBody) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[3];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 2);
 	SML_Encode_Binary_Result messageBodyTag = p_sml_encode_unsigned(messageBody->choiceTag, sizeof(uint32_t));
 	SML_Encode_Binary_Result messageBodyValue;
 
-	printBinaryResult("listWrapper", &listWrapper);
-	printBinaryResult("messageBodyTag", &messageBodyTag);
+	p_sml_message_type(messageBody->choiceTag);
 
-	switch(messageBody->choiceTag) {
-		case SML_MESSAGEBODY_OPEN_REQUEST:
-			messageBodyValue = p_sml_encode_open_request(messageBody->choiceValue.openRequest);
-		break;
-		case SML_MESSAGEBODY_OPEN_RESPONSE:
-			messageBodyValue = p_sml_encode_open_response(messageBody->choiceValue.openResponse);
-		break;
-		case SML_MESSAGEBODY_CLOSE_REQUEST:
-			messageBodyValue = p_sml_encode_close_request(messageBody->choiceValue.closeRequest);
-		break;
-		case SML_MESSAGEBODY_CLOSE_RESPONSE:
-			messageBodyValue = p_sml_encode_close_response(messageBody->choiceValue.closeResponse);
-		break;
-		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST:
-			messageBodyValue = p_sml_encode_getprofilepack_request(messageBody->choiceValue.getProfilePackRequest);
-		break;
-		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE:
-			messageBodyValue = p_sml_encode_getprofilepack_response(messageBody->choiceValue.getProfilePackResponse);
-		break;
-		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST:
-			messageBodyValue = p_sml_encode_getprofilelist_request(messageBody->choiceValue.getProfileListRequest);
-		break;
-		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE:
-			messageBodyValue = p_sml_encode_getprofilelist_response(messageBody->choiceValue.getProfileListResponse);
-		break;
-		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST:
-			messageBodyValue = p_sml_encode_getprocparameter_request(messageBody->choiceValue.getProcParameterRequest);
-		break;
-		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
-			messageBodyValue = p_sml_encode_getprocparameter_response(messageBody->choiceValue.getProcParameterResponse);
-		break;
-		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST:
-			messageBodyValue = p_sml_encode_setprocparameter_request(messageBody->choiceValue.setProcParameterRequest);
-		break;
-		case SML_MESSAGEBODY_GETLIST_REQUEST:
-			messageBodyValue = p_sml_encode_getlist_request(messageBody->choiceValue.getListRequest);
-		break;
-		case SML_MESSAGEBODY_GETLIST_RESPONSE:
-			messageBodyValue = p_sml_encode_getlist_response(messageBody->choiceValue.getListResponse);
-		break;
-		case SML_MESSAGEBODY_ATTENTION_RESPONSE:
-			messageBodyValue = p_sml_encode_attention_response(messageBody->choiceValue.attentionResponse);
-		break;
+	SML_TRACE_FIELD("listWrapper", &listWrapper);
+	SML_TRACE_FIELD("messageBodyTag", &messageBodyTag);
+
+	if(p_sml_context->compactLayout && sml_messagebody_has_compact_layout(messageBody->choiceTag)) {
+		messageBodyValue = p_sml_encode_messagebody_compact(messageBody);
+	}
+	else {
+		switch(messageBody->choiceTag) {
+			case SML_MESSAGEBODY_OPEN_REQUEST:
+				messageBodyValue = p_sml_encode_open_request(messageBody->choiceValue.openRequest);
+			break;
+			case SML_MESSAGEBODY_OPEN_RESPONSE:
+				messageBodyValue = p_sml_encode_open_response(messageBody->choiceValue.openResponse);
+			break;
+			case SML_MESSAGEBODY_CLOSE_REQUEST:
+				messageBodyValue = p_sml_encode_close_request(messageBody->choiceValue.closeRequest);
+			break;
+			case SML_MESSAGEBODY_CLOSE_RESPONSE:
+				messageBodyValue = p_sml_encode_close_response(messageBody->choiceValue.closeResponse);
+			break;
+			case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST:
+				messageBodyValue = p_sml_encode_getprofilepack_request(messageBody->choiceValue.getProfilePackRequest);
+			break;
+			case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE:
+				messageBodyValue = p_sml_encode_getprofilepack_response(messageBody->choiceValue.getProfilePackResponse);
+			break;
+			case SML_MESSAGEBODY_GETPROFILELIST_REQUEST:
+				messageBodyValue = p_sml_encode_getprofilelist_request(messageBody->choiceValue.getProfileListRequest);
+			break;
+			case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE:
+				messageBodyValue = p_sml_encode_getprofilelist_response(messageBody->choiceValue.getProfileListResponse);
+			break;
+			case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST:
+				messageBodyValue = p_sml_encode_getprocparameter_request(messageBody->choiceValue.getProcParameterRequest);
+			break;
+			case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
+				messageBodyValue = p_sml_encode_getprocparameter_response(messageBody->choiceValue.getProcParameterResponse);
+			break;
+			case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST:
+				messageBodyValue = p_sml_encode_setprocparameter_request(messageBody->choiceValue.setProcParameterRequest);
+			break;
+			case SML_MESSAGEBODY_GETLIST_REQUEST:
+				messageBodyValue = p_sml_encode_getlist_request(messageBody->choiceValue.getListRequest);
+			break;
+			case SML_MESSAGEBODY_GETLIST_RESPONSE:
+				messageBodyValue = p_sml_encode_getlist_response(messageBody->choiceValue.getListResponse);
+			break;
+			case SML_MESSAGEBODY_ATTENTION_RESPONSE:
+				messageBodyValue = p_sml_encode_attention_response(messageBody->choiceValue.attentionResponse);
+			break;
+		}
 	}
 
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &messageBodyTag;
 	listPtr[2] = &messageBodyValue;
-	p_allocate_concat_free_dynamic(&result, listPtr, 3);
+	p_allocate_concat_free_dynamic(&result, listPtr, 3, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -648,17 +972,19 @@ SML_Encode_Binary_Result p_sml_encode_messagebody(SML_MessageBody* messageBody)
 
 SML_Encode_Binary_Result p_sml_encode_treepath(SML_TreePath* treePath) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* smlPathEntry = (SML_Encode_Binary_Result*)calloc(treePath->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* smlPathEntry = (SML_Encode_Binary_Result*)p_sml_calloc(treePath->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(smlPathEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	smlPathEntry[0] = p_sml_encode_tlfield(LIST, treePath->listSize);
 	for(i=0; i < treePath->listSize; i++) {
 		smlPathEntry[i+1] = p_sml_encode_string(treePath->path_Entry[i]);
 	}
 
-	p_allocate_concat_free(&result, smlPathEntry, treePath->listSize+1);
-
-	free(smlPathEntry);
+	p_allocate_concat_free(&result, smlPathEntry, treePath->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -666,17 +992,19 @@ SML_Encode_Binary_Result p_sml_encode_treepath(SML_TreePath* treePath) {
 
 SML_Encode_Binary_Result p_sml_encode_list_of_tree(List_of_SML_Tree* list) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* smlTree = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* smlTree = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(smlTree == NULL) {
+		return p_sml_encode_nomem();
+	}
 	smlTree[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		smlTree[i+1] = p_sml_encode_tree(list->tree_Entry+i);
 	}
 
-	p_allocate_concat_free(&result, smlTree, list->listSize+1);
-
-	free(smlTree);
+	p_allocate_concat_free(&result, smlTree, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -684,18 +1012,66 @@ SML_Encode_Binary_Result p_sml_encode_list_of_tree(List_of_SML_Tree* list) {
 
 SML_Encode_Binary_Result p_sml_encode_tree(SML_Tree* tree) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* listPtr[4];
+	SML_Encode_Binary_Result* parts;
+	size_t mark;
+	SML_Tree_Walk walk;
+	SML_Tree* node;
+	uint32_t nodeCount = 0;
+	uint32_t i = 0;
 
-	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 3);
-	SML_Encode_Binary_Result parameterName 	= p_sml_encode_string(tree->parameterName);
-	SML_Encode_Binary_Result parameterValue = tree->parameterValue != NULL ? p_sml_encode_procparvalue(tree->parameterValue) : p_sml_encode_tlfield(STRING, 0);
-	SML_Encode_Binary_Result child_List 	= tree->child_List != NULL ? p_sml_encode_list_of_tree(tree->child_List) : p_sml_encode_tlfield(STRING, 0);
+	/* Count the nodes first, the walk stack replaces the recursion */
+	walk.depth = 0;
+	walk.overflow = FALSE;
+	for(node = tree; node != NULL; node = p_sml_tree_next(&walk, node)) {
+		nodeCount++;
+	}
+	if(walk.overflow) {
+		p_sml_context->encodeError = "SML_Tree exceeds SMLLIB_TREE_MAX_DEPTH.";
+		return p_sml_encode_tlfield(STRING, 0);
+	}
 
-	listPtr[0] = &listWrapper;
-	listPtr[1] = &parameterName;
-	listPtr[2] = &parameterValue;
-	listPtr[3] = &child_List;
-	p_allocate_concat_free_dynamic(&result, listPtr, 4);
+	/* Four parts per node in preorder: wrapper, name, value and child list header */
+	mark = p_sml_pool_mark();
+	parts = (SML_Encode_Binary_Result*)p_sml_calloc(nodeCount * 4, sizeof(SML_Encode_Binary_Result));
+	if(parts == NULL) {
+		return p_sml_encode_nomem();
+	}
+	for(node = tree; node != NULL; node = p_sml_tree_next(&walk, node)) {
+		parts[i++] = p_sml_encode_tlfield(LIST, 3);
+		parts[i++] = p_sml_encode_string(node->parameterName);
+		parts[i++] = node->parameterValue != NULL ? p_sml_encode_procparvalue(node->parameterValue) : p_sml_encode_tlfield(STRING, 0);
+		parts[i++] = node->child_List != NULL ? p_sml_encode_tlfield(LIST, node->child_List->listSize) : p_sml_encode_tlfield(STRING, 0);
+	}
+
+	p_allocate_concat_free(&result, parts, i, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+SML_Encode_Binary_Result p_sml_encode_flat_tree(SML_Flat_Tree* tree) {
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result* parts;
+	size_t mark;
+	SML_Flat_Node* node;
+	uint32_t i;
+	uint32_t p = 0;
+
+	/* Preorder is the encoding order, no walk needed */
+	mark = p_sml_pool_mark();
+	parts = (SML_Encode_Binary_Result*)p_sml_calloc(tree->nodeCount * 4, sizeof(SML_Encode_Binary_Result));
+	if(parts == NULL) {
+		return p_sml_encode_nomem();
+	}
+	for(i=0; i < tree->nodeCount; i++) {
+		node = &tree->nodes[i];
+		parts[p++] = p_sml_encode_tlfield(LIST, 3);
+		parts[p++] = p_sml_encode_string(node->parameterName);
+		parts[p++] = node->value != SML_FLAT_NO_VALUE ? p_sml_encode_procparvalue(&tree->values[node->value]) : p_sml_encode_tlfield(STRING, 0);
+		parts[p++] = node->childCount > 0 ? p_sml_encode_tlfield(LIST, node->childCount) : p_sml_encode_tlfield(STRING, 0);
+	}
+
+	p_allocate_concat_free(&result, parts, p, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -703,17 +1079,19 @@ SML_Encode_Binary_Result p_sml_encode_tree(SML_Tree* tree) {
 
 SML_Encode_Binary_Result p_sml_encode_list_of_objreqentry(List_of_SML_ObjReqEntry* list) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* objReqEntry = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* objReqEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(objReqEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	objReqEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		objReqEntry[i+1] = p_sml_encode_string(list->object_List_Entry[i]);
 	}
 
-	p_allocate_concat_free(&result, objReqEntry, list->listSize+1);
-
-	free(objReqEntry);
+	p_allocate_concat_free(&result, objReqEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -721,17 +1099,19 @@ SML_Encode_Binary_Result p_sml_encode_list_of_objreqentry(List_of_SML_ObjReqEntr
 
 SML_Encode_Binary_Result p_sml_encode_list_of_periodentry(List_of_SML_PeriodEntry* list) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* periodEntry = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* periodEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(periodEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	periodEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		periodEntry[i+1] = p_sml_encode_periodentry(list->period_List_Entry+i);
 	}
 
-	p_allocate_concat_free(&result, periodEntry, list->listSize+1);
-
-	free(periodEntry);
+	p_allocate_concat_free(&result, periodEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -739,17 +1119,19 @@ SML_Encode_Binary_Result p_sml_encode_list_of_periodentry(List_of_SML_PeriodEntr
 
 SML_Encode_Binary_Result p_sml_encode_list_of_objheaderentry(List_of_SML_ProfObjHeaderEntry* list) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* objHeaderEntry = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* objHeaderEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(objHeaderEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	objHeaderEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		objHeaderEntry[i+1] = p_sml_encode_objheaderentry(list->header_List_Entry+i);
 	}
 
-	p_allocate_concat_free(&result, objHeaderEntry, list->listSize+1);
-
-	free(objHeaderEntry);
+	p_allocate_concat_free(&result, objHeaderEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -757,17 +1139,19 @@ SML_Encode_Binary_Result p_sml_encode_list_of_objheaderentry(List_of_SML_ProfObj
 
 SML_Encode_Binary_Result p_sml_encode_list_of_objperiodentry(List_of_SML_ProfObjPeriodEntry* list) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* objPeriodEntry = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* objPeriodEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(objPeriodEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	objPeriodEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		objPeriodEntry[i+1] = p_sml_encode_objperiodentry(list->period_List_Entry+i);
 	}
 
-	p_allocate_concat_free(&result, objPeriodEntry, list->listSize+1);
-
-	free(objPeriodEntry);
+	p_allocate_concat_free(&result, objPeriodEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -775,17 +1159,19 @@ SML_Encode_Binary_Result p_sml_encode_list_of_objperiodentry(List_of_SML_ProfObj
 
 SML_Encode_Binary_Result p_sml_encode_list_of_valueentry(List_of_SML_ValueEntry* list) {
 	SML_Encode_Binary_Result result;
-	SML_Encode_Binary_Result* valueEntry = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* valueEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(valueEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	valueEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		valueEntry[i+1] = p_sml_encode_valueentry(list->value_List_Entry+i);
 	}
 
-	p_allocate_concat_free(&result, valueEntry, list->listSize+1);
-
-	free(valueEntry);
+	p_allocate_concat_free(&result, valueEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -794,9 +1180,10 @@ SML_Encode_Binary_Result p_sml_encode_list_of_valueentry(List_of_SML_ValueEntry*
 SML_Encode_Binary_Result p_sml_encode_objheaderentry(SML_ProfObjHeaderEntry* entry) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[4];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 3);
-	SML_Encode_Binary_Result objName 		= p_sml_encode_string(entry->objName);
+	SML_Encode_Binary_Result objName 		= p_sml_encode_objname(entry->objName, &entry->obis);
 	SML_Encode_Binary_Result unit 			= p_sml_encode_unsigned(entry->unit, sizeof(SML_Unit));
 	SML_Encode_Binary_Result scaler 		= p_sml_encode_integer(entry->scaler, sizeof(int8_t));
 
@@ -804,7 +1191,7 @@ SML_Encode_Binary_Result p_sml_encode_objheaderentry(SML_ProfObjHeaderEntry* ent
 	listPtr[1] = &objName;
 	listPtr[2] = &unit;
 	listPtr[3] = &scaler;
-	p_allocate_concat_free_dynamic(&result, listPtr, 4);
+	p_allocate_concat_free_dynamic(&result, listPtr, 4, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -813,6 +1200,7 @@ SML_Encode_Binary_Result p_sml_encode_objheaderentry(SML_ProfObjHeaderEntry* ent
 SML_Encode_Binary_Result p_sml_encode_objperiodentry(SML_ProfObjPeriodEntry* entry) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[5];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	 = p_sml_encode_tlfield(LIST, 4);
 	SML_Encode_Binary_Result valTime 		 = p_sml_encode_time(&entry->valTime);
@@ -825,7 +1213,7 @@ SML_Encode_Binary_Result p_sml_encode_objperiodentry(SML_ProfObjPeriodEntry* ent
 	listPtr[2] = &status;
 	listPtr[3] = &value_List;
 	listPtr[4] = &periodSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 5);
+	p_allocate_concat_free_dynamic(&result, listPtr, 5, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -834,6 +1222,7 @@ SML_Encode_Binary_Result p_sml_encode_objperiodentry(SML_ProfObjPeriodEntry* ent
 SML_Encode_Binary_Result p_sml_encode_valueentry(SML_ValueEntry* entry) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[3];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 2);
 	SML_Encode_Binary_Result value 		 	= p_sml_encode_value(&entry->value);
@@ -842,7 +1231,7 @@ SML_Encode_Binary_Result p_sml_encode_valueentry(SML_ValueEntry* entry) {
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &value;
 	listPtr[2] = &valueSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 3);
+	p_allocate_concat_free_dynamic(&result, listPtr, 3, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -851,6 +1240,7 @@ SML_Encode_Binary_Result p_sml_encode_valueentry(SML_ValueEntry* entry) {
 SML_Encode_Binary_Result p_sml_encode_procparvalue(SML_ProcParValue* value) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[3];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper = p_sml_encode_tlfield(LIST, 2);
 	SML_Encode_Binary_Result smlProcParTag = p_sml_encode_unsigned(value->choiceTag, sizeof(uint8_t));
@@ -874,7 +1264,7 @@ SML_Encode_Binary_Result p_sml_encode_procparvalue(SML_ProcParValue* value) {
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &smlProcParTag;
 	listPtr[2] = &smlProcParValue;
-	p_allocate_concat_free_dynamic(&result, listPtr, 3);
+	p_allocate_concat_free_dynamic(&result, listPtr, 3, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -883,9 +1273,10 @@ SML_Encode_Binary_Result p_sml_encode_procparvalue(SML_ProcParValue* value) {
 SML_Encode_Binary_Result p_sml_encode_periodentry(SML_PeriodEntry* entry) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[6];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 5);
-	SML_Encode_Binary_Result objName 		= p_sml_encode_string(entry->objName);
+	SML_Encode_Binary_Result objName 		= p_sml_encode_objname(entry->objName, &entry->obis);
 	SML_Encode_Binary_Result unit 			= p_sml_encode_unsigned(entry->unit, sizeof(SML_Unit));
 	SML_Encode_Binary_Result scaler 		= p_sml_encode_integer(entry->scaler, sizeof(int8_t));
 	SML_Encode_Binary_Result value 			= p_sml_encode_value(&entry->value);
@@ -897,7 +1288,7 @@ SML_Encode_Binary_Result p_sml_encode_periodentry(SML_PeriodEntry* entry) {
 	listPtr[3] = &scaler;
 	listPtr[4] = &value;
 	listPtr[5] = &valueSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 6);
+	p_allocate_concat_free_dynamic(&result, listPtr, 6, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -906,6 +1297,7 @@ SML_Encode_Binary_Result p_sml_encode_periodentry(SML_PeriodEntry* entry) {
 SML_Encode_Binary_Result p_sml_encode_tupelentry(SML_TupelEntry* entry) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[24];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 23);
 	SML_Encode_Binary_Result serverId 		= p_sml_encode_string(entry->serverId);
@@ -972,7 +1364,7 @@ SML_Encode_Binary_Result p_sml_encode_tupelentry(SML_TupelEntry* entry) {
 
 	listPtr[23] = &signature_mA_R2_R3;
 
-	p_allocate_concat_free_dynamic(&result, listPtr, 24);
+	p_allocate_concat_free_dynamic(&result, listPtr, 24, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -1043,17 +1435,19 @@ SML_Encode_Binary_Result p_sml_encode_status(SML_Status* status) {
 SML_Encode_Binary_Result p_sml_encode_list(SML_List* list) {
 	SML_Encode_Binary_Result result;
 
-	SML_Encode_Binary_Result* smlListEntry = (SML_Encode_Binary_Result*)calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* smlListEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
 
 	uint32_t i = 0;
+	if(smlListEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
 	smlListEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
 	for(i=0; i < list->listSize; i++) {
 		smlListEntry[i+1] = p_sml_encode_listentry(list->valListEntry+i);
 	}
 
-	p_allocate_concat_free(&result, smlListEntry, list->listSize+1);
-
-	free(smlListEntry);
+	p_allocate_concat_free(&result, smlListEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
@@ -1062,9 +1456,10 @@ SML_Encode_Binary_Result p_sml_encode_list(SML_List* list) {
 SML_Encode_Binary_Result p_sml_encode_listentry(SML_ListEntry* entry) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[8];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 7);
-	SML_Encode_Binary_Result objName 		= p_sml_encode_string(entry->objName);
+	SML_Encode_Binary_Result objName 		= p_sml_encode_objname(entry->objName, &entry->obis);
 	SML_Encode_Binary_Result status 		= entry->status != NULL ? p_sml_encode_status(entry->status) : p_sml_encode_tlfield(STRING, 0);
 	SML_Encode_Binary_Result valTime 		= entry->valTime != NULL ? p_sml_encode_time(entry->valTime) : p_sml_encode_tlfield(STRING, 0);
 	SML_Encode_Binary_Result unit 			= entry->unit != NULL ? p_sml_encode_unsigned(*entry->unit, sizeof(SML_Unit)) : p_sml_encode_tlfield(STRING, 0);
@@ -1080,16 +1475,66 @@ SML_Encode_Binary_Result p_sml_encode_listentry(SML_ListEntry* entry) {
 	listPtr[5] = &scaler;
 	listPtr[6] = &value;
 	listPtr[7] = &valueSignature;
-	p_allocate_concat_free_dynamic(&result, listPtr, 8);
+	p_allocate_concat_free_dynamic(&result, listPtr, 8, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
+
+
+SML_Encode_Binary_Result p_sml_encode_list_compact(SML_List_Compact* list) {
+	SML_Encode_Binary_Result result;
+
+	size_t mark = p_sml_pool_mark();
+	SML_Encode_Binary_Result* smlListEntry = (SML_Encode_Binary_Result*)p_sml_calloc(list->listSize+1, sizeof(SML_Encode_Binary_Result));
+
+	uint32_t i = 0;
+	if(smlListEntry == NULL) {
+		return p_sml_encode_nomem();
+	}
+	smlListEntry[0] = p_sml_encode_tlfield(LIST, list->listSize);
+	for(i=0; i < list->listSize; i++) {
+		smlListEntry[i+1] = p_sml_encode_listentry_compact(list->valListEntry+i);
+	}
+
+	p_allocate_concat_free(&result, smlListEntry, list->listSize+1, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
 }
 
+SML_Encode_Binary_Result p_sml_encode_listentry_compact(SML_ListEntry_Compact* entry) {
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result* listPtr[8];
+	size_t mark = p_sml_pool_mark();
+
+	SML_Encode_Binary_Result listWrapper	= p_sml_encode_tlfield(LIST, 7);
+	SML_Encode_Binary_Result objName 		= p_sml_encode_objname(entry->objName, &entry->obis);
+	SML_Encode_Binary_Result status 		= (entry->present & SML_LISTENTRY_STATUS) ? p_sml_encode_status(&entry->status) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result valTime 		= (entry->present & SML_LISTENTRY_VALTIME) ? p_sml_encode_time(&entry->valTime) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result unit 			= (entry->present & SML_LISTENTRY_UNIT) ? p_sml_encode_unsigned(entry->unit, sizeof(SML_Unit)) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result scaler 		= (entry->present & SML_LISTENTRY_SCALER) ? p_sml_encode_integer(entry->scaler, sizeof(int8_t)) : p_sml_encode_tlfield(STRING, 0);
+	SML_Encode_Binary_Result value 			= p_sml_encode_value(&entry->value);
+	SML_Encode_Binary_Result valueSignature = entry->valueSignature != NULL ? p_sml_encode_string(entry->valueSignature) : p_sml_encode_tlfield(STRING, 0);
+
+	listPtr[0] = &listWrapper;
+	listPtr[1] = &objName;
+	listPtr[2] = &status;
+	listPtr[3] = &valTime;
+	listPtr[4] = &unit;
+	listPtr[5] = &scaler;
+	listPtr[6] = &value;
+	listPtr[7] = &valueSignature;
+	p_allocate_concat_free_dynamic(&result, listPtr, 8, mark);
+
+	result.resultCode = SML_ENCODE_OK;
+	return result;
+}
 
 SML_Encode_Binary_Result p_sml_encode_time(SML_Time* time) {
 	SML_Encode_Binary_Result result;
 	SML_Encode_Binary_Result* listPtr[3];
+	size_t mark = p_sml_pool_mark();
 
 	SML_Encode_Binary_Result listWrapper = p_sml_encode_tlfield(LIST, 2);
 	SML_Encode_Binary_Result smlTimeTag	 = p_sml_encode_unsigned(time->choiceTag, sizeof(uint8_t));
@@ -1107,14 +1552,22 @@ SML_Encode_Binary_Result p_sml_encode_time(SML_Time* time) {
 	listPtr[0] = &listWrapper;
 	listPtr[1] = &smlTimeTag;
 	listPtr[2] = &smlTimeValue;
-	p_allocate_concat_free_dynamic(&result, listPtr, 3);
+	p_allocate_concat_free_dynamic(&result, listPtr, 3, mark);
 
 	result.resultCode = SML_ENCODE_OK;
 	return result;
 }
 
 SML_Encode_Binary_Result p_sml_encode_string(char* in) {
-	return p_sml_encode_primitive_type(in, STRING, (uint32_t)strlen(in));
+	return p_sml_encode_primitive_type(in, STRING, (uint32_t)p_sml_strlen(in));
+}
+
+SML_Encode_Binary_Result p_sml_encode_objname(char* objName, SML_Obis* obis) {
+	/* The inline code also covers OBIS codes containing zero bytes */
+	if(objName == NULL && obis->id != SML_OBIS_NONE) {
+		return p_sml_encode_primitive_type(obis->code, STRING, SML_OBIS_LENGTH);
+	}
+	return p_sml_encode_string(objName);
 }
 
 SML_Encode_Binary_Result p_sml_encode_boolean(SML_Boolean in) {
@@ -1122,34 +1575,91 @@ SML_Encode_Binary_Result p_sml_encode_boolean(SML_Boolean in) {
 }
 
 SML_Encode_Binary_Result p_sml_encode_integer(int64_t in, uint32_t length) {
-	return p_sml_encode_primitive_type(&in, INTEGER, length);
+	if(p_sml_context->encodeShortest == TRUE) {
+		length = p_sml_integer_min_length(in, length);
+	}
+	return p_sml_encode_number((uint64_t)in, INTEGER, length);
 }
 
 SML_Encode_Binary_Result p_sml_encode_unsigned(uint64_t in, uint32_t length) {
-	return p_sml_encode_primitive_type(&in, UNSIGNED, length);
+	if(p_sml_context->encodeShortest == TRUE) {
+		length = p_sml_unsigned_min_length(in, length);
+	}
+	return p_sml_encode_number(in, UNSIGNED, length);
+}
+
+SML_Encode_Binary_Result p_sml_encode_number(uint64_t in, TL_FieldType type, uint32_t length) {
+	SML_Encode_Binary_Result result;
+	uint32_t i;
+
+	result.length = 1 + length;
+	result.resultBinary = (unsigned char*)p_sml_calloc(result.length, sizeof(unsigned char));
+	result.errorMessage = NULL;
+	result.resultCode = SML_ENCODE_OK;
+	if(result.resultBinary == NULL) {
+		return p_sml_encode_nomem();
+	}
+
+	/* TL byte, value bytes in network byte order */
+	result.resultBinary[0] = (unsigned char)((type == INTEGER ? 0x50 : 0x60) + length + 1);
+	for(i=length; i > 0; i--) {
+		result.resultBinary[i] = (unsigned char)(in & 0xFF);
+		in = in >> 8;
+	}
+
+	return result;
+}
+
+uint32_t p_sml_unsigned_min_length(uint64_t in, uint32_t length) {
+	uint32_t minLength = 1;
+
+	while(minLength < length && (in >> (8*minLength)) != 0) {
+		minLength++;
+	}
+
+	return minLength;
+}
+
+uint32_t p_sml_integer_min_length(int64_t in, uint32_t length) {
+	uint32_t minLength = 1;
+	int64_t limit = 0x80;
+
+	/* smallest two's complement width that sign-extends back to the value */
+	while(minLength < length && (in < -limit || in >= limit)) {
+		minLength++;
+		limit = (minLength < sizeof(int64_t)) ? (limit << 8) : limit;
+	}
+
+	return minLength;
 }
 
 SML_Encode_Binary_Result p_sml_encode_primitive_type(void* in_ptr, TL_FieldType type, uint32_t length) {
 	SML_Encode_Binary_Result result;
+	size_t mark = p_sml_pool_mark();
 	/*SML_Encode_Binary_Result tl_List  = p_sml_encode_tlfield(LIST, 2);*/
 	SML_Encode_Binary_Result tl_Value = p_sml_encode_tlfield(type, length);
 
 	result.length = /*tl_List.length + */tl_Value.length + length;
-	result.resultBinary = (unsigned char*)calloc(result.length, sizeof(unsigned char));
+	result.resultBinary = (unsigned char*)p_sml_calloc(result.length, sizeof(unsigned char));
 	result.errorMessage = NULL;
 	result.resultCode = SML_ENCODE_OK;
+	if(tl_Value.resultBinary == NULL || result.resultBinary == NULL) {
+		p_sml_free(result.resultBinary);
+		p_sml_free(tl_Value.resultBinary);
+		return p_sml_encode_nomem();
+	}
 
 	/*memmove(
 		result.resultBinary,
 		tl_List.resultBinary,
 		tl_List.length
 	);*/
-	memmove(
+	p_sml_memcpy(
 		result.resultBinary,/*+tl_List.length*/
 		tl_Value.resultBinary,
 		tl_Value.length
 	);
-	memmove(
+	p_sml_memcpy(
 		result.resultBinary+/*tl_List.length+*/tl_Value.length,
 		(char*)in_ptr,
 		length
@@ -1167,7 +1677,8 @@ SML_Encode_Binary_Result p_sml_encode_primitive_type(void* in_ptr, TL_FieldType
 	}
 
 	/*free(tl_List.resultBinary);*/
-	free(tl_Value.resultBinary);
+	p_sml_free(tl_Value.resultBinary);
+	result.resultBinary = (unsigned char*)p_sml_pool_settle(mark, result.resultBinary, result.length);
 
 	return result;
 }
@@ -1197,7 +1708,10 @@ SML_Encode_Binary_Result p_sml_encode_tlfield(TL_FieldType type, uint32_t length
 				baseValue = 0x60; /* 0b01100000 */
 			}
 
-			result.resultBinary = (unsigned char*)calloc(1, sizeof(unsigned char));
+			result.resultBinary = (unsigned char*)p_sml_calloc(1, sizeof(unsigned char));
+			if(result.resultBinary == NULL) {
+				return p_sml_encode_nomem();
+			}
 			*(result.resultBinary) = (unsigned char)(baseValue + length + 1); /* assume length < 15 bytes */
 			result.length = 1;
 		break;
@@ -1209,7 +1723,10 @@ SML_Encode_Binary_Result p_sml_encode_tlfield(TL_FieldType type, uint32_t length
 				}
 				tlCount++;
 			}
-			result.resultBinary = (unsigned char*)calloc(tlCount, sizeof(unsigned char));
+			result.resultBinary = (unsigned char*)p_sml_calloc(tlCount, sizeof(unsigned char));
+			if(result.resultBinary == NULL) {
+				return p_sml_encode_nomem();
+			}
 			result.length = tlCount;
 
 			length = (length + tlCount);
@@ -1231,7 +1748,10 @@ SML_Encode_Binary_Result p_sml_encode_tlfield(TL_FieldType type, uint32_t length
 				}
 				tlCount++;
 			}
-			result.resultBinary = (unsigned char*)calloc(tlCount, sizeof(unsigned char));
+			result.resultBinary = (unsigned char*)p_sml_calloc(tlCount, sizeof(unsigned char));
+			if(result.resultBinary == NULL) {
+				return p_sml_encode_nomem();
+			}
 			result.length = tlCount;
 
 			for(i=tlCount; i > 0; i--) {
@@ -1253,104 +1773,279 @@ SML_Encode_Binary_Result p_sml_encode_tlfield(TL_FieldType type, uint32_t length
 void p_concat_binary_results(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* src, uint32_t count) {
 	uint32_t i;
 	for(i=0; i < count; i++) {
-		memmove(
-			target->resultBinary + target->length,
-			src[i].resultBinary,
-			src[i].length
-		);
-		target->length += src[i].length;
+		if(src[i].length > 0) {
+			p_sml_memcpy(
+				target->resultBinary + target->length,
+				src[i].resultBinary,
+				src[i].length
+			);
+			target->length += src[i].length;
+		}
 	}
 }
 
 void p_concat_binary_results_dynamic(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result** src, uint32_t count) {
 	uint32_t i;
 	for(i=0; i < count; i++) {
-		memmove(
-			target->resultBinary + target->length,
-			src[i]->resultBinary,
-			src[i]->length
-		);
-		target->length += src[i]->length;
+		if(src[i]->length > 0) {
+			p_sml_memcpy(
+				target->resultBinary + target->length,
+				src[i]->resultBinary,
+				src[i]->length
+			);
+			target->length += src[i]->length;
+		}
 	}
 }
 
-void p_allocate_concat_free(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* src, uint32_t count) {
+void p_allocate_concat_free(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* src, uint32_t count, size_t mark) {
+	p_sml_concat_parts(target, src, NULL, count);
+	p_sml_free(src);
+
+	/* Drops the list (below the parts) and whatever the parts left behind */
+	target->resultBinary = (unsigned char*)p_sml_pool_settle(mark, target->resultBinary, target->length);
+}
+
+void p_allocate_concat_free_dynamic(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result** src, uint32_t count, size_t mark) {
+	p_sml_concat_parts(target, NULL, src, count);
+	target->resultBinary = (unsigned char*)p_sml_pool_settle(mark, target->resultBinary, target->length);
+}
+
+void p_sml_concat_parts(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result* array, SML_Encode_Binary_Result** ptrs, uint32_t count) {
+	SML_Encode_Binary_Result* part;
+	unsigned char* end = NULL;
+	SML_Boolean inPlace = TRUE;
 	uint32_t totalLength;
 	uint32_t i;
 
-	/* Collect sizes */
-	for(totalLength=0, i=0; i < count; totalLength += src[i].length, i++);
+	/* Collect sizes; nested encoders settle their result where they started,
+	 * so in the pool the parts lie back to back and only need closing up */
+	for(totalLength=0, i=0; i < count; i++) {
+		part = (ptrs != NULL) ? ptrs[i] : array+i;
+		if(part->length == 0) {
+			continue;
+		}
+		if(p_sml_pool_holds(part->resultBinary) == FALSE || (end != NULL && part->resultBinary < end)) {
+			inPlace = FALSE;
+		}
+		end = part->resultBinary + part->length;
+		totalLength += part->length;
+	}
 
-	/* Allocate space for merged binary data */
 	target->length = 0;
-	target->resultBinary = (unsigned char*)calloc(totalLength, sizeof(unsigned char));
+	target->resultBinary = NULL;
+	if(inPlace && totalLength > 0) {
+		for(i=0; i < count; i++) {
+			part = (ptrs != NULL) ? ptrs[i] : array+i;
+			if(part->length == 0) {
+				continue;
+			}
+			if(target->resultBinary == NULL) {
+				target->resultBinary = part->resultBinary;
+			}
+			else {
+				p_sml_memmove(target->resultBinary + target->length, part->resultBinary, part->length);
+			}
+			target->length += part->length;
+		}
+		return;
+	}
+
+	/* Allocate space for merged binary data */
+	target->resultBinary = (unsigned char*)p_sml_calloc(totalLength, sizeof(unsigned char));
+	if(target->resultBinary == NULL && totalLength > 0) {
+		*target = p_sml_encode_nomem();
+	}
 
 	/* Merge structures & free old ones */
 	for(i=0; i < count; i++) {
-		memmove(
-			target->resultBinary + target->length,
-			src[i].resultBinary,
-			src[i].length
-		);
-		target->length += src[i].length;
-		free(src[i].resultBinary);
+		part = (ptrs != NULL) ? ptrs[i] : array+i;
+		if(target->resultBinary != NULL && part->length > 0) {
+			p_sml_memcpy(
+				target->resultBinary + target->length,
+				part->resultBinary,
+				part->length
+			);
+			target->length += part->length;
+		}
+		p_sml_free(part->resultBinary);
 	}
 }
 
-void p_allocate_concat_free_dynamic(SML_Encode_Binary_Result* target, SML_Encode_Binary_Result** src, uint32_t count) {
-	uint32_t totalLength;
-	uint32_t i;
+void p_set_encode_error(SML_Encode_Binary_Result* result, const char* errmsg) {
+	SML_TRACE_ERROR_TEXT("encodeError", errmsg);
+	p_sml_encode_error(errmsg);
+	if(errmsg == p_sml_encode_nomem_text) {
+		p_sml_context->error.code = SML_ERROR_NOMEM;
+	}
+	result->errorMessage = errmsg;
+}
 
-	/* Collect sizes */
-	for(totalLength=0, i=0; i < count; totalLength += src[i]->length, i++);
+SML_Encode_Binary_Result p_sml_encode_nomem(void) {
+	SML_Encode_Binary_Result result;
 
-	/* Allocate space for merged binary data */
-	target->length = 0;
-	target->resultBinary = (unsigned char*)calloc(totalLength, sizeof(unsigned char));
+	/* The first error wins, the top-level encoder drops the partial binary */
+	if(p_sml_context->encodeError == NULL) {
+		p_sml_context->encodeError = p_sml_encode_nomem_text;
+	}
+	result.resultCode = SML_ENCODE_OK;
+	result.resultBinary = NULL;
+	result.length = 0;
+	result.errorMessage = NULL;
+	return result;
+}
 
-	/* Merge structures & free old ones */
-	for(i=0; i < count; i++) {
-		memmove(
-			target->resultBinary + target->length,
-			src[i]->resultBinary,
-			src[i]->length
-		);
-		target->length += src[i]->length;
-		free(src[i]->resultBinary);
+SML_Encode_Binary_Result p_sml_encode_failed_message(SML_Encode_Binary_Result* messages, uint32_t failed) {
+	uint32_t i;
+
+	/* Release the messages encoded before, the failed one carries the error */
+	for(i=0; i < failed; i++) {
+		sml_encode_result_free(messages+i);
 	}
+	return messages[failed];
 }
 
-void p_set_encode_error(SML_Encode_Binary_Result* result, const char* errmsg) {
-	result->errorMessage = (char*)calloc(strlen(errmsg)+1, sizeof(char));
-	strcpy(result->errorMessage, errmsg);
+void p_sml_check_encode_error(SML_Encode_Binary_Result* result) {
+	if(p_sml_context->encodeError == NULL) {
+		return;
+	}
+	/* Nested encoders have no result code of their own, drop the binary */
+	p_sml_free(result->resultBinary);
+	result->resultBinary = NULL;
+	result->length = 0;
+	result->resultCode = SML_ENCODE_ERROR;
+	p_set_encode_error(result, p_sml_context->encodeError);
+	p_sml_context->encodeError = NULL;
 }
 
-SML_Encode_Binary_Result p_sml_transport_escape_message(SML_Encode_Binary_Result* message) {
-	SML_Encode_Binary_Result out;
+uint32_t p_sml_transport_escaped_length(const SML_Encode_Binary_Result* message) {
 	uint32_t i;
 	uint32_t buffer = 0;
 	uint32_t escapeCount = 0;
-	unsigned char* outPtr;
 
-	out.resultBinary = (unsigned char*)calloc(message->length, sizeof(unsigned char));
+	for(i=0; i<message->length; i++) {
+		buffer = (buffer << 8) | (message->resultBinary[i]);
+		if(buffer == 0x1B1B1B1B) {
+			escapeCount++;
+			buffer = 0;
+		}
+	}
+	return message->length + escapeCount*4;
+}
+
+void p_sml_transport_escape_message(const SML_Encode_Binary_Result* message, unsigned char* out) {
+	uint32_t i;
+	uint32_t buffer = 0;
+	uint32_t escapeCount = 0;
 
-	outPtr  = (out.resultBinary);
 	for(i=0; i<message->length; i++) {
-		buffer  = (buffer << 8) | (message->resultBinary[i]);
-		*outPtr = message->resultBinary[i];
-		outPtr++;
+		buffer = (buffer << 8) | (message->resultBinary[i]);
+		*out++ = message->resultBinary[i];
 		if(buffer == 0x1B1B1B1B) {
 			escapeCount++;
-			out.resultBinary = (unsigned char*)realloc(out.resultBinary, message->length+escapeCount*4);
-			outPtr = (out.resultBinary + (i+1) + (escapeCount-1)*4);
-			*(uint32_t*)outPtr = 0x1B1B1B1B;
+			*(uint32_t*)out = 0x1B1B1B1B;
 			buffer = 0;
-			outPtr += 4;
+			out += 4;
+		}
+	}
+	SML_METRIC_ADD(escapesEncoded, escapeCount);
+}
+
+void p_sml_stream_init(SML_Encode_Stream* stream, SML_Write_Callback write, void* writeUser, SML_Boolean transport) {
+	stream->write = write;
+	stream->writeUser = writeUser;
+	stream->transport = transport;
+	stream->messageCrc = 0xFFFF;
+	stream->messageLength = 0;
+	stream->escape = 0;
+	stream->transportCrc = 0xFFFF;
+	stream->written = 0;
+	stream->error = NULL;
+	stream->fill = 0;
+}
+
+void p_sml_stream_flush(SML_Encode_Stream* stream) {
+	if(stream->fill == 0 || stream->error != NULL) {
+		return;
+	}
+	if(stream->transport) {
+		stream->transportCrc = p_sml_crc16_update(stream->transportCrc, stream->buffer, stream->fill);
+	}
+	if(stream->write(stream->writeUser, stream->buffer, stream->fill) != SML_ENCODE_OK) {
+		stream->error = "Write callback failed.";
+	}
+	else {
+		stream->written += stream->fill;
+	}
+	stream->fill = 0;
+}
+
+void p_sml_stream_raw(SML_Encode_Stream* stream, const unsigned char* data, uint32_t length) {
+	uint32_t chunk;
+
+	while(length > 0 && stream->error == NULL) {
+		chunk = SMLLIB_STREAM_BUFFER_SIZE - stream->fill;
+		if(chunk > length) {
+			chunk = length;
+		}
+		p_sml_memcpy(stream->buffer + stream->fill, data, chunk);
+		stream->fill += chunk;
+		data += chunk;
+		length -= chunk;
+		if(stream->fill == SMLLIB_STREAM_BUFFER_SIZE) {
+			p_sml_stream_flush(stream);
+		}
+	}
+}
+
+void p_sml_stream_message(SML_Encode_Stream* stream, const unsigned char* data, uint32_t length) {
+	static const unsigned char escapeSequence[4] = { 0x1B, 0x1B, 0x1B, 0x1B };
+	uint32_t span;
+	uint32_t i;
+
+	if(stream->error != NULL) {
+		return;
+	}
+	stream->messageCrc = p_sml_crc16_update(stream->messageCrc, data, length);
+	stream->messageLength += length;
+	if(!stream->transport) {
+		p_sml_stream_raw(stream, data, length);
+		return;
+	}
+
+	/* Escape like p_sml_transport_escape_message(), copying the spans in between */
+	for(span=0, i=0; i < length; i++) {
+		stream->escape = (stream->escape << 8) | data[i];
+		if(stream->escape == 0x1B1B1B1B) {
+			SML_METRIC_ADD(escapesEncoded, 1);
+			p_sml_stream_raw(stream, data+span, i+1-span);
+			p_sml_stream_raw(stream, escapeSequence, 4);
+			stream->escape = 0;
+			span = i+1;
 		}
 	}
+	p_sml_stream_raw(stream, data+span, length-span);
+}
 
-	out.length = (message->length + escapeCount*4);
-	out.errorMessage = NULL;
-	out.resultCode = SML_ENCODE_OK;
-	return out;
+void p_sml_stream_put(SML_Encode_Stream* stream, SML_Encode_Binary_Result part) {
+	p_sml_stream_message(stream, part.resultBinary, part.length);
+	p_sml_free(part.resultBinary);
+}
+
+void p_sml_stream_periods(SML_Encode_Stream* stream, uint32_t count, SML_Period_Callback rows, void* rowUser) {
+	SML_ProfObjPeriodEntry row;
+	size_t mark;
+	uint32_t i;
+
+	p_sml_memset(&row, 0, sizeof(row));
+	for(i=0; i < count && stream->error == NULL; i++) {
+		if(rows(rowUser, i, &row) != SML_ENCODE_OK) {
+			stream->error = "Period callback failed.";
+			return;
+		}
+		/* Drop the row's encoding garbage so pool usage stays flat over any row count */
+		mark = p_sml_pool_mark();
+		p_sml_stream_put(stream, p_sml_encode_objperiodentry(&row));
+		p_sml_pool_release(mark);
+	}
 }
@@ -0,0 +1,109 @@
+/**
+ * File name: smllib_error.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "smllib_error.h"
+#include "smllib_context.h"
+#include "smllib_tools.h"
+
+static const char* const p_sml_error_names[SML_ERROR_CODES] = {
+	"no error",
+	"invalid type-length field",
+	"unexpected field type",
+	"wrong list size",
+	"unknown choice tag",
+	"tree too deep",
+	"message crc16 mismatch",
+	"end of message missing",
+	"transport escape sequence missing",
+	"frame crc16 mismatch",
+	"stopped by callback",
+	"out of memory",
+	"invalid encoder input"
+};
+
+const char* sml_error_name(uint8_t code) {
+	return (code < SML_ERROR_CODES) ? p_sml_error_names[code] : "unknown error";
+}
+
+uint32_t sml_error_path(const SML_Error* error, char* buffer, uint32_t size) {
+	uint32_t length = 0;
+	uint32_t part;
+	uint32_t i;
+
+	if(size == 0) {
+		return 0;
+	}
+	/* Outermost first */
+	for(i=error->depth; i > 0; i--) {
+		if(i < error->depth && length + 1 < size) {
+			buffer[length++] = '/';
+		}
+		part = (uint32_t)p_sml_strlen(error->path[i-1]);
+		if(part > size - 1 - length) {
+			part = size - 1 - length;
+		}
+		p_sml_memcpy(buffer + length, error->path[i-1], part);
+		length += part;
+	}
+	buffer[length] = '\0';
+
+	return length;
+}
+
+void p_sml_error_reset(void) {
+	p_sml_context->error.code = SML_ERROR_NONE;
+	p_sml_context->error.depth = 0;
+	p_sml_context->error.offset = 0;
+	p_sml_context->error.messageType = 0;
+	p_sml_context->error.message = NULL;
+}
+
+uint8_t p_sml_parse_error(uint8_t code, uint32_t offset) {
+	SML_Error* error = &p_sml_context->error;
+
+	if(error->code == SML_ERROR_NONE) {
+		error->code = code;
+		error->offset = offset;
+		error->messageType = p_sml_context->messageType;
+	}
+	return SML_PARSE_ERROR;
+}
+
+uint8_t p_sml_parse_failed(const char* element) {
+	SML_Error* error = &p_sml_context->error;
+
+	if(error->depth < SML_ERROR_PATH_DEPTH) {
+		error->path[error->depth++] = element;
+	}
+	return SML_PARSE_ERROR;
+}
+
+void p_sml_encode_error(const char* message) {
+	SML_Error* error = &p_sml_context->error;
+
+	/* Reported once per failed call, file checks happen before any message starts */
+	error->code = SML_ERROR_ENCODE;
+	error->depth = 0;
+	error->offset = 0;
+	error->messageType = p_sml_context->messageType;
+	error->message = message;
+}
@@ -0,0 +1,462 @@
+/**
+ * File name: smllib_index.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "smllib_index.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_intern.h"
+#include "smllib_tools.h"
+#include "smllib_validate.h"
+
+/* Longest path accepted by sml_index_build() */
+#ifndef SMLLIB_INDEX_PATH_MAX
+	#define SMLLIB_INDEX_PATH_MAX 256
+#endif
+
+/* Start escape in front of the message of a frame */
+#define SML_INDEX_ESCAPE_LENGTH 8
+
+/* Frames held back until a frame of the same SML file has its own serverId and time */
+#ifndef SMLLIB_INDEX_PENDING
+	#define SMLLIB_INDEX_PENDING 16
+#endif
+
+static const char p_sml_index_magic[4] = { 'S', 'M', 'L', 'X' };
+
+/* Writes count entries, completes them from the frame before and tracks the sort order in built */
+static void p_sml_index_write(FILE* out, SML_Index* built, SML_Index_Entry* last, SML_Index_Entry* entries, uint32_t count) {
+	unsigned char record[SML_INDEX_ENTRY_SIZE];
+	uint32_t i;
+
+	for(i=0; i<count; i++) {
+		p_sml_index_inherit(&entries[i], last);
+		if(entries[i].timeType != 0) {
+			if(built->sortedTimeType == 0) {
+				built->sortedTimeType = entries[i].timeType;
+			}
+			/* Once a frame has a time, all frames after it have one */
+			if(entries[i].timeType != built->sortedTimeType || (last->timeType != 0 && entries[i].time < last->time)) {
+				built->flags &= (uint8_t)~SML_INDEX_SORTED;
+			}
+		}
+		p_sml_index_encode(&entries[i], record);
+		fwrite(record, 1, SML_INDEX_ENTRY_SIZE, out);
+		*last = entries[i];
+		built->count++;
+	}
+}
+
+uint8_t sml_index_build(SML_Capture* capture, const char* path) {
+	char tmpPath[SMLLIB_INDEX_PATH_MAX];
+	unsigned char record[SML_INDEX_ENTRY_SIZE];
+	size_t length = p_sml_strlen(path);
+	SML_Index_Entry pending[SMLLIB_INDEX_PENDING];
+	SML_Index_Entry entry;
+	SML_Index_Entry last;
+	SML_Index built;
+	SML_Message message;
+	SML_Boolean hasServer;
+	SML_Boolean hasTime;
+	SML_Boolean open;
+	const unsigned char* frame;
+	uint32_t frameLength;
+	uint32_t pendingCount = 0;
+	uint32_t i;
+	uint8_t retValue;
+	size_t mark;
+	FILE* out;
+
+	if(length + 5 > sizeof(tmpPath)) {
+		return SML_PARSE_ERROR;
+	}
+	p_sml_memcpy(tmpPath, path, length);
+	p_sml_memcpy(tmpPath + length, ".tmp", 5);
+
+	out = fopen(tmpPath, "wb");
+	if(out == NULL) {
+		return SML_PARSE_ERROR;
+	}
+	/* The header follows once count and flags are known */
+	p_sml_memset(record, 0, sizeof(record));
+	fwrite(record, 1, SML_INDEX_HEADER_SIZE, out);
+
+	p_sml_memset(&last, 0, sizeof(last));
+	p_sml_memset(&built, 0, sizeof(built));
+	built.flags = SML_INDEX_SORTED;
+	sml_capture_seek(capture, 0);
+	mark = p_sml_parser_mark();
+	for(;;) {
+		p_sml_memset(&entry, 0, sizeof(entry));
+		hasServer = FALSE;
+		hasTime = FALSE;
+		retValue = sml_capture_next(capture, &message);
+		if(retValue == SML_PARSE_NOMEM) {
+			/* Still reachable through the index, just not described */
+			if(sml_capture_next_frame(capture, &frame, &frameLength) != SML_PARSE_OK) {
+				break;
+			}
+			entry.flags = SML_INDEX_UNPARSED;
+		}
+		else if(retValue == SML_PARSE_OK) {
+			entry.messageType = message.messageBody.choiceTag;
+			p_sml_index_describe(&message, p_sml_index_server_length(capture->data + capture->frameOffset, capture->frameLength),
+				&entry, &hasServer, &hasTime);
+			p_sml_parser_release(mark);
+		}
+		else {
+			break;
+		}
+		entry.offset = capture->frameOffset;
+		entry.length = capture->frameLength;
+
+		/* A new file, or no room: the held frames take over from the frame before after all */
+		open = (entry.messageType == SML_MESSAGEBODY_OPEN_REQUEST || entry.messageType == SML_MESSAGEBODY_OPEN_RESPONSE);
+		if(pendingCount > 0 && (open || pendingCount == SMLLIB_INDEX_PENDING)) {
+			p_sml_index_write(out, &built, &last, pending, pendingCount);
+			pendingCount = 0;
+		}
+		/*
+		 * A PublicOpen usually has no refTime, the frame before belongs to
+		 * the previous file: it and the frames after it wait for the first
+		 * frame with its own serverId and time.
+		 */
+		if(hasServer && hasTime) {
+			for(i=0; i<pendingCount; i++) {
+				p_sml_index_inherit(&pending[i], &entry);
+			}
+		}
+		pending[pendingCount++] = entry;
+		if((hasServer && hasTime) || (!open && pendingCount == 1)) {
+			p_sml_index_write(out, &built, &last, pending, pendingCount);
+			pendingCount = 0;
+		}
+	}
+	p_sml_index_write(out, &built, &last, pending, pendingCount);
+
+	p_sml_memset(record, 0, sizeof(record));
+	p_sml_memcpy(record, p_sml_index_magic, sizeof(p_sml_index_magic));
+	record[4] = SML_INDEX_VERSION;
+	record[6] = SML_INDEX_ENTRY_SIZE;
+	p_sml_index_put64(record + 8, capture->size);
+	p_sml_index_put64(record + 16, built.count);
+	record[24] = built.flags;
+	record[25] = built.sortedTimeType;
+	if(fseek(out, 0, SEEK_SET) == 0) {
+		fwrite(record, 1, SML_INDEX_HEADER_SIZE, out);
+	}
+
+	retValue = (ferror(out) != 0) ? SML_PARSE_ERROR : SML_PARSE_OK;
+	if(fclose(out) != 0 || retValue != SML_PARSE_OK || rename(tmpPath, path) != 0) {
+		remove(tmpPath);
+		return SML_PARSE_ERROR;
+	}
+	return SML_PARSE_OK;
+}
+
+uint8_t sml_index_open(SML_Index* index, const char* path) {
+	const unsigned char* header;
+
+	p_sml_memset(index, 0, sizeof(SML_Index));
+	if(sml_capture_open(&index->file, path) != SML_PARSE_OK) {
+		return SML_PARSE_ERROR;
+	}
+
+	header = index->file.data;
+	if(index->file.size < SML_INDEX_HEADER_SIZE ||
+		p_sml_memcmp(header, p_sml_index_magic, sizeof(p_sml_index_magic)) != 0 ||
+		header[4] != SML_INDEX_VERSION || header[6] != SML_INDEX_ENTRY_SIZE) {
+		sml_capture_close(&index->file);
+		return SML_PARSE_ERROR;
+	}
+	index->captureSize = p_sml_index_get64(header + 8);
+	index->count = p_sml_index_get64(header + 16);
+	index->flags = header[24];
+	index->sortedTimeType = header[25];
+
+	/* A truncated or overlong file is no index either */
+	if((index->file.size - SML_INDEX_HEADER_SIZE) / SML_INDEX_ENTRY_SIZE != index->count ||
+		(index->file.size - SML_INDEX_HEADER_SIZE) % SML_INDEX_ENTRY_SIZE != 0) {
+		sml_capture_close(&index->file);
+		return SML_PARSE_ERROR;
+	}
+	return SML_PARSE_OK;
+}
+
+void sml_index_close(SML_Index* index) {
+	sml_capture_close(&index->file);
+	index->count = 0;
+}
+
+void sml_index_entry(const SML_Index* index, uint64_t i, SML_Index_Entry* entry) {
+	const unsigned char* record = index->file.data + SML_INDEX_HEADER_SIZE + i * SML_INDEX_ENTRY_SIZE;
+
+	entry->offset = p_sml_index_get64(record);
+	entry->length = p_sml_index_get32(record + 8);
+	entry->messageType = p_sml_index_get32(record + 12);
+	entry->serverHash = p_sml_index_get32(record + 16);
+	entry->time = p_sml_index_get32(record + 20);
+	entry->timeType = record[24];
+	entry->flags = record[25];
+}
+
+void sml_index_query_init(SML_Index_Query* query) {
+	query->timeType = 0;
+	query->from = 0;
+	query->to = 0xFFFFFFFFUL;
+	query->byServer = FALSE;
+	query->serverHash = 0;
+}
+
+uint32_t sml_index_server_hash(const char* serverId, uint32_t length) {
+	uint32_t hash = p_sml_intern_hash((const unsigned char*)serverId, length);
+
+	/* 0 stands for "no serverId" */
+	return (hash != 0) ? hash : 1;
+}
+
+uint8_t sml_index_find(const SML_Index* index, const SML_Index_Query* query, uint64_t* position, SML_Index_Entry* entry) {
+	SML_Boolean sorted = (query->timeType != 0 && (index->flags & SML_INDEX_SORTED) != 0 &&
+		index->sortedTimeType == query->timeType);
+	uint64_t i = *position;
+	uint64_t lower;
+
+	if(sorted) {
+		lower = p_sml_index_lower_bound(index, query->from);
+		if(i < lower) {
+			i = lower;
+		}
+	}
+
+	for(; i < index->count; i++) {
+		sml_index_entry(index, i, entry);
+		if(query->timeType != 0) {
+			if(sorted && entry->time > query->to) {
+				break;
+			}
+			if(entry->timeType != query->timeType || entry->time < query->from || entry->time > query->to) {
+				continue;
+			}
+		}
+		if(query->byServer && entry->serverHash != query->serverHash) {
+			continue;
+		}
+		*position = i + 1;
+		return SML_PARSE_OK;
+	}
+
+	*position = index->count;
+	return SML_CAPTURE_END;
+}
+
+void p_sml_index_inherit(SML_Index_Entry* entry, const SML_Index_Entry* source) {
+	if(entry->serverHash == 0 && source->serverHash != 0) {
+		entry->serverHash = source->serverHash;
+		entry->flags |= SML_INDEX_INHERITED_SERVER;
+	}
+	if(entry->timeType == 0 && source->timeType != 0) {
+		entry->time = source->time;
+		entry->timeType = source->timeType;
+		entry->flags |= SML_INDEX_INHERITED_TIME;
+	}
+}
+
+void p_sml_index_describe(const SML_Message* message, uint32_t serverLength, SML_Index_Entry* entry, SML_Boolean* hasServer, SML_Boolean* hasTime) {
+	const SML_MessageBody* body = &message->messageBody;
+	SML_Boolean compact = (p_sml_context->compactLayout && sml_messagebody_has_compact_layout(body->choiceTag));
+	const char* serverId = NULL;
+	const SML_Time* time = NULL;
+
+	switch(body->choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+			serverId = compact ? body->choiceValue.openRequestCompact->serverId : body->choiceValue.openRequest->serverId;
+		break;
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+			if(compact) {
+				serverId = body->choiceValue.openResponseCompact->serverId;
+				if(body->choiceValue.openResponseCompact->present & SML_OPENRES_REFTIME) {
+					time = &body->choiceValue.openResponseCompact->refTime;
+				}
+			}
+			else {
+				serverId = body->choiceValue.openResponse->serverId;
+				time = body->choiceValue.openResponse->refTime;
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST:
+			serverId = body->choiceValue.getProfilePackRequest->serverId;
+		break;
+		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE:
+			serverId = body->choiceValue.getProfilePackResponse->serverId;
+			time = &body->choiceValue.getProfilePackResponse->actTime;
+		break;
+		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST:
+			serverId = body->choiceValue.getProfileListRequest->serverId;
+		break;
+		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE:
+			serverId = body->choiceValue.getProfileListResponse->serverId;
+			time = &body->choiceValue.getProfileListResponse->actTime;
+		break;
+		case SML_MESSAGEBODY_GETLIST_REQUEST:
+			serverId = body->choiceValue.getListRequest->serverId;
+		break;
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+			if(compact) {
+				serverId = body->choiceValue.getListResponseCompact->serverId;
+				if(body->choiceValue.getListResponseCompact->present & SML_GETLISTRES_ACTSENSORTIME) {
+					time = &body->choiceValue.getListResponseCompact->actSensorTime;
+				}
+				else if(body->choiceValue.getListResponseCompact->present & SML_GETLISTRES_ACTGATEWAYTIME) {
+					time = &body->choiceValue.getListResponseCompact->actGatewayTime;
+				}
+			}
+			else {
+				serverId = body->choiceValue.getListResponse->serverId;
+				time = body->choiceValue.getListResponse->actSensorTime;
+				if(time == NULL) {
+					time = body->choiceValue.getListResponse->actGatewayTime;
+				}
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST:
+			serverId = body->choiceValue.getProcParameterRequest->serverId;
+		break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
+			serverId = compact ? body->choiceValue.getProcParameterResponseCompact->serverId : body->choiceValue.getProcParameterResponse->serverId;
+		break;
+		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST:
+			serverId = body->choiceValue.setProcParameterRequest->serverId;
+		break;
+		case SML_MESSAGEBODY_ATTENTION_RESPONSE:
+			serverId = body->choiceValue.attentionResponse->serverId;
+		break;
+		default:
+		break;
+	}
+
+	*hasServer = (serverId != NULL);
+	if(*hasServer) {
+		entry->serverHash = sml_index_server_hash(serverId, serverLength);
+	}
+	*hasTime = (time != NULL && (time->choiceTag == SML_TIME_SECINDEX || time->choiceTag == SML_TIME_TIMESTAMP));
+	if(*hasTime) {
+		entry->timeType = time->choiceTag;
+		entry->time = (time->choiceTag == SML_TIME_SECINDEX) ? time->choiceValue.secIndex : time->choiceValue.timestamp;
+	}
+}
+
+uint32_t p_sml_index_server_length(const unsigned char* frame, uint32_t length) {
+	SML_Validator validator;
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint64_t choiceTag;
+	uint32_t skip;
+
+	/* Only the fields in front of serverId are read, the frame has been validated */
+	p_sml_validator_init(&validator, frame, SML_INDEX_ESCAPE_LENGTH, length, TRUE);
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(&validator, 6) ||
+		SML_PARSE_ERROR == p_sml_validate_string(&validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number(&validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_number(&validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_listsize(&validator, 2) ||
+		SML_PARSE_ERROR == p_sml_validate_number(&validator, UNSIGNED, sizeof(uint32_t), &choiceTag) ||
+		SML_PARSE_ERROR == p_sml_validate_list(&validator, &tl_value)) {
+		return 0;
+	}
+
+	/* Open: codepage, clientId and reqFileId come first, GetList: clientId, other bodies start with it */
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+			skip = 3;
+		break;
+		case SML_MESSAGEBODY_GETLIST_REQUEST:
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+			skip = 1;
+		break;
+		default:
+			skip = 0;
+		break;
+	}
+	for(; skip > 0; skip--) {
+		if(p_sml_validate_string(&validator) == SML_PARSE_ERROR) {
+			return 0;
+		}
+	}
+	if(p_sml_validate_tlfield(&validator, &tl_type, &tl_value) == SML_PARSE_ERROR || tl_type != STRING) {
+		return 0;
+	}
+	return tl_value;
+}
+
+void p_sml_index_encode(const SML_Index_Entry* entry, unsigned char* record) {
+	p_sml_memset(record, 0, SML_INDEX_ENTRY_SIZE);
+	p_sml_index_put64(record, entry->offset);
+	p_sml_index_put32(record + 8, entry->length);
+	p_sml_index_put32(record + 12, entry->messageType);
+	p_sml_index_put32(record + 16, entry->serverHash);
+	p_sml_index_put32(record + 20, entry->time);
+	record[24] = entry->timeType;
+	record[25] = entry->flags;
+}
+
+uint64_t p_sml_index_lower_bound(const SML_Index* index, uint32_t time) {
+	SML_Index_Entry entry;
+	uint64_t low = 0;
+	uint64_t high = index->count;
+	uint64_t middle;
+
+	/* Entries in front of the first time have none, they sort first */
+	while(low < high) {
+		middle = low + (high - low) / 2;
+		sml_index_entry(index, middle, &entry);
+		if(entry.timeType != 0 && entry.time >= time) {
+			high = middle;
+		}
+		else {
+			low = middle + 1;
+		}
+	}
+	return low;
+}
+
+void p_sml_index_put32(unsigned char* data, uint32_t value) {
+	data[0] = (unsigned char)value;
+	data[1] = (unsigned char)(value >> 8);
+	data[2] = (unsigned char)(value >> 16);
+	data[3] = (unsigned char)(value >> 24);
+}
+
+void p_sml_index_put64(unsigned char* data, uint64_t value) {
+	p_sml_index_put32(data, (uint32_t)value);
+	p_sml_index_put32(data + 4, (uint32_t)(value >> 32));
+}
+
+uint32_t p_sml_index_get32(const unsigned char* data) {
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+uint64_t p_sml_index_get64(const unsigned char* data) {
+	return (uint64_t)p_sml_index_get32(data) | ((uint64_t)p_sml_index_get32(data + 4) << 32);
+}
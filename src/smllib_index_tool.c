@@ -0,0 +1,217 @@
+/**
+ * File name: smllib_index_tool.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_capture.h"
+#include "smllib_index.h"
+
+/*
+ * Builds the frame index of a capture and lists the frames it selects.
+ *
+ *   SML_Index [options] <capture>
+ *
+ *   --index=<path>               sidecar file (<capture>.idx)
+ *   --build                      rebuild the index; it is also built when
+ *                                missing or made for a different capture size
+ *   --secindex=<from>-<to>       frames with a secIndex time in the range
+ *   --timestamp=<from>-<to>      frames with a timestamp in the range
+ *   --server=<hex>               frames of the serverId given in hex
+ *   --parse                      jump to every selected frame and parse it
+ *
+ * One line per frame goes to stdout: offset, length, message type, time
+ * type and time, serverId hash. A summary goes to stderr.
+ */
+
+#define TOOL_PATH_MAX 256
+
+/* Pool of the STATIC_POOL build, big enough for the largest profile */
+#define TOOL_POOL_SIZE (64 * 1024 * 1024)
+
+typedef struct Tool_Options {
+	const char* capture;
+	const char* index;
+	SML_Boolean build;
+	SML_Boolean parse;
+	SML_Index_Query query;
+	char serverId[64];
+	uint32_t serverLength;
+} Tool_Options;
+
+/* Octets of the hex string, 0 if it is none */
+static uint32_t tool_parse_server(const char* hex, char* serverId, size_t size) {
+	size_t length = strlen(hex);
+	unsigned int byte;
+	size_t i;
+
+	if(length == 0 || length % 2 != 0 || length / 2 > size) {
+		return 0;
+	}
+	for(i=0; i<length/2; i++) {
+		if(sscanf(hex + 2*i, "%2x", &byte) != 1) {
+			return 0;
+		}
+		serverId[i] = (char)byte;
+	}
+	return (uint32_t)(length / 2);
+}
+
+static int tool_options(int argc, char** argv, Tool_Options* options) {
+	unsigned long from;
+	unsigned long to;
+	int i;
+
+	memset(options, 0, sizeof(Tool_Options));
+	sml_index_query_init(&options->query);
+	for(i=1; i<argc; i++) {
+		if(strncmp(argv[i], "--index=", 8) == 0) {
+			options->index = argv[i] + 8;
+		}
+		else if(strcmp(argv[i], "--build") == 0) {
+			options->build = TRUE;
+		}
+		else if(strcmp(argv[i], "--parse") == 0) {
+			options->parse = TRUE;
+		}
+		else if(strncmp(argv[i], "--secindex=", 11) == 0 || strncmp(argv[i], "--timestamp=", 12) == 0) {
+			options->query.timeType = (argv[i][2] == 's') ? SML_TIME_SECINDEX : SML_TIME_TIMESTAMP;
+			if(sscanf(strchr(argv[i], '=') + 1, "%lu-%lu", &from, &to) != 2 || from > to) {
+				return 0;
+			}
+			options->query.from = (uint32_t)from;
+			options->query.to = (uint32_t)to;
+		}
+		else if(strncmp(argv[i], "--server=", 9) == 0) {
+			options->serverLength = tool_parse_server(argv[i] + 9, options->serverId, sizeof(options->serverId));
+			if(options->serverLength == 0) {
+				return 0;
+			}
+			options->query.byServer = TRUE;
+			options->query.serverHash = sml_index_server_hash(options->serverId, options->serverLength);
+		}
+		else if(argv[i][0] != '-' && options->capture == NULL) {
+			options->capture = argv[i];
+		}
+		else {
+			return 0;
+		}
+	}
+	return options->capture != NULL;
+}
+
+int main(int argc, char** argv) {
+	Tool_Options options;
+	SML_Capture capture;
+	SML_Index index;
+	SML_Index_Entry entry;
+	SML_Message message;
+	char indexPath[TOOL_PATH_MAX];
+	uint64_t position = 0;
+	uint32_t matches = 0;
+	uint32_t failures = 0;
+	int retValue = 0;
+
+	#ifdef SMLLIB_STATIC_POOL
+		SML_Context context;
+		void* pool = malloc(TOOL_POOL_SIZE);
+	#endif
+
+	if(!tool_options(argc, argv, &options)) {
+		fprintf(stderr, "%s\n", "usage: SML_Index [--index=<path>] [--build] [--secindex=<from>-<to> | --timestamp=<from>-<to>]");
+		fprintf(stderr, "%s\n", "       [--server=<hex>] [--parse] <capture>");
+		return 2;
+	}
+	if(options.index == NULL) {
+		if(strlen(options.capture) + 5 > sizeof(indexPath)) {
+			fprintf(stderr, "path too long: %s\n", options.capture);
+			return 1;
+		}
+		strcpy(indexPath, options.capture);
+		strcat(indexPath, ".idx");
+		options.index = indexPath;
+	}
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_init(&context);
+		sml_context_set_pool(&context, pool, TOOL_POOL_SIZE);
+		sml_context_use(&context);
+	#endif
+
+	if(sml_capture_open(&capture, options.capture) != SML_PARSE_OK) {
+		fprintf(stderr, "cannot open %s\n", options.capture);
+		return 1;
+	}
+	if(!options.build && sml_index_open(&index, options.index) == SML_PARSE_OK) {
+		if(index.captureSize != capture.size) {
+			sml_index_close(&index);
+			options.build = TRUE;
+		}
+	}
+	else {
+		options.build = TRUE;
+	}
+	if(options.build) {
+		if(sml_index_build(&capture, options.index) != SML_PARSE_OK ||
+			sml_index_open(&index, options.index) != SML_PARSE_OK) {
+			fprintf(stderr, "cannot write %s\n", options.index);
+			sml_capture_close(&capture);
+			return 1;
+		}
+	}
+
+	while(sml_index_find(&index, &options.query, &position, &entry) == SML_PARSE_OK) {
+		printf("%.0f %u %04X %u %u %08X\n", (double)entry.offset, (unsigned int)entry.length,
+			(unsigned int)entry.messageType, (unsigned int)entry.timeType, (unsigned int)entry.time,
+			(unsigned int)entry.serverHash);
+		matches++;
+		if(options.parse) {
+			sml_capture_seek(&capture, entry.offset);
+			if((entry.flags & SML_INDEX_UNPARSED) == 0 &&
+				(sml_capture_next(&capture, &message) != SML_PARSE_OK || capture.frameOffset != entry.offset ||
+				message.messageBody.choiceTag != entry.messageType)) {
+				failures++;
+				retValue = 1;
+			}
+			sml_parser_free();
+		}
+	}
+
+	fprintf(stderr, "frames %.0f (%s), sorted %s, selected %u",
+		(double)index.count, options.build ? "built" : "cached",
+		(index.flags & SML_INDEX_SORTED) ? "yes" : "no", (unsigned int)matches);
+	if(options.parse) {
+		fprintf(stderr, ", parse failures %u", (unsigned int)failures);
+	}
+	fprintf(stderr, "%s", "\n");
+
+	sml_index_close(&index);
+	sml_capture_close(&capture);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_use(NULL);
+		free(pool);
+	#endif
+	return retValue;
+}
@@ -0,0 +1,143 @@
+/**
+ * File name: smllib_intern.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_intern.h"
+#include "smllib_tools.h"
+
+SML_Intern_Table* sml_intern_create(uint32_t maxStrings, uint32_t maxBytes) {
+	SML_Intern_Table* table;
+	SML_Pool* pool = (p_sml_context->pool.base != NULL) ? &p_sml_context->pool : NULL;
+	uint32_t slotCount = 1;
+	size_t size;
+
+	if(maxStrings == 0 || maxStrings > 0xFFFF) {
+		return NULL;
+	}
+	/* Keep the load factor at or below one half */
+	while(slotCount < maxStrings * 2) {
+		slotCount <<= 1;
+	}
+	/* The table has to stay below the parser blocks in a pool */
+	if(pool != NULL && pool->used != pool->floor) {
+		return NULL;
+	}
+
+	size = sizeof(SML_Intern_Table) + slotCount * sizeof(SML_Intern_Entry) + maxStrings * sizeof(char*) + maxBytes;
+	table = (SML_Intern_Table*)p_sml_calloc(1, size);
+	if(table == NULL) {
+		return NULL;
+	}
+	if(pool != NULL) {
+		pool->floor = pool->used;
+		pool->last = SML_POOL_NO_BLOCK;
+	}
+	table->slots = (SML_Intern_Entry*)(table + 1);
+	table->slotMask = slotCount - 1;
+	table->strings = (char**)(table->slots + slotCount);
+	table->maxStrings = maxStrings;
+	table->arena = (unsigned char*)(table->strings + maxStrings);
+	table->arenaSize = maxBytes;
+
+	return table;
+}
+
+void sml_intern_destroy(SML_Intern_Table* table) {
+	if(p_sml_context->internTable == table) {
+		p_sml_context->internTable = NULL;
+	}
+	p_sml_free(table);
+}
+
+void sml_context_set_intern_table(SML_Context* context, SML_Intern_Table* table) {
+	context->internTable = table;
+}
+
+char* sml_intern(SML_Intern_Table* table, const char* data, uint32_t length) {
+	uint32_t hash = p_sml_intern_hash((const unsigned char*)data, length);
+	uint32_t i = hash & table->slotMask;
+	SML_Intern_Entry* slot;
+	unsigned char* string;
+
+	for(;;) {
+		slot = &table->slots[i];
+		if(slot->string == NULL) {
+			break;
+		}
+		if(slot->hash == hash && slot->length == length && p_sml_memcmp(slot->string, data, length) == 0) {
+			table->hits++;
+			return slot->string;
+		}
+		i = (i + 1) & table->slotMask;
+	}
+
+	/* New string: ID, bytes and terminator go to the arena */
+	if(table->count == table->maxStrings || length + 3 > table->arenaSize - table->arenaUsed) {
+		table->misses++;
+		return NULL;
+	}
+	string = table->arena + table->arenaUsed;
+	string[0] = (unsigned char)(table->count >> 8);
+	string[1] = (unsigned char)(table->count & 0xFF);
+	p_sml_memcpy(string + 2, data, length);
+	string[length + 2] = '\0';
+	table->arenaUsed += length + 3;
+
+	slot->string = (char*)(string + 2);
+	slot->hash = hash;
+	slot->length = length;
+	table->strings[table->count++] = slot->string;
+
+	return slot->string;
+}
+
+uint32_t sml_intern_id(const SML_Intern_Table* table, const char* string) {
+	const unsigned char* ptr = (const unsigned char*)string;
+	uint32_t id;
+
+	if(ptr < table->arena + 2 || ptr >= table->arena + table->arenaUsed) {
+		return SML_INTERN_NO_ID;
+	}
+	id = ((uint32_t)ptr[-2] << 8) | ptr[-1];
+	/* Pointers into the middle of a string are not interned strings */
+	if(id >= table->count || table->strings[id] != string) {
+		return SML_INTERN_NO_ID;
+	}
+	return id;
+}
+
+const char* sml_intern_string(const SML_Intern_Table* table, uint32_t id) {
+	return (id < table->count) ? table->strings[id] : NULL;
+}
+
+uint32_t p_sml_intern_hash(const unsigned char* data, uint32_t length) {
+	/* FNV-1a */
+	uint32_t hash = 2166136261UL;
+	uint32_t i;
+
+	for(i=0; i<length; i++) {
+		hash ^= data[i];
+		hash *= 16777619UL;
+	}
+	return hash;
+}
@@ -0,0 +1,196 @@
+/**
+ * File name: smllib_latency.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef SMLLIB_LATENCY
+	/* clock_gettime() */
+	#define _POSIX_C_SOURCE 199309L
+#endif
+
+#ifndef SMLLIB_FREESTANDING
+	#include <stdio.h>
+#endif
+#ifdef SMLLIB_LATENCY
+	#include <time.h>
+#endif
+
+#include "smllib_latency.h"
+#include "smllib_metrics.h"
+#include "smllib_tools.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SML_LATENCY_TSC
+#endif
+
+void sml_latency_init(SML_Latency* latency) {
+	p_sml_memset(latency, 0, sizeof(SML_Latency));
+}
+
+void sml_context_set_latency(SML_Context* context, SML_Latency* latency) {
+	context->latency = latency;
+}
+
+SML_Latency_Histogram* sml_latency_histogram(SML_Latency* latency, uint32_t op, uint32_t choiceTag) {
+	return &latency->histograms[op][sml_messagebody_index(choiceTag)];
+}
+
+void sml_latency_record(SML_Latency_Histogram* histogram, uint64_t value) {
+	histogram->buckets[p_sml_latency_bucket(value)]++;
+	if(histogram->count == 0 || value < histogram->min) {
+		histogram->min = value;
+	}
+	if(value > histogram->max) {
+		histogram->max = value;
+	}
+	histogram->count++;
+	histogram->sum += value;
+}
+
+uint64_t sml_latency_percentile(const SML_Latency_Histogram* histogram, double fraction) {
+	uint32_t rank;
+	uint32_t seen = 0;
+	uint32_t i;
+	uint64_t limit;
+
+	if(histogram->count == 0) {
+		return 0;
+	}
+	/* Rank of the value, 1 based, rounded up */
+	rank = (uint32_t)(fraction * histogram->count);
+	if((double)rank < fraction * histogram->count || rank == 0) {
+		rank++;
+	}
+	for(i=0; i<SML_LATENCY_BUCKETS; i++) {
+		seen += histogram->buckets[i];
+		if(seen >= rank) {
+			limit = p_sml_latency_bucket_limit(i);
+			return (limit < histogram->max) ? limit : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+/* The report uses stdio, hosted builds only */
+#ifndef SMLLIB_FREESTANDING
+
+static const struct {
+	const char* name;
+	double fraction;
+} p_sml_latency_percentiles[] = {
+	{ "p50", 0.5 },
+	{ "p90", 0.9 },
+	{ "p99", 0.99 },
+	{ "p99.9", 0.999 }
+};
+
+static const char* const p_sml_latency_ops[SML_LATENCY_OPS] = {
+	"parse", "t-parse", "encode", "t-encode"
+};
+
+/* choiceTag by sml_messagebody_index(), "other" last */
+static const char* const p_sml_latency_types[SML_MESSAGEBODY_TYPES] = {
+	"0100", "0101", "0200", "0201", "0300", "0301", "0400", "0401",
+	"0500", "0501", "0600", "0700", "0701", "FF01", "other"
+};
+
+void sml_latency_report(FILE* out, const SML_Latency* latency) {
+	const SML_Latency_Histogram* histogram;
+	char digits[SML_METRICS_UINT64_DIGITS];
+	uint32_t op;
+	uint32_t type;
+	uint32_t i;
+
+	fprintf(out, "%-9s %-6s %10s %10s", "op", "type", "count", "min");
+	for(i=0; i<sizeof(p_sml_latency_percentiles)/sizeof(p_sml_latency_percentiles[0]); i++) {
+		fprintf(out, " %10s", p_sml_latency_percentiles[i].name);
+	}
+	fprintf(out, " %10s  (%s)\n", "max", sml_latency_unit());
+
+	for(op=0; op<SML_LATENCY_OPS; op++) {
+		for(type=0; type<SML_MESSAGEBODY_TYPES; type++) {
+			histogram = &latency->histograms[op][type];
+			if(histogram->count == 0) {
+				continue;
+			}
+			fprintf(out, "%-9s %-6s", p_sml_latency_ops[op], p_sml_latency_types[type]);
+			fprintf(out, " %10s", p_sml_metrics_format_uint64(digits, histogram->count));
+			fprintf(out, " %10s", p_sml_metrics_format_uint64(digits, histogram->min));
+			for(i=0; i<sizeof(p_sml_latency_percentiles)/sizeof(p_sml_latency_percentiles[0]); i++) {
+				fprintf(out, " %10s", p_sml_metrics_format_uint64(digits, sml_latency_percentile(histogram, p_sml_latency_percentiles[i].fraction)));
+			}
+			fprintf(out, " %10s\n", p_sml_metrics_format_uint64(digits, histogram->max));
+		}
+	}
+}
+
+#endif /* SMLLIB_FREESTANDING */
+
+const char* sml_latency_unit(void) {
+#ifdef SML_LATENCY_TSC
+	return "cycles";
+#else
+	return "ns";
+#endif
+}
+
+uint32_t p_sml_latency_bucket(uint64_t value) {
+	uint32_t exponent = 0;
+	uint32_t bucket;
+
+	if(value < SML_LATENCY_SUB_BUCKETS) {
+		return (uint32_t)value;
+	}
+	while((value >> exponent) > 1) {
+		exponent++;
+	}
+	/* 3 bits below the leading one select the sub-bucket */
+	bucket = (exponent - 2) * SML_LATENCY_SUB_BUCKETS + (uint32_t)((value >> (exponent - 3)) & 7);
+	return (bucket < SML_LATENCY_BUCKETS) ? bucket : SML_LATENCY_BUCKETS - 1;
+}
+
+uint64_t p_sml_latency_bucket_limit(uint32_t bucket) {
+	uint32_t shift;
+
+	if(bucket < SML_LATENCY_SUB_BUCKETS) {
+		return bucket;
+	}
+	shift = bucket / SML_LATENCY_SUB_BUCKETS - 1;
+	return ((uint64_t)(SML_LATENCY_SUB_BUCKETS + bucket % SML_LATENCY_SUB_BUCKETS + 1) << shift) - 1;
+}
+
+#ifdef SMLLIB_LATENCY
+
+uint64_t p_sml_latency_now(void) {
+#ifdef SML_LATENCY_TSC
+	return (uint64_t)__builtin_ia32_rdtsc();
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void p_sml_latency_record(uint32_t op, uint32_t choiceTag, uint64_t start) {
+	sml_latency_record(sml_latency_histogram(p_sml_context->latency, op, choiceTag), p_sml_latency_now() - start);
+}
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * File name: smllib_metrics.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "smllib_metrics.h"
+#include "smllib_tools.h"
+
+/* Longest path accepted by sml_metrics_export_prometheus() */
+#ifndef SMLLIB_METRICS_PATH_MAX
+	#define SMLLIB_METRICS_PATH_MAX 256
+#endif
+
+#ifdef SMLLIB_ATOMIC_METRICS
+	#define p_sml_metric_load(counter) __atomic_load_n(counter, __ATOMIC_RELAXED)
+	#define p_sml_metric_store(counter, value) __atomic_store_n(counter, value, __ATOMIC_RELAXED)
+#else
+	#define p_sml_metric_load(counter) (*(counter))
+	#define p_sml_metric_store(counter, value) (*(counter) = (value))
+#endif
+
+void sml_metrics_snapshot(const SML_Context* context, SML_Metrics_Snapshot* snapshot) {
+	#define SML_METRIC(field, name, help) snapshot->counters.field = p_sml_metric_load(&context->metrics.field);
+	#include "smllib_metrics_counters.h"
+	#undef SML_METRIC
+	snapshot->allocations = context->allocStats.total;
+}
+
+void sml_metrics_reset(SML_Context* context) {
+	#define SML_METRIC(field, name, help) p_sml_metric_store(&context->metrics.field, 0);
+	#include "smllib_metrics_counters.h"
+	#undef SML_METRIC
+}
+
+const char* p_sml_metrics_format_uint64(char* digits, uint64_t value) {
+	int i = SML_METRICS_UINT64_DIGITS - 1;
+
+	digits[i] = '\0';
+	do {
+		digits[--i] = (char)('0' + (int)(value % 10));
+		value /= 10;
+	} while(value > 0);
+	return digits + i;
+}
+
+/* The stdio writers, hosted builds only */
+#ifndef SMLLIB_FREESTANDING
+
+static int p_sml_metrics_put_uint64(FILE* out, uint64_t value) {
+	char digits[SML_METRICS_UINT64_DIGITS];
+
+	return fputs(p_sml_metrics_format_uint64(digits, value), out);
+}
+
+static int p_sml_metrics_put_sample(FILE* out, const char* name, const char* link, uint64_t value) {
+	const char* c;
+
+	fputs(name, out);
+	if(link != NULL) {
+		fputs("{link=\"", out);
+		for(c=link; *c != '\0'; c++) {
+			/* Label value escapes of the exposition format */
+			if(*c == '\\' || *c == '"') {
+				fputc('\\', out);
+				fputc(*c, out);
+			}
+			else if(*c == '\n') {
+				fputs("\\n", out);
+			}
+			else {
+				fputc(*c, out);
+			}
+		}
+		fputs("\"}", out);
+	}
+	fputc(' ', out);
+	p_sml_metrics_put_uint64(out, value);
+	return fputc('\n', out);
+}
+
+static void p_sml_metrics_put_header(FILE* out, const char* name, const char* help) {
+	fprintf(out, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+}
+
+uint8_t sml_metrics_write_prometheus(FILE* out, const SML_Metrics_Snapshot* snapshots, const char* const* links, uint32_t count) {
+	uint32_t i;
+
+	#define p_sml_metrics_put(member, name, help) \
+		p_sml_metrics_put_header(out, name, help); \
+		for(i=0; i<count; i++) { \
+			p_sml_metrics_put_sample(out, name, (links != NULL) ? links[i] : NULL, snapshots[i].member); \
+		}
+	#define SML_METRIC(field, name, help) p_sml_metrics_put(counters.field, name, help)
+	#include "smllib_metrics_counters.h"
+	#undef SML_METRIC
+	p_sml_metrics_put(allocations.allocations, "sml_allocations_total", "Allocator calls (realloc of NULL included)")
+	p_sml_metrics_put(allocations.reallocations, "sml_reallocations_total", "Reallocations")
+	p_sml_metrics_put(allocations.frees, "sml_frees_total", "Frees")
+	p_sml_metrics_put(allocations.bytes, "sml_allocated_bytes_total", "Bytes requested from the allocator")
+	#undef p_sml_metrics_put
+
+	return ferror(out) ? SML_ENCODE_ERROR : SML_ENCODE_OK;
+}
+
+uint8_t sml_metrics_export_prometheus(const char* path, const SML_Metrics_Snapshot* snapshots, const char* const* links, uint32_t count) {
+	char tmpPath[SMLLIB_METRICS_PATH_MAX];
+	size_t length = p_sml_strlen(path);
+	FILE* out;
+	uint8_t retValue;
+
+	if(length + 5 > sizeof(tmpPath)) {
+		return SML_ENCODE_ERROR;
+	}
+	p_sml_memcpy(tmpPath, path, length);
+	p_sml_memcpy(tmpPath + length, ".tmp", 5);
+
+	out = fopen(tmpPath, "w");
+	if(out == NULL) {
+		return SML_ENCODE_ERROR;
+	}
+	retValue = sml_metrics_write_prometheus(out, snapshots, links, count);
+	if(fclose(out) != 0 || retValue != SML_ENCODE_OK || rename(tmpPath, path) != 0) {
+		remove(tmpPath);
+		return SML_ENCODE_ERROR;
+	}
+	return SML_ENCODE_OK;
+}
+
+#endif /* SMLLIB_FREESTANDING */
@@ -0,0 +1,78 @@
+/**
+ * File name: smllib_obis.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_obis.h"
+#include "smllib_tools.h"
+#include "smllib_obis_table.h"
+
+#define SML_OBIS_CODE(name, text, a, b, c, d, e, f) {a, b, c, d, e, f},
+static const uint8_t p_sml_obis_codes[SML_OBIS_COUNT][SML_OBIS_LENGTH] = {
+	{0, 0, 0, 0, 0, 0},
+	{0, 0, 0, 0, 0, 0},
+	#include "smllib_obis_codes.h"
+};
+#undef SML_OBIS_CODE
+
+#define SML_OBIS_CODE(name, text, a, b, c, d, e, f) text,
+static const char* const p_sml_obis_texts[SML_OBIS_COUNT] = {
+	NULL,
+	NULL,
+	#include "smllib_obis_codes.h"
+};
+#undef SML_OBIS_CODE
+
+uint16_t sml_obis_lookup(const uint8_t* code) {
+	uint8_t id = p_sml_obis_slots[p_sml_obis_hash(code, SML_OBIS_HASH_SEED) & (SML_OBIS_HASH_SIZE - 1)];
+
+	/* One slot per well-known code: a single compare decides */
+	if(id != SML_OBIS_NONE && p_sml_memcmp(p_sml_obis_codes[id], code, SML_OBIS_LENGTH) == 0) {
+		return id;
+	}
+	return SML_OBIS_UNKNOWN;
+}
+
+void sml_obis_set(SML_Obis* obis, const uint8_t* code) {
+	p_sml_memcpy(obis->code, code, SML_OBIS_LENGTH);
+	obis->id = sml_obis_lookup(code);
+}
+
+const uint8_t* sml_obis_code(uint16_t id) {
+	return (id > SML_OBIS_UNKNOWN && id < SML_OBIS_COUNT) ? p_sml_obis_codes[id] : NULL;
+}
+
+const char* sml_obis_text(uint16_t id) {
+	return (id > SML_OBIS_UNKNOWN && id < SML_OBIS_COUNT) ? p_sml_obis_texts[id] : NULL;
+}
+
+uint32_t p_sml_obis_hash(const uint8_t* code, uint32_t seed) {
+	/* Seeded FNV-1a with a final mix of the high bits */
+	uint32_t hash = seed ^ 2166136261UL;
+	uint32_t i;
+
+	for(i=0; i<SML_OBIS_LENGTH; i++) {
+		hash ^= code[i];
+		hash *= 16777619UL;
+	}
+	return hash ^ (hash >> 15);
+}
@@ -24,23 +24,36 @@
 
 #include "smllib_parse.h"
 #include "smllib_tools.h"
-
-#ifdef SMLLIB_DEBUG
-	#include <stdio.h>
-#endif
+#include "smllib_context.h"
+#include "smllib_intern.h"
+#include "smllib_obis.h"
+#include "smllib_tree.h"
+#include "smllib_trace.h"
+#include "smllib_metrics.h"
+#include "smllib_latency.h"
+#include "smllib_validate.h"
+#include "smllib_error.h"
 
 uint8_t sml_parse_file_binary(const unsigned char* smlBinary, uint32_t msgCount, SML_File* smlFile) {
 	uint32_t i;
 	uint32_t offset = 0;
+	uint8_t retValue;
 	smlFile->msgCount = msgCount;
-	smlFile->messages = (SML_Message**)calloc(msgCount, sizeof(SML_Message*));
-	p_sml_add_pointer(smlFile->messages);
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_error_reset();
+	smlFile->messages = (SML_Message**)p_sml_parser_calloc(msgCount, sizeof(SML_Message*));
+	if(smlFile->messages == NULL) {
+		return SML_PARSE_NOMEM;
+	}
 
 	for(i=0; i<msgCount; i++) {
-		smlFile->messages[i] = (SML_Message*)calloc(1, sizeof(SML_Message));
-		p_sml_add_pointer(smlFile->messages[i]);
-		if(sml_parse_message_binary(smlBinary, &offset, smlFile->messages[i]) == SML_PARSE_ERROR) {
-			return SML_PARSE_ERROR;
+		smlFile->messages[i] = (SML_Message*)p_sml_parser_calloc(1, sizeof(SML_Message));
+		if(smlFile->messages[i] == NULL) {
+			return SML_PARSE_NOMEM;
+		}
+		retValue = sml_parse_message_binary(smlBinary, &offset, smlFile->messages[i]);
+		if(retValue != SML_PARSE_OK) {
+			return retValue;
 		}
 	}
 
@@ -48,7 +61,34 @@ uint8_t sml_parse_file_binary(const unsigned char* smlBinary, uint32_t msgCount,
 }
 
 uint8_t sml_parse_message_binary(const unsigned char* smlBinary, uint32_t* offset, SML_Message* smlMessage) {
-	uint16_t crc16;
+	uint8_t retValue;
+	SML_LATENCY_DECLARE(start)
+
+	SML_LATENCY_START(start);
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_message_begin();
+	retValue = p_sml_parse_message(smlBinary, offset, smlMessage);
+	p_sml_message_end();
+	retValue = p_sml_parse_result(retValue);
+
+	if(retValue == SML_PARSE_OK) {
+		SML_LATENCY_RECORD(SML_LATENCY_PARSE, smlMessage->messageBody.choiceTag, start);
+	}
+	return retValue;
+}
+
+uint8_t p_sml_parse_result(uint8_t retValue) {
+	if(p_sml_context->outOfMemory) {
+		retValue = SML_PARSE_NOMEM;
+		p_sml_context->error.code = SML_ERROR_NOMEM;
+	}
+	if(retValue != SML_PARSE_OK) {
+		SML_METRIC_ADD(parseErrors, 1);
+	}
+	return retValue;
+}
+
+uint8_t p_sml_parse_message(const unsigned char* smlBinary, uint32_t* offset, SML_Message* smlMessage) {
 	uint32_t offsetPrev = *offset;
 
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 6) ||
@@ -56,33 +96,43 @@ uint8_t sml_parse_message_binary(const unsigned char* smlBinary, uint32_t* offse
 		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &smlMessage->groupNo) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &smlMessage->abortOnError) ||
 		SML_PARSE_ERROR == p_sml_parse_messagebody(smlBinary, offset, &smlMessage->messageBody)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Message");
 	}
 
-	#ifdef SMLLIB_DEBUG
-		printf("transactionId: %s\n", smlMessage->transactionId);
-		printf("groupNo: %02X\n", smlMessage->groupNo);
-		printf("abortOnError: %02X\n", smlMessage->abortOnError);
-		printf("messageBodyTag: %08X\n", (unsigned int)smlMessage->messageBody.choiceTag);
-		printf("========= endOfParserOutput =========\n");
-		printf("\n");
-	#endif
+	SML_TRACE_MESSAGE_BYTES("transactionId", (const unsigned char*)smlMessage->transactionId,
+		(smlMessage->transactionId != NULL) ? (uint32_t)p_sml_strlen(smlMessage->transactionId) : 0);
+	SML_TRACE_MESSAGE_NUMBER("groupNo", smlMessage->groupNo);
+	SML_TRACE_MESSAGE_NUMBER("abortOnError", smlMessage->abortOnError);
+	SML_TRACE_MESSAGE_NUMBER("messageBodyTag", smlMessage->messageBody.choiceTag);
+
+	return p_sml_parse_message_crc(smlBinary, offset, offsetPrev, smlMessage);
+}
+
+uint8_t p_sml_parse_message_crc(const unsigned char* smlBinary, uint32_t* offset, uint32_t offsetPrev, SML_Message* smlMessage) {
+	uint16_t crc16;
+	uint32_t crcOffset = *offset;
 
 	/* Calculate and compare crc16 */
 	crc16 = crc16_ccitt(smlBinary+offsetPrev, (*offset)-offsetPrev);
 
 	if(p_sml_parse_unsigned16(smlBinary, offset, &smlMessage->crc16) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Message");
 	}
 	else if(smlMessage->crc16 != crc16) {
-		return SML_PARSE_ERROR;
+		SML_TRACE_ERROR_TEXT("parseError", "message crc16 mismatch");
+		SML_METRIC_ADD(messageCrcFailures, 1);
+		p_sml_parse_error(SML_ERROR_MESSAGE_CRC, crcOffset);
+		return p_sml_parse_failed("Message");
 	}
 	/* Check last byte */
 	else if(smlBinary[*offset] != 0x00) {
-		return SML_PARSE_ERROR;
+		p_sml_parse_error(SML_ERROR_MESSAGE_END, *offset);
+		return p_sml_parse_failed("Message");
 	}
 	else {
 		(*offset)++;
+		SML_METRIC_ADD(messagesParsed, 1);
+		SML_METRIC_ADD(messageBytesParsed, *offset - offsetPrev);
 		return SML_PARSE_OK;
 	}
 }
@@ -90,53 +140,234 @@ uint8_t sml_parse_message_binary(const unsigned char* smlBinary, uint32_t* offse
 uint8_t sml_transport_parse_file(const unsigned char* smlBinary, uint32_t msgCount, SML_File* file) {
 	uint32_t i;
 	uint32_t offset = 0;
+	uint8_t retValue;
 	file->msgCount = msgCount;
-	file->messages = (SML_Message**)calloc(msgCount, sizeof(SML_Message*));
-	p_sml_add_pointer(file->messages);
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_error_reset();
+	file->messages = (SML_Message**)p_sml_parser_calloc(msgCount, sizeof(SML_Message*));
+	if(file->messages == NULL) {
+		return SML_PARSE_NOMEM;
+	}
 	for(i=0; i<msgCount; i++) {
-		file->messages[i] = (SML_Message*)calloc(1, sizeof(SML_Message));
-		p_sml_add_pointer(file->messages[i]);
-		if(sml_transport_parse_message(smlBinary, &offset, file->messages[i]) == SML_PARSE_ERROR) {
-			return SML_PARSE_ERROR;
+		file->messages[i] = (SML_Message*)p_sml_parser_calloc(1, sizeof(SML_Message));
+		if(file->messages[i] == NULL) {
+			return SML_PARSE_NOMEM;
+		}
+		retValue = sml_transport_parse_message(smlBinary, &offset, file->messages[i]);
+		if(retValue != SML_PARSE_OK) {
+			return retValue;
 		}
 	}
 
 	return SML_PARSE_OK;
 }
 
+/*
+ * Parses every good frame of the length bytes at smlBinary into file. Bad
+ * frames and garbage between frames do not abort: they are recorded in
+ * errors (the first errorSpace of *errorCount) and parsing resumes at the
+ * next frame start sequence. Frames are validated before they are parsed,
+ * so no read goes beyond length. Returns SML_PARSE_NOMEM only if the
+ * message list itself cannot be allocated.
+ */
+uint8_t sml_transport_parse_file_tolerant(const unsigned char* smlBinary, uint32_t length, SML_File* file, SML_Frame_Error* errors, uint32_t errorSpace, uint32_t* errorCount) {
+	SML_Message** messages = NULL;
+	SML_Message* message;
+	uint32_t msgSpace = 0;
+	uint32_t offset = 0;
+	uint32_t start;
+	uint32_t frameEnd;
+	uint32_t parseOffset;
+	uint32_t errorOffset = 0;
+	uint8_t errorReason = 0;
+	uint8_t retValue;
+	size_t mark;
+
+	file->messages = NULL;
+	file->msgCount = 0;
+	*errorCount = 0;
+	p_sml_error_reset();
+
+	while(offset < length) {
+		start = p_sml_transport_find_start(smlBinary, offset, length);
+
+		/* Garbage in front of a frame is reported on its own, after a bad frame it is part of that error */
+		if(errorReason == 0 && start > offset) {
+			errorOffset = offset;
+			errorReason = SML_FRAME_ERROR_SYNC;
+		}
+		if(errorReason != 0) {
+			if(*errorCount < errorSpace) {
+				errors[*errorCount].offset = errorOffset;
+				errors[*errorCount].length = start - errorOffset;
+				errors[*errorCount].reason = errorReason;
+			}
+			(*errorCount)++;
+			SML_METRIC_ADD(resyncBytes, start - errorOffset);
+			errorReason = 0;
+		}
+		if(start >= length) {
+			break;
+		}
+
+		frameEnd = start;
+		if(sml_transport_validate_message(smlBinary, length, &frameEnd) == SML_PARSE_ERROR) {
+			SML_METRIC_ADD(framesSkipped, 1);
+			errorOffset = start;
+			errorReason = SML_FRAME_ERROR_INVALID;
+			/* A start sequence cannot overlap itself, the next one is behind this one */
+			offset = start + 8;
+			continue;
+		}
+
+		if(file->msgCount == msgSpace) {
+			msgSpace = (msgSpace > 0) ? msgSpace*2 : 16;
+			messages = (SML_Message**)p_sml_realloc(file->messages, file->msgCount*sizeof(SML_Message*), msgSpace*sizeof(SML_Message*));
+			if(messages == NULL) {
+				p_sml_free(file->messages);
+				file->messages = NULL;
+				file->msgCount = 0;
+				p_sml_context->error.code = SML_ERROR_NOMEM;
+				return SML_PARSE_NOMEM;
+			}
+			file->messages = messages;
+		}
+
+		/* A frame that fails to parse leaves nothing behind */
+		mark = p_sml_parser_mark();
+		message = (SML_Message*)p_sml_parser_calloc(1, sizeof(SML_Message));
+		retValue = SML_PARSE_NOMEM;
+		if(message != NULL) {
+			parseOffset = start;
+			retValue = sml_transport_parse_message(smlBinary, &parseOffset, message);
+		}
+		if(retValue == SML_PARSE_OK) {
+			file->messages[file->msgCount] = message;
+			file->msgCount++;
+		}
+		else {
+			p_sml_parser_release(mark);
+			SML_METRIC_ADD(framesSkipped, 1);
+			errorOffset = start;
+			errorReason = (retValue == SML_PARSE_NOMEM) ? SML_FRAME_ERROR_NOMEM : SML_FRAME_ERROR_INVALID;
+		}
+		offset = frameEnd;
+	}
+
+	/* Register the list only once it has its final address */
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_add_pointer(file->messages);
+	if(p_sml_context->outOfMemory) {
+		p_sml_free(file->messages);
+		file->messages = NULL;
+		file->msgCount = 0;
+		p_sml_context->error.code = SML_ERROR_NOMEM;
+		return SML_PARSE_NOMEM;
+	}
+	return SML_PARSE_OK;
+}
+
 uint8_t sml_transport_parse_message(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message) {
+	uint8_t retValue;
+	SML_LATENCY_DECLARE(start)
+
+	SML_LATENCY_START(start);
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_message_begin();
+	retValue = p_sml_transport_parse_message(smlBinary, offset, message);
+	p_sml_message_end();
+	retValue = p_sml_parse_result(retValue);
+
+	if(retValue == SML_PARSE_OK) {
+		SML_LATENCY_RECORD(SML_LATENCY_TRANSPORT_PARSE, message->messageBody.choiceTag, start);
+	}
+	return retValue;
+}
+
+uint8_t p_sml_transport_parse_message(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message) {
+	unsigned char* smlMessageBinary;
+	uint32_t zeroOffset = 0;
+	uint32_t frameLength;
+
+	if(p_sml_transport_unescape(smlBinary, *offset, &smlMessageBinary, &frameLength) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(p_sml_parse_message(smlMessageBinary, &zeroOffset, message) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+
+	*offset += frameLength;
+	return SML_PARSE_OK;
+}
+
+uint32_t p_sml_transport_find_start(const unsigned char* smlBinary, uint32_t offset, uint32_t length) {
+	static const unsigned char startOfMsg[8] = { 0x1B, 0x1B, 0x1B, 0x1B, 0x01, 0x01, 0x01, 0x01 };
+	const unsigned char* last;
+
+	/* Horspool search on the last byte of the window: 0x01 shifts by one,
+	 * 0x1B by four, anything else skips the whole window */
+	while(offset < length && length - offset >= 8) {
+		last = smlBinary + offset + 7;
+		if(*last == 0x01) {
+			if(p_sml_memcmp(smlBinary + offset, startOfMsg, 7) == 0) {
+				return offset;
+			}
+			offset++;
+		}
+		else if(*last == 0x1B) {
+			offset += 4;
+		}
+		else {
+			offset += 8;
+		}
+	}
+	return length;
+}
+
+uint8_t p_sml_transport_unescape(const unsigned char* smlBinary, uint32_t offset, unsigned char** message, uint32_t* frameLength) {
 	unsigned char* smlMessageBinary;
 	unsigned char* inPtr;
 	unsigned char* outPtr;
 	uint64_t buffer = 0;
-	uint32_t zeroOffset = 0;
+	uint32_t outLength;
 	uint32_t msgSpace = 256;
 	uint16_t bufferSize = 0;
 	uint16_t crc16;
 
-	if(*((uint32_t*)(smlBinary + *offset)) != 0x1B1B1B1B) {
-		return SML_PARSE_ERROR;
+	if(*((uint32_t*)(smlBinary + offset)) != 0x1B1B1B1B) {
+		return p_sml_parse_error(SML_ERROR_FRAME, offset);
 	}
-	if(*((uint32_t*)(smlBinary + *offset + 4)) != 0x01010101) {
-		return SML_PARSE_ERROR;
+	if(*((uint32_t*)(smlBinary + offset + 4)) != 0x01010101) {
+		return p_sml_parse_error(SML_ERROR_FRAME, offset);
 	}
 
-	smlMessageBinary = (unsigned char*)calloc(msgSpace, sizeof(unsigned char*));
-	p_sml_add_pointer(smlMessageBinary);
+	smlMessageBinary = (unsigned char*)p_sml_calloc(msgSpace, sizeof(unsigned char));
+	if(smlMessageBinary == NULL) {
+		return SML_PARSE_ERROR;
+	}
 
 	outPtr = smlMessageBinary;
-	inPtr  = (unsigned char*)(smlBinary + *offset + 8);
+	inPtr  = (unsigned char*)(smlBinary + offset + 8);
 	for(;;) {
 		buffer = (buffer << 8) | *inPtr;
 		bufferSize++;
 
 		if((uint32_t)(outPtr - smlMessageBinary + 64) > msgSpace) {
-			smlMessageBinary = (unsigned char*)realloc(smlMessageBinary, msgSpace + 64);
+			/* The buffer may move, keep the write position relative to it */
+			outLength = (uint32_t)(outPtr - smlMessageBinary);
+			outPtr = (unsigned char*)p_sml_realloc(smlMessageBinary, msgSpace, msgSpace + 64);
+			if(outPtr == NULL) {
+				p_sml_free(smlMessageBinary);
+				return SML_PARSE_ERROR;
+			}
+			smlMessageBinary = outPtr;
+			outPtr = smlMessageBinary + outLength;
 			msgSpace += 64;
 		}
 
 		if(buffer == 0x1B1B1B1B1B1B1B1B) {
-			memmove(outPtr, &buffer, 4);
+			SML_METRIC_ADD(escapesParsed, 1);
+			p_sml_memcpy(outPtr, &buffer, 4);
 			outPtr += 4;
 			buffer = 0;
 			bufferSize = 0;
@@ -145,7 +376,7 @@ uint8_t sml_transport_parse_message(const unsigned char* smlBinary, uint32_t* of
 			if(bigendian_check() == FALSE) {
 				endian_swap64(&buffer);
 			}
-			memmove(outPtr, ((unsigned char*)(&buffer))+5, (uint16_t)(bufferSize-5));
+			p_sml_memcpy(outPtr, ((unsigned char*)(&buffer))+5, (uint16_t)(bufferSize-5));
 			outPtr += (bufferSize-5);
 			inPtr++;
 			break;
@@ -154,40 +385,187 @@ uint8_t sml_transport_parse_message(const unsigned char* smlBinary, uint32_t* of
 			if(bigendian_check() == FALSE) {
 				endian_swap64(&buffer);
 			}
-			memmove(outPtr, ((unsigned char*)(&buffer)) + (8 - bufferSize), bufferSize);
+			p_sml_memcpy(outPtr, ((unsigned char*)(&buffer)) + (8 - bufferSize), bufferSize);
 			outPtr += bufferSize;
 			buffer = 0;
 			bufferSize = 0;
 		}
 		inPtr++;
 	}
+	/* Register the buffer only once it has its final address */
+	p_sml_add_pointer(smlMessageBinary);
 
-	crc16 = crc16_ccitt(smlBinary + *offset, (uint32_t)((inPtr + 1) - (smlBinary + *offset)));
+	crc16 = crc16_ccitt(smlBinary + offset, (uint32_t)((inPtr + 1) - (smlBinary + offset)));
 	if(bigendian_check() == FALSE) {
 		endian_swap16(&crc16);
 	}
 	if(*((uint16_t*)(inPtr + 1)) != crc16) {
-		return SML_PARSE_ERROR;
+		SML_METRIC_ADD(frameCrcFailures, 1);
+		return p_sml_parse_error(SML_ERROR_FRAME_CRC, (uint32_t)((inPtr + 1) - smlBinary));
+	}
+
+	*message = smlMessageBinary;
+	*frameLength = (uint32_t)((inPtr + 3) - (smlBinary + offset));
+	SML_METRIC_ADD(framesParsed, 1);
+	SML_METRIC_ADD(frameBytesParsed, *frameLength);
+	return SML_PARSE_OK;
+}
+
+uint8_t sml_parse_profilepack_stream(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user) {
+	uint8_t retValue;
+	SML_LATENCY_DECLARE(start)
+
+	SML_LATENCY_START(start);
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_message_begin();
+	retValue = p_sml_parse_profilepack_stream(smlBinary, offset, message, header, period, user);
+	p_sml_message_end();
+	retValue = p_sml_parse_result(retValue);
+
+	if(retValue == SML_PARSE_OK) {
+		SML_LATENCY_RECORD(SML_LATENCY_PARSE, message->messageBody.choiceTag, start);
+	}
+	return retValue;
+}
+
+uint8_t sml_transport_parse_profilepack_stream(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user) {
+	unsigned char* smlMessageBinary;
+	uint32_t zeroOffset = 0;
+	uint32_t frameLength;
+	uint8_t retValue;
+	SML_LATENCY_DECLARE(start)
+
+	SML_LATENCY_START(start);
+	p_sml_context->outOfMemory = FALSE;
+	p_sml_message_begin();
+	retValue = p_sml_transport_unescape(smlBinary, *offset, &smlMessageBinary, &frameLength);
+	if(retValue == SML_PARSE_OK) {
+		retValue = p_sml_parse_profilepack_stream(smlMessageBinary, &zeroOffset, message, header, period, user);
+	}
+	p_sml_message_end();
+	retValue = p_sml_parse_result(retValue);
+
+	if(retValue == SML_PARSE_OK) {
+		*offset += frameLength;
+		SML_LATENCY_RECORD(SML_LATENCY_TRANSPORT_PARSE, message->messageBody.choiceTag, start);
+	}
+	return retValue;
+}
+
+uint8_t p_sml_parse_profilepack_stream(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user) {
+	SML_GetProfilePack_Res* response;
+	uint32_t offsetPrev = *offset;
+
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 6) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &message->transactionId) ||
+		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &message->groupNo) ||
+		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &message->abortOnError) ||
+		SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 2) ||
+		SML_PARSE_ERROR == p_sml_parse_unsigned32(smlBinary, offset, &message->messageBody.choiceTag)) {
+		return p_sml_parse_failed("Message");
+	}
+	if(message->messageBody.choiceTag != SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE) {
+		p_sml_parse_error(SML_ERROR_CHOICE, *offset);
+		return p_sml_parse_failed("Message");
+	}
+	p_sml_message_type(message->messageBody.choiceTag);
+
+	response = (SML_GetProfilePack_Res*)p_sml_calloc(1, sizeof(SML_GetProfilePack_Res));
+	if(response == NULL) {
+		return p_sml_parse_failed("Message");
 	}
+	p_sml_add_pointer(response);
+	message->messageBody.choiceValue.getProfilePackResponse = response;
 
-	if(sml_parse_message_binary(smlMessageBinary, &zeroOffset, message) == SML_PARSE_ERROR) {
+	/* Same layout as p_sml_parse_getprofilepack_response() */
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 8) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_time(smlBinary, offset, &response->actTime) ||
+		SML_PARSE_ERROR == p_sml_parse_unsigned32(smlBinary, offset, &response->regPeriod) ||
+		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &response->parameterTreePath) ||
+		SML_PARSE_ERROR == p_sml_parse_list_of_objheaderentry(smlBinary, offset, &response->header_List) ||
+		SML_PARSE_ERROR == p_sml_parse_profile_periods(smlBinary, offset, response, header, period, user) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->rawdata) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->profileSignature)) {
+		p_sml_parse_failed("GetProfilePack.Res");
+		p_sml_parse_failed("MessageBody");
+		return p_sml_parse_failed("Message");
+	}
+
+	return p_sml_parse_message_crc(smlBinary, offset, offsetPrev, message);
+}
+
+uint8_t p_sml_parse_profile_periods(const unsigned char* smlBinary, uint32_t* offset, SML_GetProfilePack_Res* response, SML_Profile_Header_Callback header, SML_Profile_Period_Callback period, void* user) {
+	SML_ProfObjPeriodEntry entry;
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
+	uint32_t i;
+	size_t mark;
+	uint8_t retValue;
+
+	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
+	if(tl_type != LIST || tl_value == 0) {
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+	}
+	response->period_List.listSize = tl_value;
+	response->period_List.period_List_Entry = NULL;
+	if(header != NULL && header(user, response) != SML_PARSE_OK) {
+		return p_sml_parse_error(SML_ERROR_CALLBACK, *offset);
+	}
+
+	/* Each row is released once the callback returns, memory stays flat */
+	for(i=0; i<tl_value; i++) {
+		mark = p_sml_parser_mark();
+		retValue = p_sml_parse_objperiodentry(smlBinary, offset, &entry);
+		if(retValue == SML_PARSE_OK && period != NULL && period(user, i, &entry) != SML_PARSE_OK) {
+			retValue = p_sml_parse_error(SML_ERROR_CALLBACK, *offset);
+		}
+		p_sml_parser_release(mark);
+		if(retValue == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+	}
 
-	*offset += ((uint32_t)((inPtr + 3) - (smlBinary + *offset)));
 	return SML_PARSE_OK;
 }
 
 void sml_parser_free(void) {
 	uint32_t i;
-	if(p_sml_pointer_list != NULL && p_sml_pointer_count > 0) {
-		for(i=0; i<p_sml_pointer_count; i++) {
-			free(p_sml_pointer_list[i]);
+	if(p_sml_context->pool.base != NULL) {
+		p_sml_pool_reset();
+		return;
+	}
+	if(p_sml_context->pointerList != NULL && p_sml_context->pointerCount > 0) {
+		for(i=0; i<p_sml_context->pointerCount; i++) {
+			p_sml_free(p_sml_context->pointerList[i]);
 		}
 	}
-	free(p_sml_pointer_list);
-	p_sml_pointer_list  = NULL;
-	p_sml_pointer_count = 0;
+	p_sml_free(p_sml_context->pointerList);
+	p_sml_context->pointerList  = NULL;
+	p_sml_context->pointerCount = 0;
+	p_sml_context->pointerMax   = 0;
+}
+
+size_t p_sml_parser_mark(void) {
+	if(p_sml_context->pool.base != NULL) {
+		return p_sml_pool_mark();
+	}
+	return p_sml_context->pointerCount;
+}
+
+void p_sml_parser_release(size_t mark) {
+	if(p_sml_context->pool.base != NULL) {
+		p_sml_pool_release(mark);
+		return;
+	}
+	/* Youngest first, so pool-like allocators can reclaim every block */
+	while(p_sml_context->pointerCount > mark) {
+		p_sml_context->pointerCount--;
+		p_sml_free(p_sml_context->pointerList[p_sml_context->pointerCount]);
+	}
 }
 
 uint8_t p_sml_parse_open_request(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Req* request) {
@@ -195,11 +573,11 @@ uint8_t p_sml_parse_open_request(const unsigned char* smlBinary, uint32_t* offse
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->codepage) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->clientId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->reqFileId) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8_optional(smlBinary, offset, &request->smlVersion)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("PublicOpen.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -210,10 +588,10 @@ uint8_t p_sml_parse_open_response(const unsigned char* smlBinary, uint32_t* offs
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->codepage) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->clientId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->reqFileId) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_time_optional(smlBinary, offset, &response->refTime) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8_optional(smlBinary, offset, &response->smlVersion)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("PublicOpen.Res");
 	}
 
 	return SML_PARSE_OK;
@@ -222,7 +600,7 @@ uint8_t p_sml_parse_open_response(const unsigned char* smlBinary, uint32_t* offs
 uint8_t p_sml_parse_close_request(const unsigned char* smlBinary, uint32_t* offset, SML_PublicClose_Req* request) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 1) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->globalSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("PublicClose.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -230,7 +608,7 @@ uint8_t p_sml_parse_close_request(const unsigned char* smlBinary, uint32_t* offs
 
 uint8_t p_sml_parse_getprofilelist_request(const unsigned char* smlBinary, uint32_t* offset, SML_GetProfileList_Req* request) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 9) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password) ||
 		SML_PARSE_ERROR == p_sml_parse_boolean_optional(smlBinary, offset, &request->withRawdata) ||
@@ -239,7 +617,7 @@ uint8_t p_sml_parse_getprofilelist_request(const unsigned char* smlBinary, uint3
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &request->parameterTreePath) ||
 		SML_PARSE_ERROR == p_sml_parse_list_of_objreqentry_optional(smlBinary, offset, &request->object_List) ||
 		SML_PARSE_ERROR == p_sml_parse_tree_optional(smlBinary, offset, &request->dasDetails)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetProfileList.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -247,7 +625,7 @@ uint8_t p_sml_parse_getprofilelist_request(const unsigned char* smlBinary, uint3
 
 uint8_t p_sml_parse_getprofilelist_response(const unsigned char* smlBinary, uint32_t* offset, SML_GetProfileList_Res* response) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 9) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_time(smlBinary, offset, &response->actTime) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned32(smlBinary, offset, &response->regPeriod) ||
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &response->parameterTreePath) ||
@@ -256,7 +634,7 @@ uint8_t p_sml_parse_getprofilelist_response(const unsigned char* smlBinary, uint
 		SML_PARSE_ERROR == p_sml_parse_list_of_periodentry(smlBinary, offset, &response->period_List) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->rawdata) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->periodSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetProfileList.Res");
 	}
 
 	return SML_PARSE_OK;
@@ -264,7 +642,7 @@ uint8_t p_sml_parse_getprofilelist_response(const unsigned char* smlBinary, uint
 
 uint8_t p_sml_parse_getprofilepack_request(const unsigned char* smlBinary, uint32_t* offset, SML_GetProfilePack_Req* request) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 9) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password) ||
 		SML_PARSE_ERROR == p_sml_parse_boolean_optional(smlBinary, offset, &request->withRawdata) ||
@@ -273,7 +651,7 @@ uint8_t p_sml_parse_getprofilepack_request(const unsigned char* smlBinary, uint3
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &request->parameterTreePath) ||
 		SML_PARSE_ERROR == p_sml_parse_list_of_objreqentry_optional(smlBinary, offset, &request->object_List) ||
 		SML_PARSE_ERROR == p_sml_parse_tree_optional(smlBinary, offset, &request->dasDetails)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetProfilePack.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -281,7 +659,7 @@ uint8_t p_sml_parse_getprofilepack_request(const unsigned char* smlBinary, uint3
 
 uint8_t p_sml_parse_getprofilepack_response(const unsigned char* smlBinary, uint32_t* offset, SML_GetProfilePack_Res* response) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 8) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_time(smlBinary, offset, &response->actTime) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned32(smlBinary, offset, &response->regPeriod) ||
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &response->parameterTreePath) ||
@@ -289,7 +667,7 @@ uint8_t p_sml_parse_getprofilepack_response(const unsigned char* smlBinary, uint
 		SML_PARSE_ERROR == p_sml_parse_list_of_objperiodentry(smlBinary, offset, &response->period_List) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->rawdata) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->profileSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetProfilePack.Res");
 	}
 
 	return SML_PARSE_OK;
@@ -298,7 +676,7 @@ uint8_t p_sml_parse_getprofilepack_response(const unsigned char* smlBinary, uint
 uint8_t p_sml_parse_close_response(const unsigned char* smlBinary, uint32_t* offset, SML_PublicClose_Res* response) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 1) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->globalSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("PublicClose.Res");
 	}
 
 	return SML_PARSE_OK;
@@ -307,11 +685,11 @@ uint8_t p_sml_parse_close_response(const unsigned char* smlBinary, uint32_t* off
 uint8_t p_sml_parse_getlist_request(const unsigned char* smlBinary, uint32_t* offset, SML_GetList_Req* request) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 5) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->clientId) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->listName)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetList.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -320,13 +698,13 @@ uint8_t p_sml_parse_getlist_request(const unsigned char* smlBinary, uint32_t* of
 uint8_t p_sml_parse_getlist_response(const unsigned char* smlBinary, uint32_t* offset, SML_GetList_Res* response) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 7) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->clientId) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->listName) ||
 		SML_PARSE_ERROR == p_sml_parse_time_optional(smlBinary, offset, &response->actSensorTime) ||
 		SML_PARSE_ERROR == p_sml_parse_list(smlBinary, offset, &response->valList) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->listSignature) ||
 		SML_PARSE_ERROR == p_sml_parse_time_optional(smlBinary, offset, &response->actGatewayTime)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetList.Res");
 	}
 
 	return SML_PARSE_OK;
@@ -334,12 +712,12 @@ uint8_t p_sml_parse_getlist_response(const unsigned char* smlBinary, uint32_t* o
 
 uint8_t p_sml_parse_getprocparameter_request(const unsigned char* smlBinary, uint32_t* offset, SML_GetProcParameter_Req* request) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 5) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password) ||
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &request->parameterTreePath) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->attribute)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetProcParameter.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -347,10 +725,10 @@ uint8_t p_sml_parse_getprocparameter_request(const unsigned char* smlBinary, uin
 
 uint8_t p_sml_parse_getprocparameter_response(const unsigned char* smlBinary, uint32_t* offset, SML_GetProcParameter_Res* response) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 3) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &response->parameterTreePath) ||
 		SML_PARSE_ERROR == p_sml_parse_tree(smlBinary, offset, &response->parameterTree)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("GetProcParameter.Res");
 	}
 
 	return SML_PARSE_OK;
@@ -358,12 +736,12 @@ uint8_t p_sml_parse_getprocparameter_response(const unsigned char* smlBinary, ui
 
 uint8_t p_sml_parse_setprocparameter_request(const unsigned char* smlBinary, uint32_t* offset, SML_SetProcParameter_Req* request) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 5) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password) ||
 		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &request->parameterTreePath) ||
 		SML_PARSE_ERROR == p_sml_parse_tree(smlBinary, offset, &request->parameterTree)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("SetProcParameter.Req");
 	}
 
 	return SML_PARSE_OK;
@@ -371,119 +749,279 @@ uint8_t p_sml_parse_setprocparameter_request(const unsigned char* smlBinary, uin
 
 uint8_t p_sml_parse_attention_response(const unsigned char* smlBinary, uint32_t* offset, SML_Attention_Res* response) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 4) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->attentionNo) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->attentionMsg) ||
 		SML_PARSE_ERROR == p_sml_parse_tree_optional(smlBinary, offset, &response->attentionDetails)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Attention.Res");
+	}
+
+	return SML_PARSE_OK;
+}
+
+
+uint8_t p_sml_parse_open_request_compact(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Req_Compact* request) {
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 7) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->codepage) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->clientId) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->reqFileId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &request->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->username) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &request->password)) {
+		return p_sml_parse_failed("PublicOpen.Req");
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		request->present |= SML_OPENREQ_SMLVERSION;
+		return (p_sml_parse_unsigned8(smlBinary, offset, &request->smlVersion) == SML_PARSE_OK) ? SML_PARSE_OK : p_sml_parse_failed("PublicOpen.Req");
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_open_response_compact(const unsigned char* smlBinary, uint32_t* offset, SML_PublicOpen_Res_Compact* response) {
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 6) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->codepage) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->clientId) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->reqFileId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId)) {
+		return p_sml_parse_failed("PublicOpen.Res");
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		response->present |= SML_OPENRES_REFTIME;
+		if(p_sml_parse_time(smlBinary, offset, &response->refTime) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("PublicOpen.Res");
+		}
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		response->present |= SML_OPENRES_SMLVERSION;
+		return (p_sml_parse_unsigned8(smlBinary, offset, &response->smlVersion) == SML_PARSE_OK) ? SML_PARSE_OK : p_sml_parse_failed("PublicOpen.Res");
 	}
 
 	return SML_PARSE_OK;
 }
 
+uint8_t p_sml_parse_getlist_response_compact(const unsigned char* smlBinary, uint32_t* offset, SML_GetList_Res_Compact* response) {
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 7) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->clientId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->listName)) {
+		return p_sml_parse_failed("GetList.Res");
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		response->present |= SML_GETLISTRES_ACTSENSORTIME;
+		if(p_sml_parse_time(smlBinary, offset, &response->actSensorTime) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("GetList.Res");
+		}
+	}
+	if(	SML_PARSE_ERROR == p_sml_parse_list_compact(smlBinary, offset, &response->valList) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &response->listSignature)) {
+		return p_sml_parse_failed("GetList.Res");
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		response->present |= SML_GETLISTRES_ACTGATEWAYTIME;
+		return (p_sml_parse_time(smlBinary, offset, &response->actGatewayTime) == SML_PARSE_OK) ? SML_PARSE_OK : p_sml_parse_failed("GetList.Res");
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_getprocparameter_response_compact(const unsigned char* smlBinary, uint32_t* offset, SML_GetProcParameter_Res_Compact* response) {
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 3) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &response->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_treepath(smlBinary, offset, &response->parameterTreePath) ||
+		SML_PARSE_ERROR == p_sml_parse_flat_tree(smlBinary, offset, &response->parameterTree)) {
+		return p_sml_parse_failed("GetProcParameter.Res");
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_messagebody_compact(const unsigned char* smlBinary, uint32_t* offset, SML_MessageBody* messageBody) {
+	void* body;
+	size_t size;
+
+	switch(messageBody->choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST: size = sizeof(SML_PublicOpen_Req_Compact); break;
+		case SML_MESSAGEBODY_OPEN_RESPONSE: size = sizeof(SML_PublicOpen_Res_Compact); break;
+		case SML_MESSAGEBODY_GETLIST_RESPONSE: size = sizeof(SML_GetList_Res_Compact); break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE: size = sizeof(SML_GetProcParameter_Res_Compact); break;
+		default: return p_sml_parse_error(SML_ERROR_CHOICE, *offset);
+	}
+	body = p_sml_calloc(1, size);
+	if(body == NULL) {
+		return SML_PARSE_ERROR;
+	}
+	p_sml_add_pointer(body);
+
+	switch(messageBody->choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+			messageBody->choiceValue.openRequestCompact = (SML_PublicOpen_Req_Compact*)body;
+			return p_sml_parse_open_request_compact(smlBinary, offset, messageBody->choiceValue.openRequestCompact);
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+			messageBody->choiceValue.openResponseCompact = (SML_PublicOpen_Res_Compact*)body;
+			return p_sml_parse_open_response_compact(smlBinary, offset, messageBody->choiceValue.openResponseCompact);
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+			messageBody->choiceValue.getListResponseCompact = (SML_GetList_Res_Compact*)body;
+			return p_sml_parse_getlist_response_compact(smlBinary, offset, messageBody->choiceValue.getListResponseCompact);
+		default:
+			messageBody->choiceValue.getProcParameterResponseCompact = (SML_GetProcParameter_Res_Compact*)body;
+			return p_sml_parse_getprocparameter_response_compact(smlBinary, offset, messageBody->choiceValue.getProcParameterResponseCompact);
+	}
+}
 
 uint8_t p_sml_parse_messagebody(const unsigned char* smlBinary, uint32_t* offset, SML_MessageBody* messageBody) {
 	uint8_t retValue;
+	uint32_t offsetRef = *offset;
 
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 2) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned32(smlBinary, offset, &messageBody->choiceTag)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("MessageBody");
+	}
+	p_sml_message_type(messageBody->choiceTag);
+
+	if(p_sml_context->compactLayout && sml_messagebody_has_compact_layout(messageBody->choiceTag)) {
+		if(p_sml_parse_messagebody_compact(smlBinary, offset, messageBody) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("MessageBody");
+		}
+		return SML_PARSE_OK;
 	}
 
 	switch(messageBody->choiceTag) {
 		case SML_MESSAGEBODY_OPEN_REQUEST:
-			messageBody->choiceValue.openRequest = (SML_PublicOpen_Req*)calloc(1, sizeof(SML_PublicOpen_Req));
+			messageBody->choiceValue.openRequest = (SML_PublicOpen_Req*)p_sml_calloc(1, sizeof(SML_PublicOpen_Req));
+			if(messageBody->choiceValue.openRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.openRequest);
 			retValue = p_sml_parse_open_request(
 				smlBinary, offset, messageBody->choiceValue.openRequest
 			);
 		break;
 		case SML_MESSAGEBODY_OPEN_RESPONSE:
-			messageBody->choiceValue.openResponse = (SML_PublicOpen_Res*)calloc(1, sizeof(SML_PublicOpen_Res));
+			messageBody->choiceValue.openResponse = (SML_PublicOpen_Res*)p_sml_calloc(1, sizeof(SML_PublicOpen_Res));
+			if(messageBody->choiceValue.openResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.openResponse);
 			retValue = p_sml_parse_open_response(
 				smlBinary, offset, messageBody->choiceValue.openResponse
 			);
 		break;
 		case SML_MESSAGEBODY_CLOSE_REQUEST:
-			messageBody->choiceValue.closeRequest = (SML_PublicClose_Req*)calloc(1, sizeof(SML_PublicClose_Req));
+			messageBody->choiceValue.closeRequest = (SML_PublicClose_Req*)p_sml_calloc(1, sizeof(SML_PublicClose_Req));
+			if(messageBody->choiceValue.closeRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.closeRequest);
 			retValue = p_sml_parse_close_request(
 				smlBinary, offset, messageBody->choiceValue.closeRequest
 			);
 		break;
 		case SML_MESSAGEBODY_CLOSE_RESPONSE:
-			messageBody->choiceValue.closeResponse = (SML_PublicClose_Res*)calloc(1, sizeof(SML_PublicClose_Res));
+			messageBody->choiceValue.closeResponse = (SML_PublicClose_Res*)p_sml_calloc(1, sizeof(SML_PublicClose_Res));
+			if(messageBody->choiceValue.closeResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.closeResponse);
 			retValue = p_sml_parse_close_response(
 				smlBinary, offset, messageBody->choiceValue.closeResponse
 			);
 		break;
 		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST:
-			messageBody->choiceValue.getProfilePackRequest = (SML_GetProfilePack_Req*)calloc(1, sizeof(SML_GetProfilePack_Req));
+			messageBody->choiceValue.getProfilePackRequest = (SML_GetProfilePack_Req*)p_sml_calloc(1, sizeof(SML_GetProfilePack_Req));
+			if(messageBody->choiceValue.getProfilePackRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getProfilePackRequest);
 			retValue = p_sml_parse_getprofilepack_request(
 				smlBinary, offset, messageBody->choiceValue.getProfilePackRequest
 			);
 		break;
 		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE:
-			messageBody->choiceValue.getProfilePackResponse = (SML_GetProfilePack_Res*)calloc(1, sizeof(SML_GetProfilePack_Res));
+			messageBody->choiceValue.getProfilePackResponse = (SML_GetProfilePack_Res*)p_sml_calloc(1, sizeof(SML_GetProfilePack_Res));
+			if(messageBody->choiceValue.getProfilePackResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getProfilePackResponse);
 			retValue = p_sml_parse_getprofilepack_response(
 				smlBinary, offset, messageBody->choiceValue.getProfilePackResponse
 			);
 		break;
 		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST:
-			messageBody->choiceValue.getProfileListRequest = (SML_GetProfileList_Req*)calloc(1, sizeof(SML_GetProfileList_Req));
+			messageBody->choiceValue.getProfileListRequest = (SML_GetProfileList_Req*)p_sml_calloc(1, sizeof(SML_GetProfileList_Req));
+			if(messageBody->choiceValue.getProfileListRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getProfileListRequest);
 			retValue = p_sml_parse_getprofilelist_request(
 				smlBinary, offset, messageBody->choiceValue.getProfileListRequest
 			);
 		break;
 		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE:
-			messageBody->choiceValue.getProfileListResponse = (SML_GetProfileList_Res*)calloc(1, sizeof(SML_GetProfileList_Res));
+			messageBody->choiceValue.getProfileListResponse = (SML_GetProfileList_Res*)p_sml_calloc(1, sizeof(SML_GetProfileList_Res));
+			if(messageBody->choiceValue.getProfileListResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getProfileListResponse);
 			retValue = p_sml_parse_getprofilelist_response(
 				smlBinary, offset, messageBody->choiceValue.getProfileListResponse
 			);
 		break;
 		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST:
-			messageBody->choiceValue.getProcParameterRequest = (SML_GetProcParameter_Req*)calloc(1, sizeof(SML_GetProcParameter_Req));
+			messageBody->choiceValue.getProcParameterRequest = (SML_GetProcParameter_Req*)p_sml_calloc(1, sizeof(SML_GetProcParameter_Req));
+			if(messageBody->choiceValue.getProcParameterRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getProcParameterRequest);
 			retValue = p_sml_parse_getprocparameter_request(
 				smlBinary, offset, messageBody->choiceValue.getProcParameterRequest
 			);
 		break;
 		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
-			messageBody->choiceValue.getProcParameterResponse = (SML_GetProcParameter_Res*)calloc(1, sizeof(SML_GetProcParameter_Res));
+			messageBody->choiceValue.getProcParameterResponse = (SML_GetProcParameter_Res*)p_sml_calloc(1, sizeof(SML_GetProcParameter_Res));
+			if(messageBody->choiceValue.getProcParameterResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getProcParameterResponse);
 			retValue = p_sml_parse_getprocparameter_response(
 				smlBinary, offset, messageBody->choiceValue.getProcParameterResponse
 			);
 		break;
 		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST:
-			messageBody->choiceValue.setProcParameterRequest = (SML_SetProcParameter_Req*)calloc(1, sizeof(SML_SetProcParameter_Req));
+			messageBody->choiceValue.setProcParameterRequest = (SML_SetProcParameter_Req*)p_sml_calloc(1, sizeof(SML_SetProcParameter_Req));
+			if(messageBody->choiceValue.setProcParameterRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.setProcParameterRequest);
 			retValue = p_sml_parse_setprocparameter_request(
 				smlBinary, offset, messageBody->choiceValue.setProcParameterRequest
 			);
 		break;
 		case SML_MESSAGEBODY_GETLIST_REQUEST:
-			messageBody->choiceValue.getListRequest = (SML_GetList_Req*)calloc(1, sizeof(SML_GetList_Req));
+			messageBody->choiceValue.getListRequest = (SML_GetList_Req*)p_sml_calloc(1, sizeof(SML_GetList_Req));
+			if(messageBody->choiceValue.getListRequest == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getListRequest);
 			retValue = p_sml_parse_getlist_request(
 				smlBinary, offset, messageBody->choiceValue.getListRequest
 			);
 		break;
 		case SML_MESSAGEBODY_GETLIST_RESPONSE:
-			messageBody->choiceValue.getListResponse = (SML_GetList_Res*)calloc(1, sizeof(SML_GetList_Res));
+			messageBody->choiceValue.getListResponse = (SML_GetList_Res*)p_sml_calloc(1, sizeof(SML_GetList_Res));
+			if(messageBody->choiceValue.getListResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.getListResponse);
 			retValue = p_sml_parse_getlist_response(
 				smlBinary, offset, messageBody->choiceValue.getListResponse
 			);
 		break;
 		case SML_MESSAGEBODY_ATTENTION_RESPONSE:
-			messageBody->choiceValue.attentionResponse = (SML_Attention_Res*)calloc(1, sizeof(SML_Attention_Res));
+			messageBody->choiceValue.attentionResponse = (SML_Attention_Res*)p_sml_calloc(1, sizeof(SML_Attention_Res));
+			if(messageBody->choiceValue.attentionResponse == NULL) {
+				return p_sml_parse_failed("MessageBody");
+			}
 			p_sml_add_pointer(messageBody->choiceValue.attentionResponse);
 			retValue = p_sml_parse_attention_response(
 				smlBinary, offset, messageBody->choiceValue.attentionResponse
@@ -491,30 +1029,39 @@ uint8_t p_sml_parse_messagebody(const unsigned char* smlBinary, uint32_t* offset
 		break;
 
 		default:
-			return SML_PARSE_ERROR;
+			p_sml_parse_error(SML_ERROR_CHOICE, offsetRef);
+			return p_sml_parse_failed("MessageBody");
 		break;
 	}
 
-	return retValue;
+	if(retValue == SML_PARSE_ERROR) {
+		return p_sml_parse_failed("MessageBody");
+	}
+	return SML_PARSE_OK;
 }
 
 uint8_t p_sml_parse_treepath(const unsigned char* smlBinary, uint32_t* offset, SML_TreePath* treepath) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("TreePath");
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+		return p_sml_parse_failed("TreePath");
 	}
 	treepath->listSize = tl_value;
-	treepath->path_Entry = (char**)calloc(tl_value, sizeof(char*));
+	treepath->path_Entry = (char**)p_sml_calloc(tl_value, sizeof(char*));
+	if(treepath->path_Entry == NULL) {
+		return p_sml_parse_failed("TreePath");
+	}
 	p_sml_add_pointer(treepath->path_Entry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_string(smlBinary, offset, treepath->path_Entry+i) == SML_PARSE_ERROR) {
-			return SML_PARSE_ERROR;
+			return p_sml_parse_failed("TreePath");
 		}
 	}
 
@@ -522,47 +1069,59 @@ uint8_t p_sml_parse_treepath(const unsigned char* smlBinary, uint32_t* offset, S
 }
 
 uint8_t p_sml_parse_tree(const unsigned char* smlBinary, uint32_t* offset, SML_Tree* tree) {
-	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 3) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &tree->parameterName) ||
-		SML_PARSE_ERROR == p_sml_parse_procparvalue_optional(smlBinary, offset, &tree->parameterValue) ||
-		SML_PARSE_ERROR == p_sml_parse_list_of_tree_optional(smlBinary, offset, &tree->child_List)) {
-		return SML_PARSE_ERROR;
+	SML_Tree_Walk walk;
+
+	/* Preorder, the walk stack replaces the recursion over child lists */
+	walk.depth = 0;
+	walk.overflow = FALSE;
+	while(tree != NULL) {
+		if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 3) ||
+			SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &tree->parameterName) ||
+			SML_PARSE_ERROR == p_sml_parse_procparvalue_optional(smlBinary, offset, &tree->parameterValue) ||
+			SML_PARSE_ERROR == p_sml_parse_list_of_tree_header(smlBinary, offset, &tree->child_List)) {
+			return p_sml_parse_failed("Tree");
+		}
+		tree = p_sml_tree_next(&walk, tree);
 	}
 
+	if(walk.overflow) {
+		p_sml_parse_error(SML_ERROR_DEPTH, *offset);
+		return p_sml_parse_failed("Tree");
+	}
 	return SML_PARSE_OK;
 }
 
 uint8_t p_sml_parse_tree_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Tree** tree) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Tree");
 	}
 	if(tl_type == STRING && tl_value == 0) {
 		*tree = NULL;
 		return SML_PARSE_OK;
 	}
 	if(tl_type != LIST || tl_value != 3) {
-		return SML_PARSE_ERROR;
+		p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+		return p_sml_parse_failed("Tree");
 	}
 
-	*tree = (SML_Tree*)calloc(1, sizeof(SML_Tree));
-	p_sml_add_pointer(*tree);
-
-	if(	SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &((*tree)->parameterName)) ||
-		SML_PARSE_ERROR == p_sml_parse_procparvalue_optional(smlBinary, offset, &((*tree)->parameterValue)) ||
-		SML_PARSE_ERROR == p_sml_parse_list_of_tree_optional(smlBinary, offset, &((*tree)->child_List))) {
-		return SML_PARSE_ERROR;
+	*tree = (SML_Tree*)p_sml_calloc(1, sizeof(SML_Tree));
+	if(*tree == NULL) {
+		return p_sml_parse_failed("Tree");
 	}
+	p_sml_add_pointer(*tree);
 
-	return SML_PARSE_OK;
+	*offset = offsetRef;
+	return p_sml_parse_tree(smlBinary, offset, *tree);
 }
 
-uint8_t p_sml_parse_list_of_tree_optional(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_Tree** list) {
+uint8_t p_sml_parse_list_of_tree_header(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_Tree** list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
-	uint32_t i;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
@@ -572,19 +1131,156 @@ uint8_t p_sml_parse_list_of_tree_optional(const unsigned char* smlBinary, uint32
 		return SML_PARSE_OK;
 	}
 	if(tl_type != LIST || tl_value == 0) {
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+	}
+
+	*list = (List_of_SML_Tree*)p_sml_calloc(1, sizeof(List_of_SML_Tree));
+	if(*list == NULL) {
+		return SML_PARSE_ERROR;
+	}
+	p_sml_add_pointer(*list);
+
+	(*list)->listSize = tl_value;
+	(*list)->tree_Entry = (SML_Tree*)p_sml_calloc(tl_value, sizeof(SML_Tree));
+	if((*list)->tree_Entry == NULL) {
+		return SML_PARSE_ERROR;
+	}
+	p_sml_add_pointer((*list)->tree_Entry);
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_list_of_tree_optional(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_Tree** list) {
+	uint32_t i;
+
+	if(p_sml_parse_list_of_tree_header(smlBinary, offset, list) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
+	for(i=0; *list != NULL && i<(*list)->listSize; i++) {
+		if(p_sml_parse_tree(smlBinary, offset, (*list)->tree_Entry+i) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_flat_tree(const unsigned char* smlBinary, uint32_t* offset, SML_Flat_Tree* tree) {
+	uint32_t open[SMLLIB_TREE_MAX_DEPTH];		/* nodes with children still to come */
+	uint32_t remaining[SMLLIB_TREE_MAX_DEPTH];
+	SML_Flat_Node* node;
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t nodeCount;
+	uint32_t valueCount;
+	uint32_t depth = 0;
+	uint32_t i = 0;
+	uint32_t v = 0;
+
+	/* Size the block up front, nodes and values are allocated at once */
+	if(p_sml_scan_tree(smlBinary, *offset, &nodeCount, &valueCount) == SML_PARSE_ERROR) {
+		return p_sml_parse_failed("Tree");
+	}
+	if(p_sml_flat_tree_alloc(tree, nodeCount, valueCount) == SML_PARSE_ERROR) {
+		return p_sml_parse_failed("Tree");
+	}
+	p_sml_add_pointer(tree->nodes);
+
+	/* Preorder; the scan has checked the structure already */
+	for(;;) {
+		node = &tree->nodes[i];
+		if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 3) ||
+			SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &node->parameterName)) {
+			return p_sml_parse_failed("Tree");
+		}
+		node->value = SML_FLAT_NO_VALUE;
+		if(!p_sml_parse_absent(smlBinary, offset)) {
+			node->value = v;
+			if(p_sml_parse_procparvalue(smlBinary, offset, &tree->values[v++]) == SML_PARSE_ERROR) {
+				return p_sml_parse_failed("Tree");
+			}
+		}
+		if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("Tree");
+		}
+		node->end = ++i;
+		if(tl_type == LIST) {
+			if(depth == SMLLIB_TREE_MAX_DEPTH) {
+				p_sml_parse_error(SML_ERROR_DEPTH, *offset);
+				return p_sml_parse_failed("Tree");
+			}
+			node->childCount = tl_value;
+			open[depth] = i - 1;
+			remaining[depth++] = tl_value;
+		}
+		/* Close the subtrees that are complete */
+		while(depth > 0 && remaining[depth-1] == 0) {
+			tree->nodes[open[--depth]].end = i;
+		}
+		if(depth == 0) {
+			return SML_PARSE_OK;
+		}
+		remaining[depth-1]--;
+	}
+}
+
+uint8_t p_sml_scan_tree(const unsigned char* smlBinary, uint32_t offset, uint32_t* nodeCount, uint32_t* valueCount) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t pending = 1;
+
+	*nodeCount = 0;
+	*valueCount = 0;
+	while(pending > 0) {
+		pending--;
+		(*nodeCount)++;
+		if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, &offset, 3) ||
+			SML_PARSE_ERROR == p_sml_skip_element(smlBinary, &offset)) {
+			return SML_PARSE_ERROR;
+		}
+		if(!p_sml_parse_absent(smlBinary, &offset)) {
+			(*valueCount)++;
+			if(p_sml_skip_element(smlBinary, &offset) == SML_PARSE_ERROR) {
+				return SML_PARSE_ERROR;
+			}
+		}
+		if(p_sml_parse_tlfield(smlBinary, &offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+		if(tl_type == LIST) {
+			if(tl_value == 0 || pending + tl_value < pending) {
+				return p_sml_parse_error(SML_ERROR_TYPE, offset);
+			}
+			pending += tl_value;
+		}
+		else if(tl_type != STRING || tl_value != 0) {
+			return p_sml_parse_error(SML_ERROR_TYPE, offset);
+		}
+	}
+
+	return SML_PARSE_OK;
+}
 
-	*list = (List_of_SML_Tree*)calloc(1, sizeof(List_of_SML_Tree));
-	p_sml_add_pointer(*list);
+uint8_t p_sml_skip_element(const unsigned char* smlBinary, uint32_t* offset) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t pending = 1;
 
-	(*list)->listSize = tl_value;
-	(*list)->tree_Entry = (SML_Tree*)calloc(tl_value, sizeof(SML_Tree));
-	p_sml_add_pointer((*list)->tree_Entry);
-	for(i=0; i<tl_value; i++) {
-		if(p_sml_parse_tree(smlBinary, offset, (*list)->tree_Entry+i) == SML_PARSE_ERROR) {
+	/* Lists add their elements to the pending count, no recursion */
+	while(pending > 0) {
+		pending--;
+		if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 			return SML_PARSE_ERROR;
 		}
+		if(tl_type == LIST) {
+			if(pending + tl_value < pending) {
+				return p_sml_parse_error(SML_ERROR_TYPE, *offset);
+			}
+			pending += tl_value;
+		}
+		else {
+			*offset += tl_value;
+		}
 	}
 
 	return SML_PARSE_OK;
@@ -593,6 +1289,7 @@ uint8_t p_sml_parse_list_of_tree_optional(const unsigned char* smlBinary, uint32
 uint8_t p_sml_parse_list_of_objreqentry_optional(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_ObjReqEntry** list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
@@ -603,14 +1300,20 @@ uint8_t p_sml_parse_list_of_objreqentry_optional(const unsigned char* smlBinary,
 		return SML_PARSE_OK;
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 
-	*list = (List_of_SML_ObjReqEntry*)calloc(1, sizeof(List_of_SML_ObjReqEntry));
+	*list = (List_of_SML_ObjReqEntry*)p_sml_calloc(1, sizeof(List_of_SML_ObjReqEntry));
+	if(*list == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(*list);
 
 	(*list)->listSize = tl_value;
-	(*list)->object_List_Entry = (SML_ObjReqEntry*)calloc(tl_value, sizeof(SML_ObjReqEntry));
+	(*list)->object_List_Entry = (SML_ObjReqEntry*)p_sml_calloc(tl_value, sizeof(SML_ObjReqEntry));
+	if((*list)->object_List_Entry == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer((*list)->object_List_Entry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_string(smlBinary, offset, (*list)->object_List_Entry+i) == SML_PARSE_ERROR) {
@@ -624,16 +1327,20 @@ uint8_t p_sml_parse_list_of_objreqentry_optional(const unsigned char* smlBinary,
 uint8_t p_sml_parse_list_of_periodentry(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_PeriodEntry* list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	list->listSize = tl_value;
-	list->period_List_Entry = (SML_PeriodEntry*)calloc(tl_value, sizeof(SML_PeriodEntry));
+	list->period_List_Entry = (SML_PeriodEntry*)p_sml_calloc(tl_value, sizeof(SML_PeriodEntry));
+	if(list->period_List_Entry == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(list->period_List_Entry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_periodentry(smlBinary, offset, list->period_List_Entry+i) == SML_PARSE_ERROR) {
@@ -647,16 +1354,20 @@ uint8_t p_sml_parse_list_of_periodentry(const unsigned char* smlBinary, uint32_t
 uint8_t p_sml_parse_list_of_objheaderentry(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_ProfObjHeaderEntry* list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	list->listSize = tl_value;
-	list->header_List_Entry = (SML_ProfObjHeaderEntry*)calloc(tl_value, sizeof(SML_ProfObjHeaderEntry));
+	list->header_List_Entry = (SML_ProfObjHeaderEntry*)p_sml_calloc(tl_value, sizeof(SML_ProfObjHeaderEntry));
+	if(list->header_List_Entry == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(list->header_List_Entry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_objheaderentry(smlBinary, offset, list->header_List_Entry+i) == SML_PARSE_ERROR) {
@@ -670,16 +1381,20 @@ uint8_t p_sml_parse_list_of_objheaderentry(const unsigned char* smlBinary, uint3
 uint8_t p_sml_parse_list_of_objperiodentry(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_ProfObjPeriodEntry* list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	list->listSize = tl_value;
-	list->period_List_Entry = (SML_ProfObjPeriodEntry*)calloc(tl_value, sizeof(SML_ProfObjPeriodEntry));
+	list->period_List_Entry = (SML_ProfObjPeriodEntry*)p_sml_calloc(tl_value, sizeof(SML_ProfObjPeriodEntry));
+	if(list->period_List_Entry == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(list->period_List_Entry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_objperiodentry(smlBinary, offset, list->period_List_Entry+i) == SML_PARSE_ERROR) {
@@ -693,16 +1408,20 @@ uint8_t p_sml_parse_list_of_objperiodentry(const unsigned char* smlBinary, uint3
 uint8_t p_sml_parse_list_of_valueentry(const unsigned char* smlBinary, uint32_t* offset, List_of_SML_ValueEntry* list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	list->listSize = tl_value;
-	list->value_List_Entry = (SML_ValueEntry*)calloc(tl_value, sizeof(SML_ValueEntry));
+	list->value_List_Entry = (SML_ValueEntry*)p_sml_calloc(tl_value, sizeof(SML_ValueEntry));
+	if(list->value_List_Entry == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(list->value_List_Entry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_valueentry(smlBinary, offset, list->value_List_Entry+i) == SML_PARSE_ERROR) {
@@ -717,7 +1436,7 @@ uint8_t p_sml_parse_valueentry(const unsigned char* smlBinary, uint32_t* offset,
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 2) ||
 		SML_PARSE_ERROR == p_sml_parse_value(smlBinary, offset, &entry->value) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->valueSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("ValueEntry");
 	}
 
 	return SML_PARSE_OK;
@@ -725,10 +1444,10 @@ uint8_t p_sml_parse_valueentry(const unsigned char* smlBinary, uint32_t* offset,
 
 uint8_t p_sml_parse_objheaderentry(const unsigned char* smlBinary, uint32_t* offset, SML_ProfObjHeaderEntry* entry) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 3) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->objName) ||
+		SML_PARSE_ERROR == p_sml_parse_objname(smlBinary, offset, &entry->objName, &entry->obis) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &entry->unit) ||
 		SML_PARSE_ERROR == p_sml_parse_integer8(smlBinary, offset, &entry->scaler)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("ProfObjHeaderEntry");
 	}
 
 	return SML_PARSE_OK;
@@ -740,7 +1459,7 @@ uint8_t p_sml_parse_objperiodentry(const unsigned char* smlBinary, uint32_t* off
 		SML_PARSE_ERROR == p_sml_parse_unsigned64(smlBinary, offset, &entry->status) ||
 		SML_PARSE_ERROR == p_sml_parse_list_of_valueentry(smlBinary, offset, &entry->value_List) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->periodSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("ProfObjPeriodEntry");
 	}
 
 	return SML_PARSE_OK;
@@ -749,58 +1468,92 @@ uint8_t p_sml_parse_objperiodentry(const unsigned char* smlBinary, uint32_t* off
 uint8_t p_sml_parse_procparvalue_optional(const unsigned char* smlBinary, uint32_t* offset, SML_ProcParValue** value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("ProcParValue");
 	}
 	if(tl_type == STRING && tl_value == 0) {
 		*value = NULL;
 		return SML_PARSE_OK;
 	}
 	if(tl_type != LIST || tl_value != 2) {
-		return SML_PARSE_ERROR;
+		p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+		return p_sml_parse_failed("ProcParValue");
 	}
 
-	*value = (SML_ProcParValue*)calloc(1, sizeof(SML_ProcParValue));
+	*value = (SML_ProcParValue*)p_sml_calloc(1, sizeof(SML_ProcParValue));
+	if(*value == NULL) {
+		return p_sml_parse_failed("ProcParValue");
+	}
 	p_sml_add_pointer(*value);
 
-	if(p_sml_parse_unsigned8(smlBinary, offset, &((*value)->choiceTag)) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+	*offset = offsetRef;
+	return p_sml_parse_procparvalue(smlBinary, offset, *value);
+}
+
+uint8_t p_sml_parse_procparvalue(const unsigned char* smlBinary, uint32_t* offset, SML_ProcParValue* value) {
+	uint32_t offsetRef = *offset;
+	uint8_t retValue;
+
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 2) ||
+		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &value->choiceTag)) {
+		return p_sml_parse_failed("ProcParValue");
 	}
 
-	switch((*value)->choiceTag) {
+	switch(value->choiceTag) {
 		case SML_PROCPAR_VALUE:
-			(*value)->choiceValue.smlValue = (SML_Value*)calloc(1, sizeof(SML_Value));
-			p_sml_add_pointer((*value)->choiceValue.smlValue);
-		return p_sml_parse_value(smlBinary, offset, (*value)->choiceValue.smlValue);
+			value->choiceValue.smlValue = (SML_Value*)p_sml_calloc(1, sizeof(SML_Value));
+			if(value->choiceValue.smlValue == NULL) {
+				return p_sml_parse_failed("ProcParValue");
+			}
+			p_sml_add_pointer(value->choiceValue.smlValue);
+			retValue = p_sml_parse_value(smlBinary, offset, value->choiceValue.smlValue);
+		break;
 
 		case SML_PROCPAR_PERIOD:
-			(*value)->choiceValue.smlPeriodEntry = (SML_PeriodEntry*)calloc(1, sizeof(SML_PeriodEntry));
-			p_sml_add_pointer((*value)->choiceValue.smlPeriodEntry);
-		return p_sml_parse_periodentry(smlBinary, offset, (*value)->choiceValue.smlPeriodEntry);
+			value->choiceValue.smlPeriodEntry = (SML_PeriodEntry*)p_sml_calloc(1, sizeof(SML_PeriodEntry));
+			if(value->choiceValue.smlPeriodEntry == NULL) {
+				return p_sml_parse_failed("ProcParValue");
+			}
+			p_sml_add_pointer(value->choiceValue.smlPeriodEntry);
+			retValue = p_sml_parse_periodentry(smlBinary, offset, value->choiceValue.smlPeriodEntry);
+		break;
 
 		case SML_PROCPAR_TUPEL:
-			(*value)->choiceValue.smlTupelEntry = (SML_TupelEntry*)calloc(1, sizeof(SML_TupelEntry));
-			p_sml_add_pointer((*value)->choiceValue.smlTupelEntry);
-		return p_sml_parse_tupelentry(smlBinary, offset, (*value)->choiceValue.smlTupelEntry);
+			value->choiceValue.smlTupelEntry = (SML_TupelEntry*)p_sml_calloc(1, sizeof(SML_TupelEntry));
+			if(value->choiceValue.smlTupelEntry == NULL) {
+				return p_sml_parse_failed("ProcParValue");
+			}
+			p_sml_add_pointer(value->choiceValue.smlTupelEntry);
+			retValue = p_sml_parse_tupelentry(smlBinary, offset, value->choiceValue.smlTupelEntry);
+		break;
 
 		case SML_PROCPAR_TIME:
-			(*value)->choiceValue.smlTime = (SML_Time*)calloc(1, sizeof(SML_Time));
-			p_sml_add_pointer((*value)->choiceValue.smlTime);
-		return p_sml_parse_time(smlBinary, offset, (*value)->choiceValue.smlTime);
+			value->choiceValue.smlTime = (SML_Time*)p_sml_calloc(1, sizeof(SML_Time));
+			if(value->choiceValue.smlTime == NULL) {
+				return p_sml_parse_failed("ProcParValue");
+			}
+			p_sml_add_pointer(value->choiceValue.smlTime);
+			retValue = p_sml_parse_time(smlBinary, offset, value->choiceValue.smlTime);
+		break;
 
-		default: return SML_PARSE_ERROR;
+		default:
+			p_sml_parse_error(SML_ERROR_CHOICE, offsetRef);
+			return p_sml_parse_failed("ProcParValue");
 	}
+
+	return (retValue == SML_PARSE_OK) ? SML_PARSE_OK : p_sml_parse_failed("ProcParValue");
 }
 
 uint8_t p_sml_parse_periodentry(const unsigned char* smlBinary, uint32_t* offset, SML_PeriodEntry* entry) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 5) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->objName) ||
+		SML_PARSE_ERROR == p_sml_parse_objname(smlBinary, offset, &entry->objName, &entry->obis) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &entry->unit) ||
 		SML_PARSE_ERROR == p_sml_parse_integer8(smlBinary, offset, &entry->scaler) ||
 		SML_PARSE_ERROR == p_sml_parse_value(smlBinary, offset, &entry->value) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->valueSignature)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("PeriodEntry");
 	}
 
 	return SML_PARSE_OK;
@@ -808,7 +1561,7 @@ uint8_t p_sml_parse_periodentry(const unsigned char* smlBinary, uint32_t* offset
 
 uint8_t p_sml_parse_tupelentry(const unsigned char* smlBinary, uint32_t* offset, SML_TupelEntry* entry) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 23) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->serverId) ||
+		SML_PARSE_ERROR == p_sml_parse_string_interned(smlBinary, offset, &entry->serverId) ||
 		SML_PARSE_ERROR == p_sml_parse_time(smlBinary, offset, &entry->secIndex) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned64(smlBinary, offset, &entry->status) ||
 
@@ -839,7 +1592,7 @@ uint8_t p_sml_parse_tupelentry(const unsigned char* smlBinary, uint32_t* offset,
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->signature_pA_R1_R4) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->signature_mA_R2_R3)
 	) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("TupelEntry");
 	}
 
 	return SML_PARSE_OK;
@@ -848,16 +1601,20 @@ uint8_t p_sml_parse_tupelentry(const unsigned char* smlBinary, uint32_t* offset,
 uint8_t p_sml_parse_list(const unsigned char* smlBinary, uint32_t* offset, SML_List* list) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 	uint32_t i;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
 	if(tl_type != LIST || tl_value == 0) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	list->listSize = tl_value;
-	list->valListEntry = (SML_ListEntry*)calloc(tl_value, sizeof(SML_ListEntry));
+	list->valListEntry = (SML_ListEntry*)p_sml_calloc(tl_value, sizeof(SML_ListEntry));
+	if(list->valListEntry == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(list->valListEntry);
 	for(i=0; i<tl_value; i++) {
 		if(p_sml_parse_listentry(smlBinary, offset, list->valListEntry+i) == SML_PARSE_ERROR) {
@@ -870,15 +1627,79 @@ uint8_t p_sml_parse_list(const unsigned char* smlBinary, uint32_t* offset, SML_L
 
 uint8_t p_sml_parse_listentry(const unsigned char* smlBinary, uint32_t* offset, SML_ListEntry* entry) {
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 7) ||
-		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->objName) ||
+		SML_PARSE_ERROR == p_sml_parse_objname(smlBinary, offset, &entry->objName, &entry->obis) ||
 		SML_PARSE_ERROR == p_sml_parse_status_optional(smlBinary, offset, &entry->status) ||
 		SML_PARSE_ERROR == p_sml_parse_time_optional(smlBinary, offset, &entry->valTime) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8_optional(smlBinary, offset, &entry->unit) ||
 		SML_PARSE_ERROR == p_sml_parse_integer8_optional(smlBinary, offset, &entry->scaler) ||
 		SML_PARSE_ERROR == p_sml_parse_value(smlBinary, offset, &entry->value) ||
 		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->valueSignature)) {
+		return p_sml_parse_failed("ListEntry");
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_list_compact(const unsigned char* smlBinary, uint32_t* offset, SML_List_Compact* list) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
+	uint32_t i;
+
+	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type != LIST || tl_value == 0) {
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+	}
+	list->listSize = tl_value;
+	list->valListEntry = (SML_ListEntry_Compact*)p_sml_calloc(tl_value, sizeof(SML_ListEntry_Compact));
+	if(list->valListEntry == NULL) {
 		return SML_PARSE_ERROR;
 	}
+	p_sml_add_pointer(list->valListEntry);
+	for(i=0; i<tl_value; i++) {
+		if(p_sml_parse_listentry_compact(smlBinary, offset, list->valListEntry+i) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_parse_listentry_compact(const unsigned char* smlBinary, uint32_t* offset, SML_ListEntry_Compact* entry) {
+	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 7) ||
+		SML_PARSE_ERROR == p_sml_parse_objname(smlBinary, offset, &entry->objName, &entry->obis)) {
+		return p_sml_parse_failed("ListEntry");
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		entry->present |= SML_LISTENTRY_STATUS;
+		if(p_sml_parse_status(smlBinary, offset, &entry->status) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("ListEntry");
+		}
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		entry->present |= SML_LISTENTRY_VALTIME;
+		if(p_sml_parse_time(smlBinary, offset, &entry->valTime) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("ListEntry");
+		}
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		entry->present |= SML_LISTENTRY_UNIT;
+		if(p_sml_parse_unsigned8(smlBinary, offset, &entry->unit) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("ListEntry");
+		}
+	}
+	if(!p_sml_parse_absent(smlBinary, offset)) {
+		entry->present |= SML_LISTENTRY_SCALER;
+		if(p_sml_parse_integer8(smlBinary, offset, &entry->scaler) == SML_PARSE_ERROR) {
+			return p_sml_parse_failed("ListEntry");
+		}
+	}
+	if(	SML_PARSE_ERROR == p_sml_parse_value(smlBinary, offset, &entry->value) ||
+		SML_PARSE_ERROR == p_sml_parse_string(smlBinary, offset, &entry->valueSignature)) {
+		return p_sml_parse_failed("ListEntry");
+	}
 
 	return SML_PARSE_OK;
 }
@@ -912,16 +1733,16 @@ uint8_t p_sml_parse_value(const unsigned char* smlBinary, uint32_t* offset, SML_
 			value->choiceTag = SML_VALUE_INT16;
 			return p_sml_parse_integer16(smlBinary, offset, &value->choiceValue.int16);
 		}
-		else if(tl_value == 4) {
+		else if(tl_value <= 4) {
 			value->choiceTag = SML_VALUE_INT32;
 			return p_sml_parse_integer32(smlBinary, offset, &value->choiceValue.int32);
 		}
-		else if(tl_value == 8) {
+		else if(tl_value <= 8) {
 			value->choiceTag = SML_VALUE_INT64;
 			return p_sml_parse_integer64(smlBinary, offset, &value->choiceValue.int64);
 		}
 		else {
-			return SML_PARSE_ERROR;
+			return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 		}
 	}
 	else if(tl_type == UNSIGNED) {
@@ -933,24 +1754,38 @@ uint8_t p_sml_parse_value(const unsigned char* smlBinary, uint32_t* offset, SML_
 			value->choiceTag = SML_VALUE_UINT16;
 			return p_sml_parse_unsigned16(smlBinary, offset, &value->choiceValue.uint16);
 		}
-		else if(tl_value == 4) {
+		else if(tl_value <= 4) {
 			value->choiceTag = SML_VALUE_UINT32;
 			return p_sml_parse_unsigned32(smlBinary, offset, &value->choiceValue.uint32);
 		}
-		else if(tl_value == 8) {
+		else if(tl_value <= 8) {
 			value->choiceTag = SML_VALUE_UINT64;
 			return p_sml_parse_unsigned64(smlBinary, offset, &value->choiceValue.uint64);
 		}
 		else {
-			return SML_PARSE_ERROR;
+			return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 		}
 	}
 	else {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 }
 
 uint8_t p_sml_parse_status_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Status** status) {
+	if(p_sml_parse_absent(smlBinary, offset)) {
+		*status = NULL;
+		return SML_PARSE_OK;
+	}
+	*status = (SML_Status*)p_sml_calloc(1, sizeof(SML_Status));
+	if(*status == NULL) {
+		return SML_PARSE_ERROR;
+	}
+	p_sml_add_pointer(*status);
+
+	return p_sml_parse_status(smlBinary, offset, *status);
+}
+
+uint8_t p_sml_parse_status(const unsigned char* smlBinary, uint32_t* offset, SML_Status* status) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
 	uint32_t offsetRef = *offset;
@@ -958,85 +1793,92 @@ uint8_t p_sml_parse_status_optional(const unsigned char* smlBinary, uint32_t* of
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
-	if(tl_type == STRING && tl_value == 0) {
-		*status = NULL;
-		return SML_PARSE_OK;
-	}
 	if(tl_type != UNSIGNED) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	*offset = offsetRef;
-	*status = (SML_Status*)calloc(1, sizeof(SML_Status));
-	p_sml_add_pointer(*status);
 	if(tl_value == 1) {
-		(*status)->choiceTag = SML_STATUS_UINT8;
-		return p_sml_parse_unsigned8(smlBinary, offset, &((*status)->choiceValue.uint8));
+		status->choiceTag = SML_STATUS_UINT8;
+		return p_sml_parse_unsigned8(smlBinary, offset, &status->choiceValue.uint8);
 	}
 	else if(tl_value == 2) {
-		(*status)->choiceTag = SML_STATUS_UINT16;
-		return p_sml_parse_unsigned16(smlBinary, offset, &((*status)->choiceValue.uint16));
+		status->choiceTag = SML_STATUS_UINT16;
+		return p_sml_parse_unsigned16(smlBinary, offset, &status->choiceValue.uint16);
 	}
-	else if(tl_value == 4) {
-		(*status)->choiceTag = SML_STATUS_UINT32;
-		return p_sml_parse_unsigned32(smlBinary, offset, &((*status)->choiceValue.uint32));
+	else if(tl_value <= 4) {
+		status->choiceTag = SML_STATUS_UINT32;
+		return p_sml_parse_unsigned32(smlBinary, offset, &status->choiceValue.uint32);
 	}
-	else if(tl_value == 8) {
-		(*status)->choiceTag = SML_STATUS_UINT64;
-		return p_sml_parse_unsigned64(smlBinary, offset, &((*status)->choiceValue.uint64));
+	else if(tl_value <= 8) {
+		status->choiceTag = SML_STATUS_UINT64;
+		return p_sml_parse_unsigned64(smlBinary, offset, &status->choiceValue.uint64);
 	}
 	else {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 }
 
 uint8_t p_sml_parse_time(const unsigned char* smlBinary, uint32_t* offset, SML_Time* time) {
 	uint8_t retValue;
+	uint32_t offsetRef = *offset;
 
 	if(	SML_PARSE_ERROR == p_sml_parse_listsize(smlBinary, offset, 2) ||
 		SML_PARSE_ERROR == p_sml_parse_unsigned8(smlBinary, offset, &time->choiceTag)) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Time");
 	}
 	switch(time->choiceTag) {
 		case SML_TIME_SECINDEX: retValue = p_sml_parse_unsigned32(smlBinary, offset, &time->choiceValue.secIndex); break;
 		case SML_TIME_TIMESTAMP: retValue = p_sml_parse_unsigned32(smlBinary, offset, &time->choiceValue.timestamp); break;
-		default: return SML_PARSE_ERROR;
+		default:
+			p_sml_parse_error(SML_ERROR_CHOICE, offsetRef);
+			return p_sml_parse_failed("Time");
 	}
 
-	return retValue;
+	return (retValue == SML_PARSE_OK) ? SML_PARSE_OK : p_sml_parse_failed("Time");
 }
 
 uint8_t p_sml_parse_time_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Time** time) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint8_t retValue;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Time");
 	}
 	if(tl_type == STRING && tl_value == 0) {
 		*time = NULL;
 		return SML_PARSE_OK;
 	}
 	if(tl_type != LIST || tl_value != 2) {
-		return SML_PARSE_ERROR;
+		p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
+		return p_sml_parse_failed("Time");
 	}
 
-	*time = (SML_Time*)calloc(1, sizeof(SML_Time));
+	*time = (SML_Time*)p_sml_calloc(1, sizeof(SML_Time));
+	if(*time == NULL) {
+		return p_sml_parse_failed("Time");
+	}
 	p_sml_add_pointer(*time);
 
 	if(p_sml_parse_unsigned8(smlBinary, offset, &((*time)->choiceTag)) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_failed("Time");
 	}
 	switch((*time)->choiceTag) {
-		case SML_TIME_SECINDEX: return p_sml_parse_unsigned32(smlBinary, offset, &((*time)->choiceValue.secIndex));
-		case SML_TIME_TIMESTAMP: return p_sml_parse_unsigned32(smlBinary, offset, &((*time)->choiceValue.timestamp));
-		default: return SML_PARSE_ERROR;
+		case SML_TIME_SECINDEX: retValue = p_sml_parse_unsigned32(smlBinary, offset, &((*time)->choiceValue.secIndex)); break;
+		case SML_TIME_TIMESTAMP: retValue = p_sml_parse_unsigned32(smlBinary, offset, &((*time)->choiceValue.timestamp)); break;
+		default:
+			p_sml_parse_error(SML_ERROR_CHOICE, offsetRef);
+			return p_sml_parse_failed("Time");
 	}
-	return SML_PARSE_OK;
+
+	return (retValue == SML_PARSE_OK) ? SML_PARSE_OK : p_sml_parse_failed("Time");
 }
 
 uint8_t p_sml_parse_string(const unsigned char* smlBinary, uint32_t* offset, char** value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
@@ -1052,13 +1894,16 @@ uint8_t p_sml_parse_string(const unsigned char* smlBinary, uint32_t* offset, cha
 		return SML_PARSE_ERROR;
 	}*/
 	if(tl_type != STRING) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	/* Allocate memory */
-	*value = (char*)calloc(tl_value+1, sizeof(char));
+	*value = (char*)p_sml_calloc(tl_value+1, sizeof(char));
+	if(*value == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(*value);
 	/* Read value */
-	memmove(
+	p_sml_memcpy(
 		*value,
 		((char*)(smlBinary+*offset)),
 		tl_value
@@ -1069,9 +1914,50 @@ uint8_t p_sml_parse_string(const unsigned char* smlBinary, uint32_t* offset, cha
 	return SML_PARSE_OK;
 }
 
+uint8_t p_sml_parse_string_interned(const unsigned char* smlBinary, uint32_t* offset, char** value) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
+
+	if(p_sml_context->internTable != NULL) {
+		if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+		if(tl_type == STRING && tl_value > 0) {
+			*value = sml_intern(p_sml_context->internTable, (const char*)(smlBinary+*offset), tl_value);
+			if(*value != NULL) {
+				*offset += tl_value;
+				return SML_PARSE_OK;
+			}
+		}
+		/* Table full, empty or invalid field: parse as usual */
+		*offset = offsetRef;
+	}
+	return p_sml_parse_string(smlBinary, offset, value);
+}
+
+uint8_t p_sml_parse_objname(const unsigned char* smlBinary, uint32_t* offset, char** objName, SML_Obis* obis) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
+
+	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type == STRING && tl_value == SML_OBIS_LENGTH) {
+		sml_obis_set(obis, smlBinary+*offset);
+	}
+	else {
+		obis->id = SML_OBIS_NONE;
+	}
+	*offset = offsetRef;
+	return p_sml_parse_string_interned(smlBinary, offset, objName);
+}
+
 uint8_t p_sml_parse_boolean(const unsigned char* smlBinary, uint32_t* offset, SML_Boolean* value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	/*if(p_sml_parse_listsize(smlBinary, offset, 2) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
@@ -1085,7 +1971,7 @@ uint8_t p_sml_parse_boolean(const unsigned char* smlBinary, uint32_t* offset, SM
 		*offset += 1;
 	}
 	else {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 
 	return SML_PARSE_OK;
@@ -1094,6 +1980,7 @@ uint8_t p_sml_parse_boolean(const unsigned char* smlBinary, uint32_t* offset, SM
 uint8_t p_sml_parse_boolean_optional(const unsigned char* smlBinary, uint32_t* offset, SML_Boolean** value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
@@ -1110,10 +1997,13 @@ uint8_t p_sml_parse_boolean_optional(const unsigned char* smlBinary, uint32_t* o
 	}
 	*/
 	if(tl_type != BOOLEAN || tl_value != 1) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	/* Read value */
-	*value = (SML_Boolean*)calloc(1, sizeof(SML_Boolean));
+	*value = (SML_Boolean*)p_sml_calloc(1, sizeof(SML_Boolean));
+	if(*value == NULL) {
+		return SML_PARSE_ERROR;
+	}
 	p_sml_add_pointer(*value);
 	**value = *((SML_Boolean*)(smlBinary+*offset));
 	*offset += 1;
@@ -1124,40 +2014,18 @@ uint8_t p_sml_parse_boolean_optional(const unsigned char* smlBinary, uint32_t* o
 uint8_t p_sml_parse_integer(const unsigned char* smlBinary, uint32_t size, uint32_t* offset, void* value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
-	/*if(p_sml_parse_listsize(smlBinary, offset, 2) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
-	}*/
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
-	/* Read value */
-	if(tl_type == INTEGER && tl_value <= size) {
-		if(tl_value == 1) {
-			*((int8_t*)value) = *((int8_t*)(smlBinary+*offset));
-		}
-		else if(tl_value == 2) {
-			*((int16_t*)value) = *((int16_t*)(smlBinary+*offset));
-			if(bigendian_check() == FALSE) {
-				endian_swap16((uint16_t*)value);
-			}
-		}
-		else if(tl_value == 4) {
-			*((int32_t*)value) = *((int32_t*)(smlBinary+*offset));
-			if(bigendian_check() == FALSE) {
-				endian_swap32((uint32_t*)value);
-			}
-		}
-		else if(tl_value == 8) {
-			*((int64_t*)value) = *((int64_t*)(smlBinary+*offset));
-			if(bigendian_check() == FALSE) {
-				endian_swap64((uint64_t*)value);
-			}
-		}
+	/* Read value (shortened encodings are sign-extended to the field size) */
+	if(tl_type == INTEGER && tl_value > 0 && tl_value <= size) {
+		p_sml_store_number(value, size, p_sml_read_number(smlBinary+*offset, tl_value, INTEGER));
 		*offset += tl_value;
 	}
 	else {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 
 	return SML_PARSE_OK;
@@ -1182,40 +2050,18 @@ uint8_t p_sml_parse_integer64(const unsigned char* smlBinary, uint32_t* offset,
 uint8_t p_sml_parse_unsigned(const unsigned char* smlBinary, uint32_t size, uint32_t* offset, void* value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
-	/*if(p_sml_parse_listsize(smlBinary, offset, 2) == SML_PARSE_ERROR) {
-		return SML_PARSE_ERROR;
-	}*/
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
-	/* Read value */
-	if(tl_type == UNSIGNED && tl_value <= size) {
-		if(tl_value == 1) {
-			*((uint8_t*)value) = *((uint8_t*)(smlBinary+*offset));
-		}
-		else if(tl_value == 2) {
-			*((uint16_t*)value) = *((uint16_t*)(smlBinary+*offset));
-			if(bigendian_check() == FALSE) {
-				endian_swap16((uint16_t*)value);
-			}
-		}
-		else if(tl_value == 4) {
-			*((uint32_t*)value) = *((uint32_t*)(smlBinary+*offset));
-			if(bigendian_check() == FALSE) {
-				endian_swap32((uint32_t*)value);
-			}
-		}
-		else if(tl_value == 8) {
-			*((uint64_t*)value) = *((uint64_t*)(smlBinary+*offset));
-			if(bigendian_check() == FALSE) {
-				endian_swap64((uint64_t*)value);
-			}
-		}
+	/* Read value (shortened encodings are zero-extended to the field size) */
+	if(tl_type == UNSIGNED && tl_value > 0 && tl_value <= size) {
+		p_sml_store_number(value, size, p_sml_read_number(smlBinary+*offset, tl_value, UNSIGNED));
 		*offset += tl_value;
 	}
 	else {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 
 	return SML_PARSE_OK;
@@ -1240,6 +2086,7 @@ uint8_t p_sml_parse_unsigned64(const unsigned char* smlBinary, uint32_t* offset,
 uint8_t p_sml_parse_integer_optional(const unsigned char* smlBinary, uint32_t size, uint32_t* offset, void** value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
@@ -1255,33 +2102,16 @@ uint8_t p_sml_parse_integer_optional(const unsigned char* smlBinary, uint32_t si
 		return SML_PARSE_ERROR;
 	}
 	*/
-	if(tl_type != INTEGER || tl_value > size) {
-		return SML_PARSE_ERROR;
+	if(tl_type != INTEGER || tl_value == 0 || tl_value > size) {
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	/* Read value */
-	*value = calloc(size, sizeof(int8_t));
-	p_sml_add_pointer(*value);
-	if(tl_value == 1) {
-		**((int8_t**)value) = *((int8_t*)(smlBinary+*offset));
-	}
-	else if(tl_value == 2) {
-		**((int16_t**)value) = *((int16_t*)(smlBinary+*offset));
-		if(bigendian_check() == FALSE) {
-			endian_swap16(*((uint16_t**)value));
-		}
-	}
-	else if(tl_value == 4) {
-		**((int32_t**)value) = *((int32_t*)(smlBinary+*offset));
-		if(bigendian_check() == FALSE) {
-			endian_swap32(*((uint32_t**)value));
-		}
-	}
-	else if(tl_value == 8) {
-		**((int64_t**)value) = *((int64_t*)(smlBinary+*offset));
-		if(bigendian_check() == FALSE) {
-			endian_swap64(*((uint64_t**)value));
-		}
+	*value = p_sml_calloc(size, sizeof(int8_t));
+	if(*value == NULL) {
+		return SML_PARSE_ERROR;
 	}
+	p_sml_add_pointer(*value);
+	p_sml_store_number(*value, size, p_sml_read_number(smlBinary+*offset, tl_value, INTEGER));
 	*offset += tl_value;
 
 	return SML_PARSE_OK;
@@ -1306,6 +2136,7 @@ uint8_t p_sml_parse_integer64_optional(const unsigned char* smlBinary, uint32_t*
 uint8_t p_sml_parse_unsigned_optional(const unsigned char* smlBinary, uint32_t size, uint32_t* offset, void** value) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
@@ -1320,33 +2151,16 @@ uint8_t p_sml_parse_unsigned_optional(const unsigned char* smlBinary, uint32_t s
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}*/
-	if(tl_type != UNSIGNED || tl_value > size) {
-		return SML_PARSE_ERROR;
+	if(tl_type != UNSIGNED || tl_value == 0 || tl_value > size) {
+		return p_sml_parse_error(SML_ERROR_TYPE, offsetRef);
 	}
 	/* Read value */
-	*value = calloc(size, sizeof(uint8_t));
-	p_sml_add_pointer(*value);
-	if(tl_value == 1) {
-		**((uint8_t**)value) = *((uint8_t*)(smlBinary+*offset));
-	}
-	else if(tl_value == 2) {
-		**((uint16_t**)value) = *((uint16_t*)(smlBinary+*offset));
-		if(bigendian_check() == FALSE) {
-			endian_swap16(*((uint16_t**)value));
-		}
-	}
-	else if(tl_value == 4) {
-		**((uint32_t**)value) = *((uint32_t*)(smlBinary+*offset));
-		if(bigendian_check() == FALSE) {
-			endian_swap32(*((uint32_t**)value));
-		}
-	}
-	else if(tl_value == 8) {
-		**((uint64_t**)value) = *((uint64_t*)(smlBinary+*offset));
-		if(bigendian_check() == FALSE) {
-			endian_swap64(*((uint64_t**)value));
-		}
+	*value = p_sml_calloc(size, sizeof(uint8_t));
+	if(*value == NULL) {
+		return SML_PARSE_ERROR;
 	}
+	p_sml_add_pointer(*value);
+	p_sml_store_number(*value, size, p_sml_read_number(smlBinary+*offset, tl_value, UNSIGNED));
 	*offset += tl_value;
 
 	return SML_PARSE_OK;
@@ -1368,6 +2182,45 @@ uint8_t p_sml_parse_unsigned64_optional(const unsigned char* smlBinary, uint32_t
 	return p_sml_parse_unsigned_optional(smlBinary, sizeof(uint64_t), offset, (void**)value);
 }
 
+uint64_t p_sml_read_number(const unsigned char* data, uint32_t length, TL_FieldType type) {
+	uint64_t number = 0;
+	uint32_t i;
+
+	/* Sign-extend negative Integer values */
+	if(type == INTEGER && (data[0] & 0x80) == 0x80) {
+		number = ~((uint64_t)0);
+	}
+	for(i=0; i<length; i++) {
+		number = (number << 8) | data[i];
+	}
+
+	return number;
+}
+
+void p_sml_store_number(void* value, uint32_t size, uint64_t number) {
+	if(size == sizeof(uint8_t)) {
+		*((uint8_t*)value) = (uint8_t)number;
+	}
+	else if(size == sizeof(uint16_t)) {
+		*((uint16_t*)value) = (uint16_t)number;
+	}
+	else if(size == sizeof(uint32_t)) {
+		*((uint32_t*)value) = (uint32_t)number;
+	}
+	else if(size == sizeof(uint64_t)) {
+		*((uint64_t*)value) = number;
+	}
+}
+
+SML_Boolean p_sml_parse_absent(const unsigned char* smlBinary, uint32_t* offset) {
+	/* An omitted optional field is an empty octet string (TL byte 0x01) */
+	if(smlBinary[*offset] == 0x01) {
+		(*offset)++;
+		return TRUE;
+	}
+	return FALSE;
+}
+
 uint8_t p_sml_parse_tlfield(const unsigned char* smlBinary, uint32_t* offset, TL_FieldType* tl_type, uint32_t* tl_value) {
 	char typeBits = (smlBinary[*offset] & 0x70);
 	uint32_t i = 0;
@@ -1389,6 +2242,7 @@ uint8_t p_sml_parse_tlfield(const unsigned char* smlBinary, uint32_t* offset, TL
 		*tl_type = LIST;
 	}
 	else {
+		p_sml_parse_error(SML_ERROR_TL, *offset);
 		return SML_PARSE_ERROR;
 	}
 
@@ -1417,31 +2271,53 @@ uint8_t p_sml_parse_tlfield(const unsigned char* smlBinary, uint32_t* offset, TL
 uint8_t p_sml_parse_listsize(const unsigned char* smlBinary, uint32_t* offset, uint32_t listSize) {
 	TL_FieldType tl_type;
 	uint32_t tl_value;
+	uint32_t offsetRef = *offset;
 
 	if(p_sml_parse_tlfield(smlBinary, offset, &tl_type, &tl_value) == SML_PARSE_ERROR) {
 		return SML_PARSE_ERROR;
 	}
 	else if(tl_type != LIST || tl_value != listSize) {
-		return SML_PARSE_ERROR;
+		return p_sml_parse_error(SML_ERROR_LISTSIZE, offsetRef);
 	}
 	else {
 		return SML_PARSE_OK;
 	}
 }
 
-void p_sml_add_pointer(void* ptr) {
-	if(p_sml_pointer_list == NULL) {
-		p_sml_pointer_list = (void**)calloc(20, sizeof(void*));
-		p_sml_pointer_max  = 20;
+void* p_sml_parser_calloc(size_t count, size_t size) {
+	void* ptr = p_sml_calloc(count, size);
+
+	if(ptr != NULL) {
+		p_sml_add_pointer(ptr);
+		if(p_sml_context->outOfMemory) {
+			/* The pointer list could not grow, sml_parser_free() would miss ptr */
+			p_sml_free(ptr);
+			ptr = NULL;
+		}
 	}
-	if((p_sml_pointer_count+1) > p_sml_pointer_max) {
-		p_sml_pointer_list = (void**)realloc(p_sml_pointer_list, (p_sml_pointer_count+5)*sizeof(void*));
-		p_sml_pointer_max  = p_sml_pointer_count+5;
+	if(ptr == NULL) {
+		p_sml_context->error.code = SML_ERROR_NOMEM;
 	}
-	p_sml_pointer_list[p_sml_pointer_count] = ptr;
-	p_sml_pointer_count++;
+	return ptr;
 }
 
-uint32_t p_sml_pointer_max = 0;
-uint32_t p_sml_pointer_count = 0;
-void** p_sml_pointer_list = NULL;
+void p_sml_add_pointer(void* ptr) {
+	void** pointerList;
+
+	/* Pool blocks are released all at once by sml_parser_free() */
+	if(p_sml_context->pool.base != NULL) {
+		return;
+	}
+	if((p_sml_context->pointerCount+1) > p_sml_context->pointerMax) {
+		pointerList = (void**)p_sml_realloc(p_sml_context->pointerList, p_sml_context->pointerMax*sizeof(void*),
+			((p_sml_context->pointerMax > 0) ? p_sml_context->pointerMax*2 : 20)*sizeof(void*));
+		if(pointerList == NULL) {
+			/* Keep the list intact, ptr is not released by sml_parser_free() */
+			return;
+		}
+		p_sml_context->pointerList = pointerList;
+		p_sml_context->pointerMax  = (p_sml_context->pointerMax > 0) ? p_sml_context->pointerMax*2 : 20;
+	}
+	p_sml_context->pointerList[p_sml_context->pointerCount] = ptr;
+	p_sml_context->pointerCount++;
+}
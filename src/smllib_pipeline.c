@@ -0,0 +1,382 @@
+/**
+ * File name: smllib_pipeline.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* nanosleep() and sched_yield() in C89 mode */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+#include "smllib_pipeline.h"
+#include "smllib_parse.h"
+#include "smllib_validate.h"
+#include "smllib_tools.h"
+
+/* Every worker parses with its own active context */
+#ifndef SMLLIB_THREAD_CONTEXT
+	#error "the pipeline needs SMLLIB_THREAD_CONTEXT"
+#endif
+
+/* Idle rounds spent spinning and yielding before a thread starts to sleep */
+#define SML_PIPELINE_SPIN 64
+#define SML_PIPELINE_YIELD 256
+#define SML_PIPELINE_SLEEP_NS 50000L
+
+#define SML_PIPELINE_ALIGN(size) (((size) + SML_CACHE_LINE - 1) & ~(size_t)(SML_CACHE_LINE - 1))
+
+SML_Boolean sml_ring_push(SML_Ring* ring, void* item) {
+	uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+	if(head - ring->tailCache > ring->mask) {
+		ring->tailCache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if(head - ring->tailCache > ring->mask) {
+			return FALSE;
+		}
+	}
+	ring->slots[head & ring->mask] = item;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+SML_Boolean sml_ring_pop(SML_Ring* ring, void** item) {
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+	if(tail == ring->headCache) {
+		ring->headCache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		if(tail == ring->headCache) {
+			return FALSE;
+		}
+	}
+	*item = ring->slots[tail & ring->mask];
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+size_t sml_pipeline_memory_size(const SML_Pipeline_Config* config) {
+	return p_sml_pipeline_layout(NULL, config, NULL);
+}
+
+uint8_t sml_pipeline_init(SML_Pipeline* pipeline, const SML_Pipeline_Config* config, void* memory) {
+	uint32_t i;
+
+	if(memory == NULL || p_sml_pipeline_layout(NULL, config, NULL) == 0) {
+		return SML_PARSE_ERROR;
+	}
+	p_sml_memset(pipeline, 0, sizeof(SML_Pipeline));
+	pipeline->config = *config;
+	for(i=0; i<config->workers; i++) {
+		sml_context_init(&pipeline->workers[i].context);
+		pipeline->workers[i].pipeline = pipeline;
+	}
+	for(i=0; i<config->exporters; i++) {
+		pipeline->exporters[i].pipeline = pipeline;
+		pipeline->exporters[i].index = i;
+	}
+	p_sml_pipeline_layout(pipeline, config, (unsigned char*)memory);
+
+	/* All frames start out free, before any thread could see the rings */
+	for(i=0; i<config->frames; i++) {
+		sml_ring_push(&pipeline->exporters[i % config->exporters].free, &pipeline->frames[i]);
+	}
+	return SML_PARSE_OK;
+}
+
+uint8_t sml_pipeline_start(SML_Pipeline* pipeline) {
+	uint32_t i;
+
+	for(i=0; i<pipeline->config.workers; i++) {
+		if(pipeline->workers[i].context.internTable != NULL) {
+			return SML_PARSE_ERROR;
+		}
+	}
+	for(i=0; i<pipeline->config.workers; i++) {
+		if(pthread_create(&pipeline->workers[i].thread, NULL, p_sml_pipeline_worker, &pipeline->workers[i]) != 0) {
+			sml_pipeline_stop(pipeline);
+			return SML_PARSE_ERROR;
+		}
+		pipeline->running++;
+	}
+	for(i=0; i<pipeline->config.exporters; i++) {
+		if(pthread_create(&pipeline->exporters[i].thread, NULL, p_sml_pipeline_exporter, &pipeline->exporters[i]) != 0) {
+			sml_pipeline_stop(pipeline);
+			return SML_PARSE_ERROR;
+		}
+		pipeline->running++;
+	}
+	return SML_PARSE_OK;
+}
+
+void sml_pipeline_stop(SML_Pipeline* pipeline) {
+	uint32_t workers = pipeline->config.workers;
+	uint32_t i;
+
+	__atomic_store_n(&pipeline->stopping, 1, __ATOMIC_RELEASE);
+	/* Workers are started first, exporters only once all of them run */
+	for(i=0; i<pipeline->running; i++) {
+		if(i < workers) {
+			pthread_join(pipeline->workers[i].thread, NULL);
+		}
+		else {
+			pthread_join(pipeline->exporters[i - workers].thread, NULL);
+		}
+	}
+	pipeline->running = 0;
+}
+
+SML_Pipeline_Frame* sml_pipeline_acquire(SML_Pipeline* pipeline) {
+	uint32_t exporters = pipeline->config.exporters;
+	void* frame;
+	uint32_t i;
+
+	for(i=0; i<exporters; i++) {
+		if(sml_ring_pop(&pipeline->exporters[pipeline->nextFree].free, &frame)) {
+			return (SML_Pipeline_Frame*)frame;
+		}
+		pipeline->nextFree = (pipeline->nextFree + 1) % exporters;
+	}
+	return NULL;
+}
+
+SML_Pipeline_Frame* sml_pipeline_take(SML_Pipeline* pipeline) {
+	SML_Pipeline_Frame* frame;
+	uint32_t idle = 0;
+
+	while((frame = sml_pipeline_acquire(pipeline)) == NULL) {
+		p_sml_pipeline_idle(&idle);
+	}
+	return frame;
+}
+
+void sml_pipeline_submit(SML_Pipeline* pipeline, SML_Pipeline_Frame* frame, uint32_t key) {
+	frame->key = key;
+	/* Every ring holds all frames, a push cannot fail */
+	sml_ring_push(&pipeline->workers[key % pipeline->config.workers].input, frame);
+	pipeline->submitted++;
+}
+
+void sml_pipeline_input_init(SML_Pipeline* pipeline, SML_Pipeline_Input* input, uint32_t key, void* source) {
+	input->frame = sml_pipeline_take(pipeline);
+	input->key = key;
+	input->source = source;
+	sml_deframer_init(&input->deframer, input->frame->data, pipeline->config.frameSize);
+	/* The workers validate, the reader only finds the frames */
+	input->deframer.validate = FALSE;
+}
+
+uint32_t sml_pipeline_input_feed(SML_Pipeline* pipeline, SML_Pipeline_Input* input, const unsigned char* data, uint32_t length) {
+	uint32_t frames = 0;
+	uint32_t taken;
+
+	while(length > 0) {
+		taken = sml_deframer_feed(&input->deframer, data, length);
+		data += taken;
+		length -= taken;
+		frames += sml_pipeline_input_flush(pipeline, input);
+	}
+	return frames;
+}
+
+uint32_t sml_pipeline_input_flush(SML_Pipeline* pipeline, SML_Pipeline_Input* input) {
+	SML_Pipeline_Frame* frame;
+	const unsigned char* data;
+	uint32_t length;
+	uint32_t frames = 0;
+
+	while(sml_deframer_next(&input->deframer, &data, &length) == SML_PARSE_OK) {
+		frame = input->frame;
+		input->frame = sml_pipeline_take(pipeline);
+		/* The frame is at the start of the buffer handed back, i.e. frame->data */
+		sml_deframer_exchange(&input->deframer, input->frame->data);
+		frame->length = length;
+		frame->source = input->source;
+		sml_pipeline_submit(pipeline, frame, input->key);
+		frames++;
+	}
+	return frames;
+}
+
+void sml_pipeline_input_close(SML_Pipeline* pipeline, SML_Pipeline_Input* input) {
+	input->frame->length = 0;
+	input->frame->source = input->source;
+	sml_pipeline_submit(pipeline, input->frame, input->key);
+	input->frame = NULL;
+}
+
+size_t p_sml_pipeline_layout(SML_Pipeline* pipeline, const SML_Pipeline_Config* config, unsigned char* memory) {
+	size_t slotsSize;
+	size_t frameSize;
+	size_t poolSize;
+	size_t size;
+	unsigned char* next;
+	SML_Ring* ring;
+	uint32_t rings;
+	uint32_t i;
+
+	if(config->workers == 0 || config->workers > SML_PIPELINE_MAX_WORKERS
+			|| config->exporters == 0 || config->exporters > config->workers
+			|| config->frames < 2 || (config->frames & (config->frames - 1)) != 0
+			|| config->frameSize < 16 || config->poolSize == 0 || config->exportFrame == NULL) {
+		return 0;
+	}
+	rings = 2 * config->workers + config->exporters;
+	slotsSize = SML_PIPELINE_ALIGN(config->frames * sizeof(void*));
+	frameSize = SML_PIPELINE_ALIGN(config->frameSize);
+	poolSize = SML_PIPELINE_ALIGN(config->poolSize);
+	size = rings * slotsSize + SML_PIPELINE_ALIGN(config->frames * sizeof(SML_Pipeline_Frame))
+		+ config->frames * (frameSize + poolSize);
+	if(memory == NULL) {
+		/* Room to align the start */
+		return size + SML_CACHE_LINE;
+	}
+
+	next = memory + (SML_CACHE_LINE - (size_t)memory % SML_CACHE_LINE) % SML_CACHE_LINE;
+	for(i=0; i<rings; i++) {
+		if(i < config->workers) {
+			ring = &pipeline->workers[i].input;
+		}
+		else if(i < 2 * config->workers) {
+			ring = &pipeline->workers[i - config->workers].output;
+		}
+		else {
+			ring = &pipeline->exporters[i - 2 * config->workers].free;
+		}
+		ring->slots = (void**)next;
+		ring->mask = config->frames - 1;
+		next += slotsSize;
+	}
+	pipeline->frames = (SML_Pipeline_Frame*)next;
+	next += SML_PIPELINE_ALIGN(config->frames * sizeof(SML_Pipeline_Frame));
+	for(i=0; i<config->frames; i++) {
+		p_sml_memset(&pipeline->frames[i], 0, sizeof(SML_Pipeline_Frame));
+		pipeline->frames[i].data = next;
+		pipeline->frames[i].pool = next + frameSize;
+		next += frameSize + poolSize;
+	}
+	return size + SML_CACHE_LINE;
+}
+
+void* p_sml_pipeline_worker(void* arg) {
+	SML_Pipeline_Worker* worker = (SML_Pipeline_Worker*)arg;
+	SML_Pipeline* pipeline = worker->pipeline;
+	uint32_t stopping;
+	uint32_t idle = 0;
+	void* frame;
+
+	sml_context_use(&worker->context);
+	for(;;) {
+		/* Read before the ring: once stopping, an empty ring stays empty */
+		stopping = __atomic_load_n(&pipeline->stopping, __ATOMIC_ACQUIRE);
+		if(sml_ring_pop(&worker->input, &frame)) {
+			p_sml_pipeline_parse(worker, (SML_Pipeline_Frame*)frame);
+			sml_ring_push(&worker->output, frame);
+			idle = 0;
+		}
+		else if(stopping) {
+			break;
+		}
+		else {
+			p_sml_pipeline_idle(&idle);
+		}
+	}
+	sml_context_use(NULL);
+	__atomic_add_fetch(&pipeline->workersDone, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+void* p_sml_pipeline_exporter(void* arg) {
+	SML_Pipeline_Exporter* exporter = (SML_Pipeline_Exporter*)arg;
+	SML_Pipeline* pipeline = exporter->pipeline;
+	SML_Pipeline_Frame* frame;
+	SML_Boolean found;
+	uint32_t done;
+	uint32_t idle = 0;
+	uint32_t w;
+	void* item;
+
+	for(;;) {
+		done = __atomic_load_n(&pipeline->workersDone, __ATOMIC_ACQUIRE);
+		found = FALSE;
+		/* The workers of this exporter, one frame each per round */
+		for(w=exporter->index; w<pipeline->config.workers; w+=pipeline->config.exporters) {
+			if(sml_ring_pop(&pipeline->workers[w].output, &item)) {
+				frame = (SML_Pipeline_Frame*)item;
+				if(frame->length > 0) {
+					pipeline->config.exportFrame(pipeline->config.user, frame);
+					exporter->frames++;
+				}
+				sml_ring_push(&exporter->free, frame);
+				found = TRUE;
+			}
+		}
+		if(found) {
+			idle = 0;
+		}
+		else if(done == pipeline->config.workers) {
+			break;
+		}
+		else {
+			p_sml_pipeline_idle(&idle);
+		}
+	}
+	return NULL;
+}
+
+void p_sml_pipeline_parse(SML_Pipeline_Worker* worker, SML_Pipeline_Frame* frame) {
+	uint32_t offset = 0;
+
+	if(frame->length == 0) {
+		return;
+	}
+	/* The previous message of the frame was exported, its pool is reused (no pool floor, see sml_pipeline_start()) */
+	sml_context_set_pool(&worker->context, frame->pool, worker->pipeline->config.poolSize);
+	/* The deframer checked the frame crc only, the parser relies on the structure */
+	frame->result = sml_transport_validate_message(frame->data, frame->length, &offset);
+	if(frame->result == SML_PARSE_OK && offset != frame->length) {
+		frame->result = SML_PARSE_ERROR;
+	}
+	if(frame->result == SML_PARSE_OK) {
+		offset = 0;
+		frame->result = sml_transport_parse_message(frame->data, &offset, &frame->message);
+	}
+	worker->frames++;
+	if(frame->result != SML_PARSE_OK) {
+		worker->parseErrors++;
+	}
+}
+
+void p_sml_pipeline_idle(uint32_t* idle) {
+	struct timespec pause;
+
+	if(*idle < SML_PIPELINE_SPIN) {
+		(*idle)++;
+	}
+	else if(*idle < SML_PIPELINE_SPIN + SML_PIPELINE_YIELD) {
+		(*idle)++;
+		sched_yield();
+	}
+	else {
+		pause.tv_sec = 0;
+		pause.tv_nsec = SML_PIPELINE_SLEEP_NS;
+		nanosleep(&pause, NULL);
+	}
+}
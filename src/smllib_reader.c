@@ -0,0 +1,184 @@
+/**
+ * File name: smllib_reader.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* read(), fcntl() and errno values in C89 mode */
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "smllib_reader.h"
+#include "smllib_parse.h"
+#include "smllib_tools.h"
+
+uint8_t sml_reader_init(SML_Reader* reader, SML_Reader_Frame_Callback frame, SML_Reader_Message_Callback message, SML_Reader_Closed_Callback closed, void* user) {
+	p_sml_memset(reader, 0, sizeof(SML_Reader));
+	reader->frame = frame;
+	reader->message = message;
+	reader->closed = closed;
+	reader->user = user;
+	reader->epollFd = epoll_create1(EPOLL_CLOEXEC);
+	return (reader->epollFd >= 0) ? SML_PARSE_OK : SML_PARSE_ERROR;
+}
+
+void sml_reader_close(SML_Reader* reader) {
+	if(reader->epollFd >= 0) {
+		close(reader->epollFd);
+	}
+	reader->epollFd = -1;
+	reader->links = 0;
+}
+
+void sml_link_init(SML_Link* link, int fd, unsigned char* buffer, uint32_t size, void* user) {
+	p_sml_memset(link, 0, sizeof(SML_Link));
+	sml_deframer_init(&link->deframer, buffer, size);
+	link->fd = fd;
+	link->user = user;
+}
+
+uint8_t sml_reader_add(SML_Reader* reader, SML_Link* link) {
+	struct epoll_event event;
+	int flags;
+
+	flags = fcntl(link->fd, F_GETFL);
+	if(flags < 0 || fcntl(link->fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		return SML_PARSE_ERROR;
+	}
+
+	p_sml_memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = link;
+	if(epoll_ctl(reader->epollFd, EPOLL_CTL_ADD, link->fd, &event) < 0) {
+		return SML_PARSE_ERROR;
+	}
+	link->open = TRUE;
+	reader->links++;
+	return SML_PARSE_OK;
+}
+
+void sml_reader_remove(SML_Reader* reader, SML_Link* link) {
+	struct epoll_event event;
+
+	if(!link->open) {
+		return;
+	}
+	/* Kernels before 2.6.9 want an event even for EPOLL_CTL_DEL */
+	p_sml_memset(&event, 0, sizeof(event));
+	epoll_ctl(reader->epollFd, EPOLL_CTL_DEL, link->fd, &event);
+	link->open = FALSE;
+	reader->links--;
+}
+
+int sml_reader_poll(SML_Reader* reader, int timeout) {
+	struct epoll_event events[SML_READER_EVENTS];
+	SML_Link* link;
+	uint32_t frames = 0;
+	int ready;
+	int i;
+
+	reader->stop = FALSE;
+	ready = epoll_wait(reader->epollFd, events, SML_READER_EVENTS, timeout);
+	if(ready < 0) {
+		return (errno == EINTR) ? 0 : -1;
+	}
+	for(i=0; i<ready && !reader->stop; i++) {
+		/* A callback may have removed the link after epoll_wait() reported it */
+		link = (SML_Link*)events[i].data.ptr;
+		if(link->open) {
+			frames += p_sml_reader_service(reader, link);
+		}
+	}
+	return (int)frames;
+}
+
+uint8_t sml_reader_run(SML_Reader* reader) {
+	reader->stop = FALSE;
+	while(reader->links > 0 && !reader->stop) {
+		if(sml_reader_poll(reader, -1) < 0) {
+			return SML_PARSE_ERROR;
+		}
+	}
+	return SML_PARSE_OK;
+}
+
+uint32_t p_sml_reader_service(SML_Reader* reader, SML_Link* link) {
+	unsigned char* space;
+	uint32_t length;
+	ssize_t count;
+
+	space = sml_deframer_space(&link->deframer, &length);
+	do {
+		count = read(link->fd, space, length);
+	} while(count < 0 && errno == EINTR);
+
+	if(count > 0) {
+		link->bytes += (uint64_t)count;
+		sml_deframer_commit(&link->deframer, (uint32_t)count);
+		return p_sml_reader_deliver(reader, link);
+	}
+	if(count < 0 && errno == EAGAIN) {
+		return 0;
+	}
+
+	/* End of file, or EIO of a pty whose other side is gone */
+	sml_reader_remove(reader, link);
+	if(reader->closed != NULL) {
+		reader->closed(reader->user, link);
+	}
+	return 0;
+}
+
+uint32_t p_sml_reader_deliver(SML_Reader* reader, SML_Link* link) {
+	SML_Message message;
+	const unsigned char* frame;
+	uint32_t length;
+	uint32_t offset;
+	uint32_t count = 0;
+	size_t mark;
+
+	while(!reader->stop && sml_deframer_next(&link->deframer, &frame, &length) == SML_PARSE_OK) {
+		count++;
+		if(reader->frame != NULL && reader->frame(reader->user, link, frame, length) != SML_PARSE_OK) {
+			reader->stop = TRUE;
+		}
+		if(reader->message == NULL) {
+			continue;
+		}
+
+		/* The message lives as long as the callback runs */
+		mark = p_sml_parser_mark();
+		offset = 0;
+		if(sml_transport_parse_message(frame, &offset, &message) == SML_PARSE_OK) {
+			if(reader->message(reader->user, link, &message) != SML_PARSE_OK) {
+				reader->stop = TRUE;
+			}
+		}
+		else {
+			link->parseErrors++;
+		}
+		p_sml_parser_release(mark);
+	}
+	return count;
+}
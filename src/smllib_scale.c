@@ -0,0 +1,437 @@
+/**
+ * File name: smllib_scale.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include "smllib_scale.h"
+#include "smllib_tools.h"
+
+/*
+ * Column kernels in SIMD lanes. The double kernels give the same bits as the
+ * scalar loops only if those use SSE as well, hence __SSE2_MATH__ (not set
+ * for x87 math on i386). NEON needs aarch64 for double lanes and vcgtq_s64.
+ */
+#if defined(__AVX2__) && defined(__SSE2_MATH__)
+#include <immintrin.h>
+#define SML_SCALE_LANES 4
+#define SML_SCALE_FIXED_LANES
+#elif defined(__SSE2__) && defined(__SSE2_MATH__)
+#include <emmintrin.h>
+#define SML_SCALE_LANES 2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SML_SCALE_LANES 2
+#define SML_SCALE_FIXED_LANES
+#endif
+
+/*
+ * int64_t to double without AVX-512: x = hi * 2^48 + lo with lo < 2^48.
+ * (3 * 2^67 + hi * 2^48) - (3 * 2^67 + 2^52) and 2^52 + lo are exact, their
+ * sum is rounded once like the scalar conversion.
+ */
+#define SML_SCALE_2P52 4503599627370496.0
+#define SML_SCALE_3P67 442721857769029238784.0
+
+#define SML_INT64_MAX ((int64_t)(~(uint64_t)0 >> 1))
+#define SML_INT64_MIN (-SML_INT64_MAX - 1)
+
+/* 10^9, unsigned long holds it on every target; 10^10..10^19 are built from it */
+#define SML_POW10_9 ((uint64_t)1000000000UL)
+
+/* Correctly rounded by the compiler, 10^0..10^22 are exact */
+const double p_sml_pow10_double[SML_SCALE_MAX_POW10 + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+	1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23,
+	1e24, 1e25, 1e26, 1e27, 1e28, 1e29, 1e30, 1e31,
+	1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38, 1e39,
+	1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47,
+	1e48, 1e49, 1e50, 1e51, 1e52, 1e53, 1e54, 1e55,
+	1e56, 1e57, 1e58, 1e59, 1e60, 1e61, 1e62, 1e63,
+	1e64, 1e65, 1e66, 1e67, 1e68, 1e69, 1e70, 1e71,
+	1e72, 1e73, 1e74, 1e75, 1e76, 1e77, 1e78, 1e79,
+	1e80, 1e81, 1e82, 1e83, 1e84, 1e85, 1e86, 1e87,
+	1e88, 1e89, 1e90, 1e91, 1e92, 1e93, 1e94, 1e95,
+	1e96, 1e97, 1e98, 1e99, 1e100, 1e101, 1e102, 1e103,
+	1e104, 1e105, 1e106, 1e107, 1e108, 1e109, 1e110, 1e111,
+	1e112, 1e113, 1e114, 1e115, 1e116, 1e117, 1e118, 1e119,
+	1e120, 1e121, 1e122, 1e123, 1e124, 1e125, 1e126, 1e127,
+	1e128
+};
+
+static const uint64_t p_sml_pow10_uint[20] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, SML_POW10_9,
+	SML_POW10_9 * 10, SML_POW10_9 * 100, SML_POW10_9 * 1000, SML_POW10_9 * 10000,
+	SML_POW10_9 * 100000, SML_POW10_9 * 1000000, SML_POW10_9 * 10000000,
+	SML_POW10_9 * 100000000, SML_POW10_9 * SML_POW10_9, SML_POW10_9 * SML_POW10_9 * 10
+};
+
+#if defined(__AVX2__) && defined(__SSE2_MATH__)
+
+static __m256d p_sml_scale_to_double(__m256i value) {
+	__m256i high = _mm256_and_si256(_mm256_srai_epi32(value, 16), _mm256_set_epi32(-1, 0, -1, 0, -1, 0, -1, 0));
+	__m256i low = _mm256_and_si256(value, _mm256_set_epi32(0xFFFF, -1, 0xFFFF, -1, 0xFFFF, -1, 0xFFFF, -1));
+
+	high = _mm256_add_epi64(high, _mm256_castpd_si256(_mm256_set1_pd(SML_SCALE_3P67)));
+	low = _mm256_or_si256(low, _mm256_castpd_si256(_mm256_set1_pd(SML_SCALE_2P52)));
+	return _mm256_add_pd(_mm256_sub_pd(_mm256_castsi256_pd(high), _mm256_set1_pd(SML_SCALE_3P67 + SML_SCALE_2P52)),
+		_mm256_castsi256_pd(low));
+}
+
+/* Low 64 bits of value * factor from 32 bit halves, factor < 2^63 */
+static __m256i p_sml_scale_multiply(__m256i value, __m256i factor) {
+	__m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(value, 32), factor),
+		_mm256_mul_epu32(value, _mm256_srli_epi64(factor, 32)));
+
+	return _mm256_add_epi64(_mm256_mul_epu32(value, factor), _mm256_slli_epi64(cross, 32));
+}
+
+static uint32_t p_sml_scale_column_double_lanes(const int64_t* raw, int8_t scaler, uint32_t count, double* out) {
+	uint32_t end = count - count % SML_SCALE_LANES;
+	__m256d factor = _mm256_set1_pd(p_sml_pow10_double[scaler >= 0 ? scaler : -scaler]);
+	uint32_t i;
+
+	if(scaler >= 0) {
+		for(i=0; i<end; i+=SML_SCALE_LANES) {
+			_mm256_storeu_pd(out + i, _mm256_mul_pd(p_sml_scale_to_double(_mm256_loadu_si256((const __m256i*)(raw + i))), factor));
+		}
+	}
+	else {
+		for(i=0; i<end; i+=SML_SCALE_LANES) {
+			_mm256_storeu_pd(out + i, _mm256_div_pd(p_sml_scale_to_double(_mm256_loadu_si256((const __m256i*)(raw + i))), factor));
+		}
+	}
+	return end;
+}
+
+static uint32_t p_sml_scale_column_fixed_lanes(const int64_t* raw, int8_t scaler, int8_t target, uint32_t count, int64_t* out, uint32_t* saturated) {
+	int diff = scaler - target;
+	uint32_t end = count - count % SML_SCALE_LANES;
+	int64_t lanes[SML_SCALE_LANES];
+	int64_t limit;
+	__m256i factor;
+	__m256i above;
+	__m256i below;
+	__m256i value;
+	__m256i clipped = _mm256_setzero_si256();
+	uint32_t i;
+
+	/* Rounding divisions stay scalar */
+	if(diff <= 0 || diff > 18) {
+		return 0;
+	}
+	limit = SML_INT64_MAX / (int64_t)p_sml_pow10_uint[diff];
+	factor = _mm256_set1_epi64x((int64_t)p_sml_pow10_uint[diff]);
+	for(i=0; i<end; i+=SML_SCALE_LANES) {
+		value = _mm256_loadu_si256((const __m256i*)(raw + i));
+		above = _mm256_cmpgt_epi64(value, _mm256_set1_epi64x(limit));
+		below = _mm256_cmpgt_epi64(_mm256_set1_epi64x(-limit), value);
+		value = _mm256_andnot_si256(_mm256_or_si256(above, below), p_sml_scale_multiply(value, factor));
+		value = _mm256_or_si256(value, _mm256_and_si256(above, _mm256_set1_epi64x(SML_INT64_MAX)));
+		value = _mm256_or_si256(value, _mm256_and_si256(below, _mm256_set1_epi64x(SML_INT64_MIN)));
+		_mm256_storeu_si256((__m256i*)(out + i), value);
+		clipped = _mm256_sub_epi64(clipped, _mm256_or_si256(above, below));
+	}
+	_mm256_storeu_si256((__m256i*)lanes, clipped);
+	*saturated += (uint32_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+	return end;
+}
+
+#elif defined(__SSE2__) && defined(__SSE2_MATH__)
+
+static __m128d p_sml_scale_to_double(__m128i value) {
+	__m128i high = _mm_and_si128(_mm_srai_epi32(value, 16), _mm_set_epi32(-1, 0, -1, 0));
+	__m128i low = _mm_and_si128(value, _mm_set_epi32(0xFFFF, -1, 0xFFFF, -1));
+
+	high = _mm_add_epi64(high, _mm_castpd_si128(_mm_set1_pd(SML_SCALE_3P67)));
+	low = _mm_or_si128(low, _mm_castpd_si128(_mm_set1_pd(SML_SCALE_2P52)));
+	return _mm_add_pd(_mm_sub_pd(_mm_castsi128_pd(high), _mm_set1_pd(SML_SCALE_3P67 + SML_SCALE_2P52)), _mm_castsi128_pd(low));
+}
+
+static uint32_t p_sml_scale_column_double_lanes(const int64_t* raw, int8_t scaler, uint32_t count, double* out) {
+	uint32_t end = count - count % SML_SCALE_LANES;
+	__m128d factor = _mm_set1_pd(p_sml_pow10_double[scaler >= 0 ? scaler : -scaler]);
+	uint32_t i;
+
+	if(scaler >= 0) {
+		for(i=0; i<end; i+=SML_SCALE_LANES) {
+			_mm_storeu_pd(out + i, _mm_mul_pd(p_sml_scale_to_double(_mm_loadu_si128((const __m128i*)(raw + i))), factor));
+		}
+	}
+	else {
+		for(i=0; i<end; i+=SML_SCALE_LANES) {
+			_mm_storeu_pd(out + i, _mm_div_pd(p_sml_scale_to_double(_mm_loadu_si128((const __m128i*)(raw + i))), factor));
+		}
+	}
+	return end;
+}
+
+/*
+ * No fixed point lanes: SSE2 has neither 64 bit multiply nor compare
+ * (pcmpgtq is SSE4.2), emulated they were slower than the scalar loop.
+ */
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+static uint32_t p_sml_scale_column_double_lanes(const int64_t* raw, int8_t scaler, uint32_t count, double* out) {
+	uint32_t end = count - count % SML_SCALE_LANES;
+	float64x2_t factor = vdupq_n_f64(p_sml_pow10_double[scaler >= 0 ? scaler : -scaler]);
+	uint32_t i;
+
+	if(scaler >= 0) {
+		for(i=0; i<end; i+=SML_SCALE_LANES) {
+			vst1q_f64(out + i, vmulq_f64(vcvtq_f64_s64(vld1q_s64(raw + i)), factor));
+		}
+	}
+	else {
+		for(i=0; i<end; i+=SML_SCALE_LANES) {
+			vst1q_f64(out + i, vdivq_f64(vcvtq_f64_s64(vld1q_s64(raw + i)), factor));
+		}
+	}
+	return end;
+}
+
+static uint32_t p_sml_scale_column_fixed_lanes(const int64_t* raw, int8_t scaler, int8_t target, uint32_t count, int64_t* out, uint32_t* saturated) {
+	int diff = scaler - target;
+	uint32_t end = count - count % SML_SCALE_LANES;
+	int64_t limit;
+	uint32x2_t factorLow;
+	uint32x2_t factorHigh;
+	uint64x2_t above;
+	uint64x2_t below;
+	uint64x2_t bits;
+	uint64x2_t product;
+	int64x2_t value;
+	uint64x2_t clipped = vdupq_n_u64(0);
+	uint32_t i;
+
+	/* Rounding divisions stay scalar */
+	if(diff <= 0 || diff > 18) {
+		return 0;
+	}
+	limit = SML_INT64_MAX / (int64_t)p_sml_pow10_uint[diff];
+	factorLow = vdup_n_u32((uint32_t)p_sml_pow10_uint[diff]);
+	factorHigh = vdup_n_u32((uint32_t)(p_sml_pow10_uint[diff] >> 32));
+	for(i=0; i<end; i+=SML_SCALE_LANES) {
+		value = vld1q_s64(raw + i);
+		above = vcgtq_s64(value, vdupq_n_s64(limit));
+		below = vcltq_s64(value, vdupq_n_s64(-limit));
+		/* Low 64 bits of value * factor from 32 bit halves */
+		bits = vreinterpretq_u64_s64(value);
+		product = vmlal_u32(vmull_u32(vshrn_n_u64(bits, 32), factorLow), vmovn_u64(bits), factorHigh);
+		product = vaddq_u64(vmull_u32(vmovn_u64(bits), factorLow), vshlq_n_u64(product, 32));
+		value = vbslq_s64(below, vdupq_n_s64(SML_INT64_MIN), vreinterpretq_s64_u64(product));
+		value = vbslq_s64(above, vdupq_n_s64(SML_INT64_MAX), value);
+		vst1q_s64(out + i, value);
+		clipped = vsubq_u64(clipped, vorrq_u64(above, below));
+	}
+	*saturated += (uint32_t)vaddvq_u64(clipped);
+	return end;
+}
+
+#endif
+
+void sml_scale_double(const int64_t* raw, const int8_t* scaler, uint32_t count, double* out) {
+	uint32_t i;
+	int s;
+
+	/* One of both factors is 1.0, so each value is rounded once */
+	for(i=0; i<count; i++) {
+		s = scaler[i];
+		out[i] = (double)raw[i] * p_sml_pow10_double[s > 0 ? s : 0] / p_sml_pow10_double[s < 0 ? -s : 0];
+	}
+}
+
+void sml_scale_column_double(const int64_t* raw, int8_t scaler, uint32_t count, double* out) {
+	uint32_t done = 0;
+
+#ifdef SML_SCALE_LANES
+	done = p_sml_scale_column_double_lanes(raw, scaler, count, out);
+#endif
+	p_sml_scale_column_double_scalar(raw + done, scaler, count - done, out + done);
+}
+
+uint32_t sml_scale_fixed(const int64_t* raw, const int8_t* scaler, int8_t target, uint32_t count, int64_t* out) {
+	uint32_t saturated = 0;
+	uint32_t i;
+
+	for(i=0; i<count; i++) {
+		out[i] = p_sml_scale_fixed_value(raw[i], scaler[i] - target, &saturated);
+	}
+	return saturated;
+}
+
+uint32_t sml_scale_column_fixed(const int64_t* raw, int8_t scaler, int8_t target, uint32_t count, int64_t* out) {
+	uint32_t saturated = 0;
+	uint32_t done = 0;
+
+#ifdef SML_SCALE_FIXED_LANES
+	done = p_sml_scale_column_fixed_lanes(raw, scaler, target, count, out, &saturated);
+#endif
+	return saturated + p_sml_scale_column_fixed_scalar(raw + done, scaler, target, count - done, out + done);
+}
+
+void p_sml_scale_column_double_scalar(const int64_t* raw, int8_t scaler, uint32_t count, double* out) {
+	double factor;
+	uint32_t i;
+
+	/* Divide: 10^1..10^22 are exact, their inverses are not (one rounding instead of two) */
+	if(scaler >= 0) {
+		factor = p_sml_pow10_double[scaler];
+		for(i=0; i<count; i++) {
+			out[i] = (double)raw[i] * factor;
+		}
+	}
+	else {
+		factor = p_sml_pow10_double[-scaler];
+		for(i=0; i<count; i++) {
+			out[i] = (double)raw[i] / factor;
+		}
+	}
+}
+
+uint32_t p_sml_scale_column_fixed_scalar(const int64_t* raw, int8_t scaler, int8_t target, uint32_t count, int64_t* out) {
+	int diff = scaler - target;
+	uint32_t saturated = 0;
+	uint32_t i;
+	int64_t factor;
+	int64_t limit;
+	int64_t value;
+
+	if(diff == 0) {
+		p_sml_memmove(out, raw, count * sizeof(int64_t));
+	}
+	else if(diff > 0 && diff <= 18) {
+		/* Limit computed once, not per value */
+		factor = (int64_t)p_sml_pow10_uint[diff];
+		limit = SML_INT64_MAX / factor;
+		for(i=0; i<count; i++) {
+			value = raw[i];
+			saturated += (value > limit || value < -limit);
+			out[i] = (value > limit) ? SML_INT64_MAX : (value < -limit) ? SML_INT64_MIN : value * factor;
+		}
+	}
+	else {
+		for(i=0; i<count; i++) {
+			out[i] = p_sml_scale_fixed_value(raw[i], diff, &saturated);
+		}
+	}
+	return saturated;
+}
+
+int64_t p_sml_scale_fixed_value(int64_t raw, int diff, uint32_t* saturated) {
+	uint64_t magnitude;
+	uint64_t divisor;
+	uint64_t remainder;
+	int64_t limit;
+
+	if(diff >= 0) {
+		if(raw == 0 || diff == 0) {
+			return raw;
+		}
+		if(diff <= 18) {
+			limit = SML_INT64_MAX / (int64_t)p_sml_pow10_uint[diff];
+			if(raw <= limit && raw >= -limit) {
+				return raw * (int64_t)p_sml_pow10_uint[diff];
+			}
+		}
+		(*saturated)++;
+		return (raw > 0) ? SML_INT64_MAX : SML_INT64_MIN;
+	}
+
+	/* |raw| <= 2^63 < 10^19, so from 10^-20 on every value rounds to 0 */
+	diff = -diff;
+	if(diff > 19) {
+		return 0;
+	}
+	magnitude = (raw < 0) ? (uint64_t)0 - (uint64_t)raw : (uint64_t)raw;
+	divisor = p_sml_pow10_uint[diff];
+	remainder = magnitude % divisor;
+	magnitude /= divisor;
+	if(remainder >= divisor - remainder) {
+		magnitude++;
+	}
+	return (raw < 0) ? -(int64_t)magnitude : (int64_t)magnitude;
+}
+
+SML_Boolean sml_value_raw(const SML_Value* value, int64_t* raw) {
+	switch(value->choiceTag) {
+		case SML_VALUE_INT8: *raw = value->choiceValue.int8; return TRUE;
+		case SML_VALUE_INT16: *raw = value->choiceValue.int16; return TRUE;
+		case SML_VALUE_INT32: *raw = value->choiceValue.int32; return TRUE;
+		case SML_VALUE_INT64: *raw = value->choiceValue.int64; return TRUE;
+		case SML_VALUE_UINT8: *raw = value->choiceValue.uint8; return TRUE;
+		case SML_VALUE_UINT16: *raw = value->choiceValue.uint16; return TRUE;
+		case SML_VALUE_UINT32: *raw = value->choiceValue.uint32; return TRUE;
+		case SML_VALUE_UINT64:
+			*raw = (value->choiceValue.uint64 > (uint64_t)SML_INT64_MAX) ? SML_INT64_MAX : (int64_t)value->choiceValue.uint64;
+			return TRUE;
+		default:
+			*raw = 0;
+			return FALSE;
+	}
+}
+
+uint32_t sml_list_raw(const SML_List* list, int64_t* raw, int8_t* scaler, SML_Unit* unit) {
+	const SML_ListEntry* entry;
+	uint32_t numeric = 0;
+	uint32_t i;
+
+	for(i=0; i<list->listSize; i++) {
+		entry = list->valListEntry + i;
+		numeric += (sml_value_raw(&entry->value, raw + i) == TRUE);
+		scaler[i] = (entry->scaler != NULL) ? *entry->scaler : 0;
+		if(unit != NULL) {
+			unit[i] = (entry->unit != NULL) ? *entry->unit : 0;
+		}
+	}
+	return numeric;
+}
+
+uint32_t sml_list_compact_raw(const SML_List_Compact* list, int64_t* raw, int8_t* scaler, SML_Unit* unit) {
+	const SML_ListEntry_Compact* entry;
+	uint32_t numeric = 0;
+	uint32_t i;
+
+	for(i=0; i<list->listSize; i++) {
+		entry = list->valListEntry + i;
+		numeric += (sml_value_raw(&entry->value, raw + i) == TRUE);
+		scaler[i] = (entry->present & SML_LISTENTRY_SCALER) ? entry->scaler : 0;
+		if(unit != NULL) {
+			unit[i] = (entry->present & SML_LISTENTRY_UNIT) ? entry->unit : 0;
+		}
+	}
+	return numeric;
+}
+
+uint32_t sml_profile_column_raw(const List_of_SML_ProfObjPeriodEntry* periods, uint32_t column, int64_t* raw) {
+	const SML_ProfObjPeriodEntry* period;
+	uint32_t numeric = 0;
+	uint32_t i;
+
+	for(i=0; i<periods->listSize; i++) {
+		period = periods->period_List_Entry + i;
+		raw[i] = 0;
+		if(column < period->value_List.listSize) {
+			numeric += (sml_value_raw(&period->value_List.value_List_Entry[column].value, raw + i) == TRUE);
+		}
+	}
+	return numeric;
+}
@@ -0,0 +1,489 @@
+/**
+ * File name: smllib_synth.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_synth.h"
+
+const uint32_t sml_synth_types[SML_SYNTH_TYPE_COUNT] = {
+	SML_MESSAGEBODY_OPEN_REQUEST,
+	SML_MESSAGEBODY_OPEN_RESPONSE,
+	SML_MESSAGEBODY_CLOSE_REQUEST,
+	SML_MESSAGEBODY_CLOSE_RESPONSE,
+	SML_MESSAGEBODY_GETPROFILEPACK_REQUEST,
+	SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE,
+	SML_MESSAGEBODY_GETPROFILELIST_REQUEST,
+	SML_MESSAGEBODY_GETPROFILELIST_RESPONSE,
+	SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST,
+	SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE,
+	SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST,
+	SML_MESSAGEBODY_GETLIST_REQUEST,
+	SML_MESSAGEBODY_GETLIST_RESPONSE,
+	SML_MESSAGEBODY_ATTENTION_RESPONSE
+};
+
+/* Register kinds of an eHZ push: energy, power, voltage, operating seconds */
+static const unsigned char synth_obis[4][6] = {
+	{0x01, 0x01, 0x01, 0x08, 0x01, 0xFF},
+	{0x01, 0x01, 0x10, 0x07, 0x01, 0xFF},
+	{0x01, 0x01, 0x20, 0x07, 0x01, 0xFF},
+	{0x01, 0x01, 0x60, 0x08, 0x01, 0xFF}
+};
+static SML_Unit synth_units[4] = {30, 27, 35, 7};
+static int8_t synth_scalers[4] = {-1, 0, -1, 0};
+static uint8_t synth_smlVersion = 1;
+static SML_Boolean synth_false = FALSE;
+
+void sml_synth_init(SML_Synth* synth, uint32_t seed) {
+	memset(synth, 0, sizeof(SML_Synth));
+	synth->state = (seed != 0) ? seed : 0x9E3779B9UL;
+	synth->treeFanout = SML_SYNTH_TREE_FANOUT;
+}
+
+void sml_synth_free(SML_Synth* synth) {
+	uint32_t i;
+
+	for(i=0; i<synth->blockCount; i++) {
+		free(synth->blocks[i]);
+	}
+	free(synth->blocks);
+	synth->blocks = NULL;
+	synth->blockCount = 0;
+	synth->blockMax = 0;
+}
+
+uint32_t sml_synth_random(SML_Synth* synth) {
+	uint32_t x = synth->state;
+
+	x ^= (x << 13) & 0xFFFFFFFFUL;
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xFFFFFFFFUL;
+	synth->state = x;
+	return x;
+}
+
+void* sml_synth_alloc(SML_Synth* synth, size_t size) {
+	void* block;
+
+	if(synth->blockCount == synth->blockMax) {
+		synth->blockMax = (synth->blockMax > 0) ? synth->blockMax * 2 : 64;
+		synth->blocks = (void**)realloc(synth->blocks, synth->blockMax * sizeof(void*));
+		if(synth->blocks == NULL) {
+			fprintf(stderr, "%s\n", "synth: out of memory");
+			exit(1);
+		}
+	}
+	block = calloc(1, size > 0 ? size : 1);
+	if(block == NULL) {
+		fprintf(stderr, "%s\n", "synth: out of memory");
+		exit(1);
+	}
+	synth->blocks[synth->blockCount++] = block;
+	return block;
+}
+
+/* TRUE with escapeRate per mille: the next string or counter carries an escape sequence */
+static SML_Boolean synth_escape(SML_Synth* synth) {
+	return synth->escapeRate > 0 && sml_synth_random(synth) % 1000 < synth->escapeRate;
+}
+
+/* Octet string of random non-zero bytes (SML strings are NUL terminated here) */
+static char* synth_octets(SML_Synth* synth, uint32_t length) {
+	char* octets = (char*)sml_synth_alloc(synth, length + 1);
+	uint32_t i;
+
+	for(i=0; i<length; i++) {
+		octets[i] = (char)(1 + sml_synth_random(synth) % 255);
+	}
+	if(length >= 4 && synth_escape(synth)) {
+		memset(octets + sml_synth_random(synth) % (length - 3), 0x1B, 4);
+	}
+	return octets;
+}
+
+/* prefix (at most 12 characters) followed by a zero padded number */
+static char* synth_text(SML_Synth* synth, const char* prefix, unsigned long number) {
+	char* text = (char*)sml_synth_alloc(synth, 24);
+
+	sprintf(text, "%s%06lu", prefix, number);
+	return text;
+}
+
+static char* synth_obis_name(SML_Synth* synth, uint32_t kind) {
+	char* name = (char*)sml_synth_alloc(synth, SML_OBIS_LENGTH + 1);
+
+	memcpy(name, synth_obis[kind % 4], SML_OBIS_LENGTH);
+	return name;
+}
+
+static char* synth_server_id(SML_Synth* synth) {
+	char* serverId = synth_octets(synth, 10);
+
+	/* Manufacturer prefix of an eHZ server id */
+	memcpy(serverId, "\x0A\x01" "EBZ", 5);
+	return serverId;
+}
+
+static SML_Time* synth_time(SML_Synth* synth) {
+	SML_Time* time = (SML_Time*)sml_synth_alloc(synth, sizeof(SML_Time));
+
+	time->choiceTag = SML_TIME_SECINDEX;
+	time->choiceValue.secIndex = sml_synth_random(synth) % 100000000UL;
+	return time;
+}
+
+static void synth_value(SML_Synth* synth, SML_Value* value, uint32_t kind) {
+	switch(kind % 4) {
+		case 0:
+			value->choiceTag = SML_VALUE_UINT64;
+			value->choiceValue.uint64 = synth_escape(synth) ? 0x1B1B1B1BUL : sml_synth_random(synth) % 1000000000UL;
+		break;
+		case 1:
+			/* Power is signed, negative while feeding in */
+			value->choiceTag = SML_VALUE_INT32;
+			value->choiceValue.int32 = (int32_t)(sml_synth_random(synth) % 20001UL) - 10000;
+		break;
+		case 2:
+			value->choiceTag = SML_VALUE_UINT16;
+			value->choiceValue.uint16 = (uint16_t)(2200 + sml_synth_random(synth) % 200);
+		break;
+		default:
+			value->choiceTag = SML_VALUE_UINT32;
+			value->choiceValue.uint32 = synth_escape(synth) ? 0x1B1B1B1BUL : sml_synth_random(synth);
+		break;
+	}
+}
+
+static void synth_treepath(SML_Synth* synth, SML_TreePath* path, uint32_t length) {
+	uint32_t i;
+
+	path->listSize = length;
+	path->path_Entry = (char**)sml_synth_alloc(synth, length * sizeof(char*));
+	for(i=0; i<length; i++) {
+		path->path_Entry[i] = synth_obis_name(synth, i);
+	}
+}
+
+static List_of_SML_ObjReqEntry* synth_objreq_list(SML_Synth* synth, uint32_t length) {
+	List_of_SML_ObjReqEntry* list = (List_of_SML_ObjReqEntry*)sml_synth_alloc(synth, sizeof(List_of_SML_ObjReqEntry));
+	uint32_t i;
+
+	list->listSize = length;
+	list->object_List_Entry = (SML_ObjReqEntry*)sml_synth_alloc(synth, length * sizeof(SML_ObjReqEntry));
+	for(i=0; i<length; i++) {
+		list->object_List_Entry[i] = synth_obis_name(synth, i);
+	}
+	return list;
+}
+
+/* Breadth-first tree of nodeCount nodes, every node carries a value */
+static SML_Tree* synth_tree(SML_Synth* synth, uint32_t nodeCount) {
+	SML_Tree* nodes = (SML_Tree*)sml_synth_alloc(synth, nodeCount * sizeof(SML_Tree));
+	List_of_SML_Tree* lists = (List_of_SML_Tree*)sml_synth_alloc(synth, nodeCount * sizeof(List_of_SML_Tree));
+	SML_ProcParValue* values = (SML_ProcParValue*)sml_synth_alloc(synth, nodeCount * sizeof(SML_ProcParValue));
+	SML_Value* smlValues = (SML_Value*)sml_synth_alloc(synth, nodeCount * sizeof(SML_Value));
+	uint32_t first;
+	uint32_t i;
+
+	for(i=0; i<nodeCount; i++) {
+		synth_value(synth, smlValues + i, i);
+		values[i].choiceTag = SML_PROCPAR_VALUE;
+		values[i].choiceValue.smlValue = smlValues + i;
+		nodes[i].parameterName = synth_text(synth, "P", (unsigned long)i);
+		nodes[i].parameterValue = values + i;
+		first = i * synth->treeFanout + 1;
+		if(first < nodeCount) {
+			lists[i].listSize = (nodeCount - first < synth->treeFanout) ? nodeCount - first : synth->treeFanout;
+			lists[i].tree_Entry = nodes + first;
+			nodes[i].child_List = lists + i;
+		}
+	}
+	return nodes;
+}
+
+static void* synth_open_request(SML_Synth* synth) {
+	SML_PublicOpen_Req* request = (SML_PublicOpen_Req*)sml_synth_alloc(synth, sizeof(SML_PublicOpen_Req));
+
+	request->clientId = synth_octets(synth, 6);
+	request->reqFileId = synth_text(synth, "F", (unsigned long)(sml_synth_random(synth) % 1000000UL));
+	request->serverId = synth_server_id(synth);
+	request->smlVersion = &synth_smlVersion;
+	return request;
+}
+
+static void* synth_open_response(SML_Synth* synth) {
+	SML_PublicOpen_Res* response = (SML_PublicOpen_Res*)sml_synth_alloc(synth, sizeof(SML_PublicOpen_Res));
+
+	response->reqFileId = synth_text(synth, "F", (unsigned long)(sml_synth_random(synth) % 1000000UL));
+	response->serverId = synth_server_id(synth);
+	response->refTime = synth_time(synth);
+	response->smlVersion = &synth_smlVersion;
+	return response;
+}
+
+static void* synth_getprofilepack_request(SML_Synth* synth, uint32_t size) {
+	SML_GetProfilePack_Req* request = (SML_GetProfilePack_Req*)sml_synth_alloc(synth, sizeof(SML_GetProfilePack_Req));
+
+	request->serverId = synth_server_id(synth);
+	request->withRawdata = &synth_false;
+	request->beginTime = synth_time(synth);
+	request->endTime = synth_time(synth);
+	synth_treepath(synth, &request->parameterTreePath, 1);
+	request->object_List = synth_objreq_list(synth, size);
+	return request;
+}
+
+static void* synth_getprofilepack_response(SML_Synth* synth, uint32_t size) {
+	SML_GetProfilePack_Res* response = (SML_GetProfilePack_Res*)sml_synth_alloc(synth, sizeof(SML_GetProfilePack_Res));
+	SML_ProfObjPeriodEntry* periods = (SML_ProfObjPeriodEntry*)sml_synth_alloc(synth, size * sizeof(SML_ProfObjPeriodEntry));
+	SML_ValueEntry* values = (SML_ValueEntry*)sml_synth_alloc(synth, size * 4 * sizeof(SML_ValueEntry));
+	SML_ProfObjHeaderEntry* headers = (SML_ProfObjHeaderEntry*)sml_synth_alloc(synth, 4 * sizeof(SML_ProfObjHeaderEntry));
+	uint32_t start = sml_synth_random(synth) % 100000000UL;
+	uint32_t i;
+	uint32_t v;
+
+	for(v=0; v<4; v++) {
+		headers[v].objName = synth_obis_name(synth, v);
+		headers[v].unit = synth_units[v];
+		headers[v].scaler = synth_scalers[v];
+	}
+	/* 15-minute periods */
+	for(i=0; i<size; i++) {
+		periods[i].valTime.choiceTag = SML_TIME_SECINDEX;
+		periods[i].valTime.choiceValue.secIndex = start + i * 900;
+		periods[i].value_List.listSize = 4;
+		periods[i].value_List.value_List_Entry = values + i * 4;
+		for(v=0; v<4; v++) {
+			synth_value(synth, &values[i * 4 + v].value, v);
+		}
+	}
+
+	response->serverId = synth_server_id(synth);
+	response->actTime.choiceTag = SML_TIME_SECINDEX;
+	response->actTime.choiceValue.secIndex = start + size * 900;
+	response->regPeriod = 900;
+	synth_treepath(synth, &response->parameterTreePath, 1);
+	response->header_List.listSize = 4;
+	response->header_List.header_List_Entry = headers;
+	response->period_List.listSize = size;
+	response->period_List.period_List_Entry = periods;
+	return response;
+}
+
+static void* synth_getprofilelist_request(SML_Synth* synth, uint32_t size) {
+	SML_GetProfileList_Req* request = (SML_GetProfileList_Req*)sml_synth_alloc(synth, sizeof(SML_GetProfileList_Req));
+
+	request->serverId = synth_server_id(synth);
+	request->withRawdata = &synth_false;
+	request->beginTime = synth_time(synth);
+	request->endTime = synth_time(synth);
+	synth_treepath(synth, &request->parameterTreePath, 1);
+	request->object_List = synth_objreq_list(synth, size);
+	return request;
+}
+
+static void* synth_getprofilelist_response(SML_Synth* synth, uint32_t size) {
+	SML_GetProfileList_Res* response = (SML_GetProfileList_Res*)sml_synth_alloc(synth, sizeof(SML_GetProfileList_Res));
+	SML_PeriodEntry* periods = (SML_PeriodEntry*)sml_synth_alloc(synth, size * sizeof(SML_PeriodEntry));
+	uint32_t i;
+
+	for(i=0; i<size; i++) {
+		periods[i].objName = synth_obis_name(synth, i);
+		periods[i].unit = synth_units[i % 4];
+		periods[i].scaler = synth_scalers[i % 4];
+		synth_value(synth, &periods[i].value, i);
+	}
+
+	response->serverId = synth_server_id(synth);
+	response->actTime = *synth_time(synth);
+	response->regPeriod = 900;
+	synth_treepath(synth, &response->parameterTreePath, 1);
+	response->valTime = *synth_time(synth);
+	response->status = sml_synth_random(synth) & 0xFFFF;
+	response->period_List.listSize = size;
+	response->period_List.period_List_Entry = periods;
+	return response;
+}
+
+static void* synth_getprocparameter_request(SML_Synth* synth, uint32_t size) {
+	SML_GetProcParameter_Req* request = (SML_GetProcParameter_Req*)sml_synth_alloc(synth, sizeof(SML_GetProcParameter_Req));
+
+	request->serverId = synth_server_id(synth);
+	synth_treepath(synth, &request->parameterTreePath, size);
+	return request;
+}
+
+static void* synth_getprocparameter_response(SML_Synth* synth, uint32_t size) {
+	SML_GetProcParameter_Res* response = (SML_GetProcParameter_Res*)sml_synth_alloc(synth, sizeof(SML_GetProcParameter_Res));
+
+	response->serverId = synth_server_id(synth);
+	synth_treepath(synth, &response->parameterTreePath, 1);
+	response->parameterTree = *synth_tree(synth, size);
+	return response;
+}
+
+static void* synth_setprocparameter_request(SML_Synth* synth, uint32_t size) {
+	SML_SetProcParameter_Req* request = (SML_SetProcParameter_Req*)sml_synth_alloc(synth, sizeof(SML_SetProcParameter_Req));
+
+	request->serverId = synth_server_id(synth);
+	synth_treepath(synth, &request->parameterTreePath, 1);
+	request->parameterTree = *synth_tree(synth, size);
+	return request;
+}
+
+static void* synth_getlist_request(SML_Synth* synth) {
+	SML_GetList_Req* request = (SML_GetList_Req*)sml_synth_alloc(synth, sizeof(SML_GetList_Req));
+
+	request->clientId = synth_octets(synth, 6);
+	request->serverId = synth_server_id(synth);
+	return request;
+}
+
+static void* synth_getlist_response(SML_Synth* synth, uint32_t size) {
+	SML_GetList_Res* response = (SML_GetList_Res*)sml_synth_alloc(synth, sizeof(SML_GetList_Res));
+	SML_ListEntry* entries = (SML_ListEntry*)sml_synth_alloc(synth, size * sizeof(SML_ListEntry));
+	SML_Status* status = (SML_Status*)sml_synth_alloc(synth, sizeof(SML_Status));
+	uint32_t i;
+
+	status->choiceTag = SML_STATUS_UINT64;
+	status->choiceValue.uint64 = 0x0182;
+	for(i=0; i<size; i++) {
+		entries[i].objName = synth_obis_name(synth, i);
+		entries[i].status = (i % 4 == 0) ? status : NULL;
+		entries[i].unit = &synth_units[i % 4];
+		entries[i].scaler = &synth_scalers[i % 4];
+		synth_value(synth, &entries[i].value, i);
+	}
+
+	response->serverId = synth_server_id(synth);
+	response->actSensorTime = synth_time(synth);
+	response->valList.listSize = size;
+	response->valList.valListEntry = entries;
+	return response;
+}
+
+static void* synth_attention_response(SML_Synth* synth, uint32_t size) {
+	SML_Attention_Res* response = (SML_Attention_Res*)sml_synth_alloc(synth, sizeof(SML_Attention_Res));
+
+	response->serverId = synth_server_id(synth);
+	response->attentionNo = (char*)sml_synth_alloc(synth, 7);
+	memcpy(response->attentionNo, "\x81\x81\xC7\xC7\xFE\x01", 6);
+	response->attentionMsg = synth_text(synth, "attention ", (unsigned long)(sml_synth_random(synth) % 1000UL));
+	response->attentionDetails = synth_tree(synth, size);
+	return response;
+}
+
+SML_Message* sml_synth_message(SML_Synth* synth, uint32_t choiceTag, uint32_t size) {
+	SML_Message* message;
+	SML_MessageBody* body;
+
+	if(size == 0) {
+		size = 1;
+	}
+	message = (SML_Message*)sml_synth_alloc(synth, sizeof(SML_Message));
+	message->transactionId = synth_text(synth, "T", (unsigned long)sml_synth_random(synth));
+	body = &message->messageBody;
+	body->choiceTag = choiceTag;
+
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+			body->choiceValue.openRequest = (SML_PublicOpen_Req*)synth_open_request(synth);
+		break;
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+			body->choiceValue.openResponse = (SML_PublicOpen_Res*)synth_open_response(synth);
+		break;
+		case SML_MESSAGEBODY_CLOSE_REQUEST:
+			body->choiceValue.closeRequest = (SML_PublicClose_Req*)sml_synth_alloc(synth, sizeof(SML_PublicClose_Req));
+		break;
+		case SML_MESSAGEBODY_CLOSE_RESPONSE:
+			body->choiceValue.closeResponse = (SML_PublicClose_Res*)sml_synth_alloc(synth, sizeof(SML_PublicClose_Res));
+		break;
+		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST:
+			body->choiceValue.getProfilePackRequest = (SML_GetProfilePack_Req*)synth_getprofilepack_request(synth, size);
+		break;
+		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE:
+			body->choiceValue.getProfilePackResponse = (SML_GetProfilePack_Res*)synth_getprofilepack_response(synth, size);
+		break;
+		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST:
+			body->choiceValue.getProfileListRequest = (SML_GetProfileList_Req*)synth_getprofilelist_request(synth, size);
+		break;
+		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE:
+			body->choiceValue.getProfileListResponse = (SML_GetProfileList_Res*)synth_getprofilelist_response(synth, size);
+		break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST:
+			body->choiceValue.getProcParameterRequest = (SML_GetProcParameter_Req*)synth_getprocparameter_request(synth, size);
+		break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
+			body->choiceValue.getProcParameterResponse = (SML_GetProcParameter_Res*)synth_getprocparameter_response(synth, size);
+		break;
+		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST:
+			body->choiceValue.setProcParameterRequest = (SML_SetProcParameter_Req*)synth_setprocparameter_request(synth, size);
+		break;
+		case SML_MESSAGEBODY_GETLIST_REQUEST:
+			body->choiceValue.getListRequest = (SML_GetList_Req*)synth_getlist_request(synth);
+		break;
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+			body->choiceValue.getListResponse = (SML_GetList_Res*)synth_getlist_response(synth, size);
+		break;
+		case SML_MESSAGEBODY_ATTENTION_RESPONSE:
+			body->choiceValue.attentionResponse = (SML_Attention_Res*)synth_attention_response(synth, size);
+		break;
+		default:
+			return NULL;
+	}
+	return message;
+}
+
+SML_Boolean sml_synth_is_sized(uint32_t choiceTag) {
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+		case SML_MESSAGEBODY_CLOSE_REQUEST:
+		case SML_MESSAGEBODY_CLOSE_RESPONSE:
+		case SML_MESSAGEBODY_GETLIST_REQUEST:
+			return FALSE;
+		default:
+			return TRUE;
+	}
+}
+
+const char* sml_synth_type_name(uint32_t choiceTag) {
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST: return "PublicOpen_Req";
+		case SML_MESSAGEBODY_OPEN_RESPONSE: return "PublicOpen_Res";
+		case SML_MESSAGEBODY_CLOSE_REQUEST: return "PublicClose_Req";
+		case SML_MESSAGEBODY_CLOSE_RESPONSE: return "PublicClose_Res";
+		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST: return "GetProfilePack_Req";
+		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE: return "GetProfilePack_Res";
+		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST: return "GetProfileList_Req";
+		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE: return "GetProfileList_Res";
+		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST: return "GetProcParameter_Req";
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE: return "GetProcParameter_Res";
+		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST: return "SetProcParameter_Req";
+		case SML_MESSAGEBODY_GETLIST_REQUEST: return "GetList_Req";
+		case SML_MESSAGEBODY_GETLIST_RESPONSE: return "GetList_Res";
+		case SML_MESSAGEBODY_ATTENTION_RESPONSE: return "Attention_Res";
+		default: return "unknown";
+	}
+}
@@ -21,12 +21,14 @@
  * with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 #include <stdlib.h>
+#include <string.h>
 
 #include "smllib_test.h"
 #include "smllib_types.h"
 #include "smllib_encode.h"
 #include "smllib_parse.h"
 #include "smllib_tools.h"
+#include "smllib_context.h"
 
 int sml_encode_parse_msg_test(SML_Message* message) {
 	SML_Encode_Binary_Result result;
@@ -43,11 +45,11 @@ int sml_encode_parse_msg_test(SML_Message* message) {
 				if(result.length == refResult.length && memcmp(result.resultBinary, refResult.resultBinary, result.length) == 0) {
 					retValue = 0;
 				}
-				free(refResult.resultBinary);
+				sml_encode_result_free(&refResult);
 			}
 		}
 		sml_parser_free();
-		free(result.resultBinary);
+		sml_encode_result_free(&result);
 	}
 
 	return retValue;
@@ -67,11 +69,11 @@ int sml_encode_parse_file_test(SML_File* file) {
 				if(result.length == refResult.length && memcmp(result.resultBinary, refResult.resultBinary, result.length) == 0) {
 					retValue = 0;
 				}
-				free(refResult.resultBinary);
+				sml_encode_result_free(&refResult);
 			}
 		}
 		sml_parser_free();
-		free(result.resultBinary);
+		sml_encode_result_free(&result);
 	}
 
 	return retValue;
@@ -92,11 +94,11 @@ int sml_transport_msg_test(SML_Message* message) {
 				if(result.length == refResult.length && memcmp(result.resultBinary, refResult.resultBinary, result.length) == 0) {
 					retValue = 0;
 				}
-				free(refResult.resultBinary);
+				sml_encode_result_free(&refResult);
 			}
 		}
 		sml_parser_free();
-		free(result.resultBinary);
+		sml_encode_result_free(&result);
 	}
 
 	return retValue;
@@ -116,12 +118,27 @@ int sml_transport_file_test(SML_File* file) {
 				if(result.length == refResult.length && memcmp(result.resultBinary, refResult.resultBinary, result.length) == 0) {
 					retValue = 0;
 				}
-				free(refResult.resultBinary);
+				sml_encode_result_free(&refResult);
 			}
 		}
 		sml_parser_free();
-		free(result.resultBinary);
+		sml_encode_result_free(&result);
 	}
 
 	return retValue;
 }
+
+unsigned char* sml_test_copy_result(SML_Encode_Binary_Result result, uint32_t* length) {
+	unsigned char* copy = NULL;
+
+	*length = 0;
+	if(result.resultCode == SML_ENCODE_OK) {
+		copy = (unsigned char*)malloc(result.length);
+		if(copy != NULL) {
+			memcpy(copy, result.resultBinary, result.length);
+			*length = result.length;
+		}
+	}
+	sml_encode_result_free(&result);
+	return copy;
+}
@@ -0,0 +1,82 @@
+/**
+ * File name: smllib_trace.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMLLIB_FREESTANDING
+	#include <stdio.h>
+#endif
+
+#include "smllib_trace.h"
+#include "smllib_context.h"
+#include "smllib_tools.h"
+
+#ifndef SMLLIB_FREESTANDING
+void sml_trace_print_sink(void* user, const SML_Trace_Event* event) {
+	FILE* out = (user != NULL) ? (FILE*)user : stdout;
+	uint32_t i;
+
+	switch(event->type) {
+		case SML_TRACE_NUMBER:
+			fprintf(out, "%s: %lu (0x%lX)\n", event->name, (unsigned long)event->number, (unsigned long)event->number);
+		break;
+		case SML_TRACE_TEXT:
+			fprintf(out, "%s: %.*s\n", event->name, (int)event->length, (const char*)event->data);
+		break;
+		default:
+			fprintf(out, event->length > 50 ? "%s:\n\t" : "%s: ", event->name);
+			for(i=0; i<event->length; i++) {
+				if(i % 50 == 0 && i > 0) {
+					fprintf(out, "%s", "\n\t");
+				}
+				fprintf(out, "%02X ", event->data[i]);
+			}
+			fprintf(out, "%s", "\n");
+		break;
+	}
+}
+#endif
+
+static void p_sml_trace(uint8_t level, uint8_t type, const char* name, const unsigned char* data, uint32_t length, uint32_t number) {
+	SML_Trace_Event event;
+
+	if(p_sml_context->traceSink == NULL) {
+		return;
+	}
+	event.level = level;
+	event.type = type;
+	event.name = name;
+	event.data = data;
+	event.length = length;
+	event.number = number;
+	p_sml_context->traceSink(p_sml_context->traceSinkUser, &event);
+}
+
+void p_sml_trace_bytes(uint8_t level, const char* name, const unsigned char* data, uint32_t length) {
+	p_sml_trace(level, SML_TRACE_BYTES, name, data, (data != NULL) ? length : 0, 0);
+}
+
+void p_sml_trace_number(uint8_t level, const char* name, uint32_t number) {
+	p_sml_trace(level, SML_TRACE_NUMBER, name, NULL, 0, number);
+}
+
+void p_sml_trace_text(uint8_t level, const char* name, const char* text) {
+	p_sml_trace(level, SML_TRACE_TEXT, name, (const unsigned char*)text, (text != NULL) ? (uint32_t)p_sml_strlen(text) : 0, 0);
+}
@@ -0,0 +1,259 @@
+/**
+ * File name: smllib_tree.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_tree.h"
+#include "smllib_tools.h"
+
+#define SML_TREE_PATH_SEED 2166136261UL
+
+SML_Tree* sml_tree_find(SML_Tree* root, const SML_TreePath* path) {
+	SML_Tree* node = root;
+	uint32_t i;
+	uint32_t c;
+
+	if(path->listSize == 0 || !p_sml_tree_name_equals(root->parameterName, path->path_Entry[0])) {
+		return NULL;
+	}
+	for(i=1; i<path->listSize; i++) {
+		if(node->child_List == NULL) {
+			return NULL;
+		}
+		for(c=0; c<node->child_List->listSize; c++) {
+			if(p_sml_tree_name_equals(node->child_List->tree_Entry[c].parameterName, path->path_Entry[i])) {
+				break;
+			}
+		}
+		if(c == node->child_List->listSize) {
+			return NULL;
+		}
+		node = node->child_List->tree_Entry+c;
+	}
+	return node;
+}
+
+SML_Tree_Index* sml_tree_index_create(SML_Tree* root) {
+	SML_Tree_Index* index;
+	SML_Tree_Index_Entry* entry;
+	SML_Tree_Walk walk;
+	SML_Tree* node;
+	uint32_t last[SMLLIB_TREE_MAX_DEPTH + 1];	/* last entry seen per depth */
+	uint32_t nodeCount = 0;
+	uint32_t slotCount = 1;
+	uint32_t slot;
+	uint32_t i = 0;
+
+	walk.depth = 0;
+	walk.overflow = FALSE;
+	for(node = root; node != NULL; node = p_sml_tree_next(&walk, node)) {
+		nodeCount++;
+	}
+	if(walk.overflow) {
+		return NULL;
+	}
+	/* Keep the load factor at or below one half */
+	while(slotCount < nodeCount * 2) {
+		slotCount <<= 1;
+	}
+
+	index = (SML_Tree_Index*)p_sml_calloc(1, sizeof(SML_Tree_Index) + nodeCount * sizeof(SML_Tree_Index_Entry) + slotCount * sizeof(uint32_t));
+	if(index == NULL) {
+		return NULL;
+	}
+	index->entries = (SML_Tree_Index_Entry*)(index + 1);
+	index->slots = (uint32_t*)(index->entries + nodeCount);
+	index->slotMask = slotCount - 1;
+
+	/* Preorder: the parent of a node at depth d is the last node seen at d-1 */
+	for(node = root; node != NULL; node = p_sml_tree_next(&walk, node), i++) {
+		entry = &index->entries[i];
+		entry->node = node;
+		entry->depth = walk.depth;
+		entry->parent = (walk.depth > 0) ? last[walk.depth-1] : SML_TREE_INDEX_ROOT;
+		entry->hash = p_sml_tree_path_hash(
+			(walk.depth > 0) ? index->entries[entry->parent].hash : SML_TREE_PATH_SEED,
+			node->parameterName
+		);
+		last[walk.depth] = i;
+
+		for(slot = entry->hash & index->slotMask; index->slots[slot] != 0; slot = (slot + 1) & index->slotMask);
+		index->slots[slot] = i + 1;
+	}
+	index->count = nodeCount;
+
+	return index;
+}
+
+void sml_tree_index_destroy(SML_Tree_Index* index) {
+	p_sml_free(index);
+}
+
+SML_Tree* sml_tree_index_find(const SML_Tree_Index* index, const SML_TreePath* path) {
+	const SML_Tree_Index_Entry* entry;
+	uint32_t hash = SML_TREE_PATH_SEED;
+	uint32_t slot;
+	uint32_t e;
+	uint32_t i;
+
+	if(path->listSize == 0) {
+		return NULL;
+	}
+	for(i=0; i<path->listSize; i++) {
+		hash = p_sml_tree_path_hash(hash, path->path_Entry[i]);
+	}
+	/* Entries were inserted in preorder, the first match is the first node */
+	for(slot = hash & index->slotMask; index->slots[slot] != 0; slot = (slot + 1) & index->slotMask) {
+		entry = &index->entries[index->slots[slot] - 1];
+		if(entry->hash != hash || entry->depth != path->listSize - 1) {
+			continue;
+		}
+		/* Verify the components from the node up to the root */
+		for(e = index->slots[slot] - 1, i = path->listSize; i > 0; e = index->entries[e].parent, i--) {
+			if(!p_sml_tree_name_equals(index->entries[e].node->parameterName, path->path_Entry[i-1])) {
+				break;
+			}
+		}
+		if(i == 0) {
+			return entry->node;
+		}
+	}
+	return NULL;
+}
+
+uint8_t sml_flat_tree_from_tree(SML_Flat_Tree* target, SML_Tree* root) {
+	SML_Tree_Walk walk;
+	SML_Tree* node;
+	SML_Flat_Node* flat;
+	uint32_t open[SMLLIB_TREE_MAX_DEPTH + 1];	/* node index per depth on the current path */
+	uint32_t nodeCount = 0;
+	uint32_t valueCount = 0;
+	uint32_t depth = 0;
+	uint32_t i = 0;
+	uint32_t v = 0;
+
+	walk.depth = 0;
+	walk.overflow = FALSE;
+	for(node = root; node != NULL; node = p_sml_tree_next(&walk, node)) {
+		nodeCount++;
+		valueCount += (node->parameterValue != NULL) ? 1 : 0;
+	}
+	if(walk.overflow || p_sml_flat_tree_alloc(target, nodeCount, valueCount) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+
+	for(node = root; node != NULL; node = p_sml_tree_next(&walk, node), i++) {
+		/* Entering depth d completes the subtrees open at d and below */
+		for(; depth > walk.depth; depth--) {
+			target->nodes[open[depth-1]].end = i;
+		}
+		open[depth++] = i;
+		flat = &target->nodes[i];
+		flat->parameterName = node->parameterName;
+		flat->childCount = (node->child_List != NULL) ? node->child_List->listSize : 0;
+		flat->value = SML_FLAT_NO_VALUE;
+		if(node->parameterValue != NULL) {
+			target->values[v] = *node->parameterValue;
+			flat->value = v++;
+		}
+	}
+	for(; depth > 0; depth--) {
+		target->nodes[open[depth-1]].end = i;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t sml_flat_tree_copy(SML_Flat_Tree* target, const SML_Flat_Tree* source) {
+	if(p_sml_flat_tree_alloc(target, source->nodeCount, source->valueCount) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	/* Values follow the nodes in the same block */
+	p_sml_memcpy(target->nodes, source->nodes, source->nodeCount * sizeof(SML_Flat_Node) + source->valueCount * sizeof(SML_ProcParValue));
+
+	return SML_PARSE_OK;
+}
+
+void sml_flat_tree_free(SML_Flat_Tree* tree) {
+	p_sml_free(tree->nodes);
+	tree->nodes = NULL;
+	tree->values = NULL;
+	tree->nodeCount = 0;
+	tree->valueCount = 0;
+}
+
+uint32_t sml_flat_tree_find(const SML_Flat_Tree* tree, const SML_TreePath* path) {
+	uint32_t node = 0;
+	uint32_t child;
+	uint32_t i;
+
+	if(path->listSize == 0 || tree->nodeCount == 0 ||
+		!p_sml_tree_name_equals(tree->nodes[0].parameterName, path->path_Entry[0])) {
+		return SML_FLAT_NO_VALUE;
+	}
+	for(i=1; i<path->listSize; i++) {
+		/* Children start behind the node, each one behind its previous sibling */
+		for(child = node + 1; child < tree->nodes[node].end; child = tree->nodes[child].end) {
+			if(p_sml_tree_name_equals(tree->nodes[child].parameterName, path->path_Entry[i])) {
+				break;
+			}
+		}
+		if(child == tree->nodes[node].end) {
+			return SML_FLAT_NO_VALUE;
+		}
+		node = child;
+	}
+	return node;
+}
+
+uint8_t p_sml_flat_tree_alloc(SML_Flat_Tree* tree, uint32_t nodeCount, uint32_t valueCount) {
+	tree->nodes = (SML_Flat_Node*)p_sml_calloc(1, nodeCount * sizeof(SML_Flat_Node) + valueCount * sizeof(SML_ProcParValue));
+	if(tree->nodes == NULL) {
+		return SML_PARSE_ERROR;
+	}
+	tree->values = (SML_ProcParValue*)(tree->nodes + nodeCount);
+	tree->nodeCount = nodeCount;
+	tree->valueCount = valueCount;
+
+	return SML_PARSE_OK;
+}
+
+uint32_t p_sml_tree_path_hash(uint32_t hash, const char* name) {
+	/* FNV-1a over the name, continued from the parent path */
+	const unsigned char* c = (const unsigned char*)name;
+
+	for(; c != NULL && *c != '\0'; c++) {
+		hash ^= *c;
+		hash *= 16777619UL;
+	}
+	/* Component separator */
+	hash ^= 0xFF;
+	hash *= 16777619UL;
+	return hash;
+}
+
+SML_Boolean p_sml_tree_name_equals(const char* parameterName, const char* name) {
+	if(parameterName == NULL || name == NULL) {
+		return (parameterName == name) ? TRUE : FALSE;
+	}
+	return (p_sml_strcmp(parameterName, name) == 0) ? TRUE : FALSE;
+}
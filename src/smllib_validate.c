@@ -0,0 +1,747 @@
+/**
+ * File name: smllib_validate.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_validate.h"
+#include "smllib_tools.h"
+
+/* Length of the start escape and of the end escape with padding count and crc */
+#define SML_VALIDATE_ESCAPE_LENGTH 8
+
+uint8_t sml_validate_message(const unsigned char* smlBinary, uint32_t length, uint32_t* offset) {
+	SML_Validator validator;
+
+	p_sml_validator_init(&validator, smlBinary, *offset, length, FALSE);
+	if(p_sml_validate_message(&validator) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+
+	*offset = validator.position;
+	return SML_PARSE_OK;
+}
+
+uint8_t sml_transport_validate_message(const unsigned char* smlBinary, uint32_t length, uint32_t* offset) {
+	static const unsigned char startOfMsg[SML_VALIDATE_ESCAPE_LENGTH] = { 0x1B, 0x1B, 0x1B, 0x1B, 0x01, 0x01, 0x01, 0x01 };
+	SML_Validator validator;
+	uint32_t escape;
+	uint16_t crc16;
+
+	if(*offset > length || length - *offset < SML_VALIDATE_ESCAPE_LENGTH ||
+		p_sml_memcmp(smlBinary + *offset, startOfMsg, SML_VALIDATE_ESCAPE_LENGTH) != 0) {
+		return SML_PARSE_ERROR;
+	}
+
+	p_sml_validator_init(&validator, smlBinary, *offset + SML_VALIDATE_ESCAPE_LENGTH, length, TRUE);
+	if(p_sml_validate_message(&validator) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	/* Padding (and whatever the parser ignores as well) up to the end escape */
+	while(!validator.endFound && p_sml_validate_read(&validator, NULL, 1) == SML_PARSE_OK);
+	if(!validator.endFound) {
+		return SML_PARSE_ERROR;
+	}
+
+	/* 1B1B1B1B 1A, padding count, crc16 over the frame up to the padding count */
+	escape = validator.end;
+	if(length - escape < SML_VALIDATE_ESCAPE_LENGTH) {
+		return SML_PARSE_ERROR;
+	}
+	crc16 = p_sml_crc16_update(0xFFFF, smlBinary + *offset, escape + 6 - *offset);
+	if(smlBinary[escape + 6] != (unsigned char)(crc16 >> 8) || smlBinary[escape + 7] != (unsigned char)(crc16 & 0xFF)) {
+		return SML_PARSE_ERROR;
+	}
+
+	*offset = escape + SML_VALIDATE_ESCAPE_LENGTH;
+	return SML_PARSE_OK;
+}
+
+void p_sml_validator_init(SML_Validator* validator, const unsigned char* data, uint32_t position, uint32_t end, SML_Boolean transport) {
+	validator->data = data;
+	validator->position = position;
+	validator->end = end;
+	validator->ones = 0;
+	validator->crc = 0xFFFF;
+	validator->crcPosition = position;
+	validator->transport = transport;
+	validator->endFound = FALSE;
+}
+
+uint8_t p_sml_validate_read(SML_Validator* validator, unsigned char* out, uint32_t count) {
+	static const unsigned char escapeByte = 0x1B;
+	const unsigned char* data = validator->data;
+	uint32_t chunk;
+	uint32_t i;
+
+	/* Plain message: bounds check only, the crc follows in p_sml_validate_crc() */
+	if(!validator->transport) {
+		if(count > validator->end - validator->position) {
+			return SML_PARSE_ERROR;
+		}
+		if(out != NULL) {
+			p_sml_memcpy(out, data + validator->position, count);
+		}
+		validator->position += count;
+		return SML_PARSE_OK;
+	}
+
+	while(count > 0) {
+		if(validator->ones == 0 && validator->position < validator->end && data[validator->position] == 0x1B) {
+			p_sml_validate_run(validator);
+		}
+		if(validator->ones > 0) {
+			chunk = (validator->ones < count) ? validator->ones : count;
+			validator->ones -= chunk;
+			count -= chunk;
+			for(i=0; i<chunk; i++) {
+				validator->crc = p_sml_crc16_update(validator->crc, &escapeByte, 1);
+				if(out != NULL) {
+					*out++ = 0x1B;
+				}
+			}
+			continue;
+		}
+		if(validator->position >= validator->end) {
+			return SML_PARSE_ERROR;
+		}
+
+		/* Literal bytes up to the next 0x1B run */
+		chunk = validator->end - validator->position;
+		if(chunk > count) {
+			chunk = count;
+		}
+		for(i=0; i<chunk && data[validator->position + i] != 0x1B; i++);
+		if(out != NULL) {
+			p_sml_memcpy(out, data + validator->position, i);
+			out += i;
+		}
+		validator->position += i;
+		count -= i;
+	}
+
+	return SML_PARSE_OK;
+}
+
+void p_sml_validate_crc(SML_Validator* validator) {
+	validator->crc = p_sml_crc16_update(validator->crc, validator->data + validator->crcPosition,
+		validator->position - validator->crcPosition);
+	validator->crcPosition = validator->position;
+}
+
+void p_sml_validate_run(SML_Validator* validator) {
+	uint32_t run = 0;
+
+	/* The literal bytes in front count first, the run's bytes as they are read */
+	p_sml_validate_crc(validator);
+	while(validator->position + run < validator->end && validator->data[validator->position + run] == 0x1B) {
+		run++;
+	}
+	/* Every eight 0x1B stand for four, like in p_sml_transport_unescape() */
+	validator->ones = (run / 8) * 4 + run % 8;
+	if(run % 8 >= 4 && validator->position + run < validator->end && validator->data[validator->position + run] == 0x1A) {
+		/* The last four are the end escape, nothing behind it belongs to the message */
+		validator->ones -= 4;
+		validator->end = validator->position + run - 4;
+		validator->position = validator->end;
+		validator->endFound = TRUE;
+	}
+	else {
+		validator->position += run;
+	}
+	validator->crcPosition = validator->position;
+}
+
+uint8_t p_sml_validate_message(SML_Validator* validator) {
+	uint64_t choiceTag;
+	uint64_t crc16;
+	uint16_t crc;
+	unsigned char endOfSmlMessage;
+
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 6) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_listsize(validator, 2) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint32_t), &choiceTag) ||
+		SML_PARSE_ERROR == p_sml_validate_messagebody(validator, (uint32_t)choiceTag)) {
+		return SML_PARSE_ERROR;
+	}
+
+	p_sml_validate_crc(validator);
+	crc = validator->crc;
+	if(	SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint16_t), &crc16) ||
+		crc16 != crc ||
+		SML_PARSE_ERROR == p_sml_validate_read(validator, &endOfSmlMessage, 1) ||
+		endOfSmlMessage != 0x00) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_messagebody(SML_Validator* validator, uint32_t choiceTag) {
+	switch(choiceTag) {
+		case SML_MESSAGEBODY_OPEN_REQUEST:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 7) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_number_optional(validator, UNSIGNED, sizeof(uint8_t))) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_OPEN_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 6) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time_optional(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_number_optional(validator, UNSIGNED, sizeof(uint8_t))) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_CLOSE_REQUEST:
+		case SML_MESSAGEBODY_CLOSE_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 1) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROFILEPACK_REQUEST:
+		case SML_MESSAGEBODY_GETPROFILELIST_REQUEST:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 9) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_boolean_optional(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time_optional(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time_optional(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_treepath(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_list_of_string_optional(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_tree_optional(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 8) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint32_t), NULL) ||
+				SML_PARSE_ERROR == p_sml_validate_treepath(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_list_of(validator, p_sml_validate_objheaderentry) ||
+				SML_PARSE_ERROR == p_sml_validate_list_of(validator, p_sml_validate_objperiodentry) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROFILELIST_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 9) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint32_t), NULL) ||
+				SML_PARSE_ERROR == p_sml_validate_treepath(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint64_t), NULL) ||
+				SML_PARSE_ERROR == p_sml_validate_list_of(validator, p_sml_validate_periodentry) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_REQUEST:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 5) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_treepath(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 3) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_treepath(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_tree(validator, FALSE)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_SETPROCPARAMETER_REQUEST:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 5) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_treepath(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_tree(validator, FALSE)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETLIST_REQUEST:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 5) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_GETLIST_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 7) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time_optional(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_list_of(validator, p_sml_validate_listentry) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_time_optional(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+		case SML_MESSAGEBODY_ATTENTION_RESPONSE:
+			if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 4) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+				SML_PARSE_ERROR == p_sml_validate_tree_optional(validator)) {
+				return SML_PARSE_ERROR;
+			}
+		break;
+
+		default:
+			return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_tlfield(SML_Validator* validator, TL_FieldType* tl_type, uint32_t* tl_value) {
+	unsigned char first;
+
+	/* Most fields are plain single byte reads */
+	if(!validator->transport && validator->position < validator->end) {
+		first = validator->data[validator->position++];
+	}
+	else if(p_sml_validate_read(validator, &first, 1) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_tlfield_from(validator, first, tl_type, tl_value);
+}
+
+uint8_t p_sml_validate_tlfield_from(SML_Validator* validator, unsigned char first, TL_FieldType* tl_type, uint32_t* tl_value) {
+	unsigned char next = first;
+	uint32_t bytes = 1;
+
+	switch(first & 0x70) {
+		case 0x00: *tl_type = STRING; break;
+		case 0x40: *tl_type = BOOLEAN; break;
+		case 0x50: *tl_type = INTEGER; break;
+		case 0x60: *tl_type = UNSIGNED; break;
+		case 0x70: *tl_type = LIST; break;
+		default: return SML_PARSE_ERROR;
+	}
+
+	*tl_value = (first & 0x0F);
+	while((next & 0x80) == 0x80) {
+		/* At most the eight length nibbles a uint32_t holds */
+		if(bytes == 8 || p_sml_validate_read(validator, &next, 1) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+		*tl_value = (*tl_value << 4) | (next & 0x0F);
+		bytes++;
+	}
+
+	/* The length of a non-list field includes the TL bytes */
+	if(*tl_type != LIST) {
+		if(*tl_value < bytes) {
+			return SML_PARSE_ERROR;
+		}
+		*tl_value -= bytes;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_listsize(SML_Validator* validator, uint32_t listSize) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(	SML_PARSE_ERROR == p_sml_validate_tlfield(validator, &tl_type, &tl_value) ||
+		tl_type != LIST || tl_value != listSize) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_list(SML_Validator* validator, uint32_t* listSize) {
+	TL_FieldType tl_type;
+
+	if(	SML_PARSE_ERROR == p_sml_validate_tlfield(validator, &tl_type, listSize) ||
+		tl_type != LIST || *listSize == 0) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_string(SML_Validator* validator) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(	SML_PARSE_ERROR == p_sml_validate_tlfield(validator, &tl_type, &tl_value) ||
+		tl_type != STRING) {
+		return SML_PARSE_ERROR;
+	}
+
+	return p_sml_validate_read(validator, NULL, tl_value);
+}
+
+uint8_t p_sml_validate_scalar(SML_Validator* validator, TL_FieldType tl_type, uint32_t tl_value, TL_FieldType type, uint32_t size, uint64_t* number) {
+	unsigned char bytes[sizeof(uint64_t)];
+	uint32_t i;
+
+	if(tl_type != type || tl_value == 0 || tl_value > size ||
+		p_sml_validate_read(validator, (number != NULL) ? bytes : NULL, tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(number != NULL) {
+		*number = 0;
+		for(i=0; i<tl_value; i++) {
+			*number = (*number << 8) | bytes[i];
+		}
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_number(SML_Validator* validator, TL_FieldType type, uint32_t size, uint64_t* number) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_scalar(validator, tl_type, tl_value, type, size, number);
+}
+
+uint8_t p_sml_validate_number_optional(SML_Validator* validator, TL_FieldType type, uint32_t size) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type == STRING && tl_value == 0) {
+		return SML_PARSE_OK;
+	}
+	return p_sml_validate_scalar(validator, tl_type, tl_value, type, size, NULL);
+}
+
+uint8_t p_sml_validate_boolean_optional(SML_Validator* validator) {
+	return p_sml_validate_number_optional(validator, BOOLEAN, sizeof(SML_Boolean));
+}
+
+uint8_t p_sml_validate_value(SML_Validator* validator) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type == STRING) {
+		return p_sml_validate_read(validator, NULL, tl_value);
+	}
+	else if(tl_type == BOOLEAN) {
+		return p_sml_validate_scalar(validator, tl_type, tl_value, BOOLEAN, sizeof(SML_Boolean), NULL);
+	}
+	else if(tl_type == INTEGER || tl_type == UNSIGNED) {
+		return p_sml_validate_scalar(validator, tl_type, tl_value, tl_type, sizeof(uint64_t), NULL);
+	}
+	else {
+		return SML_PARSE_ERROR;
+	}
+}
+
+uint8_t p_sml_validate_status_optional(SML_Validator* validator) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	unsigned char first;
+
+	/* Only the one byte form of an absent field, see p_sml_parse_absent() */
+	if(p_sml_validate_read(validator, &first, 1) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(first == 0x01) {
+		return SML_PARSE_OK;
+	}
+	if(p_sml_validate_tlfield_from(validator, first, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_scalar(validator, tl_type, tl_value, UNSIGNED, sizeof(uint64_t), NULL);
+}
+
+uint8_t p_sml_validate_time_choice(SML_Validator* validator) {
+	uint64_t choiceTag;
+
+	if(	SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), &choiceTag) ||
+		(choiceTag != SML_TIME_SECINDEX && choiceTag != SML_TIME_TIMESTAMP)) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_number(validator, UNSIGNED, sizeof(uint32_t), NULL);
+}
+
+uint8_t p_sml_validate_time(SML_Validator* validator) {
+	if(p_sml_validate_listsize(validator, 2) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_time_choice(validator);
+}
+
+uint8_t p_sml_validate_time_optional(SML_Validator* validator) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type == STRING && tl_value == 0) {
+		return SML_PARSE_OK;
+	}
+	if(tl_type != LIST || tl_value != 2) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_time_choice(validator);
+}
+
+uint8_t p_sml_validate_treepath(SML_Validator* validator) {
+	return p_sml_validate_list_of(validator, p_sml_validate_string);
+}
+
+uint8_t p_sml_validate_tree(SML_Validator* validator, SML_Boolean headerRead) {
+	uint32_t remaining[SMLLIB_TREE_MAX_DEPTH];	/* children still to come per open child list */
+	uint32_t depth = 0;
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	for(;;) {
+		if(	(!headerRead && SML_PARSE_ERROR == p_sml_validate_listsize(validator, 3)) ||
+			SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+			SML_PARSE_ERROR == p_sml_validate_tlfield(validator, &tl_type, &tl_value)) {
+			return SML_PARSE_ERROR;
+		}
+		headerRead = FALSE;
+
+		/* parameterValue */
+		if(tl_type == LIST && tl_value == 2) {
+			if(p_sml_validate_procparvalue_choice(validator) == SML_PARSE_ERROR) {
+				return SML_PARSE_ERROR;
+			}
+		}
+		else if(tl_type != STRING || tl_value != 0) {
+			return SML_PARSE_ERROR;
+		}
+
+		/* child_List */
+		if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+		if(tl_type == LIST && tl_value > 0) {
+			if(depth == SMLLIB_TREE_MAX_DEPTH) {
+				return SML_PARSE_ERROR;
+			}
+			remaining[depth++] = tl_value;
+		}
+		else if(tl_type != STRING || tl_value != 0) {
+			return SML_PARSE_ERROR;
+		}
+
+		while(depth > 0 && remaining[depth-1] == 0) {
+			depth--;
+		}
+		if(depth == 0) {
+			return SML_PARSE_OK;
+		}
+		remaining[depth-1]--;
+	}
+}
+
+uint8_t p_sml_validate_tree_optional(SML_Validator* validator) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+
+	if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type == STRING && tl_value == 0) {
+		return SML_PARSE_OK;
+	}
+	if(tl_type != LIST || tl_value != 3) {
+		return SML_PARSE_ERROR;
+	}
+	return p_sml_validate_tree(validator, TRUE);
+}
+
+uint8_t p_sml_validate_procparvalue_choice(SML_Validator* validator) {
+	uint64_t choiceTag;
+
+	if(p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), &choiceTag) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	switch(choiceTag) {
+		case SML_PROCPAR_VALUE: return p_sml_validate_value(validator);
+		case SML_PROCPAR_PERIOD: return p_sml_validate_periodentry(validator);
+		case SML_PROCPAR_TUPEL: return p_sml_validate_tupelentry(validator);
+		case SML_PROCPAR_TIME: return p_sml_validate_time(validator);
+		default: return SML_PARSE_ERROR;
+	}
+}
+
+uint8_t p_sml_validate_periodentry(SML_Validator* validator) {
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 5) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, INTEGER, sizeof(int8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_value(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_tupelentry(SML_Validator* validator) {
+	uint32_t i;
+
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 23) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_time(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint64_t), NULL)) {
+		return SML_PARSE_ERROR;
+	}
+	/* unit, scaler and value of pA, R1, R4, mA, R2 and R3 */
+	for(i=0; i<6; i++) {
+		if(	SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+			SML_PARSE_ERROR == p_sml_validate_number(validator, INTEGER, sizeof(int8_t), NULL) ||
+			SML_PARSE_ERROR == p_sml_validate_number(validator, INTEGER, sizeof(int64_t), NULL)) {
+			return SML_PARSE_ERROR;
+		}
+	}
+	if(	SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_listentry(SML_Validator* validator) {
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 7) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_status_optional(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_time_optional(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number_optional(validator, UNSIGNED, sizeof(uint8_t)) ||
+		SML_PARSE_ERROR == p_sml_validate_number_optional(validator, INTEGER, sizeof(int8_t)) ||
+		SML_PARSE_ERROR == p_sml_validate_value(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_objheaderentry(SML_Validator* validator) {
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 3) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint8_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, INTEGER, sizeof(int8_t), NULL)) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_objperiodentry(SML_Validator* validator) {
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 4) ||
+		SML_PARSE_ERROR == p_sml_validate_time(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_number(validator, UNSIGNED, sizeof(uint64_t), NULL) ||
+		SML_PARSE_ERROR == p_sml_validate_list_of(validator, p_sml_validate_valueentry) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_valueentry(SML_Validator* validator) {
+	if(	SML_PARSE_ERROR == p_sml_validate_listsize(validator, 2) ||
+		SML_PARSE_ERROR == p_sml_validate_value(validator) ||
+		SML_PARSE_ERROR == p_sml_validate_string(validator)) {
+		return SML_PARSE_ERROR;
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_list_of(SML_Validator* validator, uint8_t (*entry)(SML_Validator*)) {
+	uint32_t listSize;
+	uint32_t i;
+
+	if(p_sml_validate_list(validator, &listSize) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	for(i=0; i<listSize; i++) {
+		if(entry(validator) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+	}
+
+	return SML_PARSE_OK;
+}
+
+uint8_t p_sml_validate_list_of_string_optional(SML_Validator* validator) {
+	TL_FieldType tl_type;
+	uint32_t tl_value;
+	uint32_t i;
+
+	if(p_sml_validate_tlfield(validator, &tl_type, &tl_value) == SML_PARSE_ERROR) {
+		return SML_PARSE_ERROR;
+	}
+	if(tl_type == STRING && tl_value == 0) {
+		return SML_PARSE_OK;
+	}
+	if(tl_type != LIST || tl_value == 0) {
+		return SML_PARSE_ERROR;
+	}
+	for(i=0; i<tl_value; i++) {
+		if(p_sml_validate_string(validator) == SML_PARSE_ERROR) {
+			return SML_PARSE_ERROR;
+		}
+	}
+
+	return SML_PARSE_OK;
+}
@@ -0,0 +1,232 @@
+/**
+ * File name: test_allocator.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+
+typedef struct Test_Allocator_State {
+	int32_t live;
+	uint32_t hookCalls;
+	uint32_t hookGetListCalls;
+	uint32_t calls;
+	uint32_t failAt;			/* 0 never fails */
+} Test_Allocator_State;
+
+static SML_Boolean test_fail(Test_Allocator_State* state) {
+	return (++state->calls == state->failAt) ? TRUE : FALSE;
+}
+
+static void* test_alloc(void* user, size_t size) {
+	Test_Allocator_State* state = (Test_Allocator_State*)user;
+
+	if(test_fail(state)) {
+		return NULL;
+	}
+	state->live++;
+	return malloc(size);
+}
+
+static void* test_realloc(void* user, void* ptr, size_t size) {
+	if(test_fail((Test_Allocator_State*)user)) {
+		return NULL;
+	}
+	return realloc(ptr, size);
+}
+
+static void test_free(void* user, void* ptr) {
+	((Test_Allocator_State*)user)->live--;
+	free(ptr);
+}
+
+static void test_hook(void* user, uint32_t choiceTag, size_t size) {
+	Test_Allocator_State* state = (Test_Allocator_State*)user;
+	(void)size;
+	state->hookCalls++;
+	if(choiceTag == SML_MESSAGEBODY_GETLIST_RESPONSE) {
+		state->hookGetListCalls++;
+	}
+}
+
+int main(void) {
+	SML_Context context;
+	SML_Context* previous;
+	SML_Allocator allocator;
+	Test_Allocator_State state;
+	SML_Message message;
+	SML_Message refMessage;
+	SML_GetList_Res getListRes;
+	SML_ListEntry entries[2];
+	SML_Encode_Binary_Result result;
+	SML_Alloc_Counter* counter;
+	SML_Context failing;
+	SML_File parsedFile;
+	SML_Encode_Binary_Result plain;
+	uint8_t parsed;
+	uint32_t failures = 0;
+	uint32_t offset = 0;
+	int retValue = 0;
+
+	uint8_t unit = 30;
+	int8_t scaler = -1;
+	char objName[] = {"MyObjectName"};
+	char transactionId[] = {"Allocator_TransactionId"};
+	char serverId[] = {"MyServer"};
+
+	entries[0].objName = objName;
+	entries[0].status = NULL;
+	entries[0].valTime = NULL;
+	entries[0].unit = &unit;
+	entries[0].scaler = &scaler;
+	entries[0].value.choiceTag = SML_VALUE_UINT32;
+	entries[0].value.choiceValue.uint32 = 12345;
+	entries[0].valueSignature = NULL;
+	entries[1] = entries[0];
+	entries[1].value.choiceTag = SML_VALUE_INT16;
+	entries[1].value.choiceValue.int16 = -42;
+
+	getListRes.clientId = NULL;
+	getListRes.serverId = serverId;
+	getListRes.listName = NULL;
+	getListRes.actSensorTime = NULL;
+	getListRes.actGatewayTime = NULL;
+	getListRes.listSignature = NULL;
+	getListRes.valList.listSize = 2;
+	getListRes.valList.valListEntry = entries;
+
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &getListRes;
+
+	state.live = 0;
+	state.hookCalls = 0;
+	state.hookGetListCalls = 0;
+	state.calls = 0;
+	state.failAt = 0;
+	allocator.alloc = test_alloc;
+	allocator.realloc = test_realloc;
+	allocator.free = test_free;
+	allocator.user = &state;
+
+	sml_context_init(&context);
+	sml_context_set_allocator(&context, &allocator);
+	sml_context_set_alloc_hook(&context, test_hook, &state);
+	previous = sml_context_use(&context);
+
+	/* Encode, parse and release everything with the custom allocator */
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK ||
+		sml_transport_parse_message(result.resultBinary, &offset, &refMessage) != SML_PARSE_OK ||
+		refMessage.messageBody.choiceValue.getListResponse->valList.valListEntry[1].value.choiceValue.int16 != -42) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_encode_result_free(&result);
+
+	if(sml_context_use(previous) != &context) {
+		retValue = 1;
+	}
+
+	/* All blocks released, every allocation attributed to the message type */
+	counter = &context.allocStats.messageType[sml_messagebody_index(SML_MESSAGEBODY_GETLIST_RESPONSE)];
+	if(state.live != 0 ||
+		context.allocStats.total.allocations == 0 ||
+		context.allocStats.total.allocations != context.allocStats.total.frees ||
+		counter->allocations != context.allocStats.total.allocations ||
+		context.allocStats.messageType[SML_MESSAGEBODY_INDEX_NONE].allocations != 0 ||
+		state.hookCalls != context.allocStats.total.allocations + context.allocStats.total.reallocations ||
+		state.hookGetListCalls == 0) {
+		retValue = 1;
+	}
+
+	/* Fail each allocation in turn (the value makes the escape grow its
+	 * buffer), until the encoding gets through without a failure */
+	entries[0].value.choiceValue.uint32 = 0x1B1B1B1B;
+	sml_context_init(&failing);
+	sml_context_set_allocator(&failing, &allocator);
+	sml_context_use(&failing);
+	for(state.failAt = 1; retValue == 0; state.failAt++) {
+		state.calls = 0;
+		result = sml_transport_encode_message(&message);
+		if(state.calls < state.failAt) {
+			sml_encode_result_free(&result);
+			break;
+		}
+		failures++;
+		if(result.resultCode != SML_ENCODE_ERROR || result.resultBinary != NULL ||
+			result.errorMessage == NULL || sml_context_error(&failing)->code != SML_ERROR_NOMEM ||
+			state.live != 0) {
+			retValue = 1;
+		}
+	}
+	if(failures < 20 || state.live != 0) {
+		retValue = 1;
+	}
+
+	/* The file parsers report a failed allocation as SML_ERROR_NOMEM too,
+	 * a single message is a file of one */
+	state.failAt = 0;
+	plain = sml_encode_message_binary(&message);
+	result = sml_transport_encode_message(&message);
+	if(plain.resultCode != SML_ENCODE_OK || result.resultCode != SML_ENCODE_OK) {
+		retValue = 1;
+	}
+	failures = 0;
+	for(state.failAt = 1; retValue == 0; state.failAt++) {
+		state.calls = 0;
+		parsed = sml_parse_file_binary(plain.resultBinary, 1, &parsedFile);
+		sml_parser_free();
+		if(state.calls < state.failAt) {
+			break;
+		}
+		failures++;
+		if(parsed != SML_PARSE_NOMEM || sml_context_error(&failing)->code != SML_ERROR_NOMEM) {
+			retValue = 1;
+		}
+	}
+	for(state.failAt = 1; retValue == 0; state.failAt++) {
+		state.calls = 0;
+		parsed = sml_transport_parse_file(result.resultBinary, 1, &parsedFile);
+		sml_parser_free();
+		if(state.calls < state.failAt) {
+			break;
+		}
+		failures++;
+		if(parsed != SML_PARSE_NOMEM || sml_context_error(&failing)->code != SML_ERROR_NOMEM) {
+			retValue = 1;
+		}
+	}
+	state.failAt = 0;
+	sml_encode_result_free(&plain);
+	sml_encode_result_free(&result);
+	sml_context_use(previous);
+	if(failures < 4 || state.live != 0) {
+		retValue = 1;
+	}
+
+	return retValue;
+}
@@ -0,0 +1,217 @@
+/**
+ * File name: test_capture.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* pwrite() and ftruncate(), 64 bit off_t on 32 bit hosts */
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_capture.h"
+#include "smllib_metrics.h"
+
+#define CAPTURE_PATH "test_capture.sml"
+#define CAPTURE_FRAMES 1000
+#define LARGE_PATH "test_capture_large.sml"
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	SML_Capture capture;
+	#ifndef SMLLIB_NO_METRICS
+		SML_Metrics_Snapshot snapshot;
+	#endif
+	const unsigned char* frame;
+	unsigned char* good;
+	unsigned char* bad;
+	uint64_t expected[3];
+	uint64_t large[3];
+	uint64_t noise;
+	uint32_t goodLength;
+	uint32_t length;
+	uint32_t count = 0;
+	uint32_t i;
+	FILE* out;
+	int sparse;
+	int fd;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[512];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	closeResponse.globalSignature = "\x1B\x1B\x1B\x1B" "S";
+	message.transactionId = "capture";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK) {
+		return 1;
+	}
+	goodLength = result.length;
+	good = (unsigned char*)malloc(goodLength);
+	bad = (unsigned char*)malloc(goodLength);
+	memcpy(good, result.resultBinary, goodLength);
+	memcpy(bad, good, goodLength);
+	bad[goodLength - 1] ^= 0xFF;
+	sml_encode_result_free(&result);
+
+	/* noise, good, bad CRC, good, truncated, good frames, noise */
+	out = fopen(CAPTURE_PATH, "wb");
+	if(out == NULL) {
+		return 1;
+	}
+	fwrite("\x1B\x1B\x01noise", 1, 8, out);
+	expected[0] = 8;
+	fwrite(good, 1, goodLength, out);
+	fwrite(bad, 1, goodLength, out);
+	expected[1] = 8 + 2 * (uint64_t)goodLength;
+	fwrite(good, 1, goodLength, out);
+	fwrite(good, 1, goodLength / 2, out);
+	expected[2] = expected[1] + goodLength + goodLength / 2;
+	for(i=0; i<CAPTURE_FRAMES; i++) {
+		fwrite(good, 1, goodLength, out);
+	}
+	fwrite("\x1B\x1B\x1B", 1, 3, out);
+	if(fclose(out) != 0) {
+		return 1;
+	}
+	noise = 8 + goodLength + goodLength / 2 + 3;
+
+	/* Small window, so pages are released on the way */
+	sml_metrics_reset(&context);
+	if(sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_OK) {
+		return 1;
+	}
+	capture.window = capture.pageSize;
+	while(sml_capture_next(&capture, &message) == SML_PARSE_OK) {
+		if((count < 3 && capture.frameOffset != expected[count]) ||
+			capture.frameLength != goodLength ||
+			message.messageBody.choiceTag != SML_MESSAGEBODY_CLOSE_RESPONSE ||
+			strcmp(message.transactionId, "capture") != 0) {
+			retValue = 1;
+		}
+		count++;
+		sml_parser_free();
+	}
+	if(count != CAPTURE_FRAMES + 2 || capture.offset != capture.size ||
+		capture.skippedFrames != 2 || capture.skippedBytes != noise ||
+		capture.released == 0) {
+		retValue = 1;
+	}
+	#ifndef SMLLIB_NO_METRICS
+		sml_metrics_snapshot(&context, &snapshot);
+		if(snapshot.counters.framesSkipped != 2 || snapshot.counters.resyncBytes != noise) {
+			retValue = 1;
+		}
+	#endif
+
+	/* Back to an earlier frame, released pages are read again */
+	sml_capture_seek(&capture, expected[1]);
+	if(sml_capture_next_frame(&capture, &frame, &length) != SML_PARSE_OK ||
+		capture.frameOffset != expected[1] || length != goodLength ||
+		memcmp(frame, good, goodLength) != 0) {
+		retValue = 1;
+	}
+	sml_capture_seek(&capture, capture.size);
+	if(sml_capture_next(&capture, &message) != SML_CAPTURE_END) {
+		retValue = 1;
+	}
+	sml_capture_close(&capture);
+
+	/* Sparse capture past 4 GB, frames before, across and after 2^32 */
+	large[0] = 4096;
+	large[1] = ((uint64_t)1 << 32) - goodLength / 2;
+	large[2] = ((uint64_t)1 << 32) + 65536;
+	fd = open(LARGE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	sparse = (fd >= 0 && ftruncate(fd, (off_t)(large[2] + 65536)) == 0);
+	for(i=0; sparse && i<3; i++) {
+		sparse = (pwrite(fd, good, goodLength, (off_t)large[i]) == (ssize_t)goodLength);
+	}
+	if(fd >= 0 && close(fd) != 0) {
+		sparse = 0;
+	}
+	/* Without sparse files or a 64 bit address space there is nothing to test */
+	if(sparse && sml_capture_open(&capture, LARGE_PATH) == SML_PARSE_OK) {
+		count = 0;
+		while(sml_capture_next_frame(&capture, &frame, &length) == SML_PARSE_OK) {
+			if(count >= 3 || capture.frameOffset != large[count] || length != goodLength ||
+				memcmp(frame, good, goodLength) != 0) {
+				retValue = 1;
+			}
+			count++;
+		}
+		if(count != 3 || capture.offset != capture.size || capture.skippedFrames != 0 ||
+			capture.skippedBytes != capture.size - 3 * (uint64_t)goodLength) {
+			retValue = 1;
+		}
+		sml_capture_seek(&capture, large[1]);
+		for(i=1; i<3; i++) {
+			if(sml_capture_next(&capture, &message) != SML_PARSE_OK || capture.frameOffset != large[i] ||
+				strcmp(message.transactionId, "capture") != 0) {
+				retValue = 1;
+			}
+			sml_parser_free();
+		}
+		sml_capture_close(&capture);
+	}
+	else if(sparse && sizeof(size_t) >= 8) {
+		retValue = 1;
+	}
+	remove(LARGE_PATH);
+
+	/* Empty and missing files */
+	out = fopen(CAPTURE_PATH, "wb");
+	if(out == NULL || fclose(out) != 0 ||
+		sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_OK ||
+		sml_capture_next(&capture, &message) != SML_CAPTURE_END) {
+		retValue = 1;
+	}
+	sml_capture_close(&capture);
+	remove(CAPTURE_PATH);
+	if(sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_ERROR) {
+		retValue = 1;
+	}
+
+	free(bad);
+	free(good);
+	sml_context_use(NULL);
+	return retValue;
+}
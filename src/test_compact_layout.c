@@ -0,0 +1,207 @@
+/**
+ * File name: test_compact_layout.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+
+#define ENTRY_COUNT 3
+
+#ifdef SMLLIB_STATIC_POOL
+	/* No heap in this build, the test's own contexts allocate from pools */
+	#define POOL_SIZE 16384
+	static uint64_t pool[2][POOL_SIZE / sizeof(uint64_t)];
+#endif
+
+/* Encodes message with the classic layout, parses (into compact) and
+ * re-encodes it with the compact one in the given context and compares
+ * the binaries. Returns the number of parser allocations in allocations. */
+static int compact_roundtrip(SML_Context* context, SML_Message* message, SML_Message* compact, uint32_t* allocations) {
+	SML_Encode_Binary_Result classic;
+	SML_Encode_Binary_Result result;
+	uint32_t offset = 0;
+	int retValue = 1;
+
+	sml_context_use(NULL);
+	classic = sml_encode_message_binary(message);
+
+	sml_context_use(context);
+	*allocations = context->allocStats.total.allocations;
+	if(sml_parse_message_binary(classic.resultBinary, &offset, compact) == SML_PARSE_OK) {
+		*allocations = context->allocStats.total.allocations - *allocations;
+		result = sml_encode_message_binary(compact);
+		if(result.length == classic.length && memcmp(result.resultBinary, classic.resultBinary, result.length) == 0) {
+			retValue = 0;
+		}
+		sml_encode_result_free(&result);
+	}
+	sml_context_use(NULL);
+	sml_encode_result_free(&classic);
+
+	return retValue;
+}
+
+static uint32_t classic_allocations(SML_Message* message) {
+	SML_Context context;
+	SML_Encode_Binary_Result classic;
+	SML_Message parsed;
+	uint32_t offset = 0;
+	uint32_t allocations;
+
+	classic = sml_encode_message_binary(message);
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool[0], POOL_SIZE);
+	#endif
+	sml_context_use(&context);
+	sml_parse_message_binary(classic.resultBinary, &offset, &parsed);
+	allocations = context.allocStats.total.allocations;
+	sml_parser_free();
+	sml_context_use(NULL);
+	sml_encode_result_free(&classic);
+
+	return allocations;
+}
+
+int main(void) {
+	SML_Message message;
+	SML_Message compact;
+	SML_GetList_Res getListRes;
+	SML_ListEntry entries[ENTRY_COUNT];
+	SML_PublicOpen_Res openRes;
+	SML_GetList_Res_Compact* res;
+	SML_Status status;
+	SML_Time valTime;
+	SML_Time refTime;
+	SML_Context context;
+	uint32_t compactAllocations;
+	int retValue = 0;
+
+	uint8_t unit = 30;
+	int8_t scaler = -1;
+	uint8_t smlVersion = 1;
+	char objName[] = {"MyObjectName"};
+	char transactionId[] = {"Compact_TransactionId"};
+	char serverId[] = {"MyServer"};
+	char reqFileId[] = {"MyReqFileId"};
+
+	status.choiceTag = SML_STATUS_UINT16;
+	status.choiceValue.uint16 = 0x0182;
+	valTime.choiceTag = SML_TIME_SECINDEX;
+	valTime.choiceValue.secIndex = 123456;
+
+	/* Entry 0 has every optional field, entry 1 none, entry 2 unit/scaler only */
+	entries[0].objName = objName;
+	entries[0].status = &status;
+	entries[0].valTime = &valTime;
+	entries[0].unit = &unit;
+	entries[0].scaler = &scaler;
+	entries[0].value.choiceTag = SML_VALUE_UINT32;
+	entries[0].value.choiceValue.uint32 = 4711;
+	entries[0].valueSignature = NULL;
+	entries[1] = entries[0];
+	entries[1].status = NULL;
+	entries[1].valTime = NULL;
+	entries[1].unit = NULL;
+	entries[1].scaler = NULL;
+	entries[2] = entries[1];
+	entries[2].unit = &unit;
+	entries[2].scaler = &scaler;
+	entries[2].value.choiceTag = SML_VALUE_INT16;
+	entries[2].value.choiceValue.int16 = -5;
+
+	getListRes.clientId = NULL;
+	getListRes.serverId = serverId;
+	getListRes.listName = NULL;
+	getListRes.actSensorTime = NULL;
+	getListRes.actGatewayTime = &valTime;
+	getListRes.listSignature = NULL;
+	getListRes.valList.listSize = ENTRY_COUNT;
+	getListRes.valList.valListEntry = entries;
+
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &getListRes;
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool[1], POOL_SIZE);
+	#endif
+	sml_context_set_compact_layout(&context, TRUE);
+
+	if(compact_roundtrip(&context, &message, &compact, &compactAllocations) != 0) {
+		retValue = 1;
+	}
+	else {
+		res = compact.messageBody.choiceValue.getListResponseCompact;
+		if(res->present != SML_GETLISTRES_ACTGATEWAYTIME ||
+			res->actGatewayTime.choiceValue.secIndex != 123456 ||
+			res->valList.listSize != ENTRY_COUNT ||
+			res->valList.valListEntry[0].present != (SML_LISTENTRY_STATUS | SML_LISTENTRY_VALTIME | SML_LISTENTRY_UNIT | SML_LISTENTRY_SCALER) ||
+			res->valList.valListEntry[0].status.choiceValue.uint16 != 0x0182 ||
+			res->valList.valListEntry[0].value.choiceValue.uint32 != 4711 ||
+			res->valList.valListEntry[1].present != 0 ||
+			res->valList.valListEntry[2].present != (SML_LISTENTRY_UNIT | SML_LISTENTRY_SCALER) ||
+			res->valList.valListEntry[2].unit != unit ||
+			res->valList.valListEntry[2].scaler != scaler ||
+			res->valList.valListEntry[2].value.choiceValue.int16 != -5) {
+			retValue = 1;
+		}
+		/* Six optional scalars less to allocate */
+		if(compactAllocations + 6 > classic_allocations(&message)) {
+			retValue = 1;
+		}
+	}
+	sml_context_use(&context);
+	sml_parser_free();
+	sml_context_use(NULL);
+
+	/* PublicOpen_Res with refTime and smlVersion */
+	openRes.codepage = NULL;
+	openRes.clientId = NULL;
+	openRes.reqFileId = reqFileId;
+	openRes.serverId = serverId;
+	refTime.choiceTag = SML_TIME_TIMESTAMP;
+	refTime.choiceValue.timestamp = 1300000000;
+	openRes.refTime = &refTime;
+	openRes.smlVersion = &smlVersion;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_OPEN_RESPONSE;
+	message.messageBody.choiceValue.openResponse = &openRes;
+
+	if(compact_roundtrip(&context, &message, &compact, &compactAllocations) != 0 ||
+		compact.messageBody.choiceValue.openResponseCompact->present != (SML_OPENRES_REFTIME | SML_OPENRES_SMLVERSION) ||
+		compact.messageBody.choiceValue.openResponseCompact->refTime.choiceValue.timestamp != 1300000000 ||
+		compact.messageBody.choiceValue.openResponseCompact->smlVersion != 1) {
+		retValue = 1;
+	}
+	sml_context_use(&context);
+	sml_parser_free();
+	sml_context_use(NULL);
+
+	return retValue;
+}
@@ -0,0 +1,177 @@
+/**
+ * File name: test_deframer.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_deframer.h"
+
+#define STREAM_PARTS 6
+
+/* Frames delivered for the stream fed in pieces of step bytes */
+static uint32_t deframe(SML_Deframer* deframer, const unsigned char* stream, uint32_t length, uint32_t step,
+	const unsigned char* expected, uint32_t expectedLength, int* failed) {
+	const unsigned char* frame;
+	uint32_t frameLength;
+	uint32_t position = 0;
+	uint32_t count = 0;
+	uint32_t taken;
+
+	while(position < length) {
+		taken = sml_deframer_feed(deframer, stream + position,
+			(length - position < step) ? length - position : step);
+		position += taken;
+		while(sml_deframer_next(deframer, &frame, &frameLength) == SML_PARSE_OK) {
+			if(frameLength != expectedLength || memcmp(frame, expected, expectedLength) != 0) {
+				*failed = 1;
+			}
+			count++;
+		}
+	}
+	return count;
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	SML_Deframer deframer;
+	unsigned char buffer[256];
+	unsigned char other[256];
+	const unsigned char* delivered;
+	unsigned char* previous;
+	uint32_t length;
+	uint32_t frames;
+	const unsigned char* parts[STREAM_PARTS];
+	uint32_t partLength[STREAM_PARTS];
+	unsigned char* frame;
+	unsigned char* stream;
+	uint32_t frameLength;
+	uint32_t streamLength = 0;
+	uint32_t i;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[512];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* Escaped 0x1B run inside the frame */
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	closeResponse.globalSignature = "\x1B\x1B\x1B\x1B" "S";
+	message.transactionId = "deframe";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK) {
+		return 1;
+	}
+	frameLength = result.length;
+	frame = (unsigned char*)malloc(frameLength);
+	memcpy(frame, result.resultBinary, frameLength);
+	sml_encode_result_free(&result);
+
+	/* noise, good, cut off, good, bad CRC, good */
+	parts[0] = (const unsigned char*)"\x1B\x1B\x01noise";
+	partLength[0] = 8;
+	for(i=1; i<STREAM_PARTS; i++) {
+		parts[i] = frame;
+		partLength[i] = frameLength;
+	}
+	partLength[2] = frameLength / 2;
+	for(i=0; i<STREAM_PARTS; i++) {
+		streamLength += partLength[i];
+	}
+	stream = (unsigned char*)malloc(streamLength);
+	streamLength = 0;
+	for(i=0; i<STREAM_PARTS; i++) {
+		memcpy(stream + streamLength, parts[i], partLength[i]);
+		if(i == 4) {
+			stream[streamLength + partLength[i] - 1] ^= 0xFF;
+		}
+		streamLength += partLength[i];
+	}
+
+	/* Byte by byte and in one go */
+	sml_deframer_init(&deframer, buffer, sizeof(buffer));
+	if(deframe(&deframer, stream, streamLength, 1, frame, frameLength, &retValue) != 3 ||
+		deframer.frames != 3 || deframer.skippedFrames != 2 ||
+		deframer.skippedBytes != partLength[0] + partLength[2] + frameLength) {
+		retValue = 1;
+	}
+	sml_deframer_init(&deframer, buffer, sizeof(buffer));
+	if(deframe(&deframer, stream, streamLength, streamLength, frame, frameLength, &retValue) != 3 ||
+		deframer.skippedFrames != 2) {
+		retValue = 1;
+	}
+
+	/* Frames longer than the buffer are dropped, the stream goes on */
+	sml_deframer_init(&deframer, buffer, frameLength - 1);
+	if(deframe(&deframer, stream, streamLength, 7, frame, frameLength, &retValue) != 0 ||
+		deframer.skippedFrames == 0) {
+		retValue = 1;
+	}
+
+	/* Frames of one fill are handed out where they were written, nothing moves per frame */
+	sml_deframer_init(&deframer, buffer, sizeof(buffer));
+	frames = sizeof(buffer) / frameLength;
+	for(i=0; i<frames; i++) {
+		sml_deframer_feed(&deframer, frame, frameLength);
+	}
+	for(i=0; sml_deframer_next(&deframer, &delivered, &length) == SML_PARSE_OK; i++) {
+		if(delivered != buffer + i * frameLength || length != frameLength) {
+			retValue = 1;
+		}
+	}
+	if(i != frames) {
+		retValue = 1;
+	}
+
+	/* Exchange behind noise: the frame ends up at the front of the old buffer, the rest in the new one */
+	sml_deframer_init(&deframer, buffer, sizeof(buffer));
+	sml_deframer_feed(&deframer, stream, partLength[0] + frameLength + frameLength / 2);
+	if(sml_deframer_next(&deframer, &delivered, &length) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+	previous = sml_deframer_exchange(&deframer, other);
+	sml_deframer_feed(&deframer, frame + frameLength / 2, frameLength - frameLength / 2);
+	if(previous != buffer || memcmp(buffer, frame, frameLength) != 0 ||
+		sml_deframer_next(&deframer, &delivered, &length) != SML_PARSE_OK ||
+		delivered != other || length != frameLength || memcmp(other, frame, frameLength) != 0) {
+		retValue = 1;
+	}
+
+	free(stream);
+	free(frame);
+	sml_context_use(NULL);
+	return retValue;
+}
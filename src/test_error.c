@@ -0,0 +1,203 @@
+/**
+ * File name: test_error.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_test.h"
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_error.h"
+
+static uint32_t find(const unsigned char* data, uint32_t length, const char* pattern, uint32_t size) {
+	uint32_t i;
+
+	for(i=0; i + size <= length; i++) {
+		if(memcmp(data + i, pattern, size) == 0) {
+			return i;
+		}
+	}
+	return length;
+}
+
+/* Parses binary with byte index changed to value, expects the error */
+static int expect_error(unsigned char* binary, uint32_t index, unsigned char value,
+	SML_Context* context, uint8_t code, uint32_t offset, uint32_t messageType, const char* path) {
+	int retValue = 0;
+	SML_Message message;
+	const SML_Error* error = sml_context_error(context);
+	char buffer[128];
+	unsigned char original = binary[index];
+	uint32_t parseOffset = 0;
+
+	binary[index] = value;
+	if(sml_parse_message_binary(binary, &parseOffset, &message) != SML_PARSE_ERROR ||
+		error->code != code || error->offset != offset ||
+		error->messageType != messageType ||
+		sml_error_path(error, buffer, sizeof(buffer)) != strlen(path) || strcmp(buffer, path) != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	binary[index] = original;
+
+	return retValue;
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_GetList_Res response;
+	SML_ListEntry entry;
+	SML_Message message;
+	SML_File file;
+	SML_Encode_Binary_Result result;
+	const SML_Error* error;
+	char buffer[8];
+	unsigned char* plain;
+	unsigned char* frame;
+	uint32_t plainLength;
+	uint32_t frameLength;
+	uint32_t allocations;
+	uint32_t goodAllocations;
+	uint32_t index;
+	uint32_t offset;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[2048];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+	error = sml_context_error(&context);
+
+	memset(&response, 0, sizeof(response));
+	memset(&entry, 0, sizeof(entry));
+	memset(&message, 0, sizeof(message));
+	entry.objName = "obis";
+	entry.value.choiceTag = SML_VALUE_STRING;
+	entry.value.choiceValue.string = "VALUE!";
+	response.serverId = "server";
+	response.valList.listSize = 1;
+	response.valList.valListEntry = &entry;
+	message.transactionId = "error";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &response;
+	plain = sml_test_copy_result(sml_encode_message_binary(&message), &plainLength);
+	frame = sml_test_copy_result(sml_transport_encode_message(&message), &frameLength);
+	if(plain == NULL || frame == NULL) {
+		return 1;
+	}
+
+	/* Value of the list entry turned into a six byte boolean */
+	index = find(plain, plainLength, "\x07VALUE!", 7);
+	if(index == plainLength ||
+		expect_error(plain, index, 0x47, &context, SML_ERROR_TYPE, index, SML_MESSAGEBODY_GETLIST_RESPONSE,
+		"Message/MessageBody/GetList.Res/ListEntry")) {
+		retValue = 1;
+	}
+	/* Unknown message body, reported at the body */
+	index = find(plain, plainLength, "\x65\x00\x00\x07\x01", 5);
+	if(index == plainLength || plain[index - 1] != 0x72 ||
+		expect_error(plain, index + 3, 0x0E, &context, SML_ERROR_CHOICE, index - 1, 0x0E01, "Message/MessageBody")) {
+		retValue = 1;
+	}
+	/* CRC16 field: TL byte, two bytes, end of message */
+	if(expect_error(plain, plainLength - 2, (unsigned char)(plain[plainLength - 2] ^ 0x01),
+		&context, SML_ERROR_MESSAGE_CRC, plainLength - 4, SML_MESSAGEBODY_GETLIST_RESPONSE, "Message")) {
+		retValue = 1;
+	}
+
+	/* Broken TL field in front of the message */
+	if(expect_error(plain, 0, 0x30, &context, SML_ERROR_TL, 0, 0, "Message")) {
+		retValue = 1;
+	}
+
+	/* The error path does not allocate: the crc is checked after every field
+	 * was parsed and costs what a good parse does, the broken list entry
+	 * value stops the parse before the value is allocated */
+	allocations = context.allocStats.total.allocations;
+	offset = 0;
+	if(sml_parse_message_binary(plain, &offset, &message) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	goodAllocations = context.allocStats.total.allocations - allocations;
+	allocations = context.allocStats.total.allocations;
+	if(expect_error(plain, plainLength - 2, (unsigned char)(plain[plainLength - 2] ^ 0x01),
+		&context, SML_ERROR_MESSAGE_CRC, plainLength - 4, SML_MESSAGEBODY_GETLIST_RESPONSE, "Message") ||
+		context.allocStats.total.allocations - allocations != goodAllocations) {
+		retValue = 1;
+	}
+	index = find(plain, plainLength, "\x07VALUE!", 7);
+	allocations = context.allocStats.total.allocations;
+	if(expect_error(plain, index, 0x47, &context, SML_ERROR_TYPE, index, SML_MESSAGEBODY_GETLIST_RESPONSE,
+		"Message/MessageBody/GetList.Res/ListEntry") ||
+		context.allocStats.total.allocations - allocations >= goodAllocations) {
+		retValue = 1;
+	}
+
+	allocations = context.allocStats.total.allocations;
+	memset(&file, 0, sizeof(file));
+	result = sml_encode_file_binary(&file);
+	if(result.resultCode != SML_ENCODE_ERROR || result.errorMessage == NULL ||
+		error->code != SML_ERROR_ENCODE || error->message != result.errorMessage ||
+		context.allocStats.total.allocations != allocations) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&result);
+
+	/* Frame CRC16 behind the padding count, offset into the frame */
+	frame[frameLength - 1] ^= 0x01;
+	offset = 0;
+	if(sml_transport_parse_message(frame, &offset, &message) != SML_PARSE_ERROR ||
+		error->code != SML_ERROR_FRAME_CRC || error->offset != frameLength - 2 || error->depth != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	frame[frameLength - 1] ^= 0x01;
+
+	/* Success clears the error */
+	offset = 0;
+	if(sml_transport_parse_message(frame, &offset, &message) != SML_PARSE_OK || error->code != SML_ERROR_NONE ||
+		strcmp(sml_error_name(error->code), "no error") != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* Truncated path */
+	offset = 0;
+	plain[find(plain, plainLength, "\x07VALUE!", 7)] = 0x47;
+	if(sml_parse_message_binary(plain, &offset, &message) != SML_PARSE_ERROR || error->depth != 4 ||
+		sml_error_path(error, buffer, sizeof(buffer)) != sizeof(buffer) - 1 || strcmp(buffer, "Message") != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	free(plain);
+	free(frame);
+	sml_context_use(NULL);
+	return retValue;
+}
@@ -0,0 +1,208 @@
+/**
+ * File name: test_flat_tree.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_tree.h"
+
+#define NODE_COUNT 200
+#define FANOUT 3
+#define CHAIN_LENGTH (SMLLIB_TREE_MAX_DEPTH + 2)
+
+#ifdef SMLLIB_STATIC_POOL
+	/* Without a heap the test's contexts need pools, the default one is too small */
+	#define POOL_SIZE 262144
+	static uint64_t pool[2][POOL_SIZE / sizeof(uint64_t)];
+#endif
+
+static char names[FANOUT][3] = {"n0", "n1", "n2"};
+
+/* Same preorder layout as sml_flat_tree_from_tree() gives */
+static int flat_equals(const SML_Flat_Tree* a, const SML_Flat_Tree* b) {
+	uint32_t i;
+
+	if(a->nodeCount != b->nodeCount || a->valueCount != b->valueCount) {
+		return 0;
+	}
+	for(i=0; i<a->nodeCount; i++) {
+		if(strcmp(a->nodes[i].parameterName, b->nodes[i].parameterName) != 0 ||
+			a->nodes[i].childCount != b->nodes[i].childCount ||
+			a->nodes[i].end != b->nodes[i].end ||
+			a->nodes[i].value != b->nodes[i].value) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int main(void) {
+	SML_Tree nodes[NODE_COUNT];
+	List_of_SML_Tree lists[NODE_COUNT];
+	SML_ProcParValue values[NODE_COUNT];
+	SML_Value smlValues[NODE_COUNT];
+	SML_Flat_Tree reference;
+	SML_Flat_Tree copy;
+	SML_Flat_Tree original;
+	SML_Flat_Tree* flat;
+	SML_Message message;
+	SML_Message parsed;
+	SML_GetProcParameter_Res response;
+	SML_GetProcParameter_Res_Compact* compact;
+	SML_Encode_Binary_Result classic;
+	SML_Encode_Binary_Result encoded;
+	SML_Context context;
+	SML_Context classicContext;
+	SML_TreePath path;
+	char* components[3];
+	unsigned char chain[CHAIN_LENGTH * 5];
+	uint32_t allocations;
+	uint32_t offset = 0;
+	uint32_t first;
+	uint32_t i;
+	int retValue = 0;
+
+	char transactionId[] = {"Flat_TransactionId"};
+	char serverId[] = {"MyServer"};
+	char pathEntry[] = {"\x81\x81\xC7\x86\x20\xFF"};
+	char* path_Entry[1];
+
+	/* Breadth first tree, every third node without value */
+	for(i=0; i<NODE_COUNT; i++) {
+		smlValues[i].choiceTag = SML_VALUE_UINT16;
+		smlValues[i].choiceValue.uint16 = (uint16_t)i;
+		values[i].choiceTag = SML_PROCPAR_VALUE;
+		values[i].choiceValue.smlValue = smlValues + i;
+		nodes[i].parameterName = (i == 0) ? pathEntry : names[(i - 1) % FANOUT];
+		nodes[i].parameterValue = (i % 3 == 1) ? NULL : values + i;
+		nodes[i].child_List = NULL;
+		first = i * FANOUT + 1;
+		if(first < NODE_COUNT) {
+			lists[i].listSize = (NODE_COUNT - first < FANOUT) ? NODE_COUNT - first : FANOUT;
+			lists[i].tree_Entry = nodes + first;
+			nodes[i].child_List = lists + i;
+		}
+	}
+	path_Entry[0] = pathEntry;
+	response.serverId = serverId;
+	response.parameterTreePath.listSize = 1;
+	response.parameterTreePath.path_Entry = path_Entry;
+	response.parameterTree = nodes[0];
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE;
+	message.messageBody.choiceValue.getProcParameterResponse = &response;
+
+	sml_context_init(&classicContext);
+#ifdef SMLLIB_STATIC_POOL
+	sml_context_set_pool(&classicContext, pool[1], POOL_SIZE);
+#endif
+	sml_context_use(&classicContext);
+	classic = sml_encode_message_binary(&message);
+	if(sml_flat_tree_from_tree(&reference, nodes) != SML_PARSE_OK ||
+		reference.nodeCount != NODE_COUNT || reference.nodes[0].end != NODE_COUNT) {
+		return 1;
+	}
+
+	/* Parsed flat, encoded flat: same bytes, a handful of allocations */
+	sml_context_init(&context);
+#ifdef SMLLIB_STATIC_POOL
+	sml_context_set_pool(&context, pool[0], POOL_SIZE);
+#endif
+	sml_context_set_compact_layout(&context, TRUE);
+	sml_context_use(&context);
+	if(sml_parse_message_binary(classic.resultBinary, &offset, &parsed) != SML_PARSE_OK) {
+		return 1;
+	}
+	allocations = context.allocStats.total.allocations;
+	compact = parsed.messageBody.choiceValue.getProcParameterResponseCompact;
+	flat = &compact->parameterTree;
+	if(!flat_equals(flat, &reference) || allocations > 4 * NODE_COUNT) {
+		retValue = 1;
+	}
+	encoded = sml_encode_message_binary(&parsed);
+	if(encoded.length != classic.length || memcmp(encoded.resultBinary, classic.resultBinary, classic.length) != 0) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&encoded);
+
+	/* A copy encodes the same and has its own structure */
+	if(sml_flat_tree_copy(&copy, flat) != SML_PARSE_OK || !flat_equals(&copy, flat) || copy.nodes == flat->nodes) {
+		retValue = 1;
+	}
+	original = compact->parameterTree;
+	compact->parameterTree = copy;
+	encoded = sml_encode_message_binary(&parsed);
+	if(encoded.length != classic.length || memcmp(encoded.resultBinary, classic.resultBinary, classic.length) != 0) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&encoded);
+	sml_flat_tree_free(&copy);
+	compact->parameterTree = original;
+
+	/* Lookup: root, n2, n1 is nodes[3 * 3 + 2] */
+	components[0] = pathEntry;
+	components[1] = names[2];
+	components[2] = names[1];
+	path.listSize = 3;
+	path.path_Entry = components;
+	i = sml_flat_tree_find(flat, &path);
+	if(i == SML_FLAT_NO_VALUE || sml_tree_find(nodes, &path) != nodes + 11 ||
+		flat->values[flat->nodes[i].value].choiceValue.smlValue->choiceValue.uint16 != 11) {
+		retValue = 1;
+	}
+	components[2] = pathEntry;
+	if(sml_flat_tree_find(flat, &path) != SML_FLAT_NO_VALUE) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* Deeper than SMLLIB_TREE_MAX_DEPTH fails */
+	for(i=0; i<CHAIN_LENGTH; i++) {
+		chain[i * 5] = 0x73;
+		chain[i * 5 + 1] = 0x02;
+		chain[i * 5 + 2] = 'x';
+		chain[i * 5 + 3] = 0x01;
+		chain[i * 5 + 4] = (i + 1 < CHAIN_LENGTH) ? 0x71 : 0x01;
+	}
+	offset = 0;
+	if(p_sml_parse_flat_tree(chain, &offset, &copy) != SML_PARSE_ERROR) {
+		retValue = 1;
+	}
+	offset = 5;
+	if(p_sml_parse_flat_tree(chain, &offset, &copy) != SML_PARSE_OK || copy.nodeCount != CHAIN_LENGTH - 1 ||
+		copy.nodes[0].end != CHAIN_LENGTH - 1 || copy.nodes[CHAIN_LENGTH - 2].end != CHAIN_LENGTH - 1) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(&classicContext);
+
+	sml_flat_tree_free(&reference);
+	sml_encode_result_free(&classic);
+
+	return retValue;
+}
@@ -0,0 +1,364 @@
+/**
+ * File name: test_index.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_capture.h"
+#include "smllib_index.h"
+#include "smllib_tools.h"
+
+#define CAPTURE_PATH "test_index.sml"
+#define INDEX_PATH "test_index.sml.idx"
+#define INDEX_FILES 50
+#define SERVER_MAX 16
+
+/* Puts the serverId octets in place of the placeholder and renews both crcs */
+static int patch_server(unsigned char* frame, uint32_t length, const char* placeholder, const char* serverId, uint32_t serverLength) {
+	uint32_t messageEnd = length - 8 - frame[length - 3];
+	uint16_t crc;
+	uint32_t i;
+
+	for(i=8; i + serverLength <= messageEnd && memcmp(frame + i, placeholder, serverLength) != 0; i++);
+	if(i + serverLength > messageEnd || frame[messageEnd - 4] != 0x63) {
+		return 1;
+	}
+	memcpy(frame + i, serverId, serverLength);
+	crc = crc16_ccitt(frame + 8, messageEnd - 4 - 8);
+	frame[messageEnd - 3] = (unsigned char)(crc >> 8);
+	frame[messageEnd - 2] = (unsigned char)(crc & 0xFF);
+	crc = crc16_ccitt(frame, length - 2);
+	frame[length - 2] = (unsigned char)(crc >> 8);
+	frame[length - 1] = (unsigned char)(crc & 0xFF);
+	return 0;
+}
+
+/*
+ * PublicOpen_Res of server at time, PublicClose_Res. The encoder takes a
+ * serverId for a C string, so a placeholder is encoded and the octets (any
+ * but 0x1B) are patched in.
+ */
+static int write_file(FILE* out, const char* serverId, uint32_t serverLength, uint32_t secIndex) {
+	SML_PublicOpen_Res openResponse;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	SML_Time refTime;
+	char placeholder[SERVER_MAX + 1];
+	int retValue = 0;
+
+	memset(placeholder, 'P', serverLength);
+	placeholder[serverLength] = '\0';
+	memset(&openResponse, 0, sizeof(openResponse));
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	refTime.choiceTag = SML_TIME_SECINDEX;
+	refTime.choiceValue.secIndex = secIndex;
+	openResponse.reqFileId = "file";
+	openResponse.serverId = placeholder;
+	openResponse.refTime = &refTime;
+	message.transactionId = "index";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_OPEN_RESPONSE;
+	message.messageBody.choiceValue.openResponse = &openResponse;
+
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK || patch_server(result.resultBinary, result.length, placeholder, serverId, serverLength) ||
+		fwrite(result.resultBinary, 1, result.length, out) != result.length) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&result);
+
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK || fwrite(result.resultBinary, 1, result.length, out) != result.length) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&result);
+	sml_parser_free();
+	return retValue;
+}
+
+/* PublicOpen_Res without refTime, GetList_Res of server at time, PublicClose_Res: a meter's SML file */
+static int write_meter_file(FILE* out, const char* serverId, uint32_t secIndex) {
+	SML_PublicOpen_Res openResponse;
+	SML_GetList_Res getListResponse;
+	SML_PublicClose_Res closeResponse;
+	SML_ListEntry valEntry;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	SML_Time actSensorTime;
+	char objName[] = {"\x01\x00\x01\x08\x00\xFF"};
+	int retValue = 0;
+	uint32_t i;
+
+	memset(&openResponse, 0, sizeof(openResponse));
+	memset(&getListResponse, 0, sizeof(getListResponse));
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&valEntry, 0, sizeof(valEntry));
+	memset(&message, 0, sizeof(message));
+	openResponse.reqFileId = "file";
+	openResponse.serverId = (char*)serverId;
+	actSensorTime.choiceTag = SML_TIME_SECINDEX;
+	actSensorTime.choiceValue.secIndex = secIndex;
+	valEntry.objName = objName;
+	valEntry.value.choiceTag = SML_VALUE_UINT32;
+	valEntry.value.choiceValue.uint32 = secIndex;
+	getListResponse.serverId = (char*)serverId;
+	getListResponse.actSensorTime = &actSensorTime;
+	getListResponse.valList.listSize = 1;
+	getListResponse.valList.valListEntry = &valEntry;
+	message.transactionId = "meter";
+
+	for(i=0; i<3; i++) {
+		if(i == 0) {
+			message.messageBody.choiceTag = SML_MESSAGEBODY_OPEN_RESPONSE;
+			message.messageBody.choiceValue.openResponse = &openResponse;
+		}
+		else if(i == 1) {
+			message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+			message.messageBody.choiceValue.getListResponse = &getListResponse;
+		}
+		else {
+			message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+			message.messageBody.choiceValue.closeResponse = &closeResponse;
+		}
+		result = sml_transport_encode_message(&message);
+		if(result.resultCode != SML_ENCODE_OK || fwrite(result.resultBinary, 1, result.length, out) != result.length) {
+			retValue = 1;
+		}
+		sml_encode_result_free(&result);
+	}
+	sml_parser_free();
+	return retValue;
+}
+
+/* Matches of the query, each checked to be a frame of the time range */
+static uint32_t count_matches(SML_Index* index, SML_Capture* capture, const SML_Index_Query* query, int* failed) {
+	SML_Index_Entry entry;
+	SML_Message message;
+	uint64_t position = 0;
+	uint32_t count = 0;
+
+	while(sml_index_find(index, query, &position, &entry) == SML_PARSE_OK) {
+		sml_capture_seek(capture, entry.offset);
+		if(sml_capture_next(capture, &message) != SML_PARSE_OK || capture->frameOffset != entry.offset ||
+			message.messageBody.choiceTag != entry.messageType ||
+			entry.time < query->from || entry.time > query->to) {
+			*failed = 1;
+		}
+		if(message.messageBody.choiceTag == SML_MESSAGEBODY_OPEN_RESPONSE &&
+			message.messageBody.choiceValue.openResponse->refTime != NULL &&
+			message.messageBody.choiceValue.openResponse->refTime->choiceValue.secIndex != entry.time) {
+			*failed = 1;
+		}
+		sml_parser_free();
+		count++;
+	}
+	return count;
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_Capture capture;
+	SML_Index index;
+	SML_Index_Query query;
+	SML_Index_Entry entry;
+	SML_Message message;
+	uint64_t position;
+	FILE* out;
+	uint32_t i;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[512];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* Noise, then files of two servers at secIndex 100, 101, ... */
+	out = fopen(CAPTURE_PATH, "wb");
+	if(out == NULL) {
+		return 1;
+	}
+	fwrite("noise", 1, 5, out);
+	for(i=0; i<INDEX_FILES; i++) {
+		if(write_file(out, (i % 2) ? "server-B" : "server-A", 8, 100 + i)) {
+			retValue = 1;
+		}
+	}
+	if(fclose(out) != 0 ||
+		sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_OK ||
+		sml_index_build(&capture, INDEX_PATH) != SML_PARSE_OK ||
+		sml_index_open(&index, INDEX_PATH) != SML_PARSE_OK) {
+		return 1;
+	}
+	if(index.count != 2 * INDEX_FILES || index.captureSize != capture.size ||
+		(index.flags & SML_INDEX_SORTED) == 0 || index.sortedTimeType != SML_TIME_SECINDEX) {
+		retValue = 1;
+	}
+	/* The close frame takes server and time over from the open frame */
+	sml_index_entry(&index, 1, &entry);
+	if(entry.messageType != SML_MESSAGEBODY_CLOSE_RESPONSE || entry.time != 100 ||
+		entry.serverHash != sml_index_server_hash("server-A", 8) ||
+		entry.flags != (SML_INDEX_INHERITED_SERVER | SML_INDEX_INHERITED_TIME)) {
+		retValue = 1;
+	}
+
+	/* Time range, bisected */
+	sml_index_query_init(&query);
+	query.timeType = SML_TIME_SECINDEX;
+	query.from = 110;
+	query.to = 119;
+	if(count_matches(&index, &capture, &query, &retValue) != 20) {
+		retValue = 1;
+	}
+	/* Time range and server */
+	query.byServer = TRUE;
+	query.serverHash = sml_index_server_hash("server-B", 8);
+	if(count_matches(&index, &capture, &query, &retValue) != 10) {
+		retValue = 1;
+	}
+	/* Other time type */
+	query.timeType = SML_TIME_TIMESTAMP;
+	position = 0;
+	if(sml_index_find(&index, &query, &position, &entry) != SML_CAPTURE_END || position != index.count) {
+		retValue = 1;
+	}
+	sml_index_close(&index);
+	sml_capture_close(&capture);
+
+	/* A meter restart breaks the order, the reader scans instead */
+	out = fopen(CAPTURE_PATH, "ab");
+	if(out == NULL || write_file(out, "server-A", 8, 105) || fclose(out) != 0 ||
+		sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_OK ||
+		sml_index_build(&capture, INDEX_PATH) != SML_PARSE_OK ||
+		sml_index_open(&index, INDEX_PATH) != SML_PARSE_OK) {
+		return 1;
+	}
+	sml_index_query_init(&query);
+	query.timeType = SML_TIME_SECINDEX;
+	query.from = 105;
+	query.to = 105;
+	if((index.flags & SML_INDEX_SORTED) != 0 || count_matches(&index, &capture, &query, &retValue) != 4) {
+		retValue = 1;
+	}
+	sml_index_close(&index);
+	sml_capture_close(&capture);
+
+	/* Binary serverIds: equal up to the 0x00, told apart by all their octets */
+	out = fopen(CAPTURE_PATH, "wb");
+	for(i=0; out != NULL && i<4; i++) {
+		if(write_file(out, (i % 2) ? "\x06\x00\x01\x02" : "\x06\x00\x09\x00", 4, 200 + i)) {
+			retValue = 1;
+		}
+	}
+	if(out == NULL || fclose(out) != 0 ||
+		sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_OK ||
+		sml_index_build(&capture, INDEX_PATH) != SML_PARSE_OK ||
+		sml_index_open(&index, INDEX_PATH) != SML_PARSE_OK) {
+		return 1;
+	}
+	sml_index_query_init(&query);
+	query.byServer = TRUE;
+	query.serverHash = sml_index_server_hash("\x06\x00\x01\x02", 4);
+	if(query.serverHash == sml_index_server_hash("\x06\x00\x09\x00", 4) ||
+		query.serverHash == sml_index_server_hash("\x06", 1) ||
+		count_matches(&index, &capture, &query, &retValue) != 4) {
+		retValue = 1;
+	}
+	/* The octets survive the patch and the parser */
+	position = 0;
+	if(sml_index_find(&index, &query, &position, &entry) != SML_PARSE_OK || entry.time != 201) {
+		retValue = 1;
+	}
+	sml_capture_seek(&capture, entry.offset);
+	if(sml_capture_next(&capture, &message) != SML_PARSE_OK ||
+		memcmp(message.messageBody.choiceValue.openResponse->serverId, "\x06\x00\x01\x02", 4) != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_index_close(&index);
+	sml_capture_close(&capture);
+
+	/* PublicOpen_Res without refTime: the open frame takes the time of its own file's body */
+	out = fopen(CAPTURE_PATH, "wb");
+	for(i=0; out != NULL && i<3; i++) {
+		if(write_meter_file(out, (i % 2) ? "server-B" : "server-A", 300 + i)) {
+			retValue = 1;
+		}
+	}
+	if(out == NULL || fclose(out) != 0 ||
+		sml_capture_open(&capture, CAPTURE_PATH) != SML_PARSE_OK ||
+		sml_index_build(&capture, INDEX_PATH) != SML_PARSE_OK ||
+		sml_index_open(&index, INDEX_PATH) != SML_PARSE_OK) {
+		return 1;
+	}
+	if(index.count != 9 || (index.flags & SML_INDEX_SORTED) == 0) {
+		retValue = 1;
+	}
+	sml_index_query_init(&query);
+	query.timeType = SML_TIME_SECINDEX;
+	query.from = 301;
+	query.to = 301;
+	position = 0;
+	for(i=0; i<3; i++) {
+		if(sml_index_find(&index, &query, &position, &entry) != SML_PARSE_OK || position != 3 + i + 1 ||
+			entry.serverHash != sml_index_server_hash("server-B", 8)) {
+			retValue = 1;
+		}
+		if((i == 0 && (entry.messageType != SML_MESSAGEBODY_OPEN_RESPONSE || entry.flags != SML_INDEX_INHERITED_TIME)) ||
+			(i == 1 && (entry.messageType != SML_MESSAGEBODY_GETLIST_RESPONSE || entry.flags != 0)) ||
+			(i == 2 && entry.messageType != SML_MESSAGEBODY_CLOSE_RESPONSE)) {
+			retValue = 1;
+		}
+	}
+	if(sml_index_find(&index, &query, &position, &entry) != SML_CAPTURE_END ||
+		count_matches(&index, &capture, &query, &retValue) != 3) {
+		retValue = 1;
+	}
+	/* The first file has no frame before it */
+	sml_index_entry(&index, 0, &entry);
+	if(entry.time != 300 || entry.timeType != SML_TIME_SECINDEX) {
+		retValue = 1;
+	}
+	sml_index_close(&index);
+	sml_capture_close(&capture);
+
+	/* A capture is no index */
+	if(sml_index_open(&index, CAPTURE_PATH) != SML_PARSE_ERROR) {
+		retValue = 1;
+	}
+
+	remove(INDEX_PATH);
+	remove(CAPTURE_PATH);
+	sml_context_use(NULL);
+	return retValue;
+}
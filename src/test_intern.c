@@ -0,0 +1,171 @@
+/**
+ * File name: test_intern.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_intern.h"
+
+#define ENTRY_COUNT 3
+#define POOL_SIZE 8192
+
+static uint64_t pool[POOL_SIZE / sizeof(uint64_t)];
+#ifdef SMLLIB_STATIC_POOL
+	static uint64_t workPool[POOL_SIZE / sizeof(uint64_t)];
+#endif
+
+/* Parses the message and stores serverId and objName pointers */
+static int parse_names(SML_Encode_Binary_Result* binary, char** names) {
+	SML_Message message;
+	SML_GetList_Res* res;
+	uint32_t offset = 0;
+	uint32_t i;
+
+	if(sml_parse_message_binary(binary->resultBinary, &offset, &message) != SML_PARSE_OK) {
+		return 1;
+	}
+	res = message.messageBody.choiceValue.getListResponse;
+	names[0] = res->serverId;
+	for(i=0; i<ENTRY_COUNT; i++) {
+		names[i+1] = res->valList.valListEntry[i].objName;
+	}
+	return 0;
+}
+
+int main(void) {
+	SML_Context context;
+	SML_Context work;
+	SML_Intern_Table* table;
+	SML_Message message;
+	SML_GetList_Res getListRes;
+	SML_ListEntry entries[ENTRY_COUNT];
+	SML_Encode_Binary_Result binary;
+	char* first[ENTRY_COUNT+1];
+	char* second[ENTRY_COUNT+1];
+	uint32_t i;
+	int retValue = 0;
+
+	char objName1[] = {"\x01\x02\x03\x04\x05\x06"};
+	char objName2[] = {"\x01\x02\x03\x04\x05\x07"};
+	char transactionId[] = {"Intern_TransactionId"};
+	char serverId[] = {"MyServer"};
+
+	for(i=0; i<ENTRY_COUNT; i++) {
+		entries[i].objName = (i == 1) ? objName2 : objName1;
+		entries[i].status = NULL;
+		entries[i].valTime = NULL;
+		entries[i].unit = NULL;
+		entries[i].scaler = NULL;
+		entries[i].value.choiceTag = SML_VALUE_UINT32;
+		entries[i].value.choiceValue.uint32 = i;
+		entries[i].valueSignature = NULL;
+	}
+	getListRes.clientId = NULL;
+	getListRes.serverId = serverId;
+	getListRes.listName = NULL;
+	getListRes.actSensorTime = NULL;
+	getListRes.actGatewayTime = NULL;
+	getListRes.listSignature = NULL;
+	getListRes.valList.listSize = ENTRY_COUNT;
+	getListRes.valList.valListEntry = entries;
+
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &getListRes;
+
+	binary = sml_encode_message_binary(&message);
+
+	/* The binary stays in the default context, without a heap the table
+	 * cases run on a pool of their own (a pool table has to come first) */
+	sml_context_init(&work);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&work, workPool, POOL_SIZE);
+	#endif
+	sml_context_use(&work);
+
+	/* Two frames resolve to the same pointers, IDs are dense */
+	table = sml_intern_create(16, 256);
+	sml_context_set_intern_table(sml_context_current(), table);
+	if(table == NULL || parse_names(&binary, first) != 0) {
+		return 1;
+	}
+	sml_parser_free();
+	if(parse_names(&binary, second) != 0) {
+		return 1;
+	}
+	for(i=0; i<=ENTRY_COUNT; i++) {
+		if(first[i] != second[i]) {
+			retValue = 1;
+		}
+	}
+	if(strcmp(first[0], serverId) != 0 || memcmp(first[2], objName2, 6) != 0 ||
+		first[1] != first[3] ||
+		sml_intern_id(table, first[0]) != 0 ||
+		sml_intern_id(table, first[1]) != 1 ||
+		sml_intern_id(table, first[2]) != 2 ||
+		sml_intern_id(table, serverId) != SML_INTERN_NO_ID ||
+		sml_intern_string(table, 2) != first[2] ||
+		table->count != 3 || table->misses != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_set_intern_table(sml_context_current(), NULL);
+	sml_intern_destroy(table);
+
+	/* A full table falls back to copies */
+	table = sml_intern_create(2, 256);
+	sml_context_set_intern_table(sml_context_current(), table);
+	if(parse_names(&binary, first) != 0 ||
+		sml_intern_id(table, first[2]) != SML_INTERN_NO_ID ||
+		memcmp(first[2], objName2, 6) != 0 ||
+		table->misses == 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_intern_destroy(table);
+
+	/* In pool mode the table survives sml_parser_free() */
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, POOL_SIZE);
+	sml_context_use(&context);
+	table = sml_intern_create(16, 256);
+	sml_context_set_intern_table(&context, table);
+	if(table == NULL || parse_names(&binary, first) != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	if(context.pool.used == 0 || parse_names(&binary, second) != 0 || first[2] != second[2]) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(NULL);
+
+	sml_encode_result_free(&binary);
+
+	return retValue;
+}
@@ -0,0 +1,151 @@
+/**
+ * File name: test_latency.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_latency.h"
+
+int main(void) {
+	int retValue = 0;
+	SML_Latency latency;
+	SML_Latency_Histogram* histogram;
+	SML_Context context;
+	SML_Encode_Binary_Result result;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Message parsed;
+	uint32_t offset = 0;
+	uint32_t frameLength = 0;
+	unsigned char frame[256];
+	uint64_t value;
+	#ifndef SMLLIB_FREESTANDING
+		FILE* report;
+		char text[512];
+	#endif
+	uint32_t i;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[8192];
+	#endif
+
+	/* Bucket limits are contiguous: the limit maps to its bucket, one more to the next */
+	for(i=0; i<SML_LATENCY_BUCKETS; i++) {
+		value = p_sml_latency_bucket_limit(i);
+		if(p_sml_latency_bucket(value) != i ||
+			(i < SML_LATENCY_BUCKETS - 1 && p_sml_latency_bucket(value + 1) != i + 1)) {
+			retValue = 1;
+		}
+	}
+	if(p_sml_latency_bucket((uint64_t)-1) != SML_LATENCY_BUCKETS - 1) {
+		retValue = 1;
+	}
+
+	/* 1..1000: p50 within one bucket (12.5%) above 500, p100 is the maximum */
+	sml_latency_init(&latency);
+	histogram = sml_latency_histogram(&latency, SML_LATENCY_PARSE, SML_MESSAGEBODY_GETLIST_RESPONSE);
+	if(sml_latency_percentile(histogram, 0.5) != 0) {
+		retValue = 1;
+	}
+	for(i=1000; i>=1; i--) {
+		sml_latency_record(histogram, i);
+	}
+	value = sml_latency_percentile(histogram, 0.5);
+	if(histogram->count != 1000 || histogram->min != 1 || histogram->max != 1000 || histogram->sum != 500500 ||
+		value < 500 || value > 500 + 500 / 8 || sml_latency_percentile(histogram, 1.0) != 1000 ||
+		sml_latency_percentile(histogram, 0.001) != 1) {
+		retValue = 1;
+	}
+
+	/* The report prints values beyond 32 bits in full */
+	#ifndef SMLLIB_FREESTANDING
+		sml_latency_init(&latency);
+		sml_latency_record(sml_latency_histogram(&latency, SML_LATENCY_PARSE, SML_MESSAGEBODY_CLOSE_RESPONSE), (uint64_t)5000000 * 1000);
+		report = tmpfile();
+		if(report != NULL) {
+			sml_latency_report(report, &latency);
+			rewind(report);
+			text[fread(text, 1, sizeof(text) - 1, report)] = '\0';
+			fclose(report);
+			if(strstr(text, " 5000000000\n") == NULL) {
+				retValue = 1;
+			}
+		}
+	#endif
+
+	/* Recording by the public functions, only with SMLLIB_LATENCY */
+	sml_latency_init(&latency);
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	message.transactionId = "L";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_set_latency(&context, &latency);
+	sml_context_use(&context);
+
+	/* Own copy of the frame, sml_parser_free() releases the pool */
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode == SML_ENCODE_OK && result.length <= sizeof(frame)) {
+		frameLength = result.length;
+		memcpy(frame, result.resultBinary, frameLength);
+	}
+	sml_encode_result_free(&result);
+	if(frameLength == 0 || sml_transport_parse_message(frame, &offset, &parsed) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	/* Failed calls are not recorded */
+	frame[frameLength - 1] ^= 0xFF;
+	offset = 0;
+	if(sml_transport_parse_message(frame, &offset, &parsed) == SML_PARSE_OK) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(NULL);
+
+	#ifdef SMLLIB_LATENCY
+		/* The message encoder nested in the transport encoder is not recorded */
+		if(sml_latency_histogram(&latency, SML_LATENCY_TRANSPORT_ENCODE, SML_MESSAGEBODY_CLOSE_RESPONSE)->count != 1 ||
+			sml_latency_histogram(&latency, SML_LATENCY_ENCODE, SML_MESSAGEBODY_CLOSE_RESPONSE)->count != 0 ||
+			sml_latency_histogram(&latency, SML_LATENCY_TRANSPORT_PARSE, SML_MESSAGEBODY_CLOSE_RESPONSE)->count != 1) {
+			retValue = 1;
+		}
+	#else
+		for(i=0; i<SML_MESSAGEBODY_TYPES; i++) {
+			if(latency.histograms[SML_LATENCY_TRANSPORT_ENCODE][i].count != 0 ||
+				latency.histograms[SML_LATENCY_TRANSPORT_PARSE][i].count != 0) {
+				retValue = 1;
+			}
+		}
+	#endif
+
+	return retValue;
+}
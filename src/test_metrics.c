@@ -0,0 +1,160 @@
+/**
+ * File name: test_metrics.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_metrics.h"
+
+#define EXPORT_PATH "test_metrics.prom"
+
+#ifndef SMLLIB_FREESTANDING
+
+/* Expected exposition lines, only the metric types without counters */
+#ifdef SMLLIB_NO_METRICS
+	#define EXPECTED_LINES 1
+#else
+	#define EXPECTED_LINES 5
+#endif
+static const char* expected[] = {
+	"# TYPE sml_frames_parsed_total counter\n",
+	"sml_frames_parsed_total{link=\"ir0\"} 1\n",
+	"sml_frames_parsed_total{link=\"ir\\\"1\\\\\"} 0\n",
+	"sml_escapes_encoded_total{link=\"ir0\"} 1\n",
+	"sml_frame_crc_failures_total{link=\"ir0\"} 1\n"
+};
+
+#endif
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_Context other;
+	SML_Metrics_Snapshot snapshots[2];
+	SML_Encode_Binary_Result result;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Message parsed;
+	uint32_t offset = 0;
+	uint32_t frameLength = 0;
+	unsigned char frame[256];
+	#ifndef SMLLIB_FREESTANDING
+		const char* links[2] = {"ir0", "ir\"1\\"};
+		char text[8192];
+		size_t length;
+		FILE* in;
+		uint32_t i;
+	#endif
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[8192];
+	#endif
+
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	/* The transaction id needs one escape sequence in the transport frame */
+	message.transactionId = "\x1B\x1B\x1B\x1B" "M";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+
+	sml_context_init(&context);
+	sml_context_init(&other);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* Own copy of the frame, sml_parser_free() releases the pool */
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode == SML_ENCODE_OK && result.length <= sizeof(frame)) {
+		frameLength = result.length;
+		memcpy(frame, result.resultBinary, frameLength);
+	}
+	sml_encode_result_free(&result);
+	if(frameLength == 0 || sml_transport_parse_message(frame, &offset, &parsed) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	/* Corrupt the transport CRC */
+	frame[frameLength - 1] ^= 0xFF;
+	offset = 0;
+	if(sml_transport_parse_message(frame, &offset, &parsed) == SML_PARSE_OK) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(NULL);
+
+	sml_metrics_snapshot(&context, &snapshots[0]);
+	sml_metrics_snapshot(&other, &snapshots[1]);
+
+	#ifdef SMLLIB_NO_METRICS
+		if(snapshots[0].counters.framesParsed != 0 || snapshots[0].counters.crcCalls != 0) {
+			retValue = 1;
+		}
+	#else
+		/* The corrupted frame is unescaped as well before its CRC fails */
+		if(snapshots[0].counters.messagesEncoded != 1 || snapshots[0].counters.framesEncoded != 1 ||
+			snapshots[0].counters.frameBytesEncoded != frameLength || snapshots[0].counters.escapesEncoded != 1 ||
+			snapshots[0].counters.framesParsed != 1 || snapshots[0].counters.frameBytesParsed != frameLength ||
+			snapshots[0].counters.escapesParsed != 2 || snapshots[0].counters.messagesParsed != 1 ||
+			snapshots[0].counters.messageBytesParsed != snapshots[0].counters.messageBytesEncoded ||
+			snapshots[0].counters.frameCrcFailures != 1 || snapshots[0].counters.parseErrors != 1 ||
+			snapshots[0].counters.encodeErrors != 0 || snapshots[0].counters.crcCalls < 4 ||
+			snapshots[0].allocations.allocations == 0) {
+			retValue = 1;
+		}
+		if(snapshots[1].counters.messagesParsed != 0 || snapshots[1].counters.crcCalls != 0) {
+			retValue = 1;
+		}
+	#endif
+
+	/* The exporter is hosted only */
+	#ifndef SMLLIB_FREESTANDING
+		if(sml_metrics_export_prometheus(EXPORT_PATH, snapshots, links, 2) != SML_ENCODE_OK) {
+			retValue = 1;
+		}
+		in = fopen(EXPORT_PATH, "r");
+		length = (in != NULL) ? fread(text, 1, sizeof(text) - 1, in) : 0;
+		text[length] = '\0';
+		if(in != NULL) {
+			fclose(in);
+		}
+		remove(EXPORT_PATH);
+		for(i=0; i<EXPECTED_LINES; i++) {
+			if(strstr(text, expected[i]) == NULL) {
+				retValue = 1;
+			}
+		}
+	#endif
+
+	sml_metrics_reset(&context);
+	sml_metrics_snapshot(&context, &snapshots[0]);
+	if(snapshots[0].counters.framesParsed != 0 || snapshots[0].counters.crcBytes != 0) {
+		retValue = 1;
+	}
+
+	return retValue;
+}
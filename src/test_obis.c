@@ -0,0 +1,132 @@
+/**
+ * File name: test_obis.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_obis.h"
+
+#define ENTRY_COUNT 3
+
+int main(void) {
+	SML_Message message;
+	SML_Message parsed;
+	SML_GetList_Res getListRes;
+	SML_GetList_Res* res;
+	SML_ListEntry entries[ENTRY_COUNT];
+	SML_Encode_Binary_Result binary;
+	SML_Encode_Binary_Result again;
+	uint32_t offset = 0;
+	uint32_t sum[SML_OBIS_COUNT];
+	uint16_t id;
+	uint32_t i;
+	int retValue = 0;
+
+	uint8_t unknownCode[] = {0x01, 0x00, 0x63, 0x63, 0x63, 0xFF};
+	char transactionId[] = {"Obis_TransactionId"};
+	char serverId[] = {"MyServer"};
+	char name[] = {"no obis"};
+
+	/* Every well-known code maps to its own ID */
+	for(id=SML_OBIS_UNKNOWN+1; id<SML_OBIS_COUNT; id++) {
+		if(sml_obis_code(id) == NULL || sml_obis_text(id) == NULL ||
+			sml_obis_lookup(sml_obis_code(id)) != id) {
+			retValue = 1;
+		}
+	}
+	if(sml_obis_lookup(unknownCode) != SML_OBIS_UNKNOWN ||
+		sml_obis_code(SML_OBIS_NONE) != NULL || sml_obis_code(SML_OBIS_COUNT) != NULL ||
+		strcmp(sml_obis_text(SML_OBIS_ENERGY_IMPORT), "1-0:1.8.0*255") != 0) {
+		retValue = 1;
+	}
+
+	/* Entries without objName are encoded from the inline code, which works
+	 * for 1-0:0.0.9*255 and 1-0:1.8.0*255 despite their zero bytes */
+	for(i=0; i<ENTRY_COUNT; i++) {
+		entries[i].objName = NULL;
+		entries[i].status = NULL;
+		entries[i].valTime = NULL;
+		entries[i].unit = NULL;
+		entries[i].scaler = NULL;
+		entries[i].value.choiceTag = SML_VALUE_UINT32;
+		entries[i].value.choiceValue.uint32 = 10 + i;
+		entries[i].valueSignature = NULL;
+	}
+	sml_obis_set(&entries[0].obis, sml_obis_code(SML_OBIS_DEVICE_ID));
+	sml_obis_set(&entries[1].obis, sml_obis_code(SML_OBIS_ENERGY_IMPORT));
+	entries[2].objName = name;
+	getListRes.clientId = NULL;
+	getListRes.serverId = serverId;
+	getListRes.listName = NULL;
+	getListRes.actSensorTime = NULL;
+	getListRes.actGatewayTime = NULL;
+	getListRes.listSignature = NULL;
+	getListRes.valList.listSize = ENTRY_COUNT;
+	getListRes.valList.valListEntry = entries;
+
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &getListRes;
+
+	binary = sml_encode_message_binary(&message);
+	if(binary.resultCode != SML_ENCODE_OK ||
+		sml_parse_message_binary(binary.resultBinary, &offset, &parsed) != SML_PARSE_OK) {
+		return 1;
+	}
+	res = parsed.messageBody.choiceValue.getListResponse;
+	if(res->valList.valListEntry[0].obis.id != SML_OBIS_DEVICE_ID ||
+		res->valList.valListEntry[1].obis.id != SML_OBIS_ENERGY_IMPORT ||
+		res->valList.valListEntry[2].obis.id != SML_OBIS_NONE ||
+		memcmp(res->valList.valListEntry[1].obis.code, sml_obis_code(SML_OBIS_ENERGY_IMPORT), SML_OBIS_LENGTH) != 0) {
+		retValue = 1;
+	}
+
+	/* IDs index plain arrays */
+	memset(sum, 0, sizeof(sum));
+	for(i=0; i<res->valList.listSize; i++) {
+		sum[res->valList.valListEntry[i].obis.id] += res->valList.valListEntry[i].value.choiceValue.uint32;
+	}
+	if(sum[SML_OBIS_DEVICE_ID] != 10 || sum[SML_OBIS_ENERGY_IMPORT] != 11 || sum[SML_OBIS_NONE] != 12) {
+		retValue = 1;
+	}
+
+	/* Re-encoding via the inline codes gives the same bytes */
+	for(i=0; i<2; i++) {
+		res->valList.valListEntry[i].objName = NULL;
+	}
+	again = sml_encode_message_binary(&parsed);
+	if(again.resultCode != SML_ENCODE_OK || again.length != binary.length ||
+		memcmp(again.resultBinary, binary.resultBinary, binary.length) != 0) {
+		retValue = 1;
+	}
+
+	sml_encode_result_free(&again);
+	sml_encode_result_free(&binary);
+	sml_parser_free();
+	return retValue;
+}
@@ -0,0 +1,266 @@
+/**
+ * File name: test_pipeline.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_tools.h"
+#include "smllib_intern.h"
+#include "smllib_pipeline.h"
+
+#define TEST_KEYS 5
+#define TEST_FRAMES 200
+#define TEST_CHUNK 7
+
+/* Per key state, only touched by the one exporter thread serving the key */
+typedef struct Test_Key {
+	uint32_t next;
+	uint32_t received;
+	uint32_t broken;
+	int failed;
+} Test_Key;
+
+static void test_export(void* user, SML_Pipeline_Frame* frame) {
+	Test_Key* key = &((Test_Key*)user)[frame->key];
+	unsigned int k;
+	unsigned int seq;
+
+	if(frame->result != SML_PARSE_OK) {
+		key->next++;
+		key->broken++;
+		return;
+	}
+	if(frame->source != (void*)key
+			|| frame->message.messageBody.choiceTag != SML_MESSAGEBODY_CLOSE_RESPONSE
+			|| sscanf(frame->message.transactionId, "%u.%u", &k, &seq) != 2
+			|| k != frame->key || seq != key->next) {
+		key->failed = 1;
+	}
+	key->next++;
+	key->received++;
+}
+
+/* The default context of a thread that never selects one */
+static void* test_default_context(void* arg) {
+	*(SML_Context**)arg = sml_context_current();
+	return NULL;
+}
+
+/* Transport frames of key, transaction ids "key.seq" */
+static unsigned char* test_stream(uint32_t key, uint32_t* length) {
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	unsigned char* stream = NULL;
+	char transactionId[16];
+	uint32_t i;
+
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	message.transactionId = transactionId;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	*length = 0;
+	for(i=0; i<TEST_FRAMES; i++) {
+		sprintf(transactionId, "%u.%u", (unsigned int)key, (unsigned int)i);
+		result = sml_transport_encode_message(&message);
+		if(result.resultCode != SML_ENCODE_OK) {
+			free(stream);
+			return NULL;
+		}
+		stream = (unsigned char*)realloc(stream, *length + result.length);
+		memcpy(stream + *length, result.resultBinary, result.length);
+		*length += result.length;
+		sml_encode_result_free(&result);
+		/* Releases the whole pool in STATIC_POOL builds */
+		sml_parser_free();
+	}
+	return stream;
+}
+
+/* Breaks the message of the first frame, keeping the frame crc valid */
+static void test_break(unsigned char* stream) {
+	uint32_t length = 8;
+	uint16_t crc16;
+
+	/* The end escape is padded to a multiple of 4 */
+	while(memcmp(stream + length, "\x1b\x1b\x1b\x1b\x1a", 5) != 0) {
+		length += 4;
+	}
+	length += 8;
+	/* A list of 7 instead of 6 */
+	stream[8] = 0x77;
+	crc16 = crc16_ccitt(stream, length - 2);
+	stream[length - 2] = (unsigned char)(crc16 >> 8);
+	stream[length - 1] = (unsigned char)(crc16 & 0xFF);
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_Ring ring;
+	void* slots[4];
+	void* item;
+	static SML_Pipeline pipeline;
+	SML_Pipeline_Config config;
+	SML_Pipeline_Input inputs[TEST_KEYS];
+	Test_Key keys[TEST_KEYS];
+	unsigned char* streams[TEST_KEYS];
+	uint32_t lengths[TEST_KEYS];
+	uint32_t positions[TEST_KEYS];
+	uint32_t submitted = 0;
+	uint32_t exported = 0;
+	uint32_t step;
+	uint32_t parseErrors = 0;
+	SML_Context* mainDefault;
+	SML_Context* threadDefault = NULL;
+	pthread_t thread;
+	SML_Intern_Table table;
+	SML_Boolean pending;
+	void* memory;
+	uint32_t i;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[512];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	mainDefault = sml_context_use(&context);
+
+	/* Threads that never call sml_context_use() do not share a default context */
+	if(pthread_create(&thread, NULL, test_default_context, &threadDefault) != 0 ||
+		pthread_join(thread, NULL) != 0 || threadDefault == NULL ||
+		threadDefault == mainDefault || threadDefault == &context) {
+		retValue = 1;
+	}
+
+	/* Ring order, full and empty, across the index wrap-around */
+	memset(&ring, 0, sizeof(ring));
+	ring.slots = slots;
+	ring.mask = 3;
+	ring.head = ring.tail = ring.tailCache = ring.headCache = 0xFFFFFFFEUL;
+	for(i=0; i<4; i++) {
+		if(!sml_ring_push(&ring, &slots[i])) {
+			retValue = 1;
+		}
+	}
+	if(sml_ring_push(&ring, NULL)) {
+		retValue = 1;
+	}
+	for(i=0; i<4; i++) {
+		if(!sml_ring_pop(&ring, &item) || item != &slots[i]) {
+			retValue = 1;
+		}
+	}
+	if(sml_ring_pop(&ring, &item)) {
+		retValue = 1;
+	}
+
+	memset(&config, 0, sizeof(config));
+	config.workers = 3;
+	config.exporters = 2;
+	config.frames = 12;
+	config.frameSize = 256;
+	config.poolSize = 2048;
+	config.exportFrame = test_export;
+	config.user = keys;
+	if(sml_pipeline_memory_size(&config) != 0) {
+		retValue = 1;
+	}
+	config.frames = 16;
+	memory = malloc(sml_pipeline_memory_size(&config));
+	if(sml_pipeline_init(&pipeline, &config, memory) != SML_PARSE_OK) {
+		return 1;
+	}
+	/* Worker contexts switch pools per frame, an intern table is refused */
+	memset(&table, 0, sizeof(table));
+	sml_context_set_intern_table(&pipeline.workers[1].context, &table);
+	if(sml_pipeline_start(&pipeline) != SML_PARSE_ERROR || pipeline.running != 0) {
+		retValue = 1;
+	}
+	sml_context_set_intern_table(&pipeline.workers[1].context, NULL);
+	if(sml_pipeline_start(&pipeline) != SML_PARSE_OK) {
+		return 1;
+	}
+
+	/* The links' bytes interleaved in small pieces */
+	memset(keys, 0, sizeof(keys));
+	for(i=0; i<TEST_KEYS; i++) {
+		streams[i] = test_stream(i, &lengths[i]);
+		if(streams[i] == NULL) {
+			return 1;
+		}
+		positions[i] = 0;
+		/* The reader only checks the frame crc, the worker rejects the message */
+		if(i == 0) {
+			test_break(streams[i]);
+		}
+		sml_pipeline_input_init(&pipeline, &inputs[i], i, &keys[i]);
+	}
+	do {
+		pending = FALSE;
+		for(i=0; i<TEST_KEYS; i++) {
+			step = lengths[i] - positions[i];
+			if(step > TEST_CHUNK) {
+				step = TEST_CHUNK;
+			}
+			submitted += sml_pipeline_input_feed(&pipeline, &inputs[i], streams[i] + positions[i], step);
+			positions[i] += step;
+			pending = pending || positions[i] < lengths[i];
+		}
+	} while(pending);
+	for(i=0; i<TEST_KEYS; i++) {
+		sml_pipeline_input_close(&pipeline, &inputs[i]);
+	}
+	sml_pipeline_stop(&pipeline);
+
+	for(i=0; i<config.exporters; i++) {
+		exported += (uint32_t)pipeline.exporters[i].frames;
+	}
+	if(submitted != TEST_KEYS * TEST_FRAMES || exported != submitted || keys[0].broken != 1) {
+		retValue = 1;
+	}
+	for(i=0; i<TEST_KEYS; i++) {
+		if(keys[i].failed || keys[i].received + keys[i].broken != TEST_FRAMES || inputs[i].deframer.skippedBytes != 0) {
+			retValue = 1;
+		}
+		free(streams[i]);
+	}
+	for(i=0; i<config.workers; i++) {
+		parseErrors += (uint32_t)pipeline.workers[i].parseErrors;
+	}
+	if(parseErrors != 1) {
+		retValue = 1;
+	}
+
+	free(memory);
+	sml_parser_free();
+	return retValue;
+}
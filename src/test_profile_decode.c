@@ -0,0 +1,294 @@
+/**
+ * File name: test_profile_decode.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_metrics.h"
+#include "smllib_latency.h"
+
+#define ROW_COUNT 600
+#define POOL_SIZE 1048576
+
+static uint64_t pool[POOL_SIZE / sizeof(uint64_t)];
+#ifdef SMLLIB_STATIC_POOL
+	/* The encodings outlive sml_parser_free() on the default pool */
+	static uint64_t encoderPool[POOL_SIZE / 8 / sizeof(uint64_t)];
+#endif
+
+static SML_ProfObjPeriodEntry periods[ROW_COUNT];
+static SML_ValueEntry values[ROW_COUNT][2];
+static char signature[] = {"Sig"};
+
+typedef struct Rows {
+	uint32_t headers;
+	uint32_t rows;
+	uint32_t mismatches;
+	uint32_t stopAt;	/* fail the row with this index, ROW_COUNT: never */
+	size_t pointers;	/* largest pointer list seen in a callback */
+} Rows;
+
+static uint8_t check_header(void* user, SML_GetProfilePack_Res* response) {
+	Rows* rows = (Rows*)user;
+
+	rows->headers++;
+	if(response->header_List.listSize != 2 || response->period_List.listSize != ROW_COUNT ||
+		response->period_List.period_List_Entry != NULL || response->regPeriod != 900) {
+		rows->mismatches++;
+	}
+	return SML_PARSE_OK;
+}
+
+static uint8_t check_row(void* user, uint32_t index, SML_ProfObjPeriodEntry* period) {
+	Rows* rows = (Rows*)user;
+	SML_ProfObjPeriodEntry* expected = periods + index;
+	uint32_t v;
+
+	if(index == rows->stopAt) {
+		return SML_PARSE_ERROR;
+	}
+	if(index != rows->rows++ || period->valTime.choiceValue.secIndex != expected->valTime.choiceValue.secIndex ||
+		period->status != expected->status || period->value_List.listSize != 2 ||
+		(period->periodSignature == NULL) != (expected->periodSignature == NULL)) {
+		rows->mismatches++;
+		return SML_PARSE_OK;
+	}
+	for(v=0; v<2; v++) {
+		if(period->value_List.value_List_Entry[v].value.choiceValue.uint64 != expected->value_List.value_List_Entry[v].value.choiceValue.uint64) {
+			rows->mismatches++;
+		}
+	}
+	if(sml_context_current()->pointerCount > rows->pointers) {
+		rows->pointers = sml_context_current()->pointerCount;
+	}
+	return SML_PARSE_OK;
+}
+
+static void init_rows(Rows* rows) {
+	memset(rows, 0, sizeof(Rows));
+	rows->stopAt = ROW_COUNT;
+}
+
+int main(void) {
+	SML_Message message;
+	SML_Message parsed;
+	SML_GetProfilePack_Res response;
+	SML_ProfObjHeaderEntry headers[2];
+	SML_PublicClose_Res closeResponse;
+	SML_Encode_Binary_Result binary;
+	SML_Encode_Binary_Result transport;
+	SML_Context context;
+	SML_Context encoder;
+	SML_Latency latency;
+	#ifndef SMLLIB_NO_METRICS
+		SML_Metrics_Snapshot snapshot;
+	#endif
+	Rows rows;
+	size_t classicHigh;
+	uint32_t offset;
+	uint32_t i;
+	int retValue = 0;
+
+	char* path[1];
+	char pathEntry[] = {"Profile"};
+	char transactionId[] = {"ProfileDecode"};
+	char serverId[] = {"Meter"};
+	char objName[2][7] = {{1, 0, 1, 8, 0, (char)255}, {1, 0, 2, 8, 0, (char)255}};
+
+	for(i=0; i<ROW_COUNT; i++) {
+		values[i][0].value.choiceTag = SML_VALUE_UINT64;
+		values[i][0].value.choiceValue.uint64 = (uint64_t)i * 1000;
+		values[i][0].valueSignature = NULL;
+		/* Every 7th row needs escaping in the transport frame */
+		values[i][1].value.choiceTag = SML_VALUE_UINT64;
+		values[i][1].value.choiceValue.uint64 = (i % 7 == 0) ? ((uint64_t)0x1B1B1B1B << 32 | 0x1B1B1B1B) : i;
+		values[i][1].valueSignature = NULL;
+
+		periods[i].valTime.choiceTag = SML_TIME_SECINDEX;
+		periods[i].valTime.choiceValue.secIndex = i * 900;
+		periods[i].status = i & 0xFF;
+		periods[i].value_List.listSize = 2;
+		periods[i].value_List.value_List_Entry = values[i];
+		periods[i].periodSignature = (i % 50 == 0) ? signature : NULL;
+	}
+
+	path[0] = pathEntry;
+	for(i=0; i<2; i++) {
+		headers[i].objName = objName[i];
+		headers[i].unit = 30;
+		headers[i].scaler = -1;
+	}
+	memset(&response, 0, sizeof(response));
+	response.serverId = serverId;
+	response.actTime.choiceTag = SML_TIME_SECINDEX;
+	response.actTime.choiceValue.secIndex = 31536000;
+	response.regPeriod = 900;
+	response.parameterTreePath.listSize = 1;
+	response.parameterTreePath.path_Entry = path;
+	response.header_List.listSize = 2;
+	response.header_List.header_List_Entry = headers;
+	response.period_List.listSize = ROW_COUNT;
+	response.period_List.period_List_Entry = periods;
+	response.profileSignature = signature;
+
+	message.transactionId = transactionId;
+	message.groupNo = 1;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE;
+	message.messageBody.choiceValue.getProfilePackResponse = &response;
+
+	sml_context_init(&encoder);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&encoder, encoderPool, sizeof(encoderPool));
+	#endif
+	sml_context_use(&encoder);
+	binary = sml_encode_message_binary(&message);
+	transport = sml_transport_encode_message(&message);
+	sml_context_use(NULL);
+	#ifdef SMLLIB_STATIC_POOL
+		/* The unescaped frame does not fit the default pool */
+		sml_context_init(&context);
+		sml_context_set_pool(&context, pool, POOL_SIZE);
+		sml_context_use(&context);
+	#endif
+
+	/* Every row arrives in order, the trailing fields are parsed */
+	init_rows(&rows);
+	offset = 0;
+	if(sml_parse_profilepack_stream(binary.resultBinary, &offset, &parsed, check_header, check_row, &rows) != SML_PARSE_OK ||
+		offset != binary.length || rows.headers != 1 || rows.rows != ROW_COUNT || rows.mismatches != 0 ||
+		strcmp(parsed.transactionId, transactionId) != 0 ||
+		strcmp(parsed.messageBody.choiceValue.getProfilePackResponse->profileSignature, signature) != 0) {
+		retValue = 1;
+	}
+	#ifndef SMLLIB_STATIC_POOL
+		/* Heap: the rows are taken off the pointer list again */
+		if(rows.pointers > 32) {
+			retValue = 1;
+		}
+	#endif
+	sml_parser_free();
+
+	init_rows(&rows);
+	offset = 0;
+	if(sml_transport_parse_profilepack_stream(transport.resultBinary, &offset, &parsed, NULL, check_row, &rows) != SML_PARSE_OK ||
+		offset != transport.length || rows.rows != ROW_COUNT || rows.mismatches != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* Pool: the decode peak is a fraction of the materializing parser's */
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, POOL_SIZE);
+	sml_context_use(&context);
+	offset = 0;
+	if(sml_parse_message_binary(binary.resultBinary, &offset, &parsed) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+	classicHigh = context.pool.high;
+	sml_parser_free();
+	init_rows(&rows);
+	offset = 0;
+	if(sml_parse_profilepack_stream(binary.resultBinary, &offset, &parsed, check_header, check_row, &rows) != SML_PARSE_OK ||
+		rows.rows != ROW_COUNT || context.pool.high * 20 > classicHigh) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(NULL);
+
+	/* Without a period callback the rows are skipped; both calls are counted and timed */
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, POOL_SIZE);
+	sml_latency_init(&latency);
+	sml_context_set_latency(&context, &latency);
+	sml_context_use(&context);
+	init_rows(&rows);
+	offset = 0;
+	if(sml_parse_profilepack_stream(binary.resultBinary, &offset, &parsed, check_header, NULL, &rows) != SML_PARSE_OK ||
+		offset != binary.length || rows.headers != 1 || rows.rows != 0 || rows.mismatches != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	offset = 0;
+	if(sml_transport_parse_profilepack_stream(transport.resultBinary, &offset, &parsed, NULL, NULL, &rows) != SML_PARSE_OK ||
+		offset != transport.length || rows.rows != 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(NULL);
+	#ifndef SMLLIB_NO_METRICS
+		sml_metrics_snapshot(&context, &snapshot);
+		if(snapshot.counters.messagesParsed != 2 || snapshot.counters.messageBytesParsed != 2 * binary.length ||
+			snapshot.counters.framesParsed != 1 || snapshot.counters.frameBytesParsed != transport.length) {
+			retValue = 1;
+		}
+	#endif
+	#ifdef SMLLIB_LATENCY
+		if(sml_latency_histogram(&latency, SML_LATENCY_PARSE, SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE)->count != 1 ||
+			sml_latency_histogram(&latency, SML_LATENCY_TRANSPORT_PARSE, SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE)->count != 1) {
+			retValue = 1;
+		}
+	#endif
+
+	/* A failing callback stops the parse */
+	init_rows(&rows);
+	rows.stopAt = 10;
+	offset = 0;
+	if(sml_parse_profilepack_stream(binary.resultBinary, &offset, &parsed, check_header, check_row, &rows) != SML_PARSE_ERROR ||
+		rows.rows != 10) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* A broken crc is reported after the rows were delivered */
+	binary.resultBinary[binary.length - 2] ^= 0xFF;
+	init_rows(&rows);
+	offset = 0;
+	if(sml_parse_profilepack_stream(binary.resultBinary, &offset, &parsed, NULL, check_row, &rows) != SML_PARSE_ERROR ||
+		rows.rows != ROW_COUNT) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(&encoder);
+	sml_encode_result_free(&binary);
+
+	/* Other message types are refused */
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	closeResponse.globalSignature = NULL;
+	binary = sml_encode_message_binary(&message);
+	sml_context_use(NULL);
+	offset = 0;
+	if(sml_parse_profilepack_stream(binary.resultBinary, &offset, &parsed, NULL, check_row, &rows) != SML_PARSE_ERROR) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_context_use(&encoder);
+	sml_encode_result_free(&binary);
+	sml_encode_result_free(&transport);
+
+	return retValue;
+}
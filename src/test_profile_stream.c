@@ -0,0 +1,222 @@
+/**
+ * File name: test_profile_stream.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+
+#define ROW_COUNT 600
+#define LARGE_ROW_COUNT 35040
+#define OUTPUT_SIZE 65536
+#define POOL_SIZE 1048576
+
+static uint64_t pool[POOL_SIZE / sizeof(uint64_t)];
+
+static SML_ProfObjPeriodEntry periods[ROW_COUNT];
+static SML_ValueEntry values[ROW_COUNT][2];
+
+typedef struct Output {
+	unsigned char data[OUTPUT_SIZE];
+	uint32_t length;
+	uint32_t calls;
+	uint32_t failAt;	/* fail the call with this number, 0: never */
+} Output;
+
+static Output output;
+
+static uint8_t write_output(void* user, const unsigned char* data, uint32_t length) {
+	Output* out = (Output*)user;
+
+	if(++out->calls == out->failAt || out->length + length > OUTPUT_SIZE) {
+		return SML_ENCODE_ERROR;
+	}
+	memcpy(out->data + out->length, data, length);
+	out->length += length;
+	return SML_ENCODE_OK;
+}
+
+static uint8_t write_discard(void* user, const unsigned char* data, uint32_t length) {
+	(void)data;
+	*(uint32_t*)user += length;
+	return SML_ENCODE_OK;
+}
+
+static uint8_t copy_row(void* user, uint32_t index, SML_ProfObjPeriodEntry* row) {
+	*row = ((SML_ProfObjPeriodEntry*)user)[index];
+	return SML_ENCODE_OK;
+}
+
+static uint8_t fail_row(void* user, uint32_t index, SML_ProfObjPeriodEntry* row) {
+	*row = periods[index];
+	return index == *(uint32_t*)user ? SML_ENCODE_ERROR : SML_ENCODE_OK;
+}
+
+/* Generates a 15-minute row on the fly into the reused row */
+static uint8_t generate_row(void* user, uint32_t index, SML_ProfObjPeriodEntry* row) {
+	SML_ValueEntry* value = (SML_ValueEntry*)user;
+
+	value->value.choiceTag = SML_VALUE_UINT64;
+	value->value.choiceValue.uint64 = (uint64_t)index * 250;
+	value->valueSignature = NULL;
+	row->valTime.choiceTag = SML_TIME_SECINDEX;
+	row->valTime.choiceValue.secIndex = index * 900;
+	row->status = index & 0xFF;
+	row->value_List.listSize = 1;
+	row->value_List.value_List_Entry = value;
+	row->periodSignature = NULL;
+	return SML_ENCODE_OK;
+}
+
+static int differs(SML_Encode_Binary_Result* classic, SML_Encode_Binary_Result* streamed) {
+	return classic->resultCode != SML_ENCODE_OK || streamed->resultCode != SML_ENCODE_OK ||
+		streamed->resultBinary != NULL || streamed->length != classic->length ||
+		output.length != classic->length || memcmp(output.data, classic->resultBinary, classic->length) != 0;
+}
+
+int main(void) {
+	SML_Message message;
+	SML_GetProfilePack_Res response;
+	SML_ProfObjHeaderEntry headers[2];
+	SML_Encode_Binary_Result classic;
+	SML_Encode_Binary_Result streamed;
+	SML_ValueEntry generated;
+	SML_Context context;
+	size_t floor;
+	uint32_t failRow;
+	uint32_t written;
+	uint32_t i;
+	int retValue = 0;
+
+	char* path[1];
+	char pathEntry[] = {"Profile"};
+	char transactionId[] = {"ProfileStream"};
+	char serverId[] = {"Meter"};
+	char signature[] = {"Sig"};
+	char objName[2][7] = {{1, 0, 1, 8, 0, (char)255}, {1, 0, 2, 8, 0, (char)255}};
+
+	sml_context_init(&context);
+	sml_context_set_pool(&context, pool, POOL_SIZE);
+	sml_context_use(&context);
+
+	for(i=0; i<ROW_COUNT; i++) {
+		values[i][0].value.choiceTag = SML_VALUE_UINT64;
+		values[i][0].value.choiceValue.uint64 = (uint64_t)i * 1000;
+		values[i][0].valueSignature = NULL;
+		/* Every 7th row carries an escape sequence in its data */
+		values[i][1].value.choiceTag = SML_VALUE_UINT32;
+		values[i][1].value.choiceValue.uint32 = (i % 7 == 0) ? 0x1B1B1B1B : i;
+		values[i][1].valueSignature = NULL;
+
+		periods[i].valTime.choiceTag = SML_TIME_SECINDEX;
+		periods[i].valTime.choiceValue.secIndex = i * 900;
+		periods[i].status = i & 0xFF;
+		periods[i].value_List.listSize = 2;
+		periods[i].value_List.value_List_Entry = values[i];
+		periods[i].periodSignature = (i % 50 == 0) ? signature : NULL;
+	}
+
+	path[0] = pathEntry;
+	for(i=0; i<2; i++) {
+		headers[i].objName = objName[i];
+		headers[i].unit = 30;
+		headers[i].scaler = -1;
+	}
+	memset(&response, 0, sizeof(response));
+	response.serverId = serverId;
+	response.actTime.choiceTag = SML_TIME_SECINDEX;
+	response.actTime.choiceValue.secIndex = 31536000;
+	response.regPeriod = 900;
+	response.parameterTreePath.listSize = 1;
+	response.parameterTreePath.path_Entry = path;
+	response.header_List.listSize = 2;
+	response.header_List.header_List_Entry = headers;
+	response.period_List.listSize = ROW_COUNT;
+	response.period_List.period_List_Entry = periods;
+	response.profileSignature = signature;
+
+	message.transactionId = transactionId;
+	message.groupNo = 1;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE;
+	message.messageBody.choiceValue.getProfilePackResponse = &response;
+
+	/* Byte-identical to the materializing encoders */
+	classic = sml_encode_message_binary(&message);
+	memset(&output, 0, sizeof(output));
+	streamed = sml_encode_profilepack_stream(&message, copy_row, periods, write_output, &output);
+	retValue |= differs(&classic, &streamed);
+	sml_encode_result_free(&classic);
+	sml_parser_free();
+
+	classic = sml_transport_encode_message(&message);
+	memset(&output, 0, sizeof(output));
+	streamed = sml_transport_encode_profilepack_stream(&message, copy_row, periods, write_output, &output);
+	retValue |= differs(&classic, &streamed);
+	sml_encode_result_free(&classic);
+	sml_parser_free();
+
+	/* Callback failures stop the stream */
+	failRow = 10;
+	memset(&output, 0, sizeof(output));
+	streamed = sml_encode_profilepack_stream(&message, fail_row, &failRow, write_output, &output);
+	if(streamed.resultCode != SML_ENCODE_ERROR || strcmp(streamed.errorMessage, "Period callback failed.") != 0) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&streamed);
+
+	memset(&output, 0, sizeof(output));
+	output.failAt = 3;
+	streamed = sml_transport_encode_profilepack_stream(&message, copy_row, periods, write_output, &output);
+	if(streamed.resultCode != SML_ENCODE_ERROR || output.calls != 3 || streamed.length != output.length) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&streamed);
+
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROFILEPACK_REQUEST;
+	streamed = sml_encode_profilepack_stream(&message, copy_row, periods, write_output, &output);
+	if(streamed.resultCode != SML_ENCODE_ERROR) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&streamed);
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROFILEPACK_RESPONSE;
+	sml_parser_free();
+
+	/* A year of 15-minute rows: pool usage does not grow with the row count */
+	floor = context.pool.used;
+	response.period_List.listSize = LARGE_ROW_COUNT;
+	response.period_List.period_List_Entry = NULL;
+	written = 0;
+	streamed = sml_transport_encode_profilepack_stream(&message, generate_row, &generated, write_discard, &written);
+	if(streamed.resultCode != SML_ENCODE_OK || streamed.length != written || written < LARGE_ROW_COUNT * 16) {
+		retValue = 1;
+	}
+	if(context.pool.used != floor || context.pool.high - floor > 4096) {
+		retValue = 1;
+	}
+
+	sml_context_use(NULL);
+	return retValue;
+}
@@ -0,0 +1,254 @@
+/**
+ * File name: test_reader.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+/* posix_openpt(), cfmakeraw() and socketpair() in C89 mode */
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/socket.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_reader.h"
+
+#define READER_SOCKETS 8
+#define READER_LINKS (READER_SOCKETS + 1)
+
+typedef struct Test_Meter {
+	uint32_t messages;
+	uint32_t frames;
+	SML_Boolean closed;
+} Test_Meter;
+
+static uint8_t on_frame(void* user, SML_Link* link, const unsigned char* frame, uint32_t length) {
+	(void)frame;
+	(void)length;
+	(void)user;
+	((Test_Meter*)link->user)->frames++;
+	return SML_PARSE_OK;
+}
+
+static uint8_t on_message(void* user, SML_Link* link, SML_Message* message) {
+	if(message->messageBody.choiceTag == SML_MESSAGEBODY_CLOSE_RESPONSE &&
+		strcmp(message->transactionId, "reader") == 0) {
+		((Test_Meter*)link->user)->messages++;
+	}
+	(*(uint32_t*)user)++;
+	return SML_PARSE_OK;
+}
+
+/* Removes the other links of the batch from the reader on every frame */
+typedef struct Test_Batch {
+	SML_Reader* reader;
+	SML_Link* links;
+	uint32_t count;
+	uint32_t frames;
+	uint8_t result;
+} Test_Batch;
+
+static uint8_t on_frame_batch(void* user, SML_Link* link, const unsigned char* frame, uint32_t length) {
+	Test_Batch* batch = (Test_Batch*)user;
+	uint32_t i;
+
+	(void)frame;
+	(void)length;
+	batch->frames++;
+	for(i=0; i<batch->count; i++) {
+		if(&batch->links[i] != link) {
+			sml_reader_remove(batch->reader, &batch->links[i]);
+		}
+	}
+	return batch->result;
+}
+
+static void on_closed(void* user, SML_Link* link) {
+	(void)user;
+	((Test_Meter*)link->user)->closed = TRUE;
+}
+
+/* Writes count frames in two pieces each, split inside the frame */
+static int write_frames(int fd, const unsigned char* frame, uint32_t length, uint32_t count) {
+	uint32_t i;
+
+	for(i=0; i<count; i++) {
+		if(write(fd, frame, length / 3) != (ssize_t)(length / 3) ||
+			write(fd, frame + length / 3, length - length / 3) != (ssize_t)(length - length / 3)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	SML_Reader reader;
+	Test_Batch batch;
+	SML_Link links[READER_LINKS];
+	Test_Meter meters[READER_LINKS];
+	static unsigned char buffers[READER_LINKS][512];
+	struct termios raw;
+	int writers[READER_LINKS];
+	int pair[2];
+	unsigned char* frame;
+	uint32_t frameLength;
+	uint32_t messages = 0;
+	uint32_t i;
+	int master;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[512];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	closeResponse.globalSignature = "\x1B\x1B\x1B\x1B" "S";
+	message.transactionId = "reader";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK) {
+		return 1;
+	}
+	frameLength = result.length;
+	frame = (unsigned char*)malloc(frameLength);
+	memcpy(frame, result.resultBinary, frameLength);
+	sml_encode_result_free(&result);
+
+	if(sml_reader_init(&reader, on_frame, on_message, on_closed, &messages) != SML_PARSE_OK) {
+		return 1;
+	}
+	memset(meters, 0, sizeof(meters));
+
+	/* Socket pairs stand in for serial links */
+	for(i=0; i<READER_SOCKETS; i++) {
+		if(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+			return 1;
+		}
+		sml_link_init(&links[i], pair[0], buffers[i], sizeof(buffers[i]), &meters[i]);
+		writers[i] = pair[1];
+	}
+
+	/* A raw pty like an optical head behind a USB adapter */
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+		return 1;
+	}
+	writers[READER_SOCKETS] = open(ptsname(master), O_RDWR | O_NOCTTY);
+	if(writers[READER_SOCKETS] < 0 || tcgetattr(writers[READER_SOCKETS], &raw) != 0) {
+		return 1;
+	}
+	cfmakeraw(&raw);
+	tcsetattr(writers[READER_SOCKETS], TCSANOW, &raw);
+	sml_link_init(&links[READER_SOCKETS], master, buffers[READER_SOCKETS], sizeof(buffers[READER_SOCKETS]), &meters[READER_SOCKETS]);
+
+	for(i=0; i<READER_LINKS; i++) {
+		if(sml_reader_add(&reader, &links[i]) != SML_PARSE_OK ||
+			write_frames(writers[i], frame, frameLength, i + 1) != 0) {
+			retValue = 1;
+		}
+		/* Noise in front of the last frame */
+		if(write(writers[i], "noise", 5) != 5 || write_frames(writers[i], frame, frameLength, 1) != 0) {
+			retValue = 1;
+		}
+	}
+
+	/* Nothing is lost when the writers hang up */
+	for(i=0; i<READER_LINKS; i++) {
+		close(writers[i]);
+	}
+	if(sml_reader_run(&reader) != SML_PARSE_OK || reader.links != 0) {
+		retValue = 1;
+	}
+	for(i=0; i<READER_LINKS; i++) {
+		if(!meters[i].closed || meters[i].frames != i + 2 || meters[i].messages != i + 2 ||
+			links[i].deframer.skippedBytes != 5 || links[i].parseErrors != 0) {
+			retValue = 1;
+		}
+		close(links[i].fd);
+	}
+	if(messages != (READER_LINKS * (READER_LINKS + 1)) / 2 + READER_LINKS) {
+		retValue = 1;
+	}
+
+	sml_reader_close(&reader);
+
+	/* Both links are ready in one poll, the first one served removes the other */
+	batch.reader = &reader;
+	batch.links = links;
+	batch.count = 2;
+	batch.frames = 0;
+	batch.result = SML_PARSE_OK;
+	if(sml_reader_init(&reader, on_frame_batch, NULL, NULL, &batch) != SML_PARSE_OK) {
+		return 1;
+	}
+	for(i=0; i<2; i++) {
+		if(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+			return 1;
+		}
+		sml_link_init(&links[i], pair[0], buffers[i], sizeof(buffers[i]), &meters[i]);
+		writers[i] = pair[1];
+		if(sml_reader_add(&reader, &links[i]) != SML_PARSE_OK || write_frames(writers[i], frame, frameLength, 2) != 0) {
+			retValue = 1;
+		}
+	}
+	if(sml_reader_poll(&reader, 1000) != 2 || batch.frames != 2 || reader.links != 1 ||
+		(links[0].bytes == 0) == (links[1].bytes == 0)) {
+		retValue = 1;
+	}
+
+	/* A stopping callback ends the delivery, the second frame waits in the deframer */
+	i = (links[0].open) ? 0 : 1;
+	batch.links = &links[i];
+	batch.count = 1;
+	batch.frames = 0;
+	batch.result = SML_PARSE_ERROR;
+	if(write_frames(writers[i], frame, frameLength, 2) != 0 ||
+		sml_reader_poll(&reader, 1000) != 1 || batch.frames != 1 || !reader.stop) {
+		retValue = 1;
+	}
+	for(i=0; i<2; i++) {
+		close(writers[i]);
+		close(links[i].fd);
+	}
+	sml_reader_close(&reader);
+
+	sml_parser_free();
+	free(frame);
+	sml_context_use(NULL);
+	return retValue;
+}
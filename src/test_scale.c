@@ -0,0 +1,261 @@
+/**
+ * File name: test_scale.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_types.h"
+#include "smllib_scale.h"
+
+#define INT64_MAX_VALUE ((int64_t)(~(uint64_t)0 >> 1))
+#define INT64_MIN_VALUE (-INT64_MAX_VALUE - 1)
+#define POW10_18 ((int64_t)1000000000 * 1000000000)
+
+static int close_to(double value, double expected) {
+	double error = value - expected;
+	double limit = (expected < 0 ? -expected : expected) * 1e-15;
+
+	return (error <= limit && error >= -limit);
+}
+
+int main(void) {
+	int64_t raw[256];
+	int8_t scaler[256];
+	double columnOut[256];
+	double elementOut[256];
+	int64_t fixedColumn[256];
+	int64_t fixedElement[256];
+	SML_ListEntry entries[3];
+	SML_ListEntry_Compact compactEntries[3];
+	SML_List list;
+	SML_List_Compact compactList;
+	SML_ProfObjPeriodEntry periods[2];
+	SML_ValueEntry values[3];
+	List_of_SML_ProfObjPeriodEntry periodList;
+	SML_Value value;
+	SML_Unit units[3];
+	int8_t minus2 = -2;
+	SML_Unit watt = 27;
+	char text[] = {"text"};
+	uint32_t saturated;
+	uint32_t i;
+	uint64_t state = (uint64_t)88172645 * 463325252;
+	int64_t limit;
+	int s;
+	int diff;
+	int retValue = 0;
+
+	/* Double: exact for small scalers, close at the extremes */
+	raw[0] = 12345;
+	sml_scale_column_double(raw, -1, 1, columnOut);
+	if(columnOut[0] != 1234.5) {
+		retValue = 1;
+	}
+	raw[0] = 1;
+	sml_scale_column_double(raw, 127, 1, columnOut);
+	if(columnOut[0] != 1e127) {
+		retValue = 1;
+	}
+	sml_scale_column_double(raw, -128, 1, columnOut);
+	if(!close_to(columnOut[0], 1e-128)) {
+		retValue = 1;
+	}
+	raw[0] = INT64_MIN_VALUE;
+	sml_scale_column_double(raw, 127, 1, columnOut);
+	if(!close_to(columnOut[0], -9.223372036854775808e145)) {
+		retValue = 1;
+	}
+
+	/* Per-value scalers give the same bits as the column kernel, all scalers */
+	for(s=-128; s<128; s++) {
+		raw[s+128] = (int64_t)(s * 7919) - 3;
+		scaler[s+128] = (int8_t)s;
+	}
+	sml_scale_double(raw, scaler, 256, elementOut);
+	for(s=-128; s<128; s++) {
+		sml_scale_column_double(raw + s + 128, (int8_t)s, 1, columnOut);
+		if(columnOut[0] != elementOut[s+128]) {
+			retValue = 1;
+		}
+	}
+
+	/* Fixed point: rounding half away from zero, saturation */
+	raw[0] = 12345;
+	raw[1] = -12345;
+	raw[2] = 0;
+	scaler[0] = scaler[1] = scaler[2] = -1;
+	if(sml_scale_fixed(raw, scaler, -3, 3, fixedElement) != 0 || fixedElement[0] != 1234500 || fixedElement[1] != -1234500 ||
+		sml_scale_fixed(raw, scaler, 0, 3, fixedElement) != 0 || fixedElement[0] != 1235 || fixedElement[1] != -1235 || fixedElement[2] != 0) {
+		retValue = 1;
+	}
+	scaler[0] = scaler[1] = scaler[2] = 127;
+	if(sml_scale_fixed(raw, scaler, -128, 3, fixedElement) != 2 ||
+		fixedElement[0] != INT64_MAX_VALUE || fixedElement[1] != INT64_MIN_VALUE || fixedElement[2] != 0) {
+		retValue = 1;
+	}
+	if(sml_scale_column_fixed(raw, -128, 127, 3, fixedColumn) != 0 || fixedColumn[0] != 0 || fixedColumn[1] != 0) {
+		retValue = 1;
+	}
+	raw[0] = INT64_MAX_VALUE;
+	raw[1] = INT64_MIN_VALUE;
+	raw[2] = POW10_18 * 5 - 1;
+	if(sml_scale_column_fixed(raw, -19, 0, 3, fixedColumn) != 0 ||
+		fixedColumn[0] != 1 || fixedColumn[1] != -1 || fixedColumn[2] != 0) {
+		retValue = 1;
+	}
+	raw[0] = 9;
+	raw[1] = 10;
+	raw[2] = -9;
+	if(sml_scale_column_fixed(raw, 18, 0, 3, fixedColumn) != 1 ||
+		fixedColumn[0] != POW10_18 * 9 || fixedColumn[1] != INT64_MAX_VALUE || fixedColumn[2] != -POW10_18 * 9) {
+		retValue = 1;
+	}
+
+	/* Column and per-value fixed kernels agree for all shifts */
+	for(i=0; i<256; i++) {
+		raw[i] = (int64_t)((i * 2654435761UL) % 2000001UL) - 1000000;
+	}
+	raw[0] = INT64_MAX_VALUE;
+	raw[1] = INT64_MIN_VALUE + 1;
+	for(diff=-25; diff<=25; diff++) {
+		for(i=0; i<256; i++) {
+			scaler[i] = (int8_t)diff;
+		}
+		saturated = sml_scale_column_fixed(raw, (int8_t)diff, 0, 256, fixedColumn);
+		if(sml_scale_fixed(raw, scaler, 0, 256, fixedElement) != saturated) {
+			retValue = 1;
+		}
+		for(i=0; i<256; i++) {
+			if(fixedColumn[i] != fixedElement[i]) {
+				retValue = 1;
+			}
+		}
+	}
+
+	/* SIMD lanes and scalar loops give the same bits; odd count for a tail */
+	for(i=0; i<256; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		raw[i] = (int64_t)(state >> (1 + i % 63)) * ((i & 1) ? -1 : 1);
+	}
+	raw[1] = INT64_MAX_VALUE;
+	raw[2] = INT64_MIN_VALUE;
+	raw[3] = -((int64_t)1 << 48);
+	raw[4] = ((int64_t)1 << 53) + 1;
+	raw[5] = -((int64_t)1 << 53) - 3;
+	raw[6] = -1;
+	for(s=-128; s<128; s++) {
+		sml_scale_column_double(raw + 1, (int8_t)s, 255, columnOut);
+		p_sml_scale_column_double_scalar(raw + 1, (int8_t)s, 255, elementOut);
+		for(i=0; i<255; i++) {
+			if(columnOut[i] != elementOut[i]) {
+				retValue = 1;
+			}
+		}
+	}
+	for(diff=-25; diff<=25; diff++) {
+		limit = INT64_MAX_VALUE;
+		for(s=0; s<diff && s<19; s++) {
+			limit /= 10;
+		}
+		raw[7] = limit;
+		raw[8] = limit + (diff > 0);
+		raw[9] = -limit;
+		raw[10] = -limit - (diff > 0);
+		saturated = sml_scale_column_fixed(raw + 1, (int8_t)diff, 0, 255, fixedColumn);
+		if(p_sml_scale_column_fixed_scalar(raw + 1, (int8_t)diff, 0, 255, fixedElement) != saturated) {
+			retValue = 1;
+		}
+		for(i=0; i<255; i++) {
+			if(fixedColumn[i] != fixedElement[i]) {
+				retValue = 1;
+			}
+		}
+	}
+
+	/* Gathering from parsed structures */
+	value.choiceTag = SML_VALUE_UINT64;
+	value.choiceValue.uint64 = ~(uint64_t)0;
+	if(sml_value_raw(&value, raw) != TRUE || raw[0] != INT64_MAX_VALUE) {
+		retValue = 1;
+	}
+	value.choiceTag = SML_VALUE_BOOLEAN;
+	if(sml_value_raw(&value, raw) != FALSE || raw[0] != 0) {
+		retValue = 1;
+	}
+
+	for(i=0; i<3; i++) {
+		entries[i].scaler = NULL;
+		entries[i].unit = NULL;
+		compactEntries[i].present = 0;
+	}
+	entries[0].value.choiceTag = SML_VALUE_INT16;
+	entries[0].value.choiceValue.int16 = -150;
+	entries[0].scaler = &minus2;
+	entries[0].unit = &watt;
+	entries[1].value.choiceTag = SML_VALUE_UINT32;
+	entries[1].value.choiceValue.uint32 = 42;
+	entries[2].value.choiceTag = SML_VALUE_STRING;
+	entries[2].value.choiceValue.string = text;
+	list.listSize = 3;
+	list.valListEntry = entries;
+	if(sml_list_raw(&list, raw, scaler, units) != 2 || raw[0] != -150 || raw[1] != 42 || raw[2] != 0 ||
+		scaler[0] != -2 || scaler[1] != 0 || units[0] != 27 || units[1] != 0) {
+		retValue = 1;
+	}
+	sml_scale_double(raw, scaler, 2, elementOut);
+	if(elementOut[0] != -1.5 || elementOut[1] != 42.0) {
+		retValue = 1;
+	}
+
+	for(i=0; i<3; i++) {
+		compactEntries[i].value = entries[i].value;
+	}
+	compactEntries[0].scaler = -2;
+	compactEntries[0].unit = 27;
+	compactEntries[0].present = SML_LISTENTRY_SCALER | SML_LISTENTRY_UNIT;
+	compactEntries[1].scaler = 5;
+	compactList.listSize = 3;
+	compactList.valListEntry = compactEntries;
+	if(sml_list_compact_raw(&compactList, raw, scaler, NULL) != 2 || raw[0] != -150 || scaler[0] != -2 || scaler[1] != 0) {
+		retValue = 1;
+	}
+
+	values[0].value.choiceTag = SML_VALUE_UINT8;
+	values[0].value.choiceValue.uint8 = 7;
+	values[1].value.choiceTag = SML_VALUE_INT64;
+	values[1].value.choiceValue.int64 = -8;
+	values[2].value.choiceTag = SML_VALUE_INT8;
+	values[2].value.choiceValue.int8 = 9;
+	periods[0].value_List.listSize = 2;
+	periods[0].value_List.value_List_Entry = values;
+	periods[1].value_List.listSize = 1;
+	periods[1].value_List.value_List_Entry = values + 2;
+	periodList.listSize = 2;
+	periodList.period_List_Entry = periods;
+	if(sml_profile_column_raw(&periodList, 1, raw) != 1 || raw[0] != -8 || raw[1] != 0 ||
+		sml_profile_column_raw(&periodList, 0, raw) != 2 || raw[0] != 7 || raw[1] != 9) {
+		retValue = 1;
+	}
+
+	return retValue;
+}
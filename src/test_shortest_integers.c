@@ -0,0 +1,147 @@
+/**
+ * File name: test_shortest_integers.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_test.h"
+
+#define ENTRY_COUNT 8
+
+static int64_t value_as_int64(SML_Value* value) {
+	switch(value->choiceTag) {
+		case SML_VALUE_UINT8: return value->choiceValue.uint8;
+		case SML_VALUE_UINT16: return value->choiceValue.uint16;
+		case SML_VALUE_UINT32: return value->choiceValue.uint32;
+		case SML_VALUE_UINT64: return (int64_t)value->choiceValue.uint64;
+		case SML_VALUE_INT8: return value->choiceValue.int8;
+		case SML_VALUE_INT16: return value->choiceValue.int16;
+		case SML_VALUE_INT32: return value->choiceValue.int32;
+		case SML_VALUE_INT64: return value->choiceValue.int64;
+		default: return 0;
+	}
+}
+
+int main(void) {
+	SML_Message message;
+	SML_Message refMessage;
+	SML_GetList_Res getListRes;
+	SML_ListEntry entries[ENTRY_COUNT];
+	SML_Status status;
+	SML_Encode_Binary_Result full;
+	SML_Encode_Binary_Result shortest;
+	SML_GetList_Res* refRes;
+	uint32_t offset = 0;
+	uint32_t i;
+	int retValue = 1;
+	SML_Context context;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[1024];
+	#endif
+
+	uint8_t unit = 30;
+	int8_t scaler = -1;
+	char objName[] = {"MyObjectName"};
+	char transactionId[] = {"ShortestIntegers_TransactionId"};
+	char serverId[] = {"MyServer"};
+
+	status.choiceTag = SML_STATUS_UINT64;
+	status.choiceValue.uint64 = 0x0182;
+
+	for(i=0; i<ENTRY_COUNT; i++) {
+		entries[i].objName = objName;
+		entries[i].status = &status;
+		entries[i].valTime = NULL;
+		entries[i].unit = &unit;
+		entries[i].scaler = &scaler;
+		entries[i].valueSignature = NULL;
+	}
+	entries[0].value.choiceTag = SML_VALUE_UINT64;
+	entries[0].value.choiceValue.uint64 = 5;
+	entries[1].value.choiceTag = SML_VALUE_UINT64;
+	entries[1].value.choiceValue.uint64 = 0x123456;
+	entries[2].value.choiceTag = SML_VALUE_INT64;
+	entries[2].value.choiceValue.int64 = -1;
+	entries[3].value.choiceTag = SML_VALUE_INT32;
+	entries[3].value.choiceValue.int32 = -129;
+	entries[4].value.choiceTag = SML_VALUE_INT64;
+	entries[4].value.choiceValue.int64 = 128;
+	entries[5].value.choiceTag = SML_VALUE_INT64;
+	entries[5].value.choiceValue.int64 = -8388609; /* -2^23 - 1 */
+	entries[6].value.choiceTag = SML_VALUE_INT64;
+	entries[6].value.choiceValue.int64 = (-0x7FFFFFFFFFFFFFFF - 1);
+	entries[7].value.choiceTag = SML_VALUE_UINT32;
+	entries[7].value.choiceValue.uint32 = 0xFFFFFFFF;
+
+	getListRes.clientId = NULL;
+	getListRes.serverId = serverId;
+	getListRes.listName = NULL;
+	getListRes.actSensorTime = NULL;
+	getListRes.actGatewayTime = NULL;
+	getListRes.listSignature = NULL;
+	getListRes.valList.listSize = ENTRY_COUNT;
+	getListRes.valList.valListEntry = entries;
+
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &getListRes;
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	full = sml_encode_message_binary(&message);
+	sml_encode_set_shortest_integers(TRUE);
+	shortest = sml_encode_message_binary(&message);
+
+	/* Shortest form must be smaller and decode to the same values */
+	if(shortest.length < full.length &&
+		sml_parse_message_binary(shortest.resultBinary, &offset, &refMessage) == SML_PARSE_OK &&
+		offset == shortest.length) {
+		refRes = refMessage.messageBody.choiceValue.getListResponse;
+		retValue = 0;
+		for(i=0; i<ENTRY_COUNT; i++) {
+			if(value_as_int64(&refRes->valList.valListEntry[i].value) != value_as_int64(&entries[i].value) ||
+				*refRes->valList.valListEntry[i].scaler != scaler ||
+				refRes->valList.valListEntry[i].status->choiceTag != SML_STATUS_UINT16 ||
+				refRes->valList.valListEntry[i].status->choiceValue.uint16 != status.choiceValue.uint64) {
+				retValue = 1;
+			}
+		}
+	}
+	sml_parser_free();
+	sml_encode_result_free(&full);
+	sml_encode_result_free(&shortest);
+
+	if(retValue == 0) {
+		retValue = sml_encode_parse_msg_test(&message) || sml_transport_msg_test(&message);
+	}
+
+	return retValue;
+}
@@ -0,0 +1,165 @@
+/**
+ * File name: test_sml_transport_recover.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_metrics.h"
+
+#define CAPTURE_PARTS 7
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Encode_Binary_Result result;
+	SML_File file;
+	SML_Frame_Error errors[4];
+	#ifndef SMLLIB_NO_METRICS
+		SML_Metrics_Snapshot snapshot;
+	#endif
+	SML_Frame_Error expected[4];
+	const unsigned char* parts[CAPTURE_PARTS];
+	uint32_t partLength[CAPTURE_PARTS];
+	unsigned char* frame;
+	unsigned char* capture;
+	uint32_t frameLength;
+	uint32_t captureLength = 0;
+	uint32_t errorCount;
+	uint32_t i;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[4096];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* Escaped 0x1B run inside the frame */
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	closeResponse.globalSignature = "\x1B\x1B\x1B\x1B" "S";
+	message.transactionId = "recover";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	result = sml_transport_encode_message(&message);
+	if(result.resultCode != SML_ENCODE_OK) {
+		return 1;
+	}
+	frameLength = result.length;
+	frame = (unsigned char*)malloc(frameLength);
+	memcpy(frame, result.resultBinary, frameLength);
+	sml_encode_result_free(&result);
+
+	/* noise, good, bad CRC, good, truncated, good, noise */
+	parts[0] = (const unsigned char*)"\x1B\x1B\x01noise";
+	partLength[0] = 8;
+	for(i=1; i<6; i++) {
+		parts[i] = frame;
+		partLength[i] = frameLength;
+	}
+	partLength[4] = frameLength / 2;
+	parts[6] = (const unsigned char*)"\x1B\x1B\x1B";
+	partLength[6] = 3;
+	for(i=0; i<CAPTURE_PARTS; i++) {
+		captureLength += partLength[i];
+	}
+
+	/* Exactly sized, reads beyond the capture are caught by sanitizers */
+	capture = (unsigned char*)malloc(captureLength);
+	captureLength = 0;
+	for(i=0; i<CAPTURE_PARTS; i++) {
+		memcpy(capture + captureLength, parts[i], partLength[i]);
+		if(i == 2) {
+			capture[captureLength + partLength[i] - 1] ^= 0xFF;
+		}
+		captureLength += partLength[i];
+	}
+
+	expected[0].offset = 0;
+	expected[0].length = partLength[0];
+	expected[0].reason = SML_FRAME_ERROR_SYNC;
+	expected[1].offset = partLength[0] + frameLength;
+	expected[1].length = frameLength;
+	expected[1].reason = SML_FRAME_ERROR_INVALID;
+	expected[2].offset = partLength[0] + 3*frameLength;
+	expected[2].length = partLength[4];
+	expected[2].reason = SML_FRAME_ERROR_INVALID;
+	expected[3].offset = captureLength - partLength[6];
+	expected[3].length = partLength[6];
+	expected[3].reason = SML_FRAME_ERROR_SYNC;
+
+	sml_metrics_reset(&context);
+	if(sml_transport_parse_file_tolerant(capture, captureLength, &file, errors, 4, &errorCount) != SML_PARSE_OK ||
+		file.msgCount != 3 || errorCount != 4) {
+		retValue = 1;
+	}
+	else {
+		for(i=0; i<3; i++) {
+			if(file.messages[i]->messageBody.choiceTag != SML_MESSAGEBODY_CLOSE_RESPONSE ||
+				strcmp(file.messages[i]->transactionId, "recover") != 0 ||
+				strcmp(file.messages[i]->messageBody.choiceValue.closeResponse->globalSignature, closeResponse.globalSignature) != 0) {
+				retValue = 1;
+			}
+		}
+		for(i=0; i<4; i++) {
+			if(errors[i].offset != expected[i].offset || errors[i].length != expected[i].length ||
+				errors[i].reason != expected[i].reason) {
+				retValue = 1;
+			}
+		}
+	}
+	#ifndef SMLLIB_NO_METRICS
+		sml_metrics_snapshot(&context, &snapshot);
+		if(snapshot.counters.framesParsed != 3 || snapshot.counters.framesSkipped != 2 ||
+			snapshot.counters.resyncBytes != partLength[0] + frameLength + partLength[4] + partLength[6]) {
+			retValue = 1;
+		}
+	#endif
+	sml_parser_free();
+
+	/* Errors beyond the given space are counted only */
+	if(sml_transport_parse_file_tolerant(capture, captureLength, &file, errors, 1, &errorCount) != SML_PARSE_OK ||
+		file.msgCount != 3 || errorCount != 4 || errors[0].reason != SML_FRAME_ERROR_SYNC) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* Nothing but noise */
+	if(sml_transport_parse_file_tolerant(capture, 5, &file, errors, 4, &errorCount) != SML_PARSE_OK ||
+		file.msgCount != 0 || errorCount != 1 || errors[0].length != 5) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	free(capture);
+	free(frame);
+	sml_context_use(NULL);
+	return retValue;
+}
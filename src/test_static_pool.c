@@ -0,0 +1,168 @@
+/**
+ * File name: test_static_pool.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+
+#define ENTRY_COUNT 4
+#define POOL_SIZE 4096
+
+static uint32_t heapAllocations = 0;
+
+static void* test_alloc(void* user, size_t size) {
+	(void)user;
+	heapAllocations++;
+	return malloc(size);
+}
+
+static void* test_realloc(void* user, void* ptr, size_t size) {
+	(void)user;
+	heapAllocations++;
+	return realloc(ptr, size);
+}
+
+static void test_free(void* user, void* ptr) {
+	(void)user;
+	free(ptr);
+}
+
+static uint64_t pool[POOL_SIZE / sizeof(uint64_t)];
+
+int main(void) {
+	SML_Context context;
+	SML_Allocator allocator;
+	SML_Message message;
+	SML_Message refMessage;
+	SML_GetList_Res getListRes;
+	SML_ListEntry entries[ENTRY_COUNT];
+	SML_Encode_Binary_Result result;
+	size_t worstCase;
+	uint32_t offset;
+	uint32_t i;
+	unsigned char* older;
+	unsigned char* younger;
+	int retValue = 0;
+
+	uint8_t unit = 30;
+	int8_t scaler = -1;
+	char objName[] = {"MyObjectName"};
+	char transactionId[] = {"StaticPool_TransactionId"};
+	char serverId[] = {"MyServer"};
+
+	for(i=0; i<ENTRY_COUNT; i++) {
+		entries[i].objName = objName;
+		entries[i].status = NULL;
+		entries[i].valTime = NULL;
+		entries[i].unit = &unit;
+		entries[i].scaler = &scaler;
+		entries[i].value.choiceTag = SML_VALUE_UINT32;
+		entries[i].value.choiceValue.uint32 = 1000 * i;
+		entries[i].valueSignature = NULL;
+	}
+
+	getListRes.clientId = NULL;
+	getListRes.serverId = serverId;
+	getListRes.listName = NULL;
+	getListRes.actSensorTime = NULL;
+	getListRes.actGatewayTime = NULL;
+	getListRes.listSignature = NULL;
+	getListRes.valList.listSize = ENTRY_COUNT;
+	getListRes.valList.valListEntry = entries;
+
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETLIST_RESPONSE;
+	message.messageBody.choiceValue.getListResponse = &getListRes;
+
+	/* Encode on the heap of the default context */
+	result = sml_transport_encode_message(&message);
+
+	/* Parse from the pool; the allocator must never be called */
+	allocator.alloc = test_alloc;
+	allocator.realloc = test_realloc;
+	allocator.free = test_free;
+	allocator.user = NULL;
+	sml_context_init(&context);
+	sml_context_set_allocator(&context, &allocator);
+	sml_context_set_pool(&context, pool, POOL_SIZE);
+	sml_context_use(&context);
+
+	offset = 0;
+	if(sml_transport_parse_message(result.resultBinary, &offset, &refMessage) != SML_PARSE_OK ||
+		refMessage.messageBody.choiceValue.getListResponse->valList.valListEntry[3].value.choiceValue.uint32 != 3000 ||
+		heapAllocations != 0) {
+		retValue = 1;
+	}
+	worstCase = sml_context_pool_worst_case(&context, SML_MESSAGEBODY_GETLIST_RESPONSE);
+	if(worstCase == 0 || worstCase > POOL_SIZE || context.pool.used == 0) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	if(context.pool.used != 0) {
+		retValue = 1;
+	}
+
+	/* One byte less than the worst case runs out of memory */
+	sml_context_set_pool(&context, pool, worstCase - 1);
+	offset = 0;
+	if(sml_transport_parse_message(result.resultBinary, &offset, &refMessage) != SML_PARSE_NOMEM ||
+		context.pool.used > worstCase - 1) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* The worst case itself is sufficient */
+	sml_context_set_pool(&context, pool, worstCase);
+	offset = 0;
+	if(sml_transport_parse_message(result.resultBinary, &offset, &refMessage) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	/* An older block is copied with its own bytes only, not the next block's */
+	sml_context_set_pool(&context, pool, POOL_SIZE);
+	older = (unsigned char*)p_sml_calloc(1, 4);
+	younger = (unsigned char*)p_sml_calloc(1, 8);
+	memset(older, 0x11, 4);
+	memset(younger, 0xAA, 8);
+	older = (unsigned char*)p_sml_realloc(older, 4, 16);
+	if(older == NULL || older[3] != 0x11) {
+		retValue = 1;
+	}
+	for(i=4; older != NULL && i<16; i++) {
+		if(older[i] != 0) {
+			retValue = 1;
+		}
+	}
+	sml_parser_free();
+
+	sml_context_use(NULL);
+	sml_encode_result_free(&result);
+
+	return retValue;
+}
@@ -0,0 +1,129 @@
+/**
+ * File name: test_trace.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_trace.h"
+
+typedef struct Events {
+	uint32_t levels[SML_TRACE_FIELDS + 1];
+	uint32_t errors;			/* SML_TRACE_TEXT events */
+	uint32_t transactionIds;	/* message summaries naming the right transaction */
+	uint32_t malformed;
+} Events;
+
+static void count_event(void* user, const SML_Trace_Event* event) {
+	Events* events = (Events*)user;
+
+	if(event->level > SMLLIB_TRACE_LEVEL || event->name == NULL ||
+		(event->type != SML_TRACE_NUMBER && event->length > 0 && event->data == NULL)) {
+		events->malformed++;
+		return;
+	}
+	events->levels[event->level]++;
+	if(event->type == SML_TRACE_TEXT) {
+		events->errors++;
+	}
+	if(event->level == SML_TRACE_MESSAGE && event->type == SML_TRACE_BYTES && strcmp(event->name, "transactionId") == 0 &&
+		event->length == 5 && memcmp(event->data, "Trace", 5) == 0) {
+		events->transactionIds++;
+	}
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_Encode_Binary_Result result;
+	SML_Encode_Binary_Result failed;
+	SML_PublicClose_Res closeResponse;
+	SML_Message message;
+	SML_Message parsed;
+	SML_Message* messages[1];
+	SML_File file;
+	Events events;
+	uint32_t offset = 0;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[8192];
+	#endif
+
+	memset(&events, 0, sizeof(events));
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	message.transactionId = "Trace";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* No sink: trace points are silent */
+	result = sml_encode_message_binary(&message);
+	sml_encode_result_free(&result);
+
+	sml_context_set_trace_sink(&context, count_event, &events);
+	result = sml_encode_message_binary(&message);
+	if(result.resultCode != SML_ENCODE_OK || sml_parse_message_binary(result.resultBinary, &offset, &parsed) != SML_PARSE_OK) {
+		retValue = 1;
+	}
+
+	/* Corrupted CRC and an invalid file (the binary stays valid until
+	 * sml_parser_free(), it lives in the same pool) */
+	result.resultBinary[result.length - 2] ^= 0xFF;
+	offset = 0;
+	if(sml_parse_message_binary(result.resultBinary, &offset, &parsed) != SML_PARSE_ERROR) {
+		retValue = 1;
+	}
+	sml_parser_free();
+	sml_encode_result_free(&result);
+	file.messages = messages;
+	file.msgCount = 0;
+	failed = sml_encode_file_binary(&file);
+	if(failed.resultCode != SML_ENCODE_ERROR) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&failed);
+	sml_context_use(NULL);
+
+	/* Exactly the compiled-in levels produce events */
+	if(events.malformed > 0 || events.levels[SML_TRACE_OFF] > 0) {
+		retValue = 1;
+	}
+	if((SMLLIB_TRACE_LEVEL >= SML_TRACE_ERROR) != (events.errors == 2)) {
+		retValue = 1;
+	}
+	if((SMLLIB_TRACE_LEVEL >= SML_TRACE_MESSAGE) != (events.transactionIds == 3)) {
+		retValue = 1;
+	}
+	if((SMLLIB_TRACE_LEVEL >= SML_TRACE_FIELDS) != (events.levels[SML_TRACE_FIELDS] > 0)) {
+		retValue = 1;
+	}
+
+	return retValue;
+}
@@ -0,0 +1,166 @@
+/**
+ * File name: test_tree.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+
+#define CHAIN_LENGTH (SMLLIB_TREE_MAX_DEPTH + 2)
+#define FANOUT 7
+#define WIDE_NODES (1 + FANOUT + FANOUT * FANOUT)
+
+static char name[] = {"x"};
+
+/* Links nodes[0..count-1] to a chain, nodes[count-1] being the leaf */
+static void build_chain(SML_Tree* nodes, List_of_SML_Tree* lists, uint32_t count) {
+	uint32_t i;
+
+	for(i=0; i<count; i++) {
+		nodes[i].parameterName = name;
+		nodes[i].parameterValue = NULL;
+		nodes[i].child_List = NULL;
+		if(i + 1 < count) {
+			lists[i].listSize = 1;
+			lists[i].tree_Entry = nodes + i + 1;
+			nodes[i].child_List = lists + i;
+		}
+	}
+}
+
+/* Encoded chain of count nodes, written by hand */
+static uint32_t write_chain(unsigned char* buffer, uint32_t count) {
+	uint32_t length = 0;
+	uint32_t i;
+
+	for(i=0; i<count; i++) {
+		buffer[length++] = 0x73;
+		buffer[length++] = 0x02;
+		buffer[length++] = 'x';
+		buffer[length++] = 0x01;
+		buffer[length++] = (i + 1 < count) ? 0x71 : 0x01;
+	}
+	return length;
+}
+
+int main(void) {
+	SML_Tree nodes[WIDE_NODES];
+	List_of_SML_Tree lists[WIDE_NODES];
+	SML_Tree parsed;
+	SML_Tree* node;
+	SML_Encode_Binary_Result binary;
+	SML_Encode_Binary_Result again;
+	SML_Message message;
+	SML_GetProcParameter_Res response;
+	unsigned char buffer[CHAIN_LENGTH * 5];
+	char* path[1];
+	uint32_t offset = 0;
+	uint32_t length;
+	uint32_t i;
+	int retValue = 0;
+	SML_Context context;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[4096];
+	#endif
+
+	char transactionId[] = {"Tree_TransactionId"};
+	char serverId[] = {"MyServer"};
+	char pathEntry[] = {"\x81\x81\xC7\x86\x20\xFF"};
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* Deepest tree allowed: round trip */
+	build_chain(nodes, lists, CHAIN_LENGTH - 1);
+	binary = p_sml_encode_tree(nodes);
+	length = write_chain(buffer, CHAIN_LENGTH - 1);
+	if(binary.length != length || memcmp(binary.resultBinary, buffer, length) != 0 ||
+		p_sml_parse_tree(binary.resultBinary, &offset, &parsed) != SML_PARSE_OK || offset != length) {
+		retValue = 1;
+	}
+	for(node = &parsed, i = 1; node->child_List != NULL; node = node->child_List->tree_Entry, i++);
+	if(i != CHAIN_LENGTH - 1) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&binary);
+	sml_parser_free();
+
+	/* One level more is refused by parser and encoder */
+	length = write_chain(buffer, CHAIN_LENGTH);
+	offset = 0;
+	if(p_sml_parse_tree(buffer, &offset, &parsed) != SML_PARSE_ERROR) {
+		retValue = 1;
+	}
+	sml_parser_free();
+
+	build_chain(nodes, lists, CHAIN_LENGTH);
+	path[0] = pathEntry;
+	response.serverId = serverId;
+	response.parameterTreePath.listSize = 1;
+	response.parameterTreePath.path_Entry = path;
+	response.parameterTree = nodes[0];
+	message.transactionId = transactionId;
+	message.groupNo = 0;
+	message.abortOnError = 0;
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE;
+	message.messageBody.choiceValue.getProcParameterResponse = &response;
+	binary = sml_encode_message_binary(&message);
+	if(binary.resultCode != SML_ENCODE_ERROR || binary.errorMessage == NULL || binary.resultBinary != NULL) {
+		retValue = 1;
+	}
+	sml_encode_result_free(&binary);
+
+	/* Wide tree: three levels, siblings keep their order */
+	for(i=0; i<WIDE_NODES; i++) {
+		nodes[i].parameterName = name;
+		nodes[i].parameterValue = NULL;
+		nodes[i].child_List = NULL;
+		if(1 + (i + 1) * FANOUT <= WIDE_NODES) {
+			lists[i].listSize = FANOUT;
+			lists[i].tree_Entry = nodes + 1 + i * FANOUT;
+			nodes[i].child_List = lists + i;
+		}
+	}
+	binary = p_sml_encode_tree(nodes);
+	offset = 0;
+	if(p_sml_parse_tree(binary.resultBinary, &offset, &parsed) != SML_PARSE_OK || offset != binary.length ||
+		parsed.child_List->listSize != FANOUT || parsed.child_List->tree_Entry[FANOUT-1].child_List->listSize != FANOUT) {
+		retValue = 1;
+	}
+	else {
+		again = p_sml_encode_tree(&parsed);
+		if(again.length != binary.length || memcmp(again.resultBinary, binary.resultBinary, binary.length) != 0) {
+			retValue = 1;
+		}
+		sml_encode_result_free(&again);
+	}
+	sml_encode_result_free(&binary);
+	sml_parser_free();
+
+	return retValue;
+}
@@ -0,0 +1,142 @@
+/**
+ * File name: test_tree_index.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_tree.h"
+
+#define NODE_COUNT 1000
+#define FANOUT 9
+
+#ifdef SMLLIB_STATIC_POOL
+	static uint64_t pool[65536];
+#endif
+
+static char names[FANOUT + 1][3] = {"n0", "n1", "n2", "n3", "n4", "n5", "n6", "n7", "n8", "n9"};
+
+/* Path of an indexed node, built from the parent links */
+static void entry_path(const SML_Tree_Index* index, uint32_t e, SML_TreePath* path, char** components) {
+	uint32_t i;
+
+	path->listSize = index->entries[e].depth + 1;
+	path->path_Entry = components;
+	for(i = path->listSize; i > 0; i--, e = index->entries[e].parent) {
+		components[i-1] = index->entries[e].node->parameterName;
+	}
+}
+
+int main(void) {
+	SML_Tree nodes[NODE_COUNT];
+	List_of_SML_Tree lists[NODE_COUNT];
+	SML_Tree parsed;
+	SML_Tree_Index* index;
+	SML_TreePath path;
+	SML_Encode_Binary_Result binary;
+	SML_Context context;
+	char* components[SMLLIB_TREE_MAX_DEPTH + 2];
+	uint32_t first;
+	uint32_t offset = 0;
+	uint32_t i;
+	int retValue = 0;
+
+	char root[] = {"\x81\x81\xC7\x86\x20\xFF"};
+	char missing[] = {"n"};
+
+	/* Breadth first tree, siblings named n0..n8, the root n9 */
+	for(i=0; i<NODE_COUNT; i++) {
+		nodes[i].parameterName = (i == 0) ? root : names[(i - 1) % FANOUT];
+		nodes[i].parameterValue = NULL;
+		nodes[i].child_List = NULL;
+		first = i * FANOUT + 1;
+		if(first < NODE_COUNT) {
+			lists[i].listSize = (NODE_COUNT - first < FANOUT) ? NODE_COUNT - first : FANOUT;
+			lists[i].tree_Entry = nodes + first;
+			nodes[i].child_List = lists + i;
+		}
+	}
+	/* A second n3 below the root is shadowed by the first */
+	nodes[5].parameterName = names[3];
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	binary = p_sml_encode_tree(nodes);
+	if(binary.resultBinary == NULL || p_sml_parse_tree(binary.resultBinary, &offset, &parsed) != SML_PARSE_OK) {
+		return 1;
+	}
+	index = sml_tree_index_create(&parsed);
+	if(index == NULL || index->count != NODE_COUNT) {
+		return 1;
+	}
+
+	/* Every path resolves like the linear lookup does */
+	for(i=0; i<index->count; i++) {
+		entry_path(index, i, &path, components);
+		if(sml_tree_index_find(index, &path) != sml_tree_find(&parsed, &path) ||
+			sml_tree_find(&parsed, &path) == NULL) {
+			retValue = 1;
+		}
+	}
+	path.listSize = 2;
+	components[0] = root;
+	components[1] = names[3];
+	if(sml_tree_index_find(index, &path) != parsed.child_List->tree_Entry+3) {
+		retValue = 1;
+	}
+
+	/* Unknown component, wrong root, too long and empty paths */
+	components[1] = missing;
+	if(sml_tree_index_find(index, &path) != NULL || sml_tree_find(&parsed, &path) != NULL) {
+		retValue = 1;
+	}
+	components[0] = names[0];
+	components[1] = names[0];
+	if(sml_tree_index_find(index, &path) != NULL || sml_tree_find(&parsed, &path) != NULL) {
+		retValue = 1;
+	}
+	components[0] = root;
+	for(i=1; i<SMLLIB_TREE_MAX_DEPTH + 2; i++) {
+		components[i] = names[0];
+	}
+	path.listSize = SMLLIB_TREE_MAX_DEPTH + 2;
+	if(sml_tree_index_find(index, &path) != NULL || sml_tree_find(&parsed, &path) != NULL) {
+		retValue = 1;
+	}
+	path.listSize = 0;
+	if(sml_tree_index_find(index, &path) != NULL || sml_tree_find(&parsed, &path) != NULL) {
+		retValue = 1;
+	}
+
+	sml_tree_index_destroy(index);
+	sml_encode_result_free(&binary);
+	sml_parser_free();
+
+	return retValue;
+}
@@ -0,0 +1,159 @@
+/**
+ * File name: test_validate.c
+ *
+ * @author Christian Reimann <cybernico@gmx.de>
+ * @author Tobias Jeske <tobias.jeske@tu-harburg.de>
+ * @remark Supported by the Institute for Security in Distributed Applications (http://www.sva.tu-harburg.de)
+ * @see The GNU Public License (GPL)
+ */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "smllib_test.h"
+#include "smllib_types.h"
+#include "smllib_encode.h"
+#include "smllib_parse.h"
+#include "smllib_context.h"
+#include "smllib_validate.h"
+
+#define CHAIN_NODES (SMLLIB_TREE_MAX_DEPTH + 1)
+
+typedef uint8_t (*Validate_Function)(const unsigned char* smlBinary, uint32_t length, uint32_t* offset);
+typedef uint8_t (*Parse_Function)(const unsigned char* smlBinary, uint32_t* offset, SML_Message* message);
+
+/*
+ * The whole binary validates and parses to the same end, every truncation
+ * (in an exactly sized buffer) and every single byte change fails
+ */
+static int check_binary(unsigned char* binary, uint32_t length, Validate_Function validate, Parse_Function parse) {
+	int retValue = 0;
+	SML_Message message;
+	unsigned char* truncated;
+	uint32_t validOffset = 0;
+	uint32_t offset = 0;
+	uint32_t i;
+
+	if(binary == NULL || validate(binary, length, &validOffset) != SML_PARSE_OK || validOffset != length ||
+		parse(binary, &offset, &message) != SML_PARSE_OK || offset != length) {
+		return 1;
+	}
+	sml_parser_free();
+
+	for(i=1; i<length; i++) {
+		truncated = (unsigned char*)malloc(i);
+		memcpy(truncated, binary, i);
+		validOffset = 0;
+		if(validate(truncated, i, &validOffset) != SML_PARSE_ERROR || validOffset != 0) {
+			retValue = 1;
+		}
+		free(truncated);
+	}
+	for(i=0; i<length; i++) {
+		binary[i] ^= 0x5A;
+		validOffset = 0;
+		if(validate(binary, length, &validOffset) != SML_PARSE_ERROR) {
+			retValue = 1;
+		}
+		binary[i] ^= 0x5A;
+	}
+
+	return retValue;
+}
+
+int main(void) {
+	int retValue = 0;
+	SML_Context context;
+	SML_PublicClose_Res closeResponse;
+	SML_GetProcParameter_Res procResponse;
+	SML_Tree chain[CHAIN_NODES];
+	List_of_SML_Tree children[CHAIN_NODES];
+	char* path[1] = {"root"};
+	SML_Message message;
+	unsigned char* plain[2];
+	unsigned char* transport[2];
+	uint32_t plainLength[2];
+	uint32_t transportLength[2];
+	uint32_t allocations;
+	uint32_t offset;
+	uint32_t i;
+	#ifdef SMLLIB_STATIC_POOL
+		static uint64_t pool[8192];
+	#endif
+
+	sml_context_init(&context);
+	#ifdef SMLLIB_STATIC_POOL
+		sml_context_set_pool(&context, pool, sizeof(pool));
+	#endif
+	sml_context_use(&context);
+
+	/* Escaped runs of 0x1B in the frame: exactly four, and six */
+	memset(&closeResponse, 0, sizeof(closeResponse));
+	memset(&message, 0, sizeof(message));
+	closeResponse.globalSignature = "\x1B\x1B\x1B\x1B\x1B\x1B" "S";
+	message.transactionId = "\x1B\x1B\x1B\x1B" "M";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_CLOSE_RESPONSE;
+	message.messageBody.choiceValue.closeResponse = &closeResponse;
+	plain[0] = sml_test_copy_result(sml_encode_message_binary(&message), &plainLength[0]);
+	transport[0] = sml_test_copy_result(sml_transport_encode_message(&message), &transportLength[0]);
+
+	/* Parameter tree as deep as the parser accepts */
+	memset(&procResponse, 0, sizeof(procResponse));
+	memset(chain, 0, sizeof(chain));
+	for(i=0; i<CHAIN_NODES; i++) {
+		chain[i].parameterName = "node";
+		if(i + 1 < CHAIN_NODES) {
+			children[i].listSize = 1;
+			children[i].tree_Entry = &chain[i + 1];
+			chain[i].child_List = &children[i];
+		}
+	}
+	procResponse.serverId = "server";
+	procResponse.parameterTreePath.listSize = 1;
+	procResponse.parameterTreePath.path_Entry = path;
+	procResponse.parameterTree = chain[0];
+	message.transactionId = "T";
+	message.messageBody.choiceTag = SML_MESSAGEBODY_GETPROCPARAMETER_RESPONSE;
+	message.messageBody.choiceValue.getProcParameterResponse = &procResponse;
+	plain[1] = sml_test_copy_result(sml_encode_message_binary(&message), &plainLength[1]);
+	transport[1] = sml_test_copy_result(sml_transport_encode_message(&message), &transportLength[1]);
+	sml_parser_free();
+
+	for(i=0; i<2; i++) {
+		if(	check_binary(plain[i], plainLength[i], sml_validate_message, sml_parse_message_binary) != 0 ||
+			check_binary(transport[i], transportLength[i], sml_transport_validate_message, sml_transport_parse_message) != 0) {
+			retValue = 1;
+		}
+	}
+
+	/* Validation alone does not allocate */
+	allocations = context.allocStats.total.allocations;
+	for(i=0; i<2; i++) {
+		offset = 0;
+		if(transport[i] == NULL || sml_transport_validate_message(transport[i], transportLength[i], &offset) != SML_PARSE_OK) {
+			retValue = 1;
+		}
+		free(plain[i]);
+		free(transport[i]);
+	}
+	if(context.allocStats.total.allocations != allocations) {
+		retValue = 1;
+	}
+	sml_context_use(NULL);
+
+	return retValue;
+}